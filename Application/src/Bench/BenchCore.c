@@ -0,0 +1,119 @@
+/**************************************************************************//**
+* @file      BenchCore.c
+* @brief     Benchmark runner and statistics, independent of the hardware
+* @details   See BenchCore.h. Must stay free of ASF and FreeRTOS includes: Tools/BenchHarness builds it for the PC.
+* @author
+* @date      2026-10-16
+
+******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "BenchCore.h"
+
+#include <stdio.h>
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn			void BenchComputeStats(uint32_t *samples, uint32_t count, struct BenchResult *result)
+ * @brief		Fills the statistics of a result from its samples
+ * @param[in,out]	samples Timed operations. Sorted in place
+ * @param[in]	count Number of samples. May be 0 (all the statistics are then 0)
+ * @param[out]	result Result whose samples, min, median, p99 and max are written
+ */
+void BenchComputeStats(uint32_t *samples, uint32_t count, struct BenchResult *result)
+{
+	// Insertion sort: at most BENCH_MAX_SAMPLES values, and no recursion or heap
+	for (uint32_t i = 1; i < count; i++) {
+		uint32_t value = samples[i];
+		uint32_t j = i;
+		while (j > 0 && samples[j - 1] > value) {
+			samples[j] = samples[j - 1];
+			j--;
+		}
+		samples[j] = value;
+	}
+
+	result->samples = count;
+	if (count == 0) {
+		result->min = result->median = result->p99 = result->max = 0;
+		return;
+	}
+	result->min = samples[0];
+	result->median = samples[(count - 1) / 2];
+	result->p99 = samples[(count * 99 + 99) / 100 - 1];	// Nearest rank: ceil(0.99 * count)
+	result->max = samples[count - 1];
+}
+
+/**
+ * @fn			void BenchRun(BenchOperation operation, void *context, BenchClock clock, uint32_t count, uint32_t *samples, struct BenchResult *result)
+ * @brief		Times an operation count times and computes the statistics
+ * @param[in]	operation Operation to time
+ * @param[in]	context Passed to the operation
+ * @param[in]	clock Microsecond clock
+ * @param[in]	count Number of operations. Limited to BENCH_MAX_SAMPLES
+ * @param[out]	samples Room for count samples
+ * @param[in,out]	result name, unit and bytesPerOperation are set by the caller. The rest is written
+ */
+void BenchRun(BenchOperation operation, void *context, BenchClock clock, uint32_t count, uint32_t *samples, struct BenchResult *result)
+{
+	uint32_t timed = 0;
+
+	if (count > BENCH_MAX_SAMPLES) count = BENCH_MAX_SAMPLES;
+	result->errors = 0;
+
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t start = clock();
+		int32_t error = operation(context);
+		uint32_t elapsed = clock() - start;
+
+		if (error != 0) {
+			result->errors++;
+		} else {
+			samples[timed++] = elapsed;
+		}
+	}
+
+	BenchComputeStats(samples, timed, result);
+}
+
+/**
+ * @fn			uint32_t BenchBytesPerSecond(const struct BenchResult *result)
+ * @brief		Returns the throughput at the median time (in us), or 0 for latency-only benchmarks
+ */
+uint32_t BenchBytesPerSecond(const struct BenchResult *result)
+{
+	if (result->bytesPerOperation == 0 || result->median == 0) return 0;
+
+	return (uint32_t)(((uint64_t)result->bytesPerOperation * 1000000u) / result->median);
+}
+
+/**
+ * @fn			int BenchFormatResult(const struct BenchResult *result, const char *build, char *buffer, size_t len)
+ * @brief		Writes the machine-parsable result line (see BenchCore.h), with CR LF
+ * @param[in]	result Result of BenchRun
+ * @param[in]	build Firmware build identifier, no commas
+ * @param[out]	buffer Output buffer
+ * @param[in]	len Size of buffer
+ * @return		Returns the length of the line, as snprintf
+ */
+int BenchFormatResult(const struct BenchResult *result, const char *build, char *buffer, size_t len)
+{
+	return snprintf(buffer,
+					len,
+					BENCH_LINE_PREFIX "%s,%s,%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu\r\n",
+					build,
+					result->name,
+					result->unit,
+					(unsigned long)result->samples,
+					(unsigned long)result->errors,
+					(unsigned long)result->min,
+					(unsigned long)result->median,
+					(unsigned long)result->p99,
+					(unsigned long)result->max,
+					(unsigned long)BenchBytesPerSecond(result));
+}
@@ -0,0 +1,54 @@
+/**************************************************************************//**
+* @file      BenchCore.h
+* @brief     Benchmark runner and statistics, independent of the hardware
+* @details   A benchmark is an operation (one I2C transaction, one SD block...) timed COUNT times with a microsecond clock.
+*			 The results are reduced to min / median / p99 / max and printed as one machine-parsable line:
+*
+*			 BENCH,<build>,<name>,<unit>,<samples>,<errors>,<min>,<median>,<p99>,<max>,<bytes/s at median>
+*
+*			 The file only needs the C library, so the same code runs on the board (BenchTarget.c backends) and on a
+*			 PC against simulated backends (Tools/BenchHarness).
+* @author
+* @date      2026-10-16
+
+******************************************************************************/
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BENCH_MAX_SAMPLES	100			///< Largest number of timed operations per benchmark
+#define BENCH_LINE_PREFIX	"BENCH,"	///< Start of every result line, so a host can find them in the console text
+
+/// Operation to time. Returns 0 on success. Failed operations are counted but not timed
+typedef int32_t (*BenchOperation)(void *context);
+
+/// Microsecond clock. Only differences are used, so it may wrap
+typedef uint32_t (*BenchClock)(void);
+
+/// Result of a benchmark
+struct BenchResult {
+	const char *name;			///< Benchmark name, no commas
+	const char *unit;			///< Unit of the statistics, e.g. "us"
+	uint32_t samples;			///< Operations that succeeded and were timed
+	uint32_t errors;			///< Operations that failed
+	uint32_t min;				///< Fastest operation
+	uint32_t median;			///< Median operation
+	uint32_t p99;				///< 99th percentile (nearest rank)
+	uint32_t max;				///< Slowest operation
+	uint32_t bytesPerOperation;	///< Payload of one operation, 0 if the benchmark only measures latency
+};
+
+void BenchComputeStats(uint32_t *samples, uint32_t count, struct BenchResult *result);
+void BenchRun(BenchOperation operation, void *context, BenchClock clock, uint32_t count, uint32_t *samples, struct BenchResult *result);
+uint32_t BenchBytesPerSecond(const struct BenchResult *result);
+int BenchFormatResult(const struct BenchResult *result, const char *build, char *buffer, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,204 @@
+/**************************************************************************//**
+* @file      BenchTarget.c
+* @brief     On-target benchmarks of the I2C bus, the WINC SPI bus, the SD card and MQTT
+* @details   Backends of BenchCore for the board. Times are read from the run time stats counter (1 us).
+*			 See BenchTarget.h for the task each benchmark must run in.
+* @author
+* @date      2026-10-16
+
+******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "Bench/BenchTarget.h"
+
+#include <string.h>
+
+#include "I2cDriver/I2cDriver.h"
+#include "RunTimeStats/RunTimeStats.h"
+#include "WifiHandlerThread/WifiHandler.h"
+#include "driver/source/nmasic.h"
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define BENCH_I2C_TIMEOUT_MS	100		///< Longest wait for the I2C transaction
+#define BENCH_I2C_REGISTER_0	0x00	///< Seesaw STATUS base. Devices without registers simply answer the first byte
+#define BENCH_I2C_REGISTER_1	0x01	///< Seesaw HW_ID
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint32_t benchSamples[BENCH_MAX_SAMPLES];			///< Samples of the running benchmark. One benchmark runs at a time
+static uint8_t benchSdBlock[BENCH_SD_BLOCK_SIZE];			///< Data written to and read from the SD card
+static FIL benchFile;										///< Scratch file of the SD benchmark
+
+/******************************************************************************
+ * Local Functions
+ ******************************************************************************/
+
+/**
+ * @fn		static int32_t BenchI2cOperation(void *context)
+ * @brief	One write-then-read transaction: register address out, one byte in
+ */
+static int32_t BenchI2cOperation(void *context)
+{
+	static const uint8_t reg[2] = {BENCH_I2C_REGISTER_0, BENCH_I2C_REGISTER_1};
+	uint8_t value;
+	I2C_Data data;
+
+	data.address = *(const uint8_t *)context;
+	data.msgOut = reg;
+	data.lenOut = sizeof(reg);
+	data.msgIn = &value;
+	data.lenIn = sizeof(value);
+	return I2cReadDataWait(&data, 0, pdMS_TO_TICKS(BENCH_I2C_TIMEOUT_MS));
+}
+
+/**
+ * @fn		static int32_t BenchSpiOperation(void *context)
+ * @brief	One WINC register read (command, response and 4 data bytes through spi_rw)
+ * @note	The chip ID register has no side effect on read. Wi-Fi task only
+ */
+static int32_t BenchSpiOperation(void *context)
+{
+	(void)context;
+	uint32_t chipId;
+	return (nm_read_reg_with_ret(NMI_CHIPID, &chipId) == M2M_SUCCESS) ? ERROR_NONE : ERROR_IO;
+}
+
+/**
+ * @fn		static int32_t BenchSdWriteOperation(void *context)
+ * @brief	Appends one sector to the scratch file
+ */
+static int32_t BenchSdWriteOperation(void *context)
+{
+	(void)context;
+	UINT written = 0;
+	FRESULT res = f_write(&benchFile, benchSdBlock, sizeof(benchSdBlock), &written);
+	return (res == FR_OK && written == sizeof(benchSdBlock)) ? ERROR_NONE : ERROR_IO;
+}
+
+/**
+ * @fn		static int32_t BenchSdReadOperation(void *context)
+ * @brief	Reads the next sector of the scratch file
+ */
+static int32_t BenchSdReadOperation(void *context)
+{
+	(void)context;
+	UINT read = 0;
+	FRESULT res = f_read(&benchFile, benchSdBlock, sizeof(benchSdBlock), &read);
+	return (res == FR_OK && read == sizeof(benchSdBlock)) ? ERROR_NONE : ERROR_IO;
+}
+
+/**
+ * @fn		static int32_t BenchMqttOperation(void *context)
+ * @brief	Publishes one message and waits until the broker sends it back
+ */
+static int32_t BenchMqttOperation(void *context)
+{
+	return WifiBenchMqttRoundTrip(*(const uint8_t *)context, BENCH_MQTT_TIMEOUT_MS);
+}
+
+/**
+ * @fn		static int32_t BenchSd(struct BenchRequest *request)
+ * @brief	Writes count sectors to the scratch file, then reads them back. Wi-Fi task only
+ */
+static int32_t BenchSd(struct BenchRequest *request)
+{
+	char fileName[] = BENCH_SD_FILE_NAME;
+	fileName[0] = LUN_ID_SD_MMC_0_MEM + '0';
+
+	for (size_t i = 0; i < sizeof(benchSdBlock); i++) {
+		benchSdBlock[i] = (uint8_t)i;
+	}
+
+	struct BenchResult *write = &request->results[0];
+	struct BenchResult *read = &request->results[1];
+	write->name = "sd_write";
+	read->name = "sd_read";
+	write->unit = read->unit = "us";
+	write->bytesPerOperation = read->bytesPerOperation = BENCH_SD_BLOCK_SIZE;
+
+	if (f_open(&benchFile, fileName, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) return ERROR_IO;
+	BenchRun(BenchSdWriteOperation, NULL, BenchTargetClock, request->count, benchSamples, write);
+	f_close(&benchFile);
+
+	if (f_open(&benchFile, fileName, FA_OPEN_EXISTING | FA_READ) != FR_OK) return ERROR_IO;
+	BenchRun(BenchSdReadOperation, NULL, BenchTargetClock, request->count, benchSamples, read);
+	f_close(&benchFile);
+
+	f_unlink(fileName);
+	request->resultCount = 2;
+	return ERROR_NONE;
+}
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn		uint32_t BenchTargetClock(void)
+ * @brief	Microsecond clock of the benchmarks: the run time stats counter
+ */
+uint32_t BenchTargetClock(void)
+{
+	return RunTimeStatsGetCounter();
+}
+
+/**
+ * @fn			int32_t BenchTargetRun(struct BenchRequest *request)
+ * @brief		Runs a benchmark in the calling task
+ * @param[in,out]	request type, count and address are read. The results and status are written
+ * @return		Returns ERROR_NONE if the benchmark ran (individual operations may still have failed, see errors)
+ * @note		BENCH_SPI, BENCH_SD and BENCH_MQTT must run in the Wi-Fi task (see WifiRunBench)
+ */
+int32_t BenchTargetRun(struct BenchRequest *request)
+{
+	int32_t error = ERROR_NONE;
+	struct BenchResult *result = &request->results[0];
+
+	memset(request->results, 0, sizeof(request->results));
+	request->resultCount = 0;
+	if (request->count == 0) request->count = BENCH_DEFAULT_COUNT;
+
+	switch (request->type) {
+		case BENCH_I2C:
+			result->name = "i2c_wr";
+			result->unit = "us";
+			BenchRun(BenchI2cOperation, &request->address, BenchTargetClock, request->count, benchSamples, result);
+			request->resultCount = 1;
+			break;
+
+		case BENCH_SPI:
+			result->name = "winc_spi_reg";
+			result->unit = "us";
+			result->bytesPerOperation = sizeof(uint32_t);
+			BenchRun(BenchSpiOperation, NULL, BenchTargetClock, request->count, benchSamples, result);
+			request->resultCount = 1;
+			break;
+
+		case BENCH_SD:
+			error = BenchSd(request);
+			break;
+
+		case BENCH_MQTT: {
+			static const uint8_t qos[BENCH_MAX_RESULTS] = {0, 1};
+			for (uint8_t i = 0; i < BENCH_MAX_RESULTS; i++) {
+				request->results[i].name = (qos[i] == 0) ? "mqtt_rtt_qos0" : "mqtt_rtt_qos1";
+				request->results[i].unit = "us";
+				BenchRun(BenchMqttOperation, (void *)&qos[i], BenchTargetClock, request->count, benchSamples, &request->results[i]);
+			}
+			request->resultCount = BENCH_MAX_RESULTS;
+			break;
+		}
+
+		default:
+			error = ERROR_INVALID_ARG;
+			break;
+	}
+
+	request->status = error;
+	return error;
+}
@@ -0,0 +1,43 @@
+/**************************************************************************//**
+* @file      BenchTarget.h
+* @brief     On-target benchmarks of the I2C bus, the WINC SPI bus, the SD card and MQTT (see BenchCore.h)
+* @details   The I2C benchmark runs in the calling task. The WINC driver, FatFs and the MQTT client are only used by the
+*			 Wi-Fi task, so the other benchmarks are handed to it with WifiRunBench and run between two MQTT transactions.
+* @author
+* @date      2026-10-16
+
+******************************************************************************/
+
+#pragma once
+
+#include "asf.h"
+#include "Bench/BenchCore.h"
+
+#define BENCH_DEFAULT_COUNT		50						///< Operations per benchmark when the CLI does not give a count
+#define BENCH_SD_BLOCK_SIZE		512						///< Bytes per SD operation: one sector, so FatFs writes straight to the card
+#define BENCH_SD_FILE_NAME		"0:bench.bin"			///< Scratch file of the SD benchmark. Drive number is patched to LUN_ID_SD_MMC_0_MEM
+#define BENCH_MQTT_TIMEOUT_MS	2000					///< Longest round trip before a message counts as lost
+#define BENCH_WIFI_TIMEOUT_MS	60000					///< Longest time the CLI waits for the Wi-Fi task to run a benchmark
+#define BENCH_BUILD				__DATE__ " " __TIME__	///< Firmware build identifier of the result lines
+#define BENCH_MAX_RESULTS		2						///< Results per request (SD: write and read. MQTT: QoS 0 and QoS 1)
+
+/// Benchmarks
+enum eBenchType {
+	BENCH_I2C = 0,	///< Write-then-read of one register through I2cReadDataWait
+	BENCH_SPI,		///< WINC register read through nm_read_reg_with_ret (spi_rw)
+	BENCH_SD,		///< Sequential 512-byte writes then reads through FatFs
+	BENCH_MQTT,		///< Publish to BENCH_TOPIC until the broker sends the message back, QoS 0 and QoS 1
+};
+
+/// Benchmark request, filled by the caller and completed by BenchTargetRun
+struct BenchRequest {
+	enum eBenchType type;							///< Benchmark to run
+	uint32_t count;									///< Operations per result
+	uint8_t address;								///< I2C benchmark: 7-bit device address
+	uint8_t resultCount;							///< Number of valid results
+	int32_t status;									///< ERROR_NONE, or why the benchmark could not run
+	struct BenchResult results[BENCH_MAX_RESULTS];	///< Results
+};
+
+int32_t BenchTargetRun(struct BenchRequest *request);
+uint32_t BenchTargetClock(void);
@@ -0,0 +1,280 @@
+/**************************************************************************//**
+* @file      CliDispatch.c
+* @brief     Hashed command lookup and pre-tokenized parameters for the FreeRTOS+CLI commands
+* @details   See CliDispatch.h. Commands are stored in an open-addressing hash table (FNV-1a of the command name,
+*			 linear probing). The hash of every entry is kept next to it, so a probe only compares strings when the
+*			 hashes match: a lookup costs one hash of the first word plus, in practice, one strncmp.
+*			 Not re-entrant, like FreeRTOS_CLIProcessCommand: only the CLI task may call it.
+* @author
+* @date      2026-10-16
+
+******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "CliDispatch.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "SerialConsole/SerialConsole.h"
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define FNV_OFFSET_BASIS	2166136261u	///< FNV-1a 32-bit initial value
+#define FNV_PRIME			16777619u	///< FNV-1a 32-bit multiplier
+
+/******************************************************************************
+ * Structures and Enumerations
+ ******************************************************************************/
+/// Hash table entry
+struct CliCommandEntry {
+	const CLI_Command_Definition_t *command;	///< Registered command, NULL if the entry is free
+	uint32_t hash;								///< Hash of the command name
+};
+
+/// Who handles the command being run, so that calls for more output go to the same place
+enum eCliDispatchState {
+	CLI_DISPATCH_IDLE = 0,	///< No command in progress
+	CLI_DISPATCH_TABLE,		///< A command of the hash table returned pdTRUE
+	CLI_DISPATCH_FREERTOS,	///< FreeRTOS_CLIProcessCommand returned pdTRUE
+};
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+static struct CliCommandEntry cliCommandTable[CLI_COMMAND_TABLE_SIZE];	///< Registered commands
+static uint32_t cliCommandCount = 0;									///< Number of entries used in cliCommandTable
+static const CLI_Command_Definition_t *cliCurrentCommand = NULL;		///< Command being run
+static enum eCliDispatchState cliDispatchState = CLI_DISPATCH_IDLE;	///< Handler of the command being run
+
+static const char *cliParameters[CLI_MAX_PARAMETERS];		///< Start of every parameter of the current command line
+static uint8_t cliParameterLengths[CLI_MAX_PARAMETERS];	///< Length of every parameter of the current command line
+static UBaseType_t cliParameterCount = 0;					///< Number of parameters of the current command line, including the ones not stored
+
+static char *cliWriteBuffer = NULL;		///< Output buffer of the command being run, borrowed by CliPrintf
+static size_t cliWriteBufferLen = 0;	///< Size of cliWriteBuffer
+
+/******************************************************************************
+ * Local Functions
+ ******************************************************************************/
+
+/**
+ * @fn		static uint32_t CliHash(const char *name, size_t len)
+ * @brief	FNV-1a hash of a command name
+ */
+static uint32_t CliHash(const char *name, size_t len)
+{
+	uint32_t hash = FNV_OFFSET_BASIS;
+	for (size_t i = 0; i < len; i++) {
+		hash = (hash ^ (uint8_t)name[i]) * FNV_PRIME;
+	}
+	return hash;
+}
+
+/**
+ * @fn		static const CLI_Command_Definition_t *CliFindCommand(const char *name, size_t len)
+ * @brief	Looks a command up in the hash table
+ * @return	Returns the command, or NULL if it is not registered in the table
+ */
+static const CLI_Command_Definition_t *CliFindCommand(const char *name, size_t len)
+{
+	uint32_t hash = CliHash(name, len);
+
+	for (uint32_t i = 0; i < CLI_COMMAND_TABLE_SIZE; i++) {
+		const struct CliCommandEntry *entry = &cliCommandTable[(hash + i) & (CLI_COMMAND_TABLE_SIZE - 1)];
+		if (entry->command == NULL) {
+			break;
+		}
+		if (entry->hash == hash && strncmp(entry->command->pcCommand, name, len) == 0 && entry->command->pcCommand[len] == '\0') {
+			return entry->command;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @fn		static void CliTokenize(const char *commandInput, const char **name, size_t *nameLen)
+ * @brief	Splits the command line into the command name and its space separated parameters
+ */
+static void CliTokenize(const char *commandInput, const char **name, size_t *nameLen)
+{
+	const char *p = commandInput;
+
+	while (*p == ' ') p++;
+	*name = p;
+	while (*p != '\0' && *p != ' ') p++;
+	*nameLen = (size_t)(p - *name);
+
+	cliParameterCount = 0;
+	for (;;) {
+		while (*p == ' ') p++;
+		if (*p == '\0') break;
+
+		const char *start = p;
+		while (*p != '\0' && *p != ' ') p++;
+		if (cliParameterCount < CLI_MAX_PARAMETERS) {
+			cliParameters[cliParameterCount] = start;
+			cliParameterLengths[cliParameterCount] = (uint8_t)(p - start);
+		}
+		cliParameterCount++;
+	}
+}
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn			BaseType_t CliRegisterCommand(const CLI_Command_Definition_t *const command)
+ * @brief		Registers a command with the hash table, and with FreeRTOS+CLI for the "help" listing
+ * @param[in]	command Command definition. Must stay valid forever (usually a static const)
+ * @details	The table is kept at most half full, so that a lookup probes one or two entries. A command past
+ *				CLI_COMMAND_TABLE_SIZE / 2 is refused and trips configASSERT: raise CLI_COMMAND_TABLE_SIZE.
+ * @return		Returns pdPASS if the command was registered, pdFAIL if the table is half full or the name is taken
+ */
+BaseType_t CliRegisterCommand(const CLI_Command_Definition_t *const command)
+{
+	size_t len = strlen(command->pcCommand);
+	uint32_t hash = CliHash(command->pcCommand, len);
+
+	if (CliFindCommand(command->pcCommand, len) != NULL) {
+		return pdFAIL;
+	}
+	configASSERT(cliCommandCount < CLI_COMMAND_TABLE_SIZE / 2);
+	if (cliCommandCount >= CLI_COMMAND_TABLE_SIZE / 2) {
+		return pdFAIL;
+	}
+
+	for (uint32_t i = 0; i < CLI_COMMAND_TABLE_SIZE; i++) {
+		struct CliCommandEntry *entry = &cliCommandTable[(hash + i) & (CLI_COMMAND_TABLE_SIZE - 1)];
+		if (entry->command == NULL) {
+			entry->hash = hash;
+			entry->command = command;
+			cliCommandCount++;
+			return FreeRTOS_CLIRegisterCommand(command);
+		}
+	}
+	return pdFAIL;
+}
+
+/**
+ * @fn			BaseType_t CliProcessCommand(const char *const commandInput, char *writeBuffer, size_t writeBufferLen)
+ * @brief		Drop-in replacement for FreeRTOS_CLIProcessCommand
+ * @param[in]	commandInput Command line. Must not change until the command returns pdFALSE
+ * @param[out]	writeBuffer Buffer for the output of the command
+ * @param[in]	writeBufferLen Size of writeBuffer
+ * @return		Returns pdTRUE if the command has more output and must be called again, pdFALSE if it is done
+ */
+BaseType_t CliProcessCommand(const char *const commandInput, char *writeBuffer, size_t writeBufferLen)
+{
+	BaseType_t ret;
+
+	if (cliDispatchState == CLI_DISPATCH_IDLE) {
+		const char *name;
+		size_t nameLen;
+		CliTokenize(commandInput, &name, &nameLen);
+		cliCurrentCommand = CliFindCommand(name, nameLen);
+		cliDispatchState = (cliCurrentCommand != NULL) ? CLI_DISPATCH_TABLE : CLI_DISPATCH_FREERTOS;
+
+		if (cliCurrentCommand != NULL && cliCurrentCommand->cExpectedNumberOfParameters >= 0 && cliParameterCount != (UBaseType_t)cliCurrentCommand->cExpectedNumberOfParameters) {
+			strncpy(writeBuffer, "Incorrect command parameter(s).  Enter \"help\" to view a list of available commands.\r\n\r\n", writeBufferLen);
+			cliDispatchState = CLI_DISPATCH_IDLE;
+			return pdFALSE;
+		}
+	}
+
+	// Commands that only use the output sink leave the buffer empty, so the caller has nothing to print
+	writeBuffer[0] = '\0';
+	cliWriteBuffer = writeBuffer;
+	cliWriteBufferLen = writeBufferLen;
+
+	if (cliDispatchState == CLI_DISPATCH_TABLE) {
+		ret = cliCurrentCommand->pxCommandInterpreter(writeBuffer, writeBufferLen, commandInput);
+	} else {
+		ret = FreeRTOS_CLIProcessCommand(commandInput, writeBuffer, writeBufferLen);
+	}
+
+	cliWriteBuffer = NULL;
+	if (ret == pdFALSE) {
+		cliDispatchState = CLI_DISPATCH_IDLE;
+	}
+	return ret;
+}
+
+/**
+ * @fn			const char *CliGetParameter(UBaseType_t wantedParameter, BaseType_t *parameterStringLength)
+ * @brief		Returns a parameter of the command being run, without scanning the command line again
+ * @details		Same meaning as FreeRTOS_CLIGetParameter: parameter 1 is the first word after the command name.
+ *				Only valid inside a callback of a command registered with CliRegisterCommand.
+ * @param[in]	wantedParameter Parameter number, starting at 1
+ * @param[out]	parameterStringLength Length of the parameter. The parameter is not null terminated
+ * @return		Returns the start of the parameter, or NULL if there is no such parameter
+ */
+const char *CliGetParameter(UBaseType_t wantedParameter, BaseType_t *parameterStringLength)
+{
+	*parameterStringLength = 0;
+	if (wantedParameter == 0 || wantedParameter > cliParameterCount || wantedParameter > CLI_MAX_PARAMETERS) {
+		return NULL;
+	}
+
+	*parameterStringLength = cliParameterLengths[wantedParameter - 1];
+	return cliParameters[wantedParameter - 1];
+}
+
+/**
+ * @fn			UBaseType_t CliGetParameterCount(void)
+ * @brief		Returns the number of parameters of the command being run
+ */
+UBaseType_t CliGetParameterCount(void)
+{
+	return cliParameterCount;
+}
+
+/**
+ * @fn			void CliWrite(const char *data, size_t len)
+ * @brief		Output sink: sends bytes to the console, waiting for room in the TX buffer if needed
+ * @param[in]	data Bytes to send
+ * @param[in]	len Number of bytes to send
+ * @note		Blocks the CLI task while the console is busy. Only call from the CLI task
+ */
+void CliWrite(const char *data, size_t len)
+{
+	SerialConsoleWriteBlocking((const uint8_t *)data, len);
+}
+
+/**
+ * @fn			void CliWriteString(const char *string)
+ * @brief		Output sink: sends a string to the console, waiting for room in the TX buffer if needed
+ */
+void CliWriteString(const char *string)
+{
+	if (string == NULL) return;
+
+	CliWrite(string, strlen(string));
+}
+
+/**
+ * @fn			void CliPrintf(const char *format, ...)
+ * @brief		Output sink: formats a message and sends it to the console, waiting for room in the TX buffer if needed
+ * @details		Formats into the output buffer of the command being run (MAX_OUTPUT_LENGTH_CLI), so it needs no buffer
+ *				of its own. Longer messages are cut. Only valid inside a command run by CliProcessCommand, which must
+ *				not use pcWriteBuffer for anything else.
+ */
+void CliPrintf(const char *format, ...)
+{
+	if (cliWriteBuffer == NULL || cliWriteBufferLen == 0) return;
+
+	va_list ap;
+	va_start(ap, format);
+	int len = vsnprintf(cliWriteBuffer, cliWriteBufferLen, format, ap);
+	va_end(ap);
+
+	if (len > 0) {
+		CliWrite(cliWriteBuffer, ((size_t)len < cliWriteBufferLen) ? (size_t)len : cliWriteBufferLen - 1);
+	}
+	cliWriteBuffer[0] = '\0';
+}
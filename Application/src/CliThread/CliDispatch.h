@@ -0,0 +1,38 @@
+/**************************************************************************//**
+* @file      CliDispatch.h
+* @brief     Hashed command lookup and pre-tokenized parameters for the FreeRTOS+CLI commands
+* @details   FreeRTOS_CLIProcessCommand walks the list of registered commands with a string compare per command, and
+*			 every FreeRTOS_CLIGetParameter call scans the command line again from the start. The commands registered
+*			 here are found through a hash table (one string compare on a hit) and the command line is split once per
+*			 command, before the callback runs.
+*
+*			 The commands keep the FreeRTOS+CLI definition and callback signature, and are also registered with
+*			 FreeRTOS+CLI so that "help" keeps listing them. Anything not in the table (e.g. "help") is handed to
+*			 FreeRTOS_CLIProcessCommand.
+*
+*			 Output sink: instead of filling pcWriteBuffer and returning pdTRUE once per page, a command can write its
+*			 output straight to the console TX ring with CliWrite/CliWriteString/CliPrintf and return pdFALSE. These
+*			 wait for room when the console is busy, so long outputs stream at the uart rate and nothing is dropped.
+* @author
+* @date      2026-10-16
+
+******************************************************************************/
+
+#pragma once
+
+#include "FreeRTOS.h"
+#include "FreeRTOS_CLI.h"
+
+#ifndef CLI_COMMAND_TABLE_SIZE
+#define CLI_COMMAND_TABLE_SIZE	64	///< Number of hash table entries. Power of two; CliRegisterCommand refuses commands past half of it
+#endif
+#define CLI_MAX_PARAMETERS		8	///< Parameters past this number are not tokenized (CliGetParameter returns NULL for them)
+
+BaseType_t CliRegisterCommand(const CLI_Command_Definition_t *const command);
+BaseType_t CliProcessCommand(const char *const commandInput, char *writeBuffer, size_t writeBufferLen);
+const char *CliGetParameter(UBaseType_t wantedParameter, BaseType_t *parameterStringLength);
+UBaseType_t CliGetParameterCount(void);
+
+void CliWrite(const char *data, size_t len);
+void CliWriteString(const char *string);
+void CliPrintf(const char *format, ...);
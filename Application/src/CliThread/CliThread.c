@@ -10,12 +10,18 @@
  * Includes
  ******************************************************************************/
 #include "CliThread.h"
+#include "CliDispatch.h"
 #include <asf.h>
 #include "DistanceDriver/DistanceSensor.h"
 #include "IMU\lsm6dso_reg.h"
 #include "SeesawDriver/Seesaw.h"
 #include "WifiHandlerThread/WifiHandler.h"
 #include "NAU78/NAU7802.h"
+#include "SensorStream/SensorStream.h"
+#include "SerialConsole/DataStream.h"
+#include "RunTimeStats/RunTimeStats.h"
+#include "Bench/BenchTarget.h"
+#include "LedFrame/LedFrame.h"
 
 /******************************************************************************
  * Defines
@@ -49,6 +55,14 @@ static const CLI_Command_Definition_t xDistanceSensorGetDistance = {"getdistance
 
 static const CLI_Command_Definition_t xSendDummyGameData = {"game", "game: Sends dummy game data\r\n", (const pdCOMMAND_LINE_CALLBACK)CLI_SendDummyGameData, 0};
 static const CLI_Command_Definition_t xI2cScan = {"i2c", "i2c: Scans I2C bus\r\n", (const pdCOMMAND_LINE_CALLBACK)CLI_i2cScan, 0};	
+static const CLI_Command_Definition_t xStreamCommand = {"stream", "stream [on|off]: Starts or stops streaming binary sensor records. Prints the dropped frames\r\n", (const pdCOMMAND_LINE_CALLBACK)CLI_Stream, -1};
+static const CLI_Command_Definition_t xLogStats = {"logstats", "logstats: Prints the log messages dropped per level because the logger was busy\r\n", (const pdCOMMAND_LINE_CALLBACK)CLI_LogStats, 0};
+static const CLI_Command_Definition_t xBenchCommand = {"bench", "bench <i2c|spi|sd|mqtt|all> [count] [i2c address, hex]: Runs on-target benchmarks. Prints BENCH result lines\r\n", (const pdCOMMAND_LINE_CALLBACK)CLI_Bench, -1};
+static const CLI_Command_Definition_t xI2cSpeedCommand = {"i2cspeed", "i2cspeed: Prints the bus speed of each I2C device and its measured transfer times\r\n", (const pdCOMMAND_LINE_CALLBACK)CLI_I2cSpeed, 0};
+static const CLI_Command_Definition_t xI2cBusCommand = {"i2cbus", "i2cbus: Prints the state of the I2C bus and the bus recoveries of each device\r\n", (const pdCOMMAND_LINE_CALLBACK)CLI_I2cBus, 0};
+static const CLI_Command_Definition_t xI2cStatsCommand = {"i2cstats", "i2cstats [reset]: Prints the I2C transactions, bus time and latency histogram of each device\r\n", (const pdCOMMAND_LINE_CALLBACK)CLI_I2cStats, -1};
+static const CLI_Command_Definition_t xBootTimeCommand = {"boottime", "boottime: Prints the time of each startup milestone since the scheduler started, up to the MQTT connection\r\n", (const pdCOMMAND_LINE_CALLBACK)CLI_BootTime, 0};
+static const CLI_Command_Definition_t xTopCommand = {"top", "top: Prints the CPU share of each task since the previous sample, its stack high water mark and the free heap\r\n", (const pdCOMMAND_LINE_CALLBACK)CLI_Top, 0};
 static const CLI_Command_Definition_t xGetWeight =
 {
 	"weight",
@@ -63,10 +77,15 @@ const CLI_Command_Definition_t xClearScreen = {CLI_COMMAND_CLEAR_SCREEN, CLI_HEL
 
 SemaphoreHandle_t cliCharReadySemaphore;  ///< Semaphore to indicate that a character has been received
 
+static uint8_t *cliRxSpan = NULL;  ///< Received characters being processed, still inside the console RX buffer
+static size_t cliRxSpanLen = 0;    ///< Number of characters in cliRxSpan
+static size_t cliRxSpanPos = 0;    ///< Next character of cliRxSpan to process
+
 /******************************************************************************
  * Forward Declarations
  ******************************************************************************/
  static void FreeRTOS_read(char *character);
+ static void CliWaitForInput(void);
 /******************************************************************************
  * Callback Functions
  ******************************************************************************/
@@ -78,16 +97,24 @@ SemaphoreHandle_t cliCharReadySemaphore;  ///< Semaphore to indicate that a char
 void vCommandConsoleTask(void *pvParameters)
 {
     // REGISTER COMMANDS HERE
-    FreeRTOS_CLIRegisterCommand(&xOTAUCommand);
-    FreeRTOS_CLIRegisterCommand(&xImuGetCommand);
-    FreeRTOS_CLIRegisterCommand(&xClearScreen);
-    FreeRTOS_CLIRegisterCommand(&xResetCommand);
-    FreeRTOS_CLIRegisterCommand(&xNeotrellisTurnLEDCommand);
-    FreeRTOS_CLIRegisterCommand(&xNeotrellisProcessButtonCommand);
-    FreeRTOS_CLIRegisterCommand(&xDistanceSensorGetDistance);
-    FreeRTOS_CLIRegisterCommand(&xSendDummyGameData);
-	FreeRTOS_CLIRegisterCommand(&xI2cScan);
-	FreeRTOS_CLIRegisterCommand(&xGetWeight);
+    CliRegisterCommand(&xOTAUCommand);
+    CliRegisterCommand(&xImuGetCommand);
+    CliRegisterCommand(&xClearScreen);
+    CliRegisterCommand(&xResetCommand);
+    CliRegisterCommand(&xNeotrellisTurnLEDCommand);
+    CliRegisterCommand(&xNeotrellisProcessButtonCommand);
+    CliRegisterCommand(&xDistanceSensorGetDistance);
+    CliRegisterCommand(&xSendDummyGameData);
+	CliRegisterCommand(&xI2cScan);
+	CliRegisterCommand(&xGetWeight);
+    CliRegisterCommand(&xLogStats);
+    CliRegisterCommand(&xStreamCommand);
+    CliRegisterCommand(&xTopCommand);
+    CliRegisterCommand(&xBenchCommand);
+    CliRegisterCommand(&xI2cSpeedCommand);
+    CliRegisterCommand(&xI2cBusCommand);
+    CliRegisterCommand(&xI2cStatsCommand);
+    CliRegisterCommand(&xBootTimeCommand);
     char cRxedChar[2];
     unsigned char cInputIndex = 0;
     BaseType_t xMoreDataToFollow;
@@ -108,7 +135,7 @@ void vCommandConsoleTask(void *pvParameters)
     // Any semaphores/mutexes/etc you needed to be initialized, you can do them here
     cliCharReadySemaphore = xSemaphoreCreateBinary();
     if (cliCharReadySemaphore == NULL) {
-        LogMessage(LOG_ERROR_LVL, "Could not allocate semaphore\r\n");
+        LOG_ERROR("Could not allocate semaphore\r\n");
         vTaskSuspend(NULL);
     }
 
@@ -133,16 +160,16 @@ void vCommandConsoleTask(void *pvParameters)
                 /* Send the command string to the command interpreter.  Any
                 output generated by the command interpreter will be placed in the
                 pcOutputString buffer. */
-                xMoreDataToFollow = FreeRTOS_CLIProcessCommand(pcInputString,        /* The command string.*/
-                                                               pcOutputString,       /* The output buffer. */
-                                                               MAX_OUTPUT_LENGTH_CLI /* The size of the output buffer. */
+                xMoreDataToFollow = CliProcessCommand(pcInputString,        /* The command string.*/
+                                                      pcOutputString,       /* The output buffer. */
+                                                      MAX_OUTPUT_LENGTH_CLI /* The size of the output buffer. */
                 );
 
                 /* Write the output generated by the command interpreter to the
-                console. */
+                console. Commands using the output sink (CliPrintf...) leave it empty. */
                 // Ensure it is null terminated
                 pcOutputString[MAX_OUTPUT_LENGTH_CLI - 1] = 0;
-                SerialConsoleWriteString(pcOutputString);
+                CliWriteString(pcOutputString);
 
             } while (xMoreDataToFollow != pdFALSE);
 
@@ -150,8 +177,7 @@ void vCommandConsoleTask(void *pvParameters)
             Processing of the command is complete.  Clear the input string ready
             to receive the next command. */
             cInputIndex = 0;
-            memset(pcInputString, 0x00, MAX_INPUT_LENGTH_CLI);
-            memset(pcOutputString, 0, MAX_OUTPUT_LENGTH_CLI);
+            pcInputString[0] = 0;
         } else {
             /* The if() clause performs the processing after a newline character
 is received.  This else clause performs the processing if any other
@@ -209,9 +235,10 @@ character is received. */
                 or carriage return, so it is accepted as part of the input and
                 placed into the input buffer.  When a n is entered the complete
                 string will be passed to the command interpreter. */
-                if (cInputIndex < MAX_INPUT_LENGTH_CLI) {
+                if (cInputIndex < MAX_INPUT_LENGTH_CLI - 1) {
                     pcInputString[cInputIndex] = cRxedChar[0];
                     cInputIndex++;
+                    pcInputString[cInputIndex] = 0;
                 }
 
                 // Order Echo
@@ -225,21 +252,68 @@ character is received. */
 /**
  * @fn			void FreeRTOS_read(char* character)
  * @brief		This function block the thread unless we received a character
- * @details		This function blocks until UartSemaphoreHandle is released to continue reading characters in CLI
+ * @details		Characters are handed out from a span of the console RX buffer. The buffer is only visited again
+ *				(and the thread only blocks) once the whole span has been processed, so a pasted line costs one wakeup
+ *				instead of one per character.
  * @note
  */
 static void FreeRTOS_read(char *character)
 {
-    // We check if there are more characters in the buffer that arrived since the last time
-    // This function returns -1 if the buffer is empty, other value otherwise
-    int ret = SerialConsoleReadCharacter((uint8_t *)character);
+    while (cliRxSpanPos == cliRxSpanLen) {
+        SerialConsoleReleaseSpan(cliRxSpanLen);
+        cliRxSpanPos = 0;
+        cliRxSpanLen = SerialConsoleReadSpan(&cliRxSpan);
+
+        if (cliRxSpanLen == 0) {
+            CliWaitForInput();
+            cliRxSpanLen = SerialConsoleReadSpan(&cliRxSpan);
+        }
+    }
 
-    while (ret == -1) {
-        // there are no more characters - block the thread until we receive a semaphore indicating reception of at least 1 character
-        xSemaphoreTake(cliCharReadySemaphore, portMAX_DELAY);
+    *character = (char)cliRxSpan[cliRxSpanPos++];
+}
+
+/**
+ * @fn			static void CliWaitForInput(void)
+ * @brief		Blocks until a batch of characters was received
+ * @details		Sleeps until the start bit of the next character, polls for up to CLI_RX_FRAME_US until the DMAC has
+ *				stored it, then lets the DMAC keep receiving until the line is complete (CR or LF), the line is idle for
+ *				CLI_RX_IDLE_MS or half of the RX buffer is used.
+ *				A typed character is therefore seen after about 2*CLI_RX_IDLE_MS, and a pasted block in one go.
+ * @note
+ */
+static void CliWaitForInput(void)
+{
+    // Sleep until something arrives. The check after enabling the wakeup catches a character that beat it;
+    // the timeout catches a character whose start bit came just before the wakeup was enabled
+    for (;;) {
+        SerialConsoleEnableRxWakeup();
+        if (SerialConsoleGetRxCount() != 0) break;
+        if (xSemaphoreTake(cliCharReadySemaphore, pdMS_TO_TICKS(CLI_RX_SLEEP_MS)) == pdTRUE) {
+            // Woken by the start bit: the character is still on the wire. Wait for the DMAC to store it rather than
+            // go back to sleep for CLI_RX_SLEEP_MS (a glitch without a character only costs CLI_RX_FRAME_US)
+            uint32_t start = RunTimeStatsGetCounter();
+            while (SerialConsoleGetRxCount() == 0 && RunTimeStatsGetCounter() - start < CLI_RX_FRAME_US) {
+            }
+        }
+    }
+
+    // Collect the rest of the batch
+    size_t scanned = 0;
+    size_t count = SerialConsoleGetRxCount();
+    for (;;) {
+        uint8_t *span;
+        size_t len = SerialConsoleReadSpan(&span);
+        for (; scanned < len; scanned++) {
+            if (span[scanned] == '\r' || span[scanned] == '\n') return;
+        }
+        if (len < count) return;  // The batch wraps around the end of the RX buffer. Process the first part now
+        if (count >= CLI_RX_BATCH_SIZE) return;
 
-        // If we are here it means there are characters in the buffer - we re-read from the buffer to get the newly acquired character
-        ret = SerialConsoleReadCharacter((uint8_t *)character);
+        vTaskDelay(pdMS_TO_TICKS(CLI_RX_IDLE_MS));
+        size_t newCount = SerialConsoleGetRxCount();
+        if (newCount == count) return;  // Line idle
+        count = newCount;
     }
 }
 
@@ -315,25 +389,34 @@ BaseType_t CLI_ResetDevice(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const
 /**
  BaseType_t CLI_NeotrellisSetLed( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString )
  * @brief	CLI command to turn on a given LED to a given R,G,B, value
+ * @details	led <key> <R> <G> <B>. The color goes into the LED frame (LedFrame.h) and is shown before the command returns.
  * @param[out] *pcWriteBuffer. Buffer we can use to write the CLI command response to! See other CLI examples on how we use this to write back!
  * @param[in] xWriteBufferLen. How much we can write into the buffer
- * @param[in] *pcCommandString. Buffer that contains the complete input. You will find the additional arguments, if needed. Please see
- https://www.freertos.org/FreeRTOS-Plus/FreeRTOS_Plus_CLI/FreeRTOS_Plus_CLI_Implementing_A_Command.html#Example_Of_Using_FreeRTOS_CLIGetParameter
- Example 3
+ * @param[in] *pcCommandString. Buffer that contains the complete input. The parameters are read with CliGetParameter (see CliDispatch.h)
 
  * @return		Returns pdFALSE if the CLI command finished.
- * @note         Please see https://www.freertos.org/FreeRTOS-Plus/FreeRTOS_Plus_CLI/FreeRTOS_Plus_CLI_Accessing_Command_Line_Parameters.html
-                                 for more information on how to use the FreeRTOS CLI.
-
  */
 BaseType_t CLI_NeotrellisSetLed(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
 {
-    snprintf((char *) pcWriteBuffer, xWriteBufferLen, "Students to fill out!");
-    // Check code SeesawSetLed and SeesawSetLed
-    // How do you get parameters? Checl link in comments!
-    // Check that the input is sanitized: Key between 0-15, RGB between 0-255. Print if there is an error!
-    // return pdFalse to tell the FreeRTOS CLI your call is done and does not need to call again.
-    // This function expects 4 arguments inside pcCommandString: key, R, G, B.
+    static const uint32_t maxValue[4] = {15, 255, 255, 255};  // Key, R, G, B
+    uint32_t value[4];
+
+    // CliProcessCommand already checked that there are exactly 4 parameters
+    for (UBaseType_t i = 0; i < 4; i++) {
+        BaseType_t len = 0;
+        const char *param = CliGetParameter(i + 1, &len);
+        char *end = NULL;
+        value[i] = strtoul(param, &end, 10);
+        if (end != param + len || value[i] > maxValue[i]) {
+            snprintf((char *)pcWriteBuffer, xWriteBufferLen, "Usage: led <key 0-15> <R 0-255> <G 0-255> <B 0-255>\r\n");
+            return pdFALSE;
+        }
+    }
+
+    LedFrameSet((uint8_t)value[0], (uint8_t)value[1], (uint8_t)value[2], (uint8_t)value[3]);
+    if (LedFrameShow() != ERROR_NONE) {
+        snprintf((char *)pcWriteBuffer, xWriteBufferLen, "Could not set LED %lu\r\n", (unsigned long)value[0]);
+    }
     return pdFALSE;
 }
 
@@ -348,9 +431,8 @@ BaseType_t CLI_NeotrellisSetLed(int8_t *pcWriteBuffer, size_t xWriteBufferLen, c
                  The function will print "Buffer Empty" if there is nothing on the button buffer.
  * @param[out] *pcWriteBuffer. Buffer we can use to write the CLI command response to! See other CLI examples on how we use this to write back!
  * @param[in] xWriteBufferLen. How much we can write into the buffer
- * @param[in] *pcCommandString. Buffer that contains the complete input. You will find the additional arguments, if needed. Please see
- https://www.freertos.org/FreeRTOS-Plus/FreeRTOS_Plus_CLI/FreeRTOS_Plus_CLI_Implementing_A_Command.html#Example_Of_Using_FreeRTOS_CLIGetParameter
- Example 3
+ * @param[in] *pcCommandString. Buffer that contains the complete input. Not used. Commands with parameters read them with
+ CliGetParameter (see CliDispatch.h)
 
  * @return		Returns pdFALSE if the CLI command finished.
  * @note         Please see https://www.freertos.org/FreeRTOS-Plus/FreeRTOS_Plus_CLI/FreeRTOS_Plus_CLI_Accessing_Command_Line_Parameters.html
@@ -375,28 +457,25 @@ BaseType_t CLI_NeotrellProcessButtonBuffer(int8_t *pcWriteBuffer, size_t xWriteB
     // Print to pcWriteBuffer in order.
     // If the string is too long to print, print what you can.
     // The function you write will be useful in the future.
+    // All the events are read in one transaction and printed through the output sink, instead of one event per call
     uint8_t buffer[64];
     uint8_t count = SeesawGetKeypadCount();
-    if (count >= 1) {
-        int32_t res = SeesawReadKeypad(buffer, 1);
-        if (res == 0) {
+    if (count > sizeof(buffer)) count = sizeof(buffer);
+    if (count >= 1 && SeesawReadKeypad(buffer, count) == 0) {
+        for (uint8_t i = 0; i < count; i++) {
             uint8_t pos, press;
-            press = buffer[0] & 0x3;
-            pos = buffer[0] >> 2;
+            press = buffer[i] & 0x3;
+            pos = buffer[i] >> 2;
             int num = NEO_TRELLIS_SEESAW_KEY(pos);
             if (press == 0x2) {
-                snprintf((char *) pcWriteBuffer, xWriteBufferLen, "Button #%d is released\r\n", NEO_TRELLIS_SEESAW_KEY(num));
+                CliPrintf("Button #%d is released\r\n", NEO_TRELLIS_SEESAW_KEY(num));
             } else if (press == 0x3) {
-                snprintf((char *) pcWriteBuffer, xWriteBufferLen, "Button #%d is pressed\r\n", NEO_TRELLIS_SEESAW_KEY(num));
+                CliPrintf("Button #%d is pressed\r\n", NEO_TRELLIS_SEESAW_KEY(num));
             }
         }
-		port_pin_set_output_level(PIN_PA02,true);
-        return pdTRUE;
-    } else {
-        pcWriteBuffer = 0;
-		port_pin_set_output_level(PIN_PA02,true);
-        return pdFALSE;
     }
+	port_pin_set_output_level(PIN_PA02,true);
+    return pdFALSE;
 }
 
 /**
@@ -404,9 +483,8 @@ BaseType_t CLI_NeotrellProcessButtonBuffer(int8_t *pcWriteBuffer, size_t xWriteB
  * @brief	Returns distance in mm
  * @param[out] *pcWriteBuffer. Buffer we can use to write the CLI command response to! See other CLI examples on how we use this to write back!
  * @param[in] xWriteBufferLen. How much we can write into the buffer
- * @param[in] *pcCommandString. Buffer that contains the complete input. You will find the additional arguments, if needed. Please see
- https://www.freertos.org/FreeRTOS-Plus/FreeRTOS_Plus_CLI/FreeRTOS_Plus_CLI_Implementing_A_Command.html#Example_Of_Using_FreeRTOS_CLIGetParameter
- Example 3
+ * @param[in] *pcCommandString. Buffer that contains the complete input. Not used. Commands with parameters read them with
+ CliGetParameter (see CliDispatch.h)
 
  * @return		Returns pdFALSE if the CLI command finished.
  * @note         Please see https://www.freertos.org/FreeRTOS-Plus/FreeRTOS_Plus_CLI/FreeRTOS_Plus_CLI_Accessing_Command_Line_Parameters.html
@@ -435,9 +513,8 @@ BaseType_t CLI_DistanceSensorGetDistance(int8_t *pcWriteBuffer, size_t xWriteBuf
  * @brief	Returns dummy game data
  * @param[out] *pcWriteBuffer. Buffer we can use to write the CLI command response to! See other CLI examples on how we use this to write back!
  * @param[in] xWriteBufferLen. How much we can write into the buffer
- * @param[in] *pcCommandString. Buffer that contains the complete input. You will find the additional arguments, if needed. Please see
- https://www.freertos.org/FreeRTOS-Plus/FreeRTOS_Plus_CLI/FreeRTOS_Plus_CLI_Implementing_A_Command.html#Example_Of_Using_FreeRTOS_CLIGetParameter
- Example 3
+ * @param[in] *pcCommandString. Buffer that contains the complete input. Not used. Commands with parameters read them with
+ CliGetParameter (see CliDispatch.h)
 
  * @return		Returns pdFALSE if the CLI command finished.
  * @note         Please see https://www.freertos.org/FreeRTOS-Plus/FreeRTOS_Plus_CLI/FreeRTOS_Plus_CLI_Accessing_Command_Line_Parameters.html
@@ -490,11 +567,10 @@ BaseType_t CLI_i2cScan(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8
 		i2cOled.msgOut = (const uint8_t*) &dataOut[0];
 		i2cOled.lenIn = 1;
 
-            SerialConsoleWriteString("0  1  2  3  4  5  6  7  8  9  a  b  c  d  e  f\r\n");
+            CliWriteString("0  1  2  3  4  5  6  7  8  9  a  b  c  d  e  f\r\n");
             for (int i = 0; i < 128; i += 16)
             {
-				snprintf(bufCli, CLI_MSG_LEN - 1, "%02x: ", i);
-                SerialConsoleWriteString(bufCli);
+                CliPrintf("%02x: ", i);
 
                 for (int j = 0; j < 16; j++)
                 {
@@ -505,18 +581,16 @@ BaseType_t CLI_i2cScan(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8
                     int32_t ret = I2cWriteDataWait(&i2cOled, 100);
                     if (ret == 0)
                     {
-						snprintf(bufCli, CLI_MSG_LEN - 1, "%02x: ", i2cOled.address);
-                        SerialConsoleWriteString(bufCli);
+                        CliPrintf("%02x: ", i2cOled.address);
                     }
                     else
                     {
-                        snprintf(bufCli, CLI_MSG_LEN - 1, "X ");
-						SerialConsoleWriteString(bufCli);
+                        CliWriteString("X ");
                     }
                 }
-                SerialConsoleWriteString( "\r\n");
+                CliWriteString("\r\n");
             }
-            SerialConsoleWriteString( "\r\n");
+            CliWriteString("\r\n");
 			return pdFALSE;
 
 }
@@ -524,7 +598,302 @@ BaseType_t CLI_i2cScan(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8
 BaseType_t CLI_NAU78_GET_WEIGHT( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString ){
 	uint32_t w = 50;
 	w = get_weight();
-	snprintf(pcWriteBuffer,xWriteBufferLen, "The weight is %d \r\n", w);
-	SerialConsoleWriteString(pcWriteBuffer);
+	CliPrintf("The weight is %d \r\n", w);
 	return pdFALSE;
-}
\ No newline at end of file
+}
+
+/**
+ BaseType_t CLI_LogStats( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString )
+ * @brief	Prints how many log messages of each level were dropped because every logger slot was taken
+ * @param[out] *pcWriteBuffer. Buffer we can use to write the CLI command response to
+ * @param[in] xWriteBufferLen. How much we can write into the buffer
+ * @param[in] *pcCommandString. Buffer that contains the complete input. Not used
+ * @return		Returns pdFALSE if the CLI command finished.
+ */
+BaseType_t CLI_LogStats(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+    snprintf((char *)pcWriteBuffer,
+             xWriteBufferLen,
+             "Dropped logs: INFO %lu DEBUG %lu WARNING %lu ERROR %lu FATAL %lu\r\n",
+             (unsigned long)LogGetDropCount(LOG_INFO_LVL),
+             (unsigned long)LogGetDropCount(LOG_DEBUG_LVL),
+             (unsigned long)LogGetDropCount(LOG_WARNING_LVL),
+             (unsigned long)LogGetDropCount(LOG_ERROR_LVL),
+             (unsigned long)LogGetDropCount(LOG_FATAL_LVL));
+    return pdFALSE;
+}
+
+/**
+ BaseType_t CLI_Stream( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString )
+ * @brief	Turns the binary sensor stream and its producers on or off (see SensorStream.h). Without argument, prints its state
+ * @param[out] *pcWriteBuffer. Buffer we can use to write the CLI command response to
+ * @param[in] xWriteBufferLen. How much we can write into the buffer
+ * @param[in] *pcCommandString. Buffer that contains the complete input. Optional argument: on or off
+ * @return		Returns pdFALSE if the CLI command finished.
+ */
+BaseType_t CLI_Stream(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+    BaseType_t paramLen = 0;
+    const char *param = CliGetParameter(1, &paramLen);
+
+    if (param != NULL && paramLen == 2 && strncmp(param, "on", 2) == 0) {
+        if (SensorStreamStart() != ERROR_NONE) {
+            snprintf((char *)pcWriteBuffer, xWriteBufferLen, "Could not start the sensor stream\r\n");
+            return pdFALSE;
+        }
+    } else if (param != NULL && paramLen == 3 && strncmp(param, "off", 3) == 0) {
+        SensorStreamStop();
+    } else if (param != NULL) {
+        snprintf((char *)pcWriteBuffer, xWriteBufferLen, "Usage: stream [on|off]\r\n");
+        return pdFALSE;
+    }
+
+    snprintf((char *)pcWriteBuffer, xWriteBufferLen, "Stream %s, %lu frames dropped\r\n", DataStreamIsEnabled() ? "on" : "off", (unsigned long)DataStreamGetDropCount());
+    return pdFALSE;
+}
+
+/**
+ BaseType_t CLI_Top( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString )
+ * @brief	Prints the CPU share, priority, state and stack high water mark of every task, and the free heap
+ * @details	CPU shares cover the time since the previous sample (previous "top" or MQTT stats publication). Run it twice
+ *			to see the current load. Written through the output sink, one line per task.
+ * @param[out] *pcWriteBuffer. Used by CliPrintf
+ * @param[in] xWriteBufferLen. How much we can write into the buffer
+ * @param[in] *pcCommandString. Buffer that contains the complete input. Not used
+ * @return		Returns pdFALSE if the CLI command finished.
+ */
+BaseType_t CLI_Top(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+    static struct RunTimeStatsReport report;  // Too big for the CLI stack
+    RunTimeStatsSample(&report);
+
+    CliPrintf("Task     Pri St   CPU%%  Stack\r\n");
+    for (uint8_t i = 0; i < report.taskCount; i++) {
+        const struct RunTimeStatsTask *task = &report.tasks[i];
+        CliPrintf("%-8s %3u  %c %3u.%u%% %6u\r\n", task->name, task->priority, task->state, task->cpuPermille / 10, task->cpuPermille % 10, task->stackFree);
+    }
+    if (report.tasksNotListed > 0) {
+        CliPrintf("(%u more tasks)\r\n", report.tasksNotListed);
+    }
+    CliPrintf("Heap: %lu of %lu bytes free. Interval: %lu ms\r\n", (unsigned long)report.heapFree, (unsigned long)report.heapTotal, (unsigned long)(report.intervalUs / 1000));
+    return pdFALSE;
+}
+
+/**
+ static void CliBenchRun(enum eBenchType type, uint32_t count, uint8_t address)
+ * @brief	Runs one benchmark, in the CLI task (I2C) or in the Wi-Fi task (others), and prints its result lines
+ */
+static void CliBenchRun(enum eBenchType type, uint32_t count, uint8_t address)
+{
+    static struct BenchRequest request;  // Used by the Wi-Fi task while the CLI waits
+    static char line[128];              // Result lines are longer than the CLI output buffer
+
+    // A benchmark that timed out may still run in the Wi-Fi task, on this request
+    if (WifiBenchIsBusy()) {
+        CliPrintf("Benchmark %d failed: error %ld\r\n", type, (long)ERROR_BUSY);
+        return;
+    }
+
+    request.type = type;
+    request.count = count;
+    request.address = address;
+    request.resultCount = 0;
+    int32_t error = (type == BENCH_I2C) ? BenchTargetRun(&request) : WifiRunBench(&request);
+
+    for (uint8_t i = 0; error != ERROR_TIMEOUT && i < request.resultCount; i++) {
+        int len = BenchFormatResult(&request.results[i], BENCH_BUILD, line, sizeof(line));
+        if (len > 0) CliWrite(line, ((size_t)len < sizeof(line)) ? (size_t)len : sizeof(line) - 1);
+    }
+    if (error != ERROR_NONE) {
+        CliPrintf("Benchmark %d failed: error %ld\r\n", type, (long)error);
+    }
+}
+
+/**
+ BaseType_t CLI_Bench( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString )
+ * @brief	Runs on-target benchmarks and prints one BENCH line per result (see BenchCore.h)
+ * @details	bench <i2c|spi|sd|mqtt|all> [count] [i2c address, hex]. The default I2C device is the Neotrellis Seesaw.
+ *			Tools/BenchHarness sends these commands and collects the lines.
+ * @param[out] *pcWriteBuffer. Used by CliPrintf
+ * @param[in] xWriteBufferLen. How much we can write into the buffer
+ * @param[in] *pcCommandString. Buffer that contains the complete input
+ * @return		Returns pdFALSE if the CLI command finished.
+ */
+BaseType_t CLI_Bench(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+    BaseType_t len = 0;
+    const char *which = CliGetParameter(1, &len);
+    if (which == NULL) {
+        CliPrintf("Usage: bench <i2c|spi|sd|mqtt|all> [count] [i2c address, hex]\r\n");
+        return pdFALSE;
+    }
+
+    BaseType_t argLen = 0;
+    const char *arg = CliGetParameter(2, &argLen);
+    uint32_t count = (arg != NULL) ? strtoul(arg, NULL, 10) : BENCH_DEFAULT_COUNT;
+    arg = CliGetParameter(3, &argLen);
+    uint8_t address = (arg != NULL) ? (uint8_t)strtoul(arg, NULL, 16) : NEO_TRELLIS_ADDR;
+
+    bool all = (len == 3 && strncmp(which, "all", 3) == 0);
+    bool found = all;
+    if (all || (len == 3 && strncmp(which, "i2c", 3) == 0)) {
+        CliBenchRun(BENCH_I2C, count, address);
+        found = true;
+    }
+    if (all || (len == 3 && strncmp(which, "spi", 3) == 0)) {
+        CliBenchRun(BENCH_SPI, count, address);
+        found = true;
+    }
+    if (all || (len == 2 && strncmp(which, "sd", 2) == 0)) {
+        CliBenchRun(BENCH_SD, count, address);
+        found = true;
+    }
+    if (all || (len == 4 && strncmp(which, "mqtt", 4) == 0)) {
+        CliBenchRun(BENCH_MQTT, count, address);
+        found = true;
+    }
+    if (!found) {
+        CliPrintf("Unknown benchmark\r\n");
+    }
+    return pdFALSE;
+}
+
+/**
+ BaseType_t CLI_I2cSpeed( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString )
+ * @brief	Prints the speed profile of every I2C device and the transfer times measured at that speed
+ * @details	Req is the speed asked by the device driver, Act the speed the SERCOM clock gives. The first line is the default
+ *			profile, used by the devices without their own. Times run from the start of a transfer to its completion interrupt.
+ * @param[out] *pcWriteBuffer. Used by CliPrintf
+ * @param[in] xWriteBufferLen. How much we can write into the buffer
+ * @param[in] *pcCommandString. Buffer that contains the complete input. Not used
+ * @return		Returns pdFALSE if the CLI command finished.
+ */
+BaseType_t CLI_I2cSpeed(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+    static I2C_SpeedProfile profiles[I2C_MAX_SPEED_PROFILES];  // Too big for the CLI stack
+    uint8_t count = I2cGetSpeedProfiles(profiles, I2C_MAX_SPEED_PROFILES);
+
+    CliPrintf("Addr Mode Req kHz Act kHz Transfers    Bytes Avg us Last us  kB/s\r\n");
+    for (uint8_t i = 0; i < count; i++) {
+        const I2C_SpeedProfile *profile = &profiles[i];
+        uint32_t avgUs = (profile->transfers != 0) ? profile->busUs / profile->transfers : 0;
+        uint32_t kBps = (profile->busUs != 0) ? (uint32_t)(((uint64_t)profile->bytes * 1000) / profile->busUs) : 0;
+        const char *mode = profile->fastModePlus ? "Fm+" : ((profile->requestedHz > I2C_DEFAULT_SPEED_HZ) ? "Fm" : "Sm");
+
+        if (i == 0) {
+            CliWriteString("dflt ");
+        } else {
+            CliPrintf("0x%02x ", profile->address);
+        }
+        CliPrintf("%-4s %7lu %7lu %9lu %8lu %6lu %7lu %5lu\r\n",
+                  mode,
+                  (unsigned long)(profile->requestedHz / 1000),
+                  (unsigned long)(profile->actualHz / 1000),
+                  (unsigned long)profile->transfers,
+                  (unsigned long)profile->bytes,
+                  (unsigned long)avgUs,
+                  (unsigned long)profile->lastUs,
+                  (unsigned long)kBps);
+    }
+    return pdFALSE;
+}
+
+/**
+ BaseType_t CLI_I2cBus( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString )
+ * @brief	Prints the state of the I2C bus and the recovery counters of each device
+ * @details	Recoveries are counted against the device of the transfer that found the bus hung. Stuck: recoveries after which a
+ *			line was still low. Failed: transfers failed at once while the bus was down.
+ * @param[out] *pcWriteBuffer. Used by CliPrintf
+ * @param[in] xWriteBufferLen. How much we can write into the buffer
+ * @param[in] *pcCommandString. Buffer that contains the complete input. Not used
+ * @return		Returns pdFALSE if the CLI command finished.
+ */
+BaseType_t CLI_I2cBus(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+    static I2C_RecoveryStats stats[I2C_MAX_RECOVERY_DEVICES];  // Too big for the CLI stack
+    uint8_t count = I2cGetRecoveryStats(stats, I2C_MAX_RECOVERY_DEVICES);
+
+    CliPrintf("Bus: %s\r\n", I2cBusIsDown() ? "down (a line is held low)" : "ok");
+    CliPrintf("Addr Recoveries Stuck Failed Last us\r\n");
+    for (uint8_t i = 0; i < count; i++) {
+        CliPrintf("0x%02x %10u %5u %6u %7lu\r\n",
+                  stats[i].address,
+                  stats[i].recoveries,
+                  stats[i].stuck,
+                  stats[i].fastFailed,
+                  (unsigned long)stats[i].lastUs);
+    }
+    return pdFALSE;
+}
+
+/**
+ BaseType_t CLI_I2cStats( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString )
+ * @brief	Prints the transaction statistics of every I2C device, or clears them with "reset"
+ * @details	Queue: time from the submission of the transactions to their first transfer. Wire: time from the start of the transfers to their completion interrupt.
+ *			Latency runs from the queueing of a transaction to its end, so it includes the queue and the device delay.
+ *			The histogram line lists the bins that are not empty, as <lower bound in us>:<count>.
+ * @param[out] *pcWriteBuffer. Used by CliPrintf
+ * @param[in] xWriteBufferLen. How much we can write into the buffer
+ * @param[in] *pcCommandString. Buffer that contains the complete input. "reset" clears the statistics
+ * @return		Returns pdFALSE if the CLI command finished.
+ */
+BaseType_t CLI_I2cStats(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+    BaseType_t paramLen = 0;
+    const char *param = CliGetParameter(1, &paramLen);
+    I2C_DeviceStats stats;
+
+    if (param != NULL && paramLen == 5 && strncmp(param, "reset", 5) == 0) {
+        I2cResetStats();
+        CliPrintf("I2C statistics cleared\r\n");
+        return pdFALSE;
+    }
+
+    CliPrintf("Addr Transactions Errors    Bytes Queue us  Wire us Avg us Max us\r\n");
+    for (uint8_t i = 0; I2cGetDeviceStats(i, &stats); i++) {
+        uint32_t avgUs = (stats.transactions != 0) ? stats.wireUs / stats.transactions : 0;
+        CliPrintf("0x%02x %12lu %6lu %8lu %8lu %8lu %6lu %6lu\r\n",
+                  stats.address,
+                  (unsigned long)stats.transactions,
+                  (unsigned long)stats.errors,
+                  (unsigned long)stats.bytes,
+                  (unsigned long)stats.queueWaitUs,
+                  (unsigned long)stats.wireUs,
+                  (unsigned long)avgUs,
+                  (unsigned long)stats.maxUs);
+        CliWriteString("     latency us");
+        for (uint8_t bin = 0; bin < I2C_STATS_HISTOGRAM_BINS; bin++) {
+            if (stats.histogram[bin] != 0) {
+                CliPrintf(" %lu:%u", (bin == 0) ? 0UL : (1UL << bin), stats.histogram[bin]);
+            }
+        }
+        CliWriteString("\r\n");
+    }
+    return pdFALSE;
+}
+
+/**
+ BaseType_t CLI_BootTime( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString )
+ * @brief	Prints the startup milestones (see RunTimeStatsMarkBoot): time since the scheduler started and time since the
+ *			previous milestone, in ms. Milestones not reached yet are shown as "-"
+ * @param[out] *pcWriteBuffer. Used by CliPrintf
+ * @param[in] xWriteBufferLen. How much we can write into the buffer
+ * @param[in] *pcCommandString. Buffer that contains the complete input
+ * @return		Returns pdFALSE if the CLI command finished.
+ */
+BaseType_t CLI_BootTime(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString)
+{
+    uint32_t previousUs = 0;
+
+    CliPrintf("Milestone    At ms  Step ms\r\n");
+    for (uint8_t mark = 0; mark < BOOT_MARK_COUNT; mark++) {
+        uint32_t us = RunTimeStatsGetBootMark((enum RunTimeStatsBootMark)mark);
+        if (us == 0) {
+            CliPrintf("%-8s %9s %8s\r\n", RunTimeStatsBootMarkName((enum RunTimeStatsBootMark)mark), "-", "-");
+            continue;
+        }
+        CliPrintf("%-8s %9lu %8lu\r\n", RunTimeStatsBootMarkName((enum RunTimeStatsBootMark)mark), (unsigned long)(us / 1000), (unsigned long)((us - previousUs) / 1000));
+        previousUs = us;
+    }
+    return pdFALSE;
+}
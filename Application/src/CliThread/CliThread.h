@@ -21,6 +21,10 @@
 #define MAX_OUTPUT_LENGTH_CLI   100	//STUDENT FILL
 
 #define CLI_MSG_LEN						16
+#define CLI_RX_IDLE_MS					2	///< Time without a new character after which a partial line is processed
+#define CLI_RX_SLEEP_MS					100	///< Longest sleep while waiting for input. Catches a character that raced the start bit wakeup
+#define CLI_RX_FRAME_US					(2 * 10 * 1000000UL / CONSOLE_BAUDRATE)	///< Two character times. The start bit wakeup comes one character before the DMAC stores it
+#define CLI_RX_BATCH_SIZE				256	///< Process the received characters once this many are waiting, even without a line end. Half the RX buffer
 #define CLI_PC_ESCAPE_CODE_SIZE			4
 #define CLI_PC_MIN_ESCAPE_CODE_SIZE		2
 
@@ -50,4 +54,12 @@ BaseType_t CLI_DistanceSensorGetDistance( int8_t *pcWriteBuffer,size_t xWriteBuf
 BaseType_t CLI_ResetDevice( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString );
 BaseType_t CLI_SendDummyGameData(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
 BaseType_t CLI_i2cScan(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
-BaseType_t CLI_NAU78_GET_WEIGHT( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString );
\ No newline at end of file
+BaseType_t CLI_NAU78_GET_WEIGHT( int8_t *pcWriteBuffer,size_t xWriteBufferLen,const int8_t *pcCommandString );
+BaseType_t CLI_LogStats(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+BaseType_t CLI_Stream(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+BaseType_t CLI_Top(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+BaseType_t CLI_Bench(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+BaseType_t CLI_I2cSpeed(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+BaseType_t CLI_I2cBus(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+BaseType_t CLI_I2cStats(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
+BaseType_t CLI_BootTime(int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString);
\ No newline at end of file
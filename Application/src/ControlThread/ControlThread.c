@@ -72,7 +72,7 @@ void vControlHandlerTask(void *pvParameters)
             case (CONTROL_WAIT_FOR_GAME): {  // Should set the UI to ignore button presses and should wait until there is a message from the server with a new play.
                 struct GameDataPacket gamePacketIn;
                 if (pdPASS == xQueueReceive(xQueueGameBufferIn, &gamePacketIn, 0)) {
-                    LogMessage(LOG_DEBUG_LVL, "Control Thread: Consumed game packet!\r\n");
+                    LOG_DEBUG("Control Thread: Consumed game packet!\r\n");
                     UiOrderShowMoves(&gamePacketIn);
                     controlState = CONTROL_PLAYING_MOVE;
                 }
@@ -85,7 +85,7 @@ void vControlHandlerTask(void *pvParameters)
                 if (UiPlayIsDone() == true) {
                     // Send back local game packet
                     if (pdTRUE != WifiAddGameDataToQueue(UiGetGamePacketOut())) {
-                        LogMessage(LOG_DEBUG_LVL, "Control Thread: Could not send game packet!\r\n");
+                        LOG_DEBUG("Control Thread: Could not send game packet!\r\n");
                     }
                     controlState = CONTROL_WAIT_FOR_GAME;
                 }
@@ -11,9 +11,21 @@
  ******************************************************************************/
 #include "I2cDriver.h"
 
+#include <stdio.h>
+#include <string.h>
+
+#include "RunTimeStats/RunTimeStats.h"
+
 /******************************************************************************
  * Defines
  ******************************************************************************/
+#define I2C_DMA_TX_TRIGGER SERCOM0_DMAC_ID_TX  ///< DMAC trigger of the sensor bus (SERCOM0) data register empty event
+#define I2C_DMA_RX_TRIGGER SERCOM0_DMAC_ID_RX  ///< DMAC trigger of the sensor bus (SERCOM0) byte received event
+#define I2C_DMA_TAIL_US 200                    ///< Longest wait for the last byte of a DMAC transfer, after its callback: 2 byte times at 100 kHz
+#define I2C_DMA_ERROR_POLL_MS 1                ///< Period of the SERCOM error checks while the DMAC moves a transfer
+#define I2C_DMA_STATUS_ERRORS (SERCOM_I2CM_STATUS_BUSERR | SERCOM_I2CM_STATUS_ARBLOST | SERCOM_I2CM_STATUS_LENERR)  ///< Error bits of STATUS, cleared by writing one
+#define I2C_SDA_PIN PIN_PA08                   ///< SDA of the sensor bus (SERCOM0 PAD0), driven as a GPIO during a recovery
+#define I2C_SCL_PIN PIN_PA09                   ///< SCL of the sensor bus (SERCOM0 PAD1), driven as a GPIO during a recovery
 
 /******************************************************************************
  * Variables
@@ -26,10 +38,338 @@ static uint8_t sensorTransmitError = false;                   ///< Flag used to
 struct i2c_master_module i2cSensorBusInstance;
 static I2C_Bus_State I2cSensorBusState;  ///< Structure that defines the I2C Bus used for the sensors.
 
-struct i2c_master_packet sensorPacketWrite;
+static struct i2c_master_packet sensorPacketWrite;   ///< Transfer on the bus. Only the bus manager starts transfers, so one is enough
+static struct i2c_master_packet sensorPacketRead;    ///< Read phase of a combined write-read, started from the write complete interrupt
+static volatile bool sensorCombinedReadPending = false;  ///< Set while the write phase of a combined write-read is on the bus
+
+struct dma_resource i2cDmaTxResource;                   ///< DMAC channel that feeds the SERCOM0 data register on long writes
+struct dma_resource i2cDmaRxResource;                   ///< DMAC channel that empties the SERCOM0 data register on long reads
+COMPILER_ALIGNED(16) DmacDescriptor i2cDmaTxDescriptor;  ///< Transfer descriptor of the write in flight
+COMPILER_ALIGNED(16) DmacDescriptor i2cDmaRxDescriptor;  ///< Transfer descriptor of the read in flight
+static bool i2cDmaConfigured = false;                   ///< The channels are allocated once, even if the driver is initialized again
+static volatile enum i2c_transfer_direction sensorDmaDirection;  ///< Direction of the DMAC transfer in flight, valid while sensorDmaActive
+static volatile bool sensorDmaActive = false;           ///< Set while the DMAC, not the byte interrupts, moves the data
+static volatile bool sensorDmaLenen = false;            ///< The SERCOM ends the DMAC transfer in flight by itself (ADDR.LENEN)
+static uint8_t *volatile sensorDmaTail = NULL;           ///< Last byte of a DMAC read without ADDR.LENEN: the bus manager NACKs it. Else NULL
+
+static uint8_t i2cScratch[I2C_SCRATCH_COUNT][I2C_SCRATCH_SIZE];  ///< Pool of buffers for register writes (register address + data)
+static uint8_t i2cScratchUsed = 0;                                ///< Bit i set while i2cScratch[i] is owned by a caller
+
+static SemaphoreHandle_t i2cDoneSemaphores[I2C_DONE_COUNT];  ///< Completion semaphores (binary), one per transaction in flight
+static uint8_t i2cDoneUsed = 0;                             ///< Bit i set while i2cDoneSemaphores[i] belongs to a submitted transaction
+
+static I2C_SpeedProfile i2cSpeedProfiles[I2C_MAX_SPEED_PROFILES];  ///< [0] is the default profile. Written by I2cSetDeviceSpeed and the bus manager
+static uint8_t i2cSpeedProfileCount = 0;                          ///< Profiles in use, including the default one
+static const I2C_SpeedProfile *i2cSpeedCurrent = NULL;            ///< Profile the SERCOM is configured for
+
+static I2C_RecoveryStats i2cRecoveryStats[I2C_MAX_RECOVERY_DEVICES];  ///< Recovery counters, one entry per device address
+static uint8_t i2cRecoveryStatsCount = 0;                            ///< Entries in use
+static volatile bool i2cBusDown = false;                             ///< A line was still low after the last recovery: transfers fail at once
+static TickType_t i2cBusDownTick = 0;                                ///< Tick of the last recovery, while the bus is down
+
+static I2C_DeviceStats i2cDeviceStats[I2C_STATS_MAX_DEVICES];  ///< Transaction statistics, one entry per device address. Written by the bus manager
+static uint8_t i2cDeviceStatsCount = 0;                         ///< Entries in use
+
+static QueueHandle_t i2cTransactionQueue = NULL;  ///< Transactions waiting for the bus manager (I2C_Transaction *)
+static TaskHandle_t i2cBusTaskHandle = NULL;      ///< Bus manager task
+/// Transfers the bus manager can run for a transaction
+typedef enum eI2cPhase {
+    I2C_PHASE_WRITE = 0,  ///< Write msgOut, STOP
+    I2C_PHASE_READ,       ///< Read msgIn, STOP
+    I2C_PHASE_WRITE_READ, ///< Write msgOut, repeated START, read msgIn, STOP. One completion
+} eI2cPhase;
 /******************************************************************************
  * Forward Declarations
  ******************************************************************************/
+static void I2cSensorsDmaDone(struct dma_resource *const resource);
+static bool I2cUseDma(uint16_t len);
+static void I2cStartDma(uint8_t address, uint8_t *buffer, uint16_t len, enum i2c_transfer_direction direction);
+
+/**
+ * @fn			static void I2cDriverConfigureSensorDma(void)
+ * @brief       Allocates the DMAC channels of the sensor bus, one per direction, triggered by the SERCOM0 data events
+ * @note        Buffer address and length are filled in by I2cStartDma for every transfer
+ */
+static void I2cDriverConfigureSensorDma(void)
+{
+    struct dma_resource_config config_dma;
+    struct dma_descriptor_config config_descriptor;
+
+    if (i2cDmaConfigured) return;
+
+    dma_get_config_defaults(&config_dma);
+    config_dma.peripheral_trigger = I2C_DMA_TX_TRIGGER;
+    config_dma.trigger_action = DMA_TRIGGER_ACTION_BEAT;
+    while (dma_allocate(&i2cDmaTxResource, &config_dma) != STATUS_OK) {
+    }
+
+    dma_descriptor_get_config_defaults(&config_descriptor);
+    config_descriptor.beat_size = DMA_BEAT_SIZE_BYTE;
+    config_descriptor.dst_increment_enable = false;
+    config_descriptor.block_transfer_count = 1;
+    config_descriptor.destination_address = (uint32_t)(uintptr_t)(&i2cSensorBusInstance.hw->I2CM.DATA.reg);
+    dma_descriptor_create(&i2cDmaTxDescriptor, &config_descriptor);
+    dma_add_descriptor(&i2cDmaTxResource, &i2cDmaTxDescriptor);
+    dma_register_callback(&i2cDmaTxResource, I2cSensorsDmaDone, DMA_CALLBACK_TRANSFER_DONE);
+    dma_enable_callback(&i2cDmaTxResource, DMA_CALLBACK_TRANSFER_DONE);
+
+    dma_get_config_defaults(&config_dma);
+    config_dma.peripheral_trigger = I2C_DMA_RX_TRIGGER;
+    config_dma.trigger_action = DMA_TRIGGER_ACTION_BEAT;
+    while (dma_allocate(&i2cDmaRxResource, &config_dma) != STATUS_OK) {
+    }
+
+    dma_descriptor_get_config_defaults(&config_descriptor);
+    config_descriptor.beat_size = DMA_BEAT_SIZE_BYTE;
+    config_descriptor.src_increment_enable = false;
+    config_descriptor.block_transfer_count = 1;
+    config_descriptor.source_address = (uint32_t)(uintptr_t)(&i2cSensorBusInstance.hw->I2CM.DATA.reg);
+    dma_descriptor_create(&i2cDmaRxDescriptor, &config_descriptor);
+    dma_add_descriptor(&i2cDmaRxResource, &i2cDmaRxDescriptor);
+    dma_register_callback(&i2cDmaRxResource, I2cSensorsDmaDone, DMA_CALLBACK_TRANSFER_DONE);
+    dma_enable_callback(&i2cDmaRxResource, DMA_CALLBACK_TRANSFER_DONE);
+
+    i2cDmaConfigured = true;
+}
+
+/**
+ * @fn			static bool I2cUseDma(uint16_t len)
+ * @brief       Returns true if a transfer of len bytes is moved by the DMAC
+ */
+static bool I2cUseDma(uint16_t len)
+{
+    return (len >= I2C_DMA_THRESHOLD);
+}
+
+/**
+ * @fn			static void I2cStartDma(uint8_t address, uint8_t *buffer, uint16_t len, enum i2c_transfer_direction direction)
+ * @brief       Starts a DMAC transfer on the sensor bus
+ * @details     The SERCOM sends the address, then requests one DMAC beat per byte. Up to I2C_DMA_LENEN_MAX bytes, ADDR.LENEN
+ *              makes it end the transfer by itself (NACK on the last byte read, then STOP). Longer transfers run without
+ *              ADDR.LENEN: smart mode ACKs every byte the DMAC reads, and I2cFinishDma ends them (STOP after a write, NACK
+ *              and STOP on the last byte of a read, which the DMAC leaves to it). The byte interrupts stay disabled; the
+ *              DMAC completion callback wakes the bus manager, which also checks the SERCOM errors (see I2cWaitTransfer).
+ *              If the bus is still owned (combined write-read), the address goes out as a repeated START.
+ */
+static void I2cStartDma(uint8_t address, uint8_t *buffer, uint16_t len, enum i2c_transfer_direction direction)
+{
+    SercomI2cm *const i2cModule = &(i2cSensorBusInstance.hw->I2CM);
+    bool lenen = (len <= I2C_DMA_LENEN_MAX);
+    uint16_t beats = (!lenen && I2C_TRANSFER_READ == direction) ? len - 1 : len;
+
+    // With increment enabled, the DMAC expects the address one past the last beat
+    if (I2C_TRANSFER_WRITE == direction) {
+        i2cDmaTxDescriptor.SRCADDR.reg = (uint32_t)(uintptr_t)(buffer + beats);
+        i2cDmaTxDescriptor.BTCNT.reg = beats;
+        dma_start_transfer_job(&i2cDmaTxResource);
+    } else {
+        i2cDmaRxDescriptor.DSTADDR.reg = (uint32_t)(uintptr_t)(buffer + beats);
+        i2cDmaRxDescriptor.BTCNT.reg = beats;
+        dma_start_transfer_job(&i2cDmaRxResource);
+    }
+    sensorDmaDirection = direction;
+    sensorDmaLenen = lenen;
+    sensorDmaTail = (beats != len) ? buffer + beats : NULL;
+    sensorDmaActive = true;
+
+    // A byte interrupt read may have left the NACK action set
+    i2cModule->CTRLB.reg &= ~SERCOM_I2CM_CTRLB_ACKACT;
+    _i2c_master_wait_for_sync(&i2cSensorBusInstance);
+    if (lenen) {
+        i2c_master_dma_set_transfer(&i2cSensorBusInstance, address, (uint8_t)len, direction);
+    } else {
+        i2cModule->ADDR.reg = SERCOM_I2CM_ADDR_ADDR(address << 1) | direction;
+    }
+}
+
+/**
+ * @fn			static bool I2cDmaFailed(void)
+ * @brief       Returns true if the SERCOM stopped the DMAC transfer in flight on an error
+ * @details     The DMAC only reports its last beat, so a transfer the SERCOM gives up on never completes: an address or
+ *              data NACK (MB with RXNACK), a bus error, a lost arbitration or a short transfer (LENERR, INTFLAG.ERROR).
+ */
+static bool I2cDmaFailed(void)
+{
+    SercomI2cm *const i2cModule = &(i2cSensorBusInstance.hw->I2CM);
+
+    if (i2cModule->INTFLAG.reg & SERCOM_I2CM_INTFLAG_ERROR) return true;
+    return (i2cModule->INTFLAG.reg & SERCOM_I2CM_INTFLAG_MB) && (i2cModule->STATUS.reg & SERCOM_I2CM_STATUS_RXNACK);
+}
+
+/**
+ * @fn			static int32_t I2cWaitTransfer(SemaphoreHandle_t semHandle, TickType_t xMaxBlockTime)
+ * @brief       Waits for the completion of the transfer on the bus
+ * @details     The byte interrupts report the errors themselves. While the DMAC moves the data (sensorDmaActive, which the
+ *              write complete interrupt of a combined write-read may set), the SERCOM is also checked every
+ *              I2C_DMA_ERROR_POLL_MS, so a NACK ends the transfer with ERROR_ABORTED instead of a timeout and a bus recovery.
+ * @return      Returns ERROR_NONE, ERROR_ABORTED if the SERCOM stopped a DMAC transfer, or ERROR_TIMEOUT
+ */
+static int32_t I2cWaitTransfer(SemaphoreHandle_t semHandle, TickType_t xMaxBlockTime)
+{
+    TickType_t start = xTaskGetTickCount();
+    TickType_t elapsed = 0;
+
+    for (;;) {
+        TickType_t wait = xMaxBlockTime - elapsed;
+
+        if ((sensorDmaActive || sensorCombinedReadPending) && wait > pdMS_TO_TICKS(I2C_DMA_ERROR_POLL_MS)) {
+            wait = pdMS_TO_TICKS(I2C_DMA_ERROR_POLL_MS);
+        }
+        if (xSemaphoreTake(semHandle, wait) == pdTRUE) return ERROR_NONE;
+        if (sensorDmaActive && I2cDmaFailed()) return ERROR_ABORTED;
+
+        elapsed = xTaskGetTickCount() - start;
+        if (xMaxBlockTime != portMAX_DELAY && elapsed >= xMaxBlockTime) return ERROR_TIMEOUT;
+    }
+}
+
+/**
+ * @fn			static bool I2cWaitFlag(uint8_t flag)
+ * @brief       Polls a SERCOM interrupt flag for at most I2C_DMA_TAIL_US
+ * @return      Returns true if the flag is set
+ */
+static bool I2cWaitFlag(uint8_t flag)
+{
+    SercomI2cm *const i2cModule = &(i2cSensorBusInstance.hw->I2CM);
+    uint32_t start = RunTimeStatsGetCounter();
+
+    while (!(i2cModule->INTFLAG.reg & flag)) {
+        if (RunTimeStatsGetCounter() - start > I2C_DMA_TAIL_US) return false;
+    }
+    return true;
+}
+
+/**
+ * @fn			static int32_t I2cFinishDma(int32_t status)
+ * @brief       Ends the DMAC transfer of the last phase, after its completion callback, an error or a timeout
+ * @details     The write callback fires when the last byte is handed to the SERCOM, so the end of that byte on the wire
+ *              (MB) is polled here, in the bus manager, rather than in the interrupt. Without ADDR.LENEN the STOP is sent
+ *              here too, and the last byte of a read is NACKed and read here. A failed or timed out transfer is aborted,
+ *              the bus released and the error flags cleared, so the next byte interrupt transfer does not see them.
+ * @param[in]   status Result of I2cWaitTransfer
+ * @return      Returns status, or ERROR_ABORTED if the device did not acknowledge the data, or ERROR_TIMEOUT if the last
+ *              byte did not come
+ */
+static int32_t I2cFinishDma(int32_t status)
+{
+    SercomI2cm *const i2cModule = &(i2cSensorBusInstance.hw->I2CM);
+    int32_t error = status;
+
+    if (!sensorDmaActive) return status;
+    sensorDmaActive = false;
+
+    if (ERROR_NONE != status) {
+        dma_abort_job(&i2cDmaTxResource);
+        dma_abort_job(&i2cDmaRxResource);
+        i2c_master_send_stop(&i2cSensorBusInstance);
+        i2cModule->STATUS.reg = I2C_DMA_STATUS_ERRORS;
+        i2cModule->INTFLAG.reg = SERCOM_I2CM_INTFLAG_ERROR | SERCOM_I2CM_INTFLAG_MB | SERCOM_I2CM_INTFLAG_SB;
+        return status;
+    }
+
+    if (I2C_TRANSFER_WRITE == sensorDmaDirection) {
+        if (!I2cWaitFlag(SERCOM_I2CM_INTFLAG_MB)) {
+            error = ERROR_TIMEOUT;
+        } else if (!sensorDmaLenen && !(i2cModule->STATUS.reg & SERCOM_I2CM_STATUS_RXNACK)) {
+            i2c_master_send_stop(&i2cSensorBusInstance);
+        }
+        i2cModule->INTFLAG.reg = SERCOM_I2CM_INTFLAG_MB;
+    } else if (NULL != sensorDmaTail) {
+        // Same end of read as the ASF byte interrupt driver: NACK and STOP, then read the byte
+        if (I2cWaitFlag(SERCOM_I2CM_INTFLAG_SB)) {
+            i2cModule->CTRLB.reg |= SERCOM_I2CM_CTRLB_ACKACT;
+            _i2c_master_wait_for_sync(&i2cSensorBusInstance);
+            i2cModule->CTRLB.reg |= SERCOM_I2CM_CTRLB_CMD(3);
+            _i2c_master_wait_for_sync(&i2cSensorBusInstance);
+            *sensorDmaTail = i2cModule->DATA.reg;
+        } else {
+            error = ERROR_TIMEOUT;
+        }
+        sensorDmaTail = NULL;
+    }
+    if (i2cModule->STATUS.reg & (SERCOM_I2CM_STATUS_RXNACK | SERCOM_I2CM_STATUS_LENERR)) {
+        error = ERROR_ABORTED;
+    }
+    if (ERROR_NONE != error) {
+        if (ERROR_ABORTED == error) i2c_master_send_stop(&i2cSensorBusInstance);
+        i2cModule->STATUS.reg = I2C_DMA_STATUS_ERRORS;
+        i2cModule->INTFLAG.reg = SERCOM_I2CM_INTFLAG_ERROR;
+    }
+    return error;
+}
+
+/**
+ * @fn			static void I2cComputeSpeed(I2C_SpeedProfile *profile, uint32_t speedHz)
+ * @brief       Computes the BAUD and BAUDLOW values of a speed, and the speed they really give
+ * @details     fSCL = fGCLK / (10 + BAUD + BAUDLOW + fGCLK * tRISE), with tHIGH = (BAUD + 5) / fGCLK and
+ *              tLOW = (BAUDLOW + 5) / fGCLK. The SERCOM runs on GCLK generator 0 (48 MHz) and tRISE = 215 ns is 10.3
+ *              clocks. The split of a symmetric BAUD breaks tLOW above 100 kHz (BAUD = 50 gives 1.15 us at 400 kHz),
+ *              so the low time gets at least the minimum of its mode and the high time the rest:
+ *              100 kHz: 230 + 230, 99.9 kHz. 400 kHz: 42 + 58, 398.9 kHz. 1 MHz: 9 + 19, 993 kHz (tHIGH 292 ns).
+ *              Below 90.5 kHz both values are 255.
+ */
+static void I2cComputeSpeed(I2C_SpeedProfile *profile, uint32_t speedHz)
+{
+    uint32_t fgclk = system_gclk_chan_get_hz(SERCOM0_GCLK_ID_CORE);
+    uint32_t riseCycles100 = (uint32_t)(((uint64_t)fgclk * I2C_SDA_SCL_RISE_TIME_NS) / 10000000);  // Rise time in 1/100 SERCOM clocks
+    uint32_t lowMinNs = (speedHz > I2C_FAST_MODE_MAX_HZ) ? I2C_FMP_LOW_MIN_NS : ((speedHz > I2C_DEFAULT_SPEED_HZ) ? I2C_FM_LOW_MIN_NS : I2C_SM_LOW_MIN_NS);
+    int32_t lowMin = (int32_t)(((uint64_t)fgclk * lowMinNs + 999999999) / 1000000000) - 5;
+    int32_t total = (int32_t)(((int64_t)fgclk * 100 - (int64_t)speedHz * (1000 + riseCycles100) + (int64_t)speedHz * 100 - 1) / ((int64_t)speedHz * 100));
+    int32_t low = (total + 1) / 2;
+    int32_t high;
+
+    if (low < lowMin) low = lowMin;
+    if (low > 255) low = 255;
+    if (low < 0) low = 0;
+    high = total - low;
+    if (high > 255) high = 255;
+    if (high < 0) high = 0;
+
+    profile->requestedHz = speedHz;
+    profile->baud = (uint8_t)high;
+    profile->baudLow = (uint8_t)low;
+    profile->fastModePlus = (speedHz > I2C_FAST_MODE_MAX_HZ);
+    profile->actualHz = (uint32_t)(((uint64_t)fgclk * 100) / (1000 + 100 * (uint32_t)(high + low) + riseCycles100));
+}
+
+/**
+ * @fn			static I2C_SpeedProfile *I2cFindSpeedProfile(uint8_t address)
+ * @brief       Returns the speed profile of a device, or the default profile
+ */
+static I2C_SpeedProfile *I2cFindSpeedProfile(uint8_t address)
+{
+    for (uint8_t i = 1; i < i2cSpeedProfileCount; i++) {
+        if (i2cSpeedProfiles[i].address == address) return &i2cSpeedProfiles[i];
+    }
+    return &i2cSpeedProfiles[0];
+}
+
+/**
+ * @fn			static void I2cApplySpeed(const I2C_SpeedProfile *profile)
+ * @brief       Reconfigures the SERCOM for a speed profile, if it is not the current one
+ * @details     BAUD and CTRLA.SPEED can only be written while the SERCOM is disabled. Only called by the bus manager,
+ *              between transfers, so the bus is idle.
+ */
+static void I2cApplySpeed(const I2C_SpeedProfile *profile)
+{
+    SercomI2cm *const i2cModule = &(i2cSensorBusInstance.hw->I2CM);
+
+    if (profile == i2cSpeedCurrent) return;
+    if (i2cSpeedCurrent != NULL && profile->baud == i2cSpeedCurrent->baud && profile->baudLow == i2cSpeedCurrent->baudLow &&
+        profile->fastModePlus == i2cSpeedCurrent->fastModePlus) {
+        i2cSpeedCurrent = profile;
+        return;
+    }
+
+    i2c_master_disable(&i2cSensorBusInstance);
+    _i2c_master_wait_for_sync(&i2cSensorBusInstance);
+    i2cModule->CTRLA.reg = (i2cModule->CTRLA.reg & ~SERCOM_I2CM_CTRLA_SPEED_Msk) |
+                           (profile->fastModePlus ? I2C_MASTER_SPEED_FAST_MODE_PLUS : I2C_MASTER_SPEED_STANDARD_AND_FAST);
+    i2cModule->BAUD.reg = SERCOM_I2CM_BAUD_BAUD(profile->baud) | SERCOM_I2CM_BAUD_BAUDLOW(profile->baudLow);
+    i2c_master_enable(&i2cSensorBusInstance);
+    i2cSpeedCurrent = profile;
+}
+
 static int32_t I2cDriverConfigureSensorBus(void)
 {
     int32_t error = STATUS_OK;
@@ -42,6 +382,11 @@ static int32_t I2cDriverConfigureSensorBus(void)
     config_i2c_master.pinmux_pad1 = PINMUX_PA09C_SERCOM0_PAD1;
     /* Change buffer timeout to something longer */
     config_i2c_master.buffer_timeout = 1000;
+    config_i2c_master.baud_rate = I2C_DEFAULT_SPEED_HZ / 1000;
+    config_i2c_master.sda_scl_rise_time_ns = I2C_SDA_SCL_RISE_TIME_NS;
+    /* A device holding SCL low for 25-35 ms ends the transfer with an error, and a missed STOP frees the bus after 55 us */
+    config_i2c_master.scl_low_timeout = true;
+    config_i2c_master.inactive_timeout = I2C_MASTER_INACTIVE_TIMEOUT_55US;
     /* Initialize and enable device with config. Try three times to initialize */
 
     for (uint8_t i = I2C_INIT_ATTEMPTS; i != 0; i--) {
@@ -58,6 +403,11 @@ static int32_t I2cDriverConfigureSensorBus(void)
 
     i2c_master_enable(&i2cSensorBusInstance);
 
+    // The SERCOM starts at the default speed
+    if (i2cSpeedProfileCount == 0) i2cSpeedProfileCount = 1;
+    I2cComputeSpeed(&i2cSpeedProfiles[0], I2C_DEFAULT_SPEED_HZ);
+    i2cSpeedCurrent = &i2cSpeedProfiles[0];
+
 exit:
     return error;
 }
@@ -76,6 +426,22 @@ exit:
   */
 void I2cSensorsTxComplete(struct i2c_master_module *const module)
 {
+    if (sensorCombinedReadPending) {
+        // Write phase of a combined transfer: we still own the bus, so the read starts with a repeated START.
+        // The task is only woken when the read completes
+        sensorCombinedReadPending = false;
+        if (I2cUseDma(sensorPacketRead.data_length)) {
+            I2cStartDma(sensorPacketRead.address, sensorPacketRead.data, sensorPacketRead.data_length, I2C_TRANSFER_READ);
+            return;
+        }
+        if (STATUS_OK == i2c_master_read_packet_job(module, &sensorPacketRead)) {
+            return;
+        }
+        i2c_master_send_stop(module);
+        I2cSensorsError(module);
+        return;
+    }
+
     I2cSensorBusState.i2cState = I2C_BUS_READY;
     I2cSensorBusState.rxDoneFlag = true;
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
@@ -97,6 +463,7 @@ void I2cSensorsTxComplete(struct i2c_master_module *const module)
   */
 void I2cSensorsRxComplete(struct i2c_master_module *const module)
 {
+    (void)module;
     I2cSensorBusState.i2cState = I2C_BUS_READY;
     I2cSensorBusState.rxDoneFlag = true;
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
@@ -118,6 +485,11 @@ void I2cSensorsRxComplete(struct i2c_master_module *const module)
   */
 void I2cSensorsError(struct i2c_master_module *const module)
 {
+    if (sensorCombinedReadPending) {
+        // The write phase was sent without STOP: release the bus
+        sensorCombinedReadPending = false;
+        i2c_master_send_stop(module);
+    }
     I2cSensorBusState.i2cState = I2C_BUS_READY;
     I2cSensorBusState.txDoneFlag = true;
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
@@ -127,6 +499,17 @@ void I2cSensorsError(struct i2c_master_module *const module)
     portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
+/**
+ * @fn				static void I2cSensorsDmaDone(struct dma_resource *const resource)
+ * @brief			Callback function for when the DMAC has moved all the bytes of a long transfer on the SENSOR bus
+ * @details			Same completion as the byte interrupt driver: wakes the bus manager. See I2cFinishDma for the end of a write.
+ */
+static void I2cSensorsDmaDone(struct dma_resource *const resource)
+{
+    (void)resource;
+    I2cSensorsRxComplete(&i2cSensorBusInstance);
+}
+
 void I2cDriverRegisterSensorBusCallbacks(void)
 {
     /* Register callback function. */
@@ -143,7 +526,8 @@ void I2cDriverRegisterSensorBusCallbacks(void)
 /**
  * @fn			int32_t I2cInitializeDriver(void)
  * @brief       Function call to initialize the I2C driver\
- * @details     This function must be called from an RTOS thread if using RTOS, and must be called before any I2C call
+ * @details     This function must be called from an RTOS thread if using RTOS, and must be called before any I2C call.
+ *              Also starts the bus manager task (vI2cBusTask) that runs every transaction.
  * @note
  */
 int32_t I2cInitializeDriver(void)
@@ -154,17 +538,31 @@ int32_t I2cInitializeDriver(void)
     if (STATUS_OK != error) goto exit;
 
     I2cDriverRegisterSensorBusCallbacks();
+    I2cDriverConfigureSensorDma();
 
-    sensorI2cMutexHandle = xSemaphoreCreateMutex();
+    // The RTOS objects are created once: the driver may be initialized again to reset the bus
+    if (NULL == sensorI2cMutexHandle) sensorI2cMutexHandle = xSemaphoreCreateMutex();
+    if (NULL == sensorI2cSemaphoreHandle) sensorI2cSemaphoreHandle = xSemaphoreCreateBinary();
+    if (NULL == i2cTransactionQueue) i2cTransactionQueue = xQueueCreate(I2C_QUEUE_LENGTH, sizeof(I2C_Transaction *));
 
-    sensorI2cSemaphoreHandle = xSemaphoreCreateBinary();
-    // xSemaphoreGive(sensorI2cSemaphoreHandle);
-
-    if (NULL == sensorI2cMutexHandle || NULL == sensorI2cSemaphoreHandle) {
+    if (NULL == sensorI2cMutexHandle || NULL == sensorI2cSemaphoreHandle || NULL == i2cTransactionQueue) {
         error = STATUS_SUSPEND;  // Could not initialize mutex!
         goto exit;
     }
 
+    for (uint8_t i = 0; i < I2C_DONE_COUNT; i++) {
+        if (NULL == i2cDoneSemaphores[i]) i2cDoneSemaphores[i] = xSemaphoreCreateBinary();
+        if (NULL == i2cDoneSemaphores[i]) {
+            error = STATUS_SUSPEND;
+            goto exit;
+        }
+    }
+
+    if (NULL == i2cBusTaskHandle && xTaskCreate(vI2cBusTask, "I2C Bus", I2C_TASK_SIZE, NULL, I2C_TASK_PRIORITY, &i2cBusTaskHandle) != pdPASS) {
+        error = STATUS_SUSPEND;
+        goto exit;
+    }
+
 exit:
     return error;
 }
@@ -189,6 +587,12 @@ int32_t I2cWriteData(I2C_Data *data)
         goto exit;
     }
 
+    // Long writes: the DMAC feeds the SERCOM
+    if (I2cUseDma(data->lenOut)) {
+        I2cStartDma(data->address, (uint8_t *)data->msgOut, data->lenOut, I2C_TRANSFER_WRITE);
+        goto exit;
+    }
+
     // Prepare to write
     sensorPacketWrite.address = data->address;
     sensorPacketWrite.data = (uint8_t *)data->msgOut;
@@ -221,11 +625,17 @@ int32_t I2cReadData(I2C_Data *data)
     enum status_code hwError;
 
     // Check parameters
-    if (data == NULL || data->msgOut == NULL) {
+    if (data == NULL || data->msgIn == NULL) {
         error = ERR_INVALID_ARG;
         goto exit;
     }
 
+    // Long reads: the DMAC empties the SERCOM
+    if (I2cUseDma(data->lenIn)) {
+        I2cStartDma(data->address, data->msgIn, data->lenIn, I2C_TRANSFER_READ);
+        goto exit;
+    }
+
     // Prepare to read
     sensorPacketWrite.address = data->address;
     sensorPacketWrite.data = data->msgIn;
@@ -244,6 +654,48 @@ exit:
     return error;
 }
 
+/**
+ * @fn    int32_t I2cWriteReadData(I2C_Data *data)
+ * @brief       Function call to write msgOut then read msgIn in one transfer, with a repeated START in between
+ * @details     The write is sent without STOP. Its complete interrupt starts the read (see I2cSensorsTxComplete), so the
+ *              semaphore is given once, when the read is done. For register reads of devices that need no conversion delay.
+ * @param[in]   data Pointer to I2C data structure which has all the information needed to send an I2C message
+ * @return      Returns an error message in case of error. See ErrCodes.h
+ * @note
+ */
+int32_t I2cWriteReadData(I2C_Data *data)
+{
+    int32_t error = ERROR_NONE;
+    enum status_code hwError;
+
+    // Check parameters
+    if (data == NULL || data->msgOut == NULL || data->msgIn == NULL) {
+        error = ERR_INVALID_ARG;
+        goto exit;
+    }
+
+    // Prepare both phases
+    sensorPacketWrite.address = data->address;
+    sensorPacketWrite.data = (uint8_t *)data->msgOut;
+    sensorPacketWrite.data_length = data->lenOut;
+    sensorPacketRead.address = data->address;
+    sensorPacketRead.data = data->msgIn;
+    sensorPacketRead.data_length = data->lenIn;
+
+    // Write, then read from the interrupt
+    sensorCombinedReadPending = true;
+    hwError = i2c_master_write_packet_job_no_stop(&i2cSensorBusInstance, &sensorPacketWrite);
+
+    if (STATUS_OK != hwError) {
+        sensorCombinedReadPending = false;
+        error = ERROR_IO;
+        goto exit;
+    }
+
+exit:
+    return error;
+}
+
 /**
  * @fn			int32_t I2cFreeMutex(eI2cBuses bus)
  * @brief       Frees the mutex of the given I2C bus
@@ -316,142 +768,822 @@ static void I2cSetTaskErrorStatus(uint8_t value)
 }
 
 /**
-  * @fn			int32_t I2cWriteDataWait(I2C_Data *data, const TickType_t delay, const TickType_t xMaxBlockTime)
-  * @brief       This is the main function to use to write data from an I2C device on a given I2C Bus. This function is blocking.
-  * @details     This function writes data from an I2C device, by writing the requested bytes.This function is blocking (bare-metal) or it
-                                 makes the current thread sleep until the I2C bus has finished the transaction (FREERTOS version).
-                                 On FreeRtos, this function gets the mutex for the respective I2C bus.
-  * @param[in]   data Pointer to I2C data structure which has all the information needed to send an I2C message
-  * @param[in]   delay Delay that the I2C device needs to return the response. Can be 0 if the response is ready instantly. It can be
-                                 the delay an I2C device needs to make a measurement.
-  * @param[in]   xMaxBlockTime Maximum time for the thread to wait until the I2C mutex is free.
-  * @return      Returns an error message in case of error.
-  * @note
-  */
-int32_t I2cWriteDataWait(I2C_Data *data, const TickType_t xMaxBlockTime)
+ * @fn			static void I2cWaitUs(uint32_t us)
+ * @brief       Busy waits on the run time stats counter. For the few microseconds of a recovery clock
+ */
+static void I2cWaitUs(uint32_t us)
+{
+    uint32_t start = RunTimeStatsGetCounter();
+    while (RunTimeStatsGetCounter() - start < us) {
+    }
+}
+
+/**
+ * @fn			static void I2cSetLine(uint8_t pin, bool high)
+ * @brief       Drives an I2C line as an open drain GPIO: low, or released to the pull-up
+ */
+static void I2cSetLine(uint8_t pin, bool high)
+{
+    struct port_config config_port_pin;
+
+    port_get_config_defaults(&config_port_pin);
+    if (high) {
+        config_port_pin.direction = PORT_PIN_DIR_INPUT;
+        config_port_pin.input_pull = PORT_PIN_PULL_UP;
+    } else {
+        port_pin_set_output_level(pin, false);
+        config_port_pin.direction = PORT_PIN_DIR_OUTPUT;
+    }
+    port_pin_set_config(pin, &config_port_pin);
+    I2cWaitUs(I2C_RECOVERY_HALF_PERIOD_US);
+}
+
+/**
+ * @fn			static I2C_RecoveryStats *I2cFindRecoveryStats(uint8_t address)
+ * @brief       Returns the recovery counters of a device, added on first use, or NULL if the table is full
+ */
+static I2C_RecoveryStats *I2cFindRecoveryStats(uint8_t address)
+{
+    for (uint8_t i = 0; i < i2cRecoveryStatsCount; i++) {
+        if (i2cRecoveryStats[i].address == address) return &i2cRecoveryStats[i];
+    }
+    if (i2cRecoveryStatsCount >= I2C_MAX_RECOVERY_DEVICES) return NULL;
+
+    I2C_RecoveryStats *stats = &i2cRecoveryStats[i2cRecoveryStatsCount];
+    memset(stats, 0, sizeof(I2C_RecoveryStats));
+    stats->address = address;
+    i2cRecoveryStatsCount++;
+    return stats;
+}
+
+/**
+ * @fn			static I2C_DeviceStats *I2cFindDeviceStats(uint8_t address)
+ * @brief       Returns the transaction statistics of a device, added on first use, or NULL if the table is full
+ */
+static I2C_DeviceStats *I2cFindDeviceStats(uint8_t address)
+{
+    for (uint8_t i = 0; i < i2cDeviceStatsCount; i++) {
+        if (i2cDeviceStats[i].address == address) return &i2cDeviceStats[i];
+    }
+    if (i2cDeviceStatsCount >= I2C_STATS_MAX_DEVICES) return NULL;
+
+    I2C_DeviceStats *stats = &i2cDeviceStats[i2cDeviceStatsCount];
+    memset(stats, 0, sizeof(I2C_DeviceStats));
+    stats->address = address;
+    i2cDeviceStatsCount++;
+    return stats;
+}
+
+/**
+ * @fn			static uint8_t I2cLatencyBin(uint32_t us)
+ * @brief       Returns the histogram bin of a latency: floor(log2(us)), limited to the last bin
+ * @note        The Cortex-M0+ has no CLZ instruction, so a shift loop (at most 15 turns) is as fast as __builtin_clz
+ */
+static uint8_t I2cLatencyBin(uint32_t us)
+{
+    uint8_t bin = 0;
+
+    while (us > 1 && bin < I2C_STATS_HISTOGRAM_BINS - 1) {
+        us >>= 1;
+        bin++;
+    }
+    return bin;
+}
+
+/**
+ * @fn			static bool I2cBusHung(int32_t error)
+ * @brief       Returns true if a failed transfer may have left the bus hung
+ * @details     A timeout (the SERCOM never finished), a lost arbitration, a bus error or an SCL low timeout. A NACK is a
+ *              normal answer of a missing or busy device and leaves the bus free.
+ */
+static bool I2cBusHung(int32_t error)
+{
+    SercomI2cm *const i2cModule = &(i2cSensorBusInstance.hw->I2CM);
+
+    if (ERROR_TIMEOUT == error) return true;
+    if (ERROR_ABORTED != error) return false;
+    return (STATUS_ERR_PACKET_COLLISION == i2cSensorBusInstance.status) ||
+           (i2cModule->STATUS.reg & (SERCOM_I2CM_STATUS_ARBLOST | SERCOM_I2CM_STATUS_BUSERR | SERCOM_I2CM_STATUS_LOWTOUT));
+}
+
+/**
+ * @fn			static bool I2cRecoverBus(uint8_t address)
+ * @brief       Frees a hung bus and starts the SERCOM again from its reset state
+ * @details     The SERCOM is reset (i2c_master_reset) and the pins are taken as GPIOs. A device that was sending a byte
+ *              when the transfer broke holds SDA low: up to I2C_RECOVERY_CLOCKS clocks let it finish the byte and see a
+ *              NACK, then a STOP resets every device. The SERCOM is then configured again, at the default speed.
+ *              If a line is still low, the bus is marked down: transfers fail at once (ERROR_I2C_HANG_RESET) and the
+ *              recovery is tried again after I2C_RECOVERY_RETRY_MS. Bus manager only, with the mutex taken.
+ * @param[in]   address Device of the transfer that found the bus hung, for the counters
+ * @return      Returns true if both lines are high again
+ */
+static bool I2cRecoverBus(uint8_t address)
+{
+    I2C_RecoveryStats *stats = I2cFindRecoveryStats(address);
+    uint32_t start = RunTimeStatsGetCounter();
+    bool released;
+
+    //---1. Stop the DMAC and the SERCOM, and take the pins
+    if (sensorDmaActive) {
+        sensorDmaActive = false;
+        sensorDmaTail = NULL;
+        dma_abort_job(&i2cDmaTxResource);
+        dma_abort_job(&i2cDmaRxResource);
+    }
+    sensorCombinedReadPending = false;
+    i2c_master_reset(&i2cSensorBusInstance);
+    I2cSetLine(I2C_SDA_PIN, true);
+    I2cSetLine(I2C_SCL_PIN, true);
+
+    //---2. Clock until the device releases SDA
+    for (uint8_t i = 0; i < I2C_RECOVERY_CLOCKS && !port_pin_get_input_level(I2C_SDA_PIN); i++) {
+        I2cSetLine(I2C_SCL_PIN, false);
+        I2cSetLine(I2C_SCL_PIN, true);
+    }
+
+    //---3. STOP: SDA rises while SCL is high
+    I2cSetLine(I2C_SCL_PIN, false);
+    I2cSetLine(I2C_SDA_PIN, false);
+    I2cSetLine(I2C_SCL_PIN, true);
+    I2cSetLine(I2C_SDA_PIN, true);
+    released = port_pin_get_input_level(I2C_SDA_PIN) && port_pin_get_input_level(I2C_SCL_PIN);
+
+    //---4. Give the pins back to the SERCOM. i2c_master_init clears the callbacks
+    if (STATUS_OK != I2cDriverConfigureSensorBus()) released = false;
+    I2cDriverRegisterSensorBusCallbacks();
+    xSemaphoreTake(sensorI2cSemaphoreHandle, 0);  // Completion of the broken transfer, if it came late
+    I2cSetTaskErrorStatus(false);
+
+    i2cBusDown = !released;
+    i2cBusDownTick = xTaskGetTickCount();
+    if (NULL != stats) {
+        stats->recoveries++;
+        if (!released) stats->stuck++;
+        stats->lastUs = RunTimeStatsGetCounter() - start;
+    }
+    return released;
+}
+
+/**
+ * @fn			static int32_t I2cRunPhase(I2C_Data *data, eI2cPhase phase, const TickType_t xMaxBlockTime, const uint32_t *submitUs)
+ * @brief       Runs one transfer of a transaction on the bus and waits for its interrupt
+ * @details     Only called by the bus manager. The mutex is still taken for each phase, for code that uses
+ *              I2cWriteData / I2cReadData directly. A transfer that leaves the bus hung is followed by a recovery
+ *              (I2cRecoverBus) and returns ERROR_I2C_HANG_RESET. While the bus is down, returns ERROR_I2C_HANG_RESET
+ *              at once, so the queued transactions fail in turn without waiting for the bus.
+ * @param[in]   data Address and buffers
+ * @param[in]   phase Write, read, or write then read with a repeated START
+ * @param[in]   xMaxBlockTime Maximum time to wait for the end of the transfer
+ * @param[in]   submitUs Queueing time of the transaction if this is its first transfer, else NULL. Adds the queue wait to the stats
+ * @return      Returns an error message in case of error. See ErrCodes.h
+ */
+static int32_t I2cRunPhase(I2C_Data *data, eI2cPhase phase, const TickType_t xMaxBlockTime, const uint32_t *submitUs)
 {
     int32_t error = ERROR_NONE;
     SemaphoreHandle_t semHandle = NULL;
+    I2C_SpeedProfile *profile = I2cFindSpeedProfile(data->address);
+    I2C_DeviceStats *stats = I2cFindDeviceStats(data->address);
+    uint32_t start = RunTimeStatsGetCounter();
 
-    //---0. Get Mutex
-    error = I2cGetMutex(WAIT_I2C_LINE_MS);
-    if (ERROR_NONE != error) goto exit;
+    if (NULL != stats && NULL != submitUs) stats->queueWaitUs += start - *submitUs;
 
-    //---1. Get Semaphore Handle
-    error = I2cGetSemaphoreHandle(&semHandle);
-    if (ERROR_NONE != error) goto exit;
+    //---0. Fail at once while the bus is down, until the recovery is due again
+    if (i2cBusDown && (xTaskGetTickCount() - i2cBusDownTick) < pdMS_TO_TICKS(I2C_RECOVERY_RETRY_MS)) {
+        I2C_RecoveryStats *stats = I2cFindRecoveryStats(data->address);
+        if (NULL != stats) stats->fastFailed++;
+        error = ERROR_I2C_HANG_RESET;
+        goto exit;
+    }
 
-    //---2. Initiate sending data
+    //---1. Get Mutex
+    error = I2cGetMutex(WAIT_I2C_LINE_MS);
+    if (ERROR_NONE != error) goto exit;
 
-    error = I2cWriteData(data);
-    if (ERROR_NONE != error) {
+    if (i2cBusDown && !I2cRecoverBus(data->address)) {
+        error = ERROR_I2C_HANG_RESET;
         goto exitError0;
     }
 
-    //---2. Wait for binary semaphore to tell us that we are done!
-    if (xSemaphoreTake(semHandle, xMaxBlockTime) == pdTRUE) {
-        /* The transmission ended as expected. We now delay until the I2C sensor is finished */
+    //---2. Get Semaphore Handle
+    error = I2cGetSemaphoreHandle(&semHandle);
+    if (ERROR_NONE != error) goto exitError0;
+
+    //---3. Initiate the transfer, at the speed of the device
+    I2cApplySpeed(profile);
+    start = RunTimeStatsGetCounter();
+    switch (phase) {
+        case I2C_PHASE_READ:
+            error = I2cReadData(data);
+            break;
+        case I2C_PHASE_WRITE_READ:
+            error = I2cWriteReadData(data);
+            break;
+        default:
+            error = I2cWriteData(data);
+            break;
+    }
+    if (ERROR_NONE != error) goto exitError0;
+
+    //---4. Wait for binary semaphore to tell us that we are done!
+    error = I2cWaitTransfer(semHandle, xMaxBlockTime);
+    if (ERROR_NONE == error) {
+        error = I2cFinishDma(error);
         if (I2cGetTaskErrorStatus()) {
             I2cSetTaskErrorStatus(false);
-            if (error != ERROR_NONE) {
-                error = ERROR_I2C_HANG_RESET;
-            } else {
-                error = ERROR_ABORTED;
-            }
-            goto exitError0;
+            error = ERROR_ABORTED;
         }
     } else {
-        /* The call to ulTaskNotifyTake() timed out. */
-        error = ERR_TIMEOUT;
-        goto exitError0;
+        sensorCombinedReadPending = false;
+        error = I2cFinishDma(error);
     }
 
-    //---8. Release Mutex
-    error |= I2cFreeMutex();
-// xSemaphoreGive(semHandle);
-exit:
-    return error;
+    profile->lastUs = RunTimeStatsGetCounter() - start;
+    profile->busUs += profile->lastUs;
+    profile->transfers++;
+    if (NULL != stats) stats->wireUs += profile->lastUs;
+    profile->bytes += ((phase != I2C_PHASE_READ) ? data->lenOut : 0) + ((phase != I2C_PHASE_WRITE) ? data->lenIn : 0);
+
+    //---5. Free the bus before the next transfer if this one left it hung
+    if (I2cBusHung(error)) {
+        I2cRecoverBus(data->address);
+        error = ERROR_I2C_HANG_RESET;
+    }
 
 exitError0:
-    error |= I2cFreeMutex();
-    // xSemaphoreGive(semHandle);
+    //---6. Release Mutex
+    I2cFreeMutex();
+exit:
     return error;
 }
 
+/**
+ * @fn			static void I2cCompleteTransaction(I2C_Transaction *transaction, int32_t status)
+ * @brief       Hands a finished transaction back to its owner
+ * @note        The owner may reuse the transaction as soon as its state is I2C_TRANSACTION_DONE, so it is not touched afterwards
+ */
+static void I2cCompleteTransaction(I2C_Transaction *transaction, int32_t status)
+{
+    SemaphoreHandle_t done = transaction->done;
+    I2C_DeviceStats *stats = I2cFindDeviceStats(transaction->data.address);
+
+    if (NULL != stats) {
+        uint32_t latencyUs = RunTimeStatsGetCounter() - transaction->submitUs;
+        uint16_t *bin = &stats->histogram[I2cLatencyBin(latencyUs)];
+
+        stats->transactions++;
+        if (ERROR_NONE != status) {
+            stats->errors++;
+        } else {
+            stats->bytes += transaction->data.lenOut + transaction->data.lenIn;
+        }
+        if (latencyUs > stats->maxUs) stats->maxUs = latencyUs;
+        if (*bin != UINT16_MAX) (*bin)++;
+    }
+
+    transaction->status = status;
+    transaction->state = I2C_TRANSACTION_DONE;
+    if (NULL != done) {
+        xSemaphoreGive(done);
+    }
+}
+
+/**
+ * @fn			static bool I2cStartTransaction(I2C_Transaction *transaction)
+ * @brief       Runs the write phase of a transaction, and its read phase if the device needs no delay
+ * @details     Without a delay, a write and a read are one combined transfer (repeated START), so one wakeup instead of two.
+ * @return      Returns true if the transaction is finished, false if it now waits for its delay (I2C_TRANSACTION_DELAY)
+ */
+static bool I2cStartTransaction(I2C_Transaction *transaction)
+{
+    I2C_Data *data = &transaction->data;
+    bool write = (data->msgOut != NULL && data->lenOut != 0);
+    bool read = (data->msgIn != NULL && data->lenIn != 0);
+    int32_t error = ERROR_NONE;
+
+    if (write && read && transaction->delay == 0) {
+        I2cCompleteTransaction(transaction, I2cRunPhase(data, I2C_PHASE_WRITE_READ, transaction->xMaxBlockTime, &transaction->submitUs));
+        return true;
+    }
+    if (write) {
+        error = I2cRunPhase(data, I2C_PHASE_WRITE, transaction->xMaxBlockTime, &transaction->submitUs);
+    }
+    if (ERROR_NONE != error || !read) {
+        I2cCompleteTransaction(transaction, error);
+        return true;
+    }
+    if (transaction->delay != 0) {
+        transaction->writeTick = xTaskGetTickCount();
+        transaction->state = I2C_TRANSACTION_DELAY;
+        return false;
+    }
+    I2cCompleteTransaction(transaction, I2cRunPhase(data, I2C_PHASE_READ, transaction->xMaxBlockTime, write ? NULL : &transaction->submitUs));
+    return true;
+}
+
+/**
+ * @fn			static bool I2cAddressIsWaiting(I2C_Transaction *const *pending, uint8_t address)
+ * @brief       Returns true if a transaction to the address is waiting for its device. The device must not be addressed until it is read
+ */
+static bool I2cAddressIsWaiting(I2C_Transaction *const *pending, uint8_t address)
+{
+    for (uint8_t i = 0; i < I2C_MAX_PENDING; i++) {
+        if (pending[i] != NULL && pending[i]->state == I2C_TRANSACTION_DELAY && pending[i]->data.address == address) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @fn			void vI2cBusTask(void *pvParameters)
+ * @brief       Bus manager: the only task that starts transfers on the sensor bus
+ * @details     Takes the transactions from the queue in order. When a device needs time between the write and the read
+ *              (e.g. the NAU7802 conversion), its transaction is parked and the bus serves the other devices until the
+ *              delay is over. Transactions to a device that is waiting are held back until that device has been read.
+ * @param[in]   pvParameters Unused
+ */
+void vI2cBusTask(void *pvParameters)
+{
+    (void)pvParameters;
+    I2C_Transaction *pending[I2C_MAX_PENDING] = {NULL};  ///< Transactions taken from the queue and not done yet
+
+    for (;;) {
+        TickType_t wait = portMAX_DELAY;
+        bool full = true;
+
+        //---1. Read the devices whose delay is over, then start the held back transactions that are now free to go
+        for (uint8_t i = 0; i < I2C_MAX_PENDING; i++) {
+            I2C_Transaction *transaction = pending[i];
+            if (transaction == NULL || transaction->state != I2C_TRANSACTION_DELAY) continue;
+
+            TickType_t elapsed = xTaskGetTickCount() - transaction->writeTick;
+            if (elapsed >= transaction->delay) {
+                I2cCompleteTransaction(transaction, I2cRunPhase(&transaction->data, I2C_PHASE_READ, transaction->xMaxBlockTime, NULL));
+                pending[i] = NULL;
+            }
+        }
+        for (uint8_t i = 0; i < I2C_MAX_PENDING; i++) {
+            I2C_Transaction *transaction = pending[i];
+            if (transaction == NULL || transaction->state != I2C_TRANSACTION_QUEUED) continue;
+            if (!I2cAddressIsWaiting(pending, transaction->data.address) && I2cStartTransaction(transaction)) {
+                pending[i] = NULL;
+            }
+        }
+
+        //---2. Sleep until a new transaction comes or the next delay is over
+        for (uint8_t i = 0; i < I2C_MAX_PENDING; i++) {
+            I2C_Transaction *transaction = pending[i];
+            if (transaction == NULL) {
+                full = false;
+            } else if (transaction->state == I2C_TRANSACTION_DELAY) {
+                TickType_t elapsed = xTaskGetTickCount() - transaction->writeTick;
+                TickType_t left = (elapsed < transaction->delay) ? transaction->delay - elapsed : 0;
+                if (left < wait) wait = left;
+            }
+        }
+        if (full) {
+            // Nowhere to put a new transaction: only the parked ones can make progress
+            vTaskDelay(wait == portMAX_DELAY ? 1 : wait);
+            continue;
+        }
+
+        I2C_Transaction *transaction = NULL;
+        if (xQueueReceive(i2cTransactionQueue, &transaction, wait) != pdTRUE) continue;
+
+        if (I2cAddressIsWaiting(pending, transaction->data.address) || !I2cStartTransaction(transaction)) {
+            for (uint8_t i = 0; i < I2C_MAX_PENDING; i++) {
+                if (pending[i] == NULL) {
+                    pending[i] = transaction;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @fn			void I2cTransactionInit(I2C_Transaction *transaction, uint8_t address, const uint8_t *msgOut, uint16_t lenOut, uint8_t *msgIn, uint16_t lenIn, TickType_t delay, TickType_t xMaxBlockTime)
+ * @brief       Fills a caller-owned transaction
+ * @details     Each task describes its own transactions (on its stack or in its own structures), so several
+ *              transactions can be prepared and queued at the same time. The buffers belong to the caller as well.
+ * @param[out]  transaction Transaction to fill
+ * @param[in]   address 7-bit device address
+ * @param[in]   msgOut Bytes to write, or NULL
+ * @param[in]   lenOut Number of bytes to write
+ * @param[out]  msgIn Buffer for the bytes read, or NULL
+ * @param[in]   lenIn Number of bytes to read
+ * @param[in]   delay Time the device needs between the write and the read
+ * @param[in]   xMaxBlockTime Longest time for each phase on the bus
+ */
+void I2cTransactionInit(I2C_Transaction *transaction,
+                        uint8_t address,
+                        const uint8_t *msgOut,
+                        uint16_t lenOut,
+                        uint8_t *msgIn,
+                        uint16_t lenIn,
+                        TickType_t delay,
+                        TickType_t xMaxBlockTime)
+{
+    transaction->data.address = address;
+    transaction->data.msgOut = msgOut;
+    transaction->data.lenOut = lenOut;
+    transaction->data.msgIn = msgIn;
+    transaction->data.lenIn = lenIn;
+    transaction->delay = delay;
+    transaction->xMaxBlockTime = xMaxBlockTime;
+    transaction->done = NULL;
+    transaction->state = I2C_TRANSACTION_DONE;
+    transaction->status = ERROR_NONE;
+}
+
+/**
+ * @fn			static SemaphoreHandle_t I2cDoneGet(TickType_t waitTime)
+ * @brief       Takes a completion semaphore from the pool, for a transaction about to be submitted
+ * @param[in]   waitTime Maximum time to wait for a free one
+ * @return      Returns the semaphore (empty), or NULL if none became free in time. Give it back with I2cDoneFree
+ */
+static SemaphoreHandle_t I2cDoneGet(TickType_t waitTime)
+{
+    TickType_t start = xTaskGetTickCount();
+
+    for (;;) {
+        taskENTER_CRITICAL();
+        for (uint8_t i = 0; i < I2C_DONE_COUNT; i++) {
+            if (!(i2cDoneUsed & (1 << i))) {
+                i2cDoneUsed |= (1 << i);
+                taskEXIT_CRITICAL();
+                return i2cDoneSemaphores[i];
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        if (xTaskGetTickCount() - start >= waitTime) return NULL;
+        vTaskDelay(1);
+    }
+}
+
+/**
+ * @fn			static void I2cDoneFree(SemaphoreHandle_t done)
+ * @brief       Gives back a completion semaphore of I2cDoneGet. It must be empty: not given, or already taken
+ */
+static void I2cDoneFree(SemaphoreHandle_t done)
+{
+    for (uint8_t i = 0; i < I2C_DONE_COUNT; i++) {
+        if (done == i2cDoneSemaphores[i]) {
+            taskENTER_CRITICAL();
+            i2cDoneUsed &= ~(1 << i);
+            taskEXIT_CRITICAL();
+        }
+    }
+}
+
+/**
+ * @fn			int32_t I2cSubmitTransaction(I2C_Transaction *transaction, TickType_t waitTime)
+ * @brief       Queues a transaction for the bus manager and returns without waiting for the bus
+ * @details     Fill data, delay and xMaxBlockTime first (I2cTransactionInit). Completion is signalled by the state
+ *              (I2C_TRANSACTION_DONE) and by a completion semaphore from the driver pool, given once by the bus
+ *              manager. The task notifications of the caller are left alone. Every submitted transaction must be
+ *              waited for with I2cWaitTransaction, which takes the semaphore and returns it to the pool.
+ * @param[in,out]   transaction Transaction to run. Must stay valid until done
+ * @param[in]   waitTime Maximum time to wait for a completion semaphore, then for room in the queue
+ * @return      Returns ERROR_NONE if queued, ERROR_NO_RESOURCE if no completion semaphore was free, ERROR_BUSY if the queue stayed full
+ */
+int32_t I2cSubmitTransaction(I2C_Transaction *transaction, TickType_t waitTime)
+{
+    if (transaction == NULL || (transaction->data.msgOut == NULL && transaction->data.msgIn == NULL)) {
+        return ERROR_INVALID_ARG;
+    }
+    if (i2cTransactionQueue == NULL) {
+        return ERROR_NOT_INITIALIZED;
+    }
+
+    transaction->done = I2cDoneGet(waitTime);
+    if (transaction->done == NULL) {
+        return ERROR_NO_RESOURCE;
+    }
+
+    transaction->state = I2C_TRANSACTION_QUEUED;
+    transaction->status = ERROR_NONE;
+    transaction->submitUs = RunTimeStatsGetCounter();
+    if (xQueueSend(i2cTransactionQueue, &transaction, waitTime) != pdTRUE) {
+        I2cDoneFree(transaction->done);
+        transaction->done = NULL;
+        transaction->state = I2C_TRANSACTION_DONE;
+        return ERROR_BUSY;
+    }
+    return ERROR_NONE;
+}
+
+/**
+ * @fn			int32_t I2cWaitTransaction(I2C_Transaction *transaction)
+ * @brief       Sleeps until a submitted transaction is done and returns its status
+ * @note        Takes the completion semaphore, which the bus manager gives exactly once per transaction, so nothing is left
+ *              pending for the next wait, even when the transaction finished before this call. Every phase is bounded
+ *              by xMaxBlockTime, so this returns.
+ */
+int32_t I2cWaitTransaction(I2C_Transaction *transaction)
+{
+    if (transaction->done == NULL) return transaction->status;  // Not submitted
+
+    xSemaphoreTake(transaction->done, portMAX_DELAY);
+    I2cDoneFree(transaction->done);
+    transaction->done = NULL;
+    return transaction->status;
+}
+
+/**
+  * @fn			int32_t I2cWriteDataWait(I2C_Data *data, const TickType_t xMaxBlockTime)
+  * @brief       This is the main function to use to write data from an I2C device on a given I2C Bus. This function is blocking.
+  * @details     This function writes data from an I2C device, by writing the requested bytes. It queues the transaction for the bus manager
+                                 and makes the current thread sleep until the I2C bus has finished the transaction.
+  * @param[in]   data Pointer to I2C data structure which has all the information needed to send an I2C message
+  * @param[in]   xMaxBlockTime Maximum time for the thread to wait until the transfer is done.
+  * @return      Returns an error message in case of error.
+  * @note
+  */
+int32_t I2cWriteDataWait(I2C_Data *data, const TickType_t xMaxBlockTime)
+{
+    I2C_Transaction transaction;
+    int32_t error = ERROR_NONE;
+
+    if (data == NULL || data->msgOut == NULL) return ERROR_INVALID_ARG;
+
+    I2cTransactionInit(&transaction, data->address, data->msgOut, data->lenOut, NULL, 0, 0, xMaxBlockTime);
+
+    error = I2cSubmitTransaction(&transaction, WAIT_I2C_LINE_MS);
+    if (ERROR_NONE != error) return error;
+
+    return I2cWaitTransaction(&transaction);
+}
+
 /**
   * @fn			int32_t I2cReadDataWait(I2C_Data *data, const TickType_t delay, const TickType_t xMaxBlockTime)
   * @brief       This is the main function to use to read data from an I2C device on a given I2C Bus. This function is blocking.
-  * @details     This function reads data from an I2C device, by first writing to the address (I2C device address + register) and then reading the requested bytes. This
-                                 function is blocking (bare-metal) or it makes the current thread sleep until the I2C bus has finished the transaction (FREERTOS version).
-                                 On FreeRtos, this function gets the mutex for the respective I2C bus.
+  * @details     This function reads data from an I2C device, by first writing to the address (I2C device address + register) and then reading the requested bytes.
+                                 It queues the transaction for the bus manager and makes the current thread sleep until it is done. During the delay
+                                 the bus is free for other devices.
   * @param[in]   data Pointer to I2C data structure which has all the information needed to send an I2C message
   * @param[in]   delay Delay that the I2C device needs to return the response. Can be 0 if the response is ready instantly. It can be the delay an I2C device needs to make a measurement.
-  * @param[in]   xMaxBlockTime Maximum time for the thread to wait until the I2C mutex is free.
+  * @param[in]   xMaxBlockTime Maximum time for the thread to wait until each transfer is done.
   * @return      Returns an error message in case of error. See ErrCodes.h
-  * @note        THIS IS THE FREERTOS VERSION! DO NOT Declare #define USE_FREERTOS if you wish to use the baremetal version!
+  * @note
   */
 int32_t I2cReadDataWait(I2C_Data *data, const TickType_t delay, const TickType_t xMaxBlockTime)
 {
+    I2C_Transaction transaction;
     int32_t error = ERROR_NONE;
-    SemaphoreHandle_t semHandle = NULL;
 
-    //---0. Get Mutex
-    error = I2cGetMutex(WAIT_I2C_LINE_MS);
-    if (ERROR_NONE != error) goto exit;
+    if (data == NULL || data->msgOut == NULL || data->msgIn == NULL) return ERROR_INVALID_ARG;
 
-    //---1. Get Semaphore Handle
-    error = I2cGetSemaphoreHandle(&semHandle);
-    if (ERROR_NONE != error) goto exit;
+    I2cTransactionInit(&transaction, data->address, data->msgOut, data->lenOut, data->msgIn, data->lenIn, delay, xMaxBlockTime);
 
-    //---2. Initiate sending data
+    error = I2cSubmitTransaction(&transaction, WAIT_I2C_LINE_MS);
+    if (ERROR_NONE != error) return error;
 
-    error = I2cWriteData(data);
-    if (ERROR_NONE != error) {
-        goto exitError0;
-    }
+    return I2cWaitTransaction(&transaction);
+}
 
-    //---2. Wait for binary semaphore to tell us that we are done!
-    if (xSemaphoreTake(semHandle, xMaxBlockTime) == pdTRUE) {
-        /* The transmission ended as expected. We now delay until the I2C sensor is finished */
-        if (I2cGetTaskErrorStatus()) {
-            I2cSetTaskErrorStatus(false);
-            error = ERROR_ABORTED;
-            goto exitError0;
+/**
+ * @fn			uint8_t *I2cScratchGet(TickType_t waitTime)
+ * @brief       Takes a buffer of I2C_SCRATCH_SIZE bytes from the pool, to build a register write
+ * @param[in]   waitTime Maximum time to wait for a buffer
+ * @return      Returns the buffer, or NULL if none became free in time. Give it back with I2cScratchFree
+ */
+uint8_t *I2cScratchGet(TickType_t waitTime)
+{
+    TickType_t start = xTaskGetTickCount();
+
+    for (;;) {
+        taskENTER_CRITICAL();
+        for (uint8_t i = 0; i < I2C_SCRATCH_COUNT; i++) {
+            if (!(i2cScratchUsed & (1 << i))) {
+                i2cScratchUsed |= (1 << i);
+                taskEXIT_CRITICAL();
+                return i2cScratch[i];
+            }
         }
-        vTaskDelay(delay);
-    } else {
-        /* The call to ulTaskNotifyTake() timed out. */
-        error = ERR_TIMEOUT;
-        goto exitError0;
-    }
+        taskEXIT_CRITICAL();
 
-    //---6. Initiate Read data
-    error = I2cReadData(data);
-    if (ERROR_NONE != error) {
-        goto exitError0;
+        if (xTaskGetTickCount() - start >= waitTime) return NULL;
+        vTaskDelay(1);
     }
-    //---7. Wait for notification
-    if (xSemaphoreTake(semHandle, xMaxBlockTime) == pdTRUE) {
-        /* The transmission ended as expected. We now delay until the I2C sensor is finished */
-        if (I2cGetTaskErrorStatus()) {
-            I2cSetTaskErrorStatus(false);
-            error = ERROR_ABORTED;
-            goto exitError0;
+}
+
+/**
+ * @fn			void I2cScratchFree(uint8_t *scratch)
+ * @brief       Gives back a buffer of I2cScratchGet. The transaction that used it must be done
+ */
+void I2cScratchFree(uint8_t *scratch)
+{
+    for (uint8_t i = 0; i < I2C_SCRATCH_COUNT; i++) {
+        if (scratch == i2cScratch[i]) {
+            taskENTER_CRITICAL();
+            i2cScratchUsed &= ~(1 << i);
+            taskEXIT_CRITICAL();
         }
-    } else {
-        /* The call to ulTaskNotifyTake() timed out. */
-        error = ERR_TIMEOUT;
-        goto exitError0;
     }
+}
 
-    //---8. Release Mutex
-    error = I2cFreeMutex();
-// xSemaphoreGive(semHandle);
-exit:
-    return error;
+/**
+ * @fn			int32_t I2cReadRegister(uint8_t address, const uint8_t *reg, uint8_t regLen, uint8_t *buffer, uint16_t len, TickType_t delay, TickType_t xMaxBlockTime)
+ * @brief       Reads len bytes from a device register. Blocking, reentrant
+ * @param[in]   address 7-bit device address
+ * @param[in]   reg Register address as sent on the bus (1 byte for most devices, base + function for the Seesaw)
+ * @param[in]   regLen Length of reg
+ * @param[out]  buffer Bytes read
+ * @param[in]   len Number of bytes to read
+ * @param[in]   delay Time the device needs between the register write and the read. 0 for a repeated START read
+ * @param[in]   xMaxBlockTime Longest time for each phase on the bus
+ * @return      Returns an error message in case of error. See ErrCodes.h
+ */
+int32_t I2cReadRegister(uint8_t address, const uint8_t *reg, uint8_t regLen, uint8_t *buffer, uint16_t len, TickType_t delay, TickType_t xMaxBlockTime)
+{
+    I2C_Transaction transaction;
+    int32_t error = ERROR_NONE;
 
-exitError0:
-    error = I2cFreeMutex();
-    // xSemaphoreGive(semHandle);
+    I2cTransactionInit(&transaction, address, reg, regLen, buffer, len, delay, xMaxBlockTime);
+    error = I2cSubmitTransaction(&transaction, WAIT_I2C_LINE_MS);
+    if (ERROR_NONE != error) return error;
+
+    return I2cWaitTransaction(&transaction);
+}
+
+/**
+ * @fn			int32_t I2cWriteRegister(uint8_t address, const uint8_t *reg, uint8_t regLen, const uint8_t *data, uint16_t len, TickType_t xMaxBlockTime)
+ * @brief       Writes len bytes to a device register. Blocking, reentrant
+ * @details     Register address and data must be one write on the bus, so they are copied into a pool buffer.
+ * @param[in]   address 7-bit device address
+ * @param[in]   reg Register address as sent on the bus
+ * @param[in]   regLen Length of reg
+ * @param[in]   data Bytes to write
+ * @param[in]   len Number of bytes to write. regLen + len must fit in I2C_SCRATCH_SIZE
+ * @param[in]   xMaxBlockTime Longest time for the write on the bus
+ * @return      Returns an error message in case of error. See ErrCodes.h
+ */
+int32_t I2cWriteRegister(uint8_t address, const uint8_t *reg, uint8_t regLen, const uint8_t *data, uint16_t len, TickType_t xMaxBlockTime)
+{
+    I2C_Transaction transaction;
+    int32_t error = ERROR_NONE;
+
+    if ((uint16_t)regLen + len > I2C_SCRATCH_SIZE) return ERROR_OVERFLOW;
+
+    uint8_t *scratch = I2cScratchGet(WAIT_I2C_LINE_MS);
+    if (scratch == NULL) return ERROR_NO_RESOURCE;
+
+    memcpy(scratch, reg, regLen);
+    memcpy(scratch + regLen, data, len);
+
+    I2cTransactionInit(&transaction, address, scratch, regLen + len, NULL, 0, 0, xMaxBlockTime);
+    error = I2cSubmitTransaction(&transaction, WAIT_I2C_LINE_MS);
+    if (ERROR_NONE == error) {
+        error = I2cWaitTransaction(&transaction);
+    }
+
+    I2cScratchFree(scratch);
     return error;
 }
+
+/**
+ * @fn			int32_t I2cSetDeviceSpeed(uint8_t address, uint32_t speedHz)
+ * @brief       Sets the bus speed of a device. The bus manager switches the SERCOM to it before each transfer to the device
+ * @details     Devices without a profile use I2C_DEFAULT_SPEED_HZ. Above I2C_FAST_MODE_MAX_HZ the SERCOM runs in
+ *              Fast-mode Plus. The speed really used is limited by the SERCOM clock (see I2cGetSpeedProfiles).
+ *              Call from the device driver initialization, after I2cInitializeDriver.
+ * @param[in]   address 7-bit device address
+ * @param[in]   speedHz Highest SCL frequency the device supports
+ * @return      Returns ERROR_NONE, or ERROR_NO_RESOURCE if I2C_MAX_SPEED_PROFILES devices already have one
+ */
+int32_t I2cSetDeviceSpeed(uint8_t address, uint32_t speedHz)
+{
+    I2C_SpeedProfile profile;
+    I2C_SpeedProfile *slot = I2cFindSpeedProfile(address);
+
+    if (speedHz == 0) return ERROR_INVALID_ARG;
+    if (slot == &i2cSpeedProfiles[0]) {
+        if (i2cSpeedProfileCount >= I2C_MAX_SPEED_PROFILES) return ERROR_NO_RESOURCE;
+        slot = &i2cSpeedProfiles[i2cSpeedProfileCount];
+    }
+
+    memset(&profile, 0, sizeof(profile));
+    profile.address = address;
+    I2cComputeSpeed(&profile, speedHz);
+
+    // The bus manager reads the table between transfers
+    taskENTER_CRITICAL();
+    *slot = profile;
+    if (slot == &i2cSpeedProfiles[i2cSpeedProfileCount]) i2cSpeedProfileCount++;
+    if (slot == i2cSpeedCurrent) i2cSpeedCurrent = NULL;  // Applied again on the next transfer
+    taskEXIT_CRITICAL();
+    return ERROR_NONE;
+}
+
+/**
+ * @fn			uint8_t I2cGetSpeedProfiles(I2C_SpeedProfile *profiles, uint8_t max)
+ * @brief       Copies the speed profiles and their transfer statistics. The first one is the default profile
+ * @param[out]  profiles Room for max profiles
+ * @param[in]   max Size of profiles
+ * @return      Returns the number of profiles copied
+ */
+uint8_t I2cGetSpeedProfiles(I2C_SpeedProfile *profiles, uint8_t max)
+{
+    uint8_t count;
+
+    taskENTER_CRITICAL();
+    count = (i2cSpeedProfileCount < max) ? i2cSpeedProfileCount : max;
+    memcpy(profiles, i2cSpeedProfiles, count * sizeof(I2C_SpeedProfile));
+    taskEXIT_CRITICAL();
+    return count;
+}
+
+/**
+ * @fn			uint8_t I2cGetRecoveryStats(I2C_RecoveryStats *stats, uint8_t max)
+ * @brief       Copies the bus recovery counters, one entry per device that hung the bus or was failed at once
+ * @param[out]  stats Room for max entries
+ * @param[in]   max Size of stats
+ * @return      Returns the number of entries copied
+ */
+uint8_t I2cGetRecoveryStats(I2C_RecoveryStats *stats, uint8_t max)
+{
+    uint8_t count;
+
+    taskENTER_CRITICAL();
+    count = (i2cRecoveryStatsCount < max) ? i2cRecoveryStatsCount : max;
+    memcpy(stats, i2cRecoveryStats, count * sizeof(I2C_RecoveryStats));
+    taskEXIT_CRITICAL();
+    return count;
+}
+
+/**
+ * @fn			bool I2cBusIsDown(void)
+ * @brief       Returns true if a line was still low after the last recovery. Transactions then fail with ERROR_I2C_HANG_RESET
+ */
+bool I2cBusIsDown(void)
+{
+    return i2cBusDown;
+}
+
+/**
+ * @fn			bool I2cGetDeviceStats(uint8_t index, I2C_DeviceStats *stats)
+ * @brief       Copies the transaction statistics of one device. Devices are numbered in the order of their first transaction
+ * @param[in]   index Device number, from 0
+ * @param[out]  stats Statistics of the device
+ * @return      Returns false if there is no device with this number
+ */
+bool I2cGetDeviceStats(uint8_t index, I2C_DeviceStats *stats)
+{
+    bool found = false;
+
+    taskENTER_CRITICAL();
+    if (index < i2cDeviceStatsCount) {
+        *stats = i2cDeviceStats[index];
+        found = true;
+    }
+    taskEXIT_CRITICAL();
+    return found;
+}
+
+/**
+ * @fn			void I2cResetStats(void)
+ * @brief       Clears the transaction statistics of every device
+ */
+void I2cResetStats(void)
+{
+    taskENTER_CRITICAL();
+    i2cDeviceStatsCount = 0;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @fn			int I2cStatsToJson(const I2C_DeviceStats *stats, char *buffer, size_t len)
+ * @brief       Writes the statistics of one device as a compact JSON object, for MQTT
+ * @details     {"a":<address>,"n":<transactions>,"err":<errors>,"b":<bytes>,"qw":<queue wait us>,"w":<on-wire us>,
+ *              "max":<us>,"h":[<bin 0>,...]}. The histogram stops at the last bin that is not empty.
+ * @param[in]   stats Statistics from I2cGetDeviceStats
+ * @param[out]  buffer Output buffer
+ * @param[in]   len Size of buffer
+ * @return      Returns the length of the JSON text, or -1 if it does not fit in buffer
+ */
+int I2cStatsToJson(const I2C_DeviceStats *stats, char *buffer, size_t len)
+{
+    uint8_t bins = I2C_STATS_HISTOGRAM_BINS;
+    int pos = snprintf(buffer,
+                       len,
+                       "{\"a\":%u,\"n\":%lu,\"err\":%lu,\"b\":%lu,\"qw\":%lu,\"w\":%lu,\"max\":%lu,\"h\":[",
+                       stats->address,
+                       (unsigned long)stats->transactions,
+                       (unsigned long)stats->errors,
+                       (unsigned long)stats->bytes,
+                       (unsigned long)stats->queueWaitUs,
+                       (unsigned long)stats->wireUs,
+                       (unsigned long)stats->maxUs);
+
+    while (bins > 0 && stats->histogram[bins - 1] == 0) bins--;
+    for (uint8_t i = 0; i < bins && pos >= 0 && (size_t)pos < len; i++) {
+        pos += snprintf(buffer + pos, len - pos, "%s%u", (i > 0) ? "," : "", stats->histogram[i]);
+    }
+    if (pos >= 0 && (size_t)pos < len) {
+        pos += snprintf(buffer + pos, len - pos, "]}");
+    }
+
+    return (pos >= 0 && (size_t)pos < len) ? pos : -1;
+}
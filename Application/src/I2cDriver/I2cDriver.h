@@ -24,6 +24,36 @@ extern "C" {
 #define I2C_INIT_ATTEMPTS 3
 #define WAIT_I2C_LINE_MS 300
 
+#define I2C_TASK_SIZE 128                            ///< Stack of the bus manager task, in words
+#define I2C_TASK_PRIORITY (configMAX_PRIORITIES - 1)  ///< Above the sensor users, so the bus never waits for a CPU
+#define I2C_QUEUE_LENGTH 4                           ///< Transactions that can wait for the bus manager
+#define I2C_MAX_PENDING 4                            ///< Transactions the bus manager holds at once (started or waiting for their device)
+#define I2C_DONE_COUNT 6                             ///< Transactions that can be in flight at once, from any tasks: one completion semaphore each
+
+#ifndef I2C_DMA_THRESHOLD
+#define I2C_DMA_THRESHOLD 16    ///< Transfers of at least this many bytes are moved by the DMAC: one interrupt per transfer instead of one per byte. 65535 keeps every transfer on the byte interrupts
+#endif
+#define I2C_DMA_LENEN_MAX 255   ///< Longest transfer the SERCOM ends by itself (ADDR.LEN is 8 bits). The bus manager ends longer ones
+
+#define I2C_DEFAULT_SPEED_HZ 100000    ///< Bus speed of the devices without a speed profile (Standard mode)
+#define I2C_FAST_MODE_MAX_HZ 400000    ///< Above this speed the SERCOM is switched to Fast-mode Plus
+#define I2C_SM_LOW_MIN_NS 4700         ///< Shortest SCL low time (tLOW) of Standard mode
+#define I2C_FM_LOW_MIN_NS 1300         ///< Shortest SCL low time (tLOW) of Fast mode
+#define I2C_FMP_LOW_MIN_NS 500         ///< Shortest SCL low time (tLOW) of Fast-mode Plus
+#define I2C_SDA_SCL_RISE_TIME_NS 215   ///< Rise time used to compute the BAUD values, as the ASF default
+#define I2C_MAX_SPEED_PROFILES 6       ///< Devices that can have their own speed, plus the default profile
+
+#define I2C_SCRATCH_SIZE 64   ///< Largest register write through I2cWriteRegister: register address plus data
+#define I2C_SCRATCH_COUNT 3   ///< Register writes that can be in flight at the same time, from any tasks
+
+#define I2C_RECOVERY_CLOCKS 9            ///< SCL pulses that let a device finish the byte it was sending and release SDA
+#define I2C_RECOVERY_HALF_PERIOD_US 5    ///< Half period of the recovery clock (100 kHz)
+#define I2C_RECOVERY_RETRY_MS 100        ///< While a line stays low, transactions fail at once and the recovery is tried again after this time
+#define I2C_MAX_RECOVERY_DEVICES 6       ///< Device addresses with their own recovery counters
+
+#define I2C_STATS_MAX_DEVICES 4       ///< Device addresses with their own transaction statistics. Others are not counted
+#define I2C_STATS_HISTOGRAM_BINS 16   ///< Latency bins: bin 0 is under 2 us, bin i from 2^i us, the last one from 32.8 ms
+
 #define ERROR_NONE 0
 #define ERROR_INVALID_DATA -1
 #define ERROR_NO_CHANGE -2
@@ -76,6 +106,61 @@ typedef struct I2C_Data {
 
 } I2C_Data;
 
+/// Progress of a queued I2C transaction
+typedef enum eI2cTransactionState {
+    I2C_TRANSACTION_QUEUED = 0,  ///< Submitted, waiting for the bus
+    I2C_TRANSACTION_DELAY,       ///< Written, waiting for the device before the read. The bus serves other devices meanwhile
+    I2C_TRANSACTION_DONE,        ///< Finished. The status is valid and the bus manager no longer uses the transaction
+} eI2cTransactionState;
+
+/// Structure that describes a queued I2C transaction: write msgOut, wait delay, read msgIn.
+/// Owned by the caller, who must keep it (and the buffers) alive until its state is I2C_TRANSACTION_DONE
+typedef struct I2C_Transaction {
+    I2C_Data data;                         ///< Address and buffers. lenOut or lenIn may be 0 to skip that phase
+    TickType_t delay;                      ///< Time the device needs between the write and the read (e.g. a conversion)
+    TickType_t xMaxBlockTime;              ///< Longest time for each phase on the bus
+    SemaphoreHandle_t done;                ///< Driver only: completion semaphore, given once when the transaction is done
+    volatile eI2cTransactionState state;  ///< Progress, written by the bus manager
+    int32_t status;                        ///< Result, valid once the state is I2C_TRANSACTION_DONE
+    TickType_t writeTick;                  ///< Bus manager only: tick at the end of the write phase
+    uint32_t submitUs;                     ///< Driver only: run time stats counter when the transaction was queued
+} I2C_Transaction;
+
+/// Bus speed of one device, applied by the bus manager before each of its transfers. See I2cSetDeviceSpeed
+typedef struct I2C_SpeedProfile {
+    uint8_t address;       ///< 7-bit device address. Unused in the default profile
+    uint8_t baud;          ///< BAUD.BAUD value: SCL high time
+    uint8_t baudLow;       ///< BAUD.BAUDLOW value: SCL low time
+    bool fastModePlus;     ///< CTRLA.SPEED is Fast-mode Plus
+    uint32_t requestedHz;  ///< Speed asked by the device driver
+    uint32_t actualHz;     ///< Speed given by the BAUD value, the SERCOM clock and the rise time
+    uint32_t transfers;    ///< Transfers run at this speed
+    uint32_t bytes;        ///< Bytes moved by these transfers
+    uint32_t busUs;        ///< Time from the start of these transfers to their completion interrupt, in us
+    uint32_t lastUs;       ///< Duration of the last transfer, in us
+} I2C_SpeedProfile;
+
+/// Bus recoveries of one device: the device addressed by the transfer that found the bus hung
+typedef struct I2C_RecoveryStats {
+    uint8_t address;      ///< 7-bit device address
+    uint16_t recoveries;  ///< Bus recoveries after a transfer to this device
+    uint16_t stuck;       ///< Recoveries after which a line was still low (bus down)
+    uint16_t fastFailed;  ///< Transfers to this device failed at once (ERROR_I2C_HANG_RESET) while the bus was down
+    uint32_t lastUs;      ///< Duration of the last recovery, in us
+} I2C_RecoveryStats;
+
+/// Transaction statistics of one device, recorded by the bus manager on the run time stats counter (1 us)
+typedef struct I2C_DeviceStats {
+    uint8_t address;                               ///< 7-bit device address
+    uint32_t transactions;                         ///< Transactions done, with or without error
+    uint32_t errors;                               ///< Transactions done with an error
+    uint32_t bytes;                                ///< Bytes written and read by the transactions without error
+    uint32_t queueWaitUs;                          ///< Time the transactions waited in the queue, from submission to their first transfer
+    uint32_t wireUs;                               ///< Time from the start of the transfers to their completion interrupt
+    uint32_t maxUs;                                ///< Longest latency
+    uint16_t histogram[I2C_STATS_HISTOGRAM_BINS];  ///< Latency (queued to done) in log2 bins. Each bin stops at 65535
+} I2C_DeviceStats;
+
 /// Structure that describes an I2C bus data, determining the bus and the flags
 typedef struct I2C_Bus_State {
     eI2cBusState i2cState;  ///< Holds the state of a I2C_Bus.
@@ -93,7 +178,23 @@ int32_t I2cGetMutex(TickType_t waitTime);
 int32_t I2cFreeMutex(void);
 int32_t I2cReadData(I2C_Data *data);
 int32_t I2cWriteData(I2C_Data *data);
+int32_t I2cWriteReadData(I2C_Data *data);
 int32_t I2cInitializeDriver(void);
+void I2cTransactionInit(I2C_Transaction *transaction, uint8_t address, const uint8_t *msgOut, uint16_t lenOut, uint8_t *msgIn, uint16_t lenIn, TickType_t delay, TickType_t xMaxBlockTime);
+int32_t I2cSubmitTransaction(I2C_Transaction *transaction, TickType_t waitTime);
+int32_t I2cWaitTransaction(I2C_Transaction *transaction);
+void vI2cBusTask(void *pvParameters);
+int32_t I2cSetDeviceSpeed(uint8_t address, uint32_t speedHz);
+uint8_t I2cGetSpeedProfiles(I2C_SpeedProfile *profiles, uint8_t max);
+uint8_t I2cGetRecoveryStats(I2C_RecoveryStats *stats, uint8_t max);
+bool I2cBusIsDown(void);
+bool I2cGetDeviceStats(uint8_t index, I2C_DeviceStats *stats);
+void I2cResetStats(void);
+int I2cStatsToJson(const I2C_DeviceStats *stats, char *buffer, size_t len);
+uint8_t *I2cScratchGet(TickType_t waitTime);
+void I2cScratchFree(uint8_t *scratch);
+int32_t I2cReadRegister(uint8_t address, const uint8_t *reg, uint8_t regLen, uint8_t *buffer, uint16_t len, TickType_t delay, TickType_t xMaxBlockTime);
+int32_t I2cWriteRegister(uint8_t address, const uint8_t *reg, uint8_t regLen, const uint8_t *data, uint16_t len, TickType_t xMaxBlockTime);
 void I2cDriverRegisterSensorBusCallbacks(void);
 void I2cSensorsError(struct i2c_master_module *const module);
 void I2cSensorsRxComplete(struct i2c_master_module *const module);
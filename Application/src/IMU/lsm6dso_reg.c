@@ -18,7 +18,7 @@
   */
 
 #include "lsm6dso_reg.h"
-#include "I2cDriver\I2cDriver.h"
+#include "I2cDriver/I2cDriver.h"
 #include <stddef.h>
 
 /**
@@ -11786,14 +11786,14 @@ int32_t lsm6dso_mode_set(stmdev_ctx_t *ctx, stmdev_ctx_t *aux_ctx,
 {
   lsm6dso_func_cfg_access_t func_cfg_access;
   lsm6dso_ctrl1_ois_t ctrl1_ois;
-  lsm6dso_ctrl2_ois_t ctrl2_ois;
+  lsm6dso_ctrl2_ois_t ctrl2_ois = { 0 };
   lsm6dso_ctrl3_ois_t ctrl3_ois;
   lsm6dso_ctrl1_xl_t ctrl1_xl;
   lsm6dso_ctrl8_xl_t ctrl8_xl;
   lsm6dso_ctrl2_g_t ctrl2_g;
   lsm6dso_ctrl3_c_t ctrl3_c;
   lsm6dso_ctrl4_c_t ctrl4_c;
-  lsm6dso_ctrl5_c_t ctrl5_c;
+  lsm6dso_ctrl5_c_t ctrl5_c = { 0 };
   lsm6dso_ctrl6_c_t ctrl6_c;
   lsm6dso_ctrl7_g_t ctrl7_g;
   uint8_t xl_hm_mode;
@@ -13130,7 +13130,7 @@ int32_t lsm6dso_embedded_sens_off(stmdev_ctx_t *ctx)
 }
 
 
-static int32_t platform_write(void *handle, uint8_t reg, uint8_t *bufp, uint16_t len);
+static int32_t platform_write(void *handle, uint8_t reg, const uint8_t *bufp, uint16_t len);
 
 static int32_t platform_read(void *handle, uint8_t reg, uint8_t *bufp, uint16_t len);
 
@@ -13138,11 +13138,11 @@ static int32_t platform_read(void *handle, uint8_t reg, uint8_t *bufp, uint16_t
 
 stmdev_ctx_t dev_ctx = {.write_reg = platform_write, .read_reg = platform_read};
 
-uint8_t msgOutImu[64]; ///<USE ME AS A BUFFER FOR platform_write and platform_read
-I2C_Data imuData; ///<Use me as a structure to communicate with the IMU on platform_write and platform_read
+#define IMU_I2C_ADDR (LSM6DSO_I2C_ADD_H >> 1) ///< 7-bit address of the IMU (SA0 high)
+#define IMU_I2C_SPEED_HZ 1000000 ///< Bus speed of the IMU (Fast-mode Plus). Limited by the SERCOM clock, see "i2cspeed"
 
 /**************************************************************************//**
- * @fn			static int32_t platform_write(void *handle, uint8_t reg, uint8_t *bufp,uint16_t len)
+ * @fn			static int32_t platform_write(void *handle, uint8_t reg, const uint8_t *bufp,uint16_t len)
  * @brief       Function to write data to a register
  * @details     Function to write data (bufp) to a register (reg)
 				
@@ -13150,16 +13150,13 @@ I2C_Data imuData; ///<Use me as a structure to communicate with the IMU on platf
  * @param[in]   reg Register to write to. In an I2C transaction, this gets sent first
  * @param[in]   bufp Pointer to the data to be sent
  * @param[in]   len Length of the data sent
- * @return      Returns what the function "I2cWriteDataWait" returns
- * @note        STUDENTS TO FILL  
+ * @return      Returns what the function "I2cWriteRegister" returns
+ * @note        Register and data are assembled in an I2C pool buffer, so any task may call the driver
 *****************************************************************************/
-static int32_t platform_write(void *handle, uint8_t reg, uint8_t *bufp,uint16_t len)
+static int32_t platform_write(void *handle, uint8_t reg, const uint8_t *bufp,uint16_t len)
 {
-	//YOUR JOB: Fill out the structure "imuData" to send to the device
-	//TIP: Use the array "msgOutImu" to copy the data to be sent. Remember that the position [0] of the array you send must be the register, and
-	//starting from position [1] you can copy the data to be sent. Remember to adjust the length accordingly
-return 0;
-
+	(void)handle;
+	return I2cWriteRegister(IMU_I2C_ADDR, &reg, 1, bufp, len, 100);
 }
 
 /**************************************************************************//**
@@ -13171,16 +13168,13 @@ return 0;
  * @param[in]   reg Register to read from. In an I2C transaction, this gets sent first
  * @param[out]   bufp Pointer to the data to write to (write what was read)
  * @param[in]   len Length of the data to be read
- * @return      Returns what the function "I2cReadDataWait" returns
- * @note        STUDENTS TO FILL  
+ * @return      Returns what the function "I2cReadRegister" returns
+ * @note        Register write and read are one repeated START transfer
 *****************************************************************************/
 static  int32_t platform_read(void *handle, uint8_t reg, uint8_t *bufp, uint16_t len)
 {
-	//YOUR JOB: Fill out the structure "imuData" to send to the device
-	//TIP: Check the structure "imuData" and notice that it has a msgOut and msgIn parameter. How do we fill this to our advantage?
-return 0;
-
-
+	(void)handle;
+	return I2cReadRegister(IMU_I2C_ADDR, &reg, 1, bufp, len, 0, 100);
 }
 
 
@@ -13195,6 +13189,8 @@ int32_t InitImu(void)
 {
 uint8_t rst;
 int32_t error = 0;
+
+I2cSetDeviceSpeed(IMU_I2C_ADDR, IMU_I2C_SPEED_HZ);
 /*
    * Restore default configuration
    */
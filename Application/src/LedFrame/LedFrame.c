@@ -0,0 +1,141 @@
+/**************************************************************************/ /**
+ * @file      LedFrame.c
+ * @brief     Shadow of the 16 NeoTrellis LEDs, flushed to the Seesaw at most LED_FRAME_RATE_HZ times per second
+ * @details   See LedFrame.h. Pixels are kept as red, green, blue. SeesawWriteLeds reorders them for the NeoPixels.
+ * @author
+ * @date      2026-10-16
+
+ ******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "LedFrame/LedFrame.h"
+
+#include <string.h>
+
+#include "task.h"
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+static uint8_t ledFrame[NEO_TRELLIS_NUM_KEYS * 3];  ///< Color of each key (red, green, blue), as the application set it
+static volatile uint16_t ledFrameDirty;             ///< Bit per key changed since the last flush
+static TickType_t ledFrameLastFlush;                ///< Tick count of the last flush
+
+/******************************************************************************
+ * Functions
+ ******************************************************************************/
+
+/**
+ * @fn		void LedFrameSet(uint8_t key, uint8_t red, uint8_t green, uint8_t blue)
+ * @brief	Sets the color of one key in the shadow. No I2C traffic: the change is sent by the next flush
+ * @param[in] key  Key number (0 to 15)
+ * @param[in] red Red color. 0 to 255.
+ * @param[in] green Green color. 0 to 255.
+ * @param[in] blue Blue color. 0 to 255.
+ * @note	Setting a key to the color it already has does not mark it dirty
+ */
+void LedFrameSet(uint8_t key, uint8_t red, uint8_t green, uint8_t blue)
+{
+    if (key >= NEO_TRELLIS_NUM_KEYS) return;
+    uint8_t *pixel = &ledFrame[3 * key];
+
+    taskENTER_CRITICAL();
+    if (pixel[0] != red || pixel[1] != green || pixel[2] != blue) {
+        pixel[0] = red;
+        pixel[1] = green;
+        pixel[2] = blue;
+        ledFrameDirty |= (1 << key);
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @fn		void LedFrameFill(uint8_t red, uint8_t green, uint8_t blue)
+ * @brief	Sets every key of the shadow to the same color (LedFrameFill(0, 0, 0) turns all LEDs off)
+ */
+void LedFrameFill(uint8_t red, uint8_t green, uint8_t blue)
+{
+    for (uint8_t key = 0; key < NEO_TRELLIS_NUM_KEYS; key++) {
+        LedFrameSet(key, red, green, blue);
+    }
+}
+
+/**
+ * @fn		bool LedFrameIsDirty(void)
+ * @brief	Returns true if a key changed since the last flush
+ */
+bool LedFrameIsDirty(void)
+{
+    return ledFrameDirty != 0;
+}
+
+/**
+ * @fn		TickType_t LedFrameFlushDelay(void)
+ * @brief	Returns the ticks until LedFrameFlush will send the pending changes
+ * @return	0 if a flush would send now, portMAX_DELAY if nothing changed. Useful as the timeout of a task that waits for events
+ */
+TickType_t LedFrameFlushDelay(void)
+{
+    if (ledFrameDirty == 0) return portMAX_DELAY;
+
+    TickType_t elapsed = xTaskGetTickCount() - ledFrameLastFlush;
+    return (elapsed >= LED_FRAME_PERIOD) ? 0 : LED_FRAME_PERIOD - elapsed;
+}
+
+/**
+ * @fn		int32_t LedFrameFlush(void)
+ * @brief	Sends the changed keys to the Seesaw and shows them, unless nothing changed or the last flush was too recent
+ * @details	The keys from the first to the last dirty one go out in one SeesawWriteLeds (2 writes at most), then one SHOW.
+ *			Call it from the task that owns the LEDs, as often as convenient: the frame rate stays at LED_FRAME_RATE_HZ or less
+ * @return	Returns zero if nothing was due or no I2C errors occurred. Other number in case of error
+ * @note	After an error the keys stay dirty, so the next flush sends them again
+ */
+int32_t LedFrameFlush(void)
+{
+    uint8_t rgb[NEO_TRELLIS_NUM_KEYS * 3];
+    uint16_t dirty;
+    uint8_t first = 0;
+    uint8_t last = NEO_TRELLIS_NUM_KEYS - 1;
+
+    if (LedFrameFlushDelay() != 0) return ERROR_NONE;
+
+    // Take a consistent copy, so keys may keep changing while the I2C transfer runs
+    taskENTER_CRITICAL();
+    dirty = ledFrameDirty;
+    ledFrameDirty = 0;
+    memcpy(rgb, ledFrame, sizeof(rgb));
+    taskEXIT_CRITICAL();
+
+    while (!(dirty & (1 << first))) first++;
+    while (!(dirty & (1 << last))) last--;
+
+    int32_t error = SeesawWriteLeds(first, &rgb[3 * first], last - first + 1);
+    if (ERROR_NONE == error) {
+        error = SeesawOrderLedUpdate();
+    }
+    ledFrameLastFlush = xTaskGetTickCount();
+
+    if (ERROR_NONE != error) {
+        taskENTER_CRITICAL();
+        ledFrameDirty |= dirty;
+        taskEXIT_CRITICAL();
+    }
+    return error;
+}
+
+/**
+ * @fn		int32_t LedFrameShow(void)
+ * @brief	Like LedFrameFlush, but waits for the frame period instead of deferring, so the changes are shown on return
+ * @return	Returns zero if no I2C errors occurred. Other number in case of error
+ * @note	Blocks for up to LED_FRAME_PERIOD. Use before holding a pattern on screen (for example before a vTaskDelay)
+ */
+int32_t LedFrameShow(void)
+{
+    TickType_t delay = LedFrameFlushDelay();
+
+    if (delay == portMAX_DELAY) return ERROR_NONE;
+    if (delay != 0) vTaskDelay(delay);
+    return LedFrameFlush();
+}
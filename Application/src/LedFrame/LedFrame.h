@@ -0,0 +1,40 @@
+/**************************************************************************/ /**
+ * @file      LedFrame.h
+ * @brief     Shadow of the 16 NeoTrellis LEDs, flushed to the Seesaw at most LED_FRAME_RATE_HZ times per second
+ * @details   Application code only sets pixels in RAM (LedFrameSet). Every changed pixel gets a dirty bit. LedFrameFlush
+ *            sends the range of dirty pixels with SeesawWriteLeds followed by one SHOW. A flush within LED_FRAME_PERIOD of the
+ *            previous one is deferred, so a burst of key events becomes one frame. Nothing is sent when no pixel changed.
+ * @author
+ * @date      2026-10-16
+
+ ******************************************************************************/
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "SeesawDriver/Seesaw.h"
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define LED_FRAME_RATE_HZ 60                                  ///< Most frames sent to the Seesaw per second
+#define LED_FRAME_PERIOD pdMS_TO_TICKS(1000 / LED_FRAME_RATE_HZ)  ///< Shortest time between two flushes, in ticks
+
+/******************************************************************************
+ * Global Function Declaration
+ ******************************************************************************/
+void LedFrameSet(uint8_t key, uint8_t red, uint8_t green, uint8_t blue);
+void LedFrameFill(uint8_t red, uint8_t green, uint8_t blue);
+bool LedFrameIsDirty(void);
+TickType_t LedFrameFlushDelay(void);
+int32_t LedFrameFlush(void);
+int32_t LedFrameShow(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,198 @@
+/**************************************************************************/ /**
+ * @file      LedSequence.c
+ * @brief     Plays a list of game moves on the NeoTrellis LEDs without blocking the caller
+ * @details   See LedSequence.h. One one-shot timer is created at the first start and reused (heap_1 cannot free it).
+ *            Every expiry ends the current phase (lit or dark) and programs the length of the next one.
+ * @author
+ * @date      2026-10-16
+
+ ******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "LedFrame/LedSequence.h"
+
+#include "task.h"
+#include "timers.h"
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define LED_SEQUENCE_TIMER_WAIT_MS 10  ///< Longest wait for room in the timer command queue
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+static TimerHandle_t ledSequenceTimer = NULL;     ///< Timer that ends each phase
+static uint8_t ledSequenceMoves[GAME_SIZE];       ///< Keys of the running sequence
+static uint8_t ledSequenceCount;                  ///< Number of moves
+static volatile uint8_t ledSequenceStep;          ///< Move being played
+static volatile bool ledSequenceRunning;          ///< A sequence is playing
+static bool ledSequenceLit;                       ///< The current move is lit (false: dark gap after it)
+static uint8_t ledSequenceColor[3];               ///< Red, green and blue of the lit moves
+static struct LedSequenceTempo ledSequenceTempo;  ///< Tempo of the running sequence
+static TickType_t ledSequenceOnTicks;             ///< Lit time of the current move
+static TickType_t ledSequencePhaseStart;          ///< Tick count when the current phase was programmed
+static TickType_t ledSequencePhaseTicks;          ///< Length of the current phase
+static LedSequenceCallback ledSequenceCallback;   ///< Event callback of the running sequence, or NULL
+
+/******************************************************************************
+ * Local Functions
+ ******************************************************************************/
+
+/**
+ * @fn		static void LedSequenceSchedule(TickType_t ticks, TickType_t wait)
+ * @brief	Ends the current phase after ticks (restarts the timer)
+ */
+static void LedSequenceSchedule(TickType_t ticks, TickType_t wait)
+{
+    if (ticks == 0) ticks = 1;
+    ledSequencePhaseStart = xTaskGetTickCount();
+    ledSequencePhaseTicks = ticks;
+    xTimerChangePeriod(ledSequenceTimer, ticks, wait);
+}
+
+/**
+ * @fn		static void LedSequenceLight(TickType_t wait)
+ * @brief	Lights the current move and reports it
+ */
+static void LedSequenceLight(TickType_t wait)
+{
+    uint8_t step = ledSequenceStep;
+
+    LedFrameSet(ledSequenceMoves[step], ledSequenceColor[0], ledSequenceColor[1], ledSequenceColor[2]);
+    ledSequenceLit = true;
+    LedSequenceSchedule(ledSequenceOnTicks, wait);
+    if (ledSequenceCallback != NULL) ledSequenceCallback(LED_SEQUENCE_EVENT_STEP, step);
+}
+
+/**
+ * @fn		static void LedSequenceTimerCallback(TimerHandle_t timer)
+ * @brief	Ends a phase: turns the lit move off and waits the gap, or goes to the next move, or completes the sequence
+ * @note	Runs in the timer task
+ */
+static void LedSequenceTimerCallback(TimerHandle_t timer)
+{
+    if (!ledSequenceRunning) return;
+    // An expiry of the previous sequence may run just after a restart. The current phase is not over yet: ignore it
+    if (xTaskGetTickCount() - ledSequencePhaseStart < ledSequencePhaseTicks) return;
+
+    if (ledSequenceLit) {
+        LedFrameSet(ledSequenceMoves[ledSequenceStep], 0, 0, 0);
+        ledSequenceLit = false;
+        LedSequenceSchedule((ledSequenceOnTicks * ledSequenceTempo.offMs) / ledSequenceTempo.onMs, 0);
+        // The owner task must flush the dark gap, or a key that repeats would show as one long light
+        if (ledSequenceCallback != NULL) ledSequenceCallback(LED_SEQUENCE_EVENT_OFF, ledSequenceStep);
+        return;
+    }
+
+    ledSequenceStep++;
+    if (ledSequenceStep >= ledSequenceCount) {
+        ledSequenceRunning = false;
+        if (ledSequenceCallback != NULL) ledSequenceCallback(LED_SEQUENCE_EVENT_DONE, ledSequenceCount);
+        return;
+    }
+
+    // Tempo curve: each move is speedupPercent shorter than the previous one
+    TickType_t on = (ledSequenceOnTicks * (100 - ledSequenceTempo.speedupPercent)) / 100;
+    TickType_t minOn = pdMS_TO_TICKS(ledSequenceTempo.minOnMs);
+    ledSequenceOnTicks = (on > minOn) ? on : minOn;
+    LedSequenceLight(0);
+}
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn		int32_t LedSequenceStart(const struct GameDataPacket *moves, const struct LedSequenceTempo *tempo, uint8_t red,
+ *								 uint8_t green, uint8_t blue, LedSequenceCallback callback)
+ * @brief	Starts playing moves and returns at once. A running sequence is replaced
+ * @param[in] moves  Keys to light (0 to 15), in order. The list ends at the first entry that is not a key (0xFF) or at GAME_SIZE
+ * @param[in] tempo  Tempo curve. Copied
+ * @param[in] red Red color of the lit moves. 0 to 255.
+ * @param[in] green Green color of the lit moves. 0 to 255.
+ * @param[in] blue Blue color of the lit moves. 0 to 255.
+ * @param[in] callback  Event callback, or NULL. An empty list reports LED_SEQUENCE_EVENT_DONE at once, from the caller
+ * @return	Returns ERROR_NONE if started, ERROR_INVALID_ARG for a bad tempo (onMs 0 or speedupPercent above 100), ERROR_NO_MEMORY if the timer could not be created
+ * @note	Call LedFrameFlush (or let the LED owner task do it) to send the frames. Callers should wake that task on events
+ */
+int32_t LedSequenceStart(const struct GameDataPacket *moves,
+                         const struct LedSequenceTempo *tempo,
+                         uint8_t red,
+                         uint8_t green,
+                         uint8_t blue,
+                         LedSequenceCallback callback)
+{
+    if (moves == NULL || tempo == NULL || tempo->onMs == 0 || tempo->speedupPercent > 100) return ERROR_INVALID_ARG;
+    if (ledSequenceTimer == NULL) {
+        ledSequenceTimer = xTimerCreate("LedSeq", 1, pdFALSE, NULL, LedSequenceTimerCallback);
+        if (ledSequenceTimer == NULL) return ERROR_NO_MEMORY;
+    }
+
+    LedSequenceStop();
+
+    uint8_t count = 0;
+    while (count < GAME_SIZE && moves->game[count] < NEO_TRELLIS_NUM_KEYS) {
+        ledSequenceMoves[count] = moves->game[count];
+        count++;
+    }
+    ledSequenceCount = count;
+    if (count == 0) {
+        if (callback != NULL) callback(LED_SEQUENCE_EVENT_DONE, 0);
+        return ERROR_NONE;
+    }
+
+    ledSequenceStep = 0;
+    ledSequenceColor[0] = red;
+    ledSequenceColor[1] = green;
+    ledSequenceColor[2] = blue;
+    ledSequenceTempo = *tempo;
+    ledSequenceOnTicks = pdMS_TO_TICKS(tempo->onMs);
+    ledSequenceCallback = callback;
+    ledSequenceRunning = true;
+    LedSequenceLight(pdMS_TO_TICKS(LED_SEQUENCE_TIMER_WAIT_MS));
+    return ERROR_NONE;
+}
+
+/**
+ * @fn		void LedSequenceStop(void)
+ * @brief	Stops the running sequence, if any, and turns its lit move off. No event is reported
+ */
+void LedSequenceStop(void)
+{
+    if (ledSequenceTimer == NULL) return;
+
+    ledSequenceRunning = false;
+    xTimerStop(ledSequenceTimer, pdMS_TO_TICKS(LED_SEQUENCE_TIMER_WAIT_MS));
+    if (ledSequenceLit) {
+        LedFrameSet(ledSequenceMoves[ledSequenceStep], 0, 0, 0);
+        ledSequenceLit = false;
+    }
+}
+
+/**
+ * @fn		bool LedSequenceIsRunning(void)
+ * @brief	Returns true while a sequence plays
+ */
+bool LedSequenceIsRunning(void)
+{
+    return ledSequenceRunning;
+}
+
+/**
+ * @fn		bool LedSequenceGetProgress(uint8_t *step, uint8_t *count)
+ * @brief	Returns the progress of the last sequence
+ * @param[out] step  Move being played, or the number of moves once complete. May be NULL
+ * @param[out] count  Number of moves of the sequence. May be NULL
+ * @return	Returns true while the sequence plays
+ */
+bool LedSequenceGetProgress(uint8_t *step, uint8_t *count)
+{
+    bool running = ledSequenceRunning;
+
+    if (step != NULL) *step = running ? ledSequenceStep : ledSequenceCount;
+    if (count != NULL) *count = ledSequenceCount;
+    return running;
+}
@@ -0,0 +1,63 @@
+/**************************************************************************/ /**
+ * @file      LedSequence.h
+ * @brief     Plays a list of game moves on the NeoTrellis LEDs without blocking the caller
+ * @details   A FreeRTOS software timer steps through the moves: each move lights its key, then leaves a dark gap. The
+ *            timer callback only changes the LedFrame shadow; the task that owns the LEDs sends the frames with
+ *            LedFrameFlush, so the timer task never waits on the I2C bus. Progress and completion are reported through
+ *            an event callback and LedSequenceGetProgress.
+ * @author
+ * @date      2026-10-16
+
+ ******************************************************************************/
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "LedFrame/LedFrame.h"
+#include "WifiHandlerThread/WifiHandler.h"
+
+/******************************************************************************
+ * Structures and Enumerations
+ ******************************************************************************/
+
+/// Tempo curve of a sequence. Each move is shorter than the previous one by speedupPercent, down to minOnMs,
+/// so long sequences play faster. The dark gap shrinks in the same proportion
+struct LedSequenceTempo {
+    uint16_t onMs;           ///< Time the first move stays lit
+    uint16_t offMs;          ///< Dark gap after the first move. Keep it above 0 so a repeated key is visible twice
+    uint16_t minOnMs;        ///< Shortest time a move stays lit
+    uint8_t speedupPercent;  ///< Share by which each move is shorter than the previous one, 0 to 100 (0: constant tempo)
+};
+
+/// Events of a sequence, passed to its LedSequenceCallback
+enum LedSequenceEvent {
+    LED_SEQUENCE_EVENT_STEP = 0,  ///< A move was lit. step is its index
+    LED_SEQUENCE_EVENT_OFF,       ///< A move was turned off: its dark gap starts. step is its index
+    LED_SEQUENCE_EVENT_DONE,      ///< The last gap ended: the sequence is complete. step is the number of moves
+};
+
+/// Called on every event of a sequence, from the timer task (the first step: from LedSequenceStart). Must not block,
+/// for example notify a task
+typedef void (*LedSequenceCallback)(enum LedSequenceEvent event, uint8_t step);
+
+/******************************************************************************
+ * Global Function Declaration
+ ******************************************************************************/
+int32_t LedSequenceStart(const struct GameDataPacket *moves,
+                         const struct LedSequenceTempo *tempo,
+                         uint8_t red,
+                         uint8_t green,
+                         uint8_t blue,
+                         LedSequenceCallback callback);
+void LedSequenceStop(void);
+bool LedSequenceIsRunning(void);
+bool LedSequenceGetProgress(uint8_t *step, uint8_t *count);
+
+#ifdef __cplusplus
+}
+#endif
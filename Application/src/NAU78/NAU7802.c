@@ -4,49 +4,46 @@
 #include "NAU7802.h"
 #include "I2cDriver/I2cDriver.h"
 #include "SerialConsole.h"
-uint8_t msgOut[64];
-I2C_Data SEN_Data; 
+#include "SerialConsole/DataStream.h"
+#include "queue.h"
 
-//write the data to the reg
+static QueueHandle_t nauSampleQueue = NULL;      ///< Samples of the stream, for the consumers
+static TaskHandle_t nauStreamTaskHandle = NULL;  ///< Stream task, created at the first NAU78_stream_start
+static volatile bool nauStreamRequested = false; ///< Set by NAU78_stream_start, cleared by NAU78_stream_stop
+static bool nauInitialized = false;              ///< Reset and calibration are done
+static bool nauConverting = false;               ///< CS is set: the ADC converts continuously
+static uint16_t nauSequence = 0;                 ///< Sequence number of the next sample
+static TickType_t nauPollEarly = pdMS_TO_TICKS(NAU78_STREAM_RETRY_MS); ///< How early the next poll is, before the expected conversion
+static uint8_t nauPollMisses = 0;                ///< Polls that found the current conversion not ready
+static uint8_t nauCalibrationRegs[7];            ///< OCAL1_B2 to GCAL1_B0, read once after the calibration
+static bool nauCalibrationValid = false;         ///< nauCalibrationRegs holds the current calibration
+static struct nau78_sample nauLatestSample;      ///< Newest sample of the stream, kept for get_raw_data without taking it from the queue
+static bool nauLatestValid = false;              ///< nauLatestSample is from the running stream
+static volatile bool nauSingleRunning = false;   ///< get_raw_data is doing a one-shot conversion: the stream task waits
+
+//write the data to the reg. The register address and the data are assembled in an I2C pool buffer
 static int32_t reg_write(uint8_t reg, uint8_t *bufp,uint16_t len)
 {
-	int32_t error = ERROR_NONE;
-	msgOut[0] = reg;
-	
-	for(int i = 0; i < len; i++){
-		msgOut[i+1] = bufp[i];
-	}
-	
-	SEN_Data.address = ADC_SLAVE_ADDR;
-	SEN_Data.msgOut = &msgOut;
-	SEN_Data.lenOut = len + 1;
-	
-	error = I2cWriteDataWait(&SEN_Data,100);
-	return error;
+	return I2cWriteRegister(ADC_SLAVE_ADDR, &reg, 1, bufp, len, 100);
 }
 
 //read the data inside regs
 static  int32_t reg_read(uint8_t reg, uint8_t *bufp, uint16_t len)
 {
-	int32_t error = ERROR_NONE;
-	
-	SEN_Data.address = ADC_SLAVE_ADDR;
-	SEN_Data.msgIn = bufp;
-	SEN_Data.lenIn = len;
-
-	msgOut[0] = reg;
-	SEN_Data.lenOut = 1;
-	SEN_Data.msgOut = &msgOut;
-
-	error = I2cReadDataWait(&SEN_Data,5 ,100);
-	return error;
+	return I2cReadRegister(ADC_SLAVE_ADDR, &reg, 1, bufp, len, 5, 100);
+}
+
+//read consecutive regs in one transfer: repeated START without delay, the register address auto increments
+static int32_t reg_read_burst(uint8_t reg, uint8_t *bufp, uint16_t len)
+{
+	return I2cReadRegister(ADC_SLAVE_ADDR, &reg, 1, bufp, len, 0, 100);
 }
 
 //read data from a single reg
 uint8_t read_a_reg(uint8_t u8RegAddr)
 {
-	static uint8_t read_bytes;
-	int32_t err= reg_read(u8RegAddr, &read_bytes,1);
+	uint8_t read_bytes = 0;
+	reg_read(u8RegAddr, &read_bytes,1);
 	return read_bytes;
 }
 
@@ -116,10 +113,15 @@ void NAU78_init(void)
 	reg=0x30;
 	write_a_reg(OTP_B1_ADDR , reg);
 	delay_ms(1);
-   
+
+	/* Conversion rate. Set before the calibration, which is only valid for this rate */
+	reg = read_a_reg(CTRL2_ADDR);
+	reg = (reg & ~CRS_Msk) | NAU78_CRS;
+	write_a_reg(CTRL2_ADDR, reg);
 
 	/* Calibration */
 	NAU78_calibration();
+	nauCalibrationValid = false;
 }
 
 //set cycle start = 1 to enable the connection
@@ -132,21 +134,64 @@ static void cycle_ready(void)
 	write_a_reg(PU_CTRL_ADDR, reg);
 }
 
-//read the raw data of weight
+//one conversion with the stream stopped: initializes and calibrates the ADC once, sets CS, reads the first result
+//and clears CS again. Returns false if the conversion did not end in NAU78_STREAM_TIMEOUT_MS
+static bool single_conversion(int32_t *raw)
+{
+	TickType_t start = xTaskGetTickCount();
+	uint8_t reg = 0;
+	uint8_t adco[3];
+	bool ready = false;
+
+	if (!nauInitialized) {
+		NAU78_init();
+		nauInitialized = true;
+	}
+	cycle_ready();
+	/* Sleep through most of the conversion, then poll CR */
+	vTaskDelay(NAU78_SAMPLE_TICKS - pdMS_TO_TICKS(NAU78_STREAM_RETRY_MS));
+	for (;;) {
+		ready = reg_read_burst(PU_CTRL_ADDR, &reg, 1) == ERROR_NONE && (reg & CR_Msk) == CR_DATA_RDY;
+		if (ready || (xTaskGetTickCount() - start) >= pdMS_TO_TICKS(NAU78_STREAM_TIMEOUT_MS)) break;
+		vTaskDelay(pdMS_TO_TICKS(NAU78_STREAM_RETRY_MS));
+	}
+	/* ADCO_B2 to ADCO_B0. Reading B0 clears CR */
+	ready = ready && reg_read_burst(ADCO_B2_ADDR, adco, sizeof(adco)) == ERROR_NONE;
+	reg = read_a_reg(PU_CTRL_ADDR);
+	write_a_reg(PU_CTRL_ADDR, reg & ~CS_Msk);
+	if (!ready) return false;
+
+	*raw = ((int32_t)adco[0] << 16) | ((int32_t)adco[1] << 8) | adco[2];
+	if (*raw & 0x800000) *raw -= 0x1000000;
+	return true;
+}
+
+//newest conversion. While the stream runs, the sample its task keeps: the queue is left to the stream consumer.
+//Otherwise one conversion, after which the ADC stops again. Returns 0 if no sample came in NAU78_STREAM_TIMEOUT_MS
 int32_t get_raw_data(void)
 {
-	int32_t temp1, temp2, temp3, raw_weight;
-	temp1 = read_a_reg(CTRL2_ADDR);
-	temp1 |= 0 << 7;
-	write_a_reg(CTRL2_ADDR, temp1);
-	vTaskDelay(10);
+	TickType_t start = xTaskGetTickCount();
+	int32_t raw = 0;
+	bool found = false;
 
-	temp1 = read_a_reg(ADCO_B2_ADDR );
-	temp2 = read_a_reg(ADCO_B1_ADDR );
-	temp3 = read_a_reg(ADCO_B0_ADDR );
+	/* Flag first, then check the stream: a start from now on waits in NAU78_stream_service until the flag is cleared */
+	nauSingleRunning = true;
+	if (!nauStreamRequested) {
+		found = single_conversion(&raw);
+		nauSingleRunning = false;
+		return found ? raw : 0;
+	}
+	nauSingleRunning = false;
 
-	raw_weight = temp1 << 16 | temp2 << 8 | temp3 << 0;
-	return  raw_weight;
+	/* The first sample after a start follows the init and the calibration */
+	while (!found && (xTaskGetTickCount() - start) < pdMS_TO_TICKS(NAU78_STREAM_TIMEOUT_MS)) {
+		taskENTER_CRITICAL();
+		found = nauLatestValid;
+		raw = nauLatestSample.raw;
+		taskEXIT_CRITICAL();
+		if (!found) vTaskDelay(pdMS_TO_TICKS(NAU78_STREAM_RETRY_MS));
+	}
+	return found ? raw : 0;
 }
 
 //calculate the raw data to real weight
@@ -154,16 +199,14 @@ float raw_data_to_weight(int raw_data){
 	float adc_out = 00.00;
 	float gain = 00.00;
 	float offset = 00.00;
-	uint8_t gain_reg[4];
-	uint8_t offset_reg[3];
-
-	gain_reg[0]=read_a_reg(GCAL1_B3_ADDR);
-	gain_reg[1]=read_a_reg(GCAL1_B2_ADDR);
-	gain_reg[2]=read_a_reg(GCAL1_B1_ADDR);
-	gain_reg[3]=read_a_reg(GCAL1_B0_ADDR);
-	offset_reg[0]=read_a_reg(OCAL1_B2_ADDR);
-	offset_reg[1]=read_a_reg(OCAL1_B1_ADDR);
-	offset_reg[2]=read_a_reg(OCAL1_B0_ADDR);
+	uint8_t *gain_reg = &nauCalibrationRegs[3];
+	uint8_t *offset_reg = &nauCalibrationRegs[0];
+
+	//the calibration only changes in NAU78_init: read OCAL1 and GCAL1 once after it
+	if (!nauCalibrationValid) {
+		if (reg_read_burst(OCAL1_B2_ADDR, nauCalibrationRegs, sizeof(nauCalibrationRegs)) != ERROR_NONE) return 0;
+		nauCalibrationValid = true;
+	}
 	
 	for(int i=31;i>=0;i--){
 		gain+=(float)(((gain_reg[3-i/8]>>(i%8))&0x01)*(2<<(i-23)*10000));
@@ -171,27 +214,175 @@ float raw_data_to_weight(int raw_data){
 	for(int i=22;i>=0;i--){
 		offset+=(float)(((offset_reg[2-i/8]>>(i%8))&0x01)*(2<<(i-23)*10000));
 	}
-	offset*=(float)(1-(offset_reg[0]>>7)&0x01);
+	offset*=(float)((1-(offset_reg[0]>>7))&0x01);
 
 	adc_out = (float)gain/10000*((float)raw_data-(float)offset/10000);
 	return adc_out;
 }
+//weight of the newest conversion (see get_raw_data). The first call initializes and calibrates the ADC once
 float get_weight(void)
-{	
-	I2cInitializeDriver();
-	NAU78_init();
-	cycle_ready();
-	
-	//read CR->until data ready
-	while ((read_a_reg(PU_CTRL_ADDR)&CR_Msk) != CR_DATA_RDY);
-	uint32_t raw_data = get_raw_data();
-	float w = raw_data_to_weight(raw_data);
-	return w;
+{
+	return raw_data_to_weight(get_raw_data());
 }
 
+//revision of the ADC. Read only: does not reset the ADC, so the stream keeps running
 int32_t get_adc_id(void){
-	uint8_t ver;
-	NAU78_init();
-	ver = read_a_reg(0x1F);
-	return ver;
+	return read_a_reg(DEVICE_REVISION_ADDR);
+}
+
+/******************************************************************************
+* Streaming
+******************************************************************************/
+
+/**
+ * @fn		TickType_t NAU78_stream_service(void)
+ * @brief	Runs one step of the stream: initializes and calibrates the ADC once, starts continuous conversion, then reads
+ *			each conversion when it is ready, queues it and sends it on the binary stream when that is on (DataStream.h)
+ * @details	There is no data ready interrupt (the DRDY pin is not routed, EXT1 carries the NeoTrellis INT). Instead the
+ *			polls follow the conversion period: a ready poll takes one status read and one 3-byte read. The ADC runs on
+ *			its own oscillator, so each poll aims one retry before the conversion: a poll that finds it ready at once
+ *			may be late and the next one is earlier, a conversion that takes several retries makes the next poll later
+ * @return	Ticks to wait before the next step, or portMAX_DELAY once stopped
+ * @note	Body of the stream task
+ */
+TickType_t NAU78_stream_service(void)
+{
+	TickType_t pollStart = xTaskGetTickCount();
+	TickType_t elapsed;
+	uint8_t reg = 0;
+	uint8_t adco[3];
+	struct nau78_sample sample, oldest;
+
+	if (nauSingleRunning) {
+		/* get_raw_data owns the ADC until its conversion is read and CS is cleared */
+		return pdMS_TO_TICKS(NAU78_STREAM_RETRY_MS);
+	}
+	if (!nauStreamRequested) {
+		if (nauConverting) {
+			/* Stop conversions */
+			reg = read_a_reg(PU_CTRL_ADDR);
+			write_a_reg(PU_CTRL_ADDR, reg & ~CS_Msk);
+			nauConverting = false;
+		}
+		taskENTER_CRITICAL();
+		nauLatestValid = false;
+		taskEXIT_CRITICAL();
+		return portMAX_DELAY;
+	}
+
+	if (!nauInitialized) {
+		NAU78_init();
+		nauInitialized = true;
+	}
+	if (!nauConverting) {
+		cycle_ready();
+		nauConverting = true;
+		return NAU78_SAMPLE_TICKS;
+	}
+
+	if (reg_read_burst(PU_CTRL_ADDR, &reg, 1) != ERROR_NONE || (reg & CR_Msk) != CR_DATA_RDY) {
+		if (nauPollMisses < UINT8_MAX) nauPollMisses++;
+		return pdMS_TO_TICKS(NAU78_STREAM_RETRY_MS);
+	}
+	/* ADCO_B2 to ADCO_B0. Reading B0 clears CR */
+	if (reg_read_burst(ADCO_B2_ADDR, adco, sizeof(adco)) != ERROR_NONE) return pdMS_TO_TICKS(NAU78_STREAM_RETRY_MS);
+
+	sample.raw = ((int32_t)adco[0] << 16) | ((int32_t)adco[1] << 8) | adco[2];
+	if (sample.raw & 0x800000) sample.raw -= 0x1000000;
+	sample.tick = pollStart;
+	sample.sequence = nauSequence++;
+	taskENTER_CRITICAL();
+	nauLatestSample = sample;
+	nauLatestValid = true;
+	taskEXIT_CRITICAL();
+	if (xQueueSend(nauSampleQueue, &sample, 0) != pdPASS) {
+		/* Full: drop the oldest sample, the consumers want the newest ones */
+		xQueueReceive(nauSampleQueue, &oldest, 0);
+		xQueueSend(nauSampleQueue, &sample, 0);
+	}
+	if (DataStreamIsEnabled()) {
+		struct DataStreamWeightRecord record = {sample.tick * portTICK_PERIOD_MS, sample.raw};
+		DataStreamSend(DATA_STREAM_RECORD_WEIGHT, &record, sizeof(record));
+	}
+
+	/* The next conversion is ready one period after this one. Keep the polls one retry ahead of it */
+	if (nauPollMisses == 0 && nauPollEarly < NAU78_SAMPLE_TICKS / 2) {
+		nauPollEarly += pdMS_TO_TICKS(NAU78_STREAM_RETRY_MS);
+	} else if (nauPollMisses > 1 && nauPollEarly > pdMS_TO_TICKS(NAU78_STREAM_RETRY_MS)) {
+		nauPollEarly -= pdMS_TO_TICKS(NAU78_STREAM_RETRY_MS);
+	}
+	nauPollMisses = 0;
+	elapsed = xTaskGetTickCount() - pollStart;
+	if (elapsed + nauPollEarly >= NAU78_SAMPLE_TICKS) return 0;
+	return NAU78_SAMPLE_TICKS - nauPollEarly - elapsed;
+}
+
+/**
+ * @fn		static void NAU78_stream_task(void *pvParameters)
+ * @brief	Runs NAU78_stream_service, and sleeps between its steps or until the stream is started again
+ */
+static void NAU78_stream_task(void *pvParameters)
+{
+	TickType_t wait;
+
+	(void)pvParameters;
+
+	for (;;) {
+		wait = NAU78_stream_service();
+		if (wait == portMAX_DELAY) {
+			/* Only this task takes its notification: a start during the service leaves it pending */
+			if (!nauStreamRequested) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		} else if (wait > 0) {
+			vTaskDelay(wait);
+		}
+	}
+}
+
+/**
+ * @fn		int32_t NAU78_stream_start(void)
+ * @brief	Starts the stream: the ADC converts continuously and every sample goes to the queue (see NAU78_stream_read)
+ * @details	The first call creates the queue and the stream task (once: heap_1 can not free them). The ADC is reset and
+ *			calibrated once, by the stream task. Does nothing if the stream runs
+ * @return	Returns ERROR_NONE, or ERROR_NO_MEMORY if the queue or the task could not be created
+ * @note	Call after I2cInitializeDriver
+ */
+int32_t NAU78_stream_start(void)
+{
+	if (nauSampleQueue == NULL) {
+		nauSampleQueue = xQueueCreate(NAU78_STREAM_QUEUE_LENGTH, sizeof(struct nau78_sample));
+		if (nauSampleQueue == NULL) return ERROR_NO_MEMORY;
+	}
+	if (nauStreamTaskHandle == NULL) {
+		if (xTaskCreate(NAU78_stream_task, "NAU Task", NAU78_TASK_SIZE, NULL, NAU78_TASK_PRIORITY, &nauStreamTaskHandle) != pdPASS) {
+			nauStreamTaskHandle = NULL;
+			return ERROR_NO_MEMORY;
+		}
+	}
+	if (!nauStreamRequested) {
+		nauStreamRequested = true;
+		xTaskNotifyGive(nauStreamTaskHandle);
+	}
+	return ERROR_NONE;
+}
+
+/**
+ * @fn		void NAU78_stream_stop(void)
+ * @brief	Stops the conversions. The queued samples stay readable. NAU78_stream_start resumes without a new calibration
+ */
+void NAU78_stream_stop(void)
+{
+	nauStreamRequested = false;
+}
+
+/**
+ * @fn		bool NAU78_stream_read(struct nau78_sample *sample, TickType_t wait)
+ * @brief	Takes the oldest queued sample. For the one consumer of the stream (see NAU7802.h)
+ * @param[out] sample  Sample read
+ * @param[in] wait  Longest time to wait for a sample, in ticks (0: do not wait)
+ * @return	Returns true if a sample was read
+ */
+bool NAU78_stream_read(struct nau78_sample *sample, TickType_t wait)
+{
+	if (nauSampleQueue == NULL || sample == NULL) return false;
+	return xQueueReceive(nauSampleQueue, sample, wait) == pdPASS;
 }
\ No newline at end of file
@@ -83,16 +83,49 @@
 #define CALMOD_OFFSET_INTERNAL  (0<<CALMOD_Pos)  /* 00 = Offset Calibration Internal (default) */
 
 
-static int32_t reg_write(uint8_t reg, uint8_t *bufp,uint16_t len);
-static int32_t reg_read(uint8_t reg, uint8_t *bufp, uint16_t len);
+/* Conversion rate select (CTRL2) */
+
+#define CRS_Pos     (4)
+#define CRS_Msk     (7<<CRS_Pos)
+#define CRS_10SPS   (0<<CRS_Pos)  /* 000 = 10 samples per second (default) */
+#define CRS_20SPS   (1<<CRS_Pos)  /* 001 = 20 SPS */
+#define CRS_40SPS   (2<<CRS_Pos)  /* 010 = 40 SPS */
+#define CRS_80SPS   (3<<CRS_Pos)  /* 011 = 80 SPS */
+#define CRS_320SPS  (7<<CRS_Pos)  /* 111 = 320 SPS */
+
+/* Streaming
+ * The sample queue has one consumer: the task that reads it with NAU78_stream_read. get_raw_data and get_weight never
+ * take from it. While the stream runs they return the newest sample, which the stream task keeps apart; while it is
+ * stopped they do one conversion and leave the ADC stopped.
+ */
+
+#define NAU78_CRS                  CRS_10SPS  ///< Conversion rate set by NAU78_init, before the calibration
+#define NAU78_SPS                  10         ///< Samples per second of NAU78_CRS
+#define NAU78_SAMPLE_TICKS         pdMS_TO_TICKS(1000 / NAU78_SPS)  ///< One conversion period
+#define NAU78_STREAM_RETRY_MS      2          ///< Poll interval while the conversion is not ready, and how early each poll is
+#define NAU78_STREAM_QUEUE_LENGTH  8          ///< Samples kept for the consumers. When full, the oldest one is dropped
+#define NAU78_STREAM_TIMEOUT_MS    1000       ///< Longest wait of get_raw_data for a conversion. The first one follows init and calibration
+#define NAU78_TASK_SIZE            160        ///< Size of stack to assign to the NAU7802 stream task. In words
+#define NAU78_TASK_PRIORITY        (configMAX_PRIORITIES - 3)
+
+/// One conversion of the stream
+struct nau78_sample {
+	int32_t raw;           ///< Signed 24-bit conversion result
+	TickType_t tick;       ///< Tick count of the poll that found it ready
+	uint16_t sequence;     ///< Counts samples since the first start. A gap means the queue was full and samples were dropped
+};
+
+
 uint8_t read_a_reg(uint8_t u8RegAddr);
 uint8_t write_a_reg(uint8_t u8RegAddr, uint8_t data);
-static void NAU78_calibration(void);
 void  NAU78_init(void);
-static void cycle_ready(void);
 int32_t get_raw_data(void);
 float raw_data_to_weight(int raw_data);
 float get_weight(void);
 int32_t get_adc_id(void);
+int32_t NAU78_stream_start(void);
+void NAU78_stream_stop(void);
+bool NAU78_stream_read(struct nau78_sample *sample, TickType_t wait);
+TickType_t NAU78_stream_service(void);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,205 @@
+/**************************************************************************//**
+* @file      RunTimeStats.c
+* @brief     Per-task CPU usage, stack and heap statistics
+* @details   See RunTimeStats.h. RunTimeStatsTimerInit and RunTimeStatsGetCounter are called by the kernel through
+*			 portCONFIGURE_TIMER_FOR_RUN_TIME_STATS and portGET_RUN_TIME_COUNTER_VALUE (FreeRTOSConfig.h).
+* @author
+* @date      2026-10-16
+
+******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "RunTimeStats.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define RUN_TIME_STATS_MAX_SAMPLED	(RUN_TIME_STATS_MAX_TASKS + 4)	///< Room in the kernel snapshot. uxTaskGetSystemState returns nothing if there are more tasks than this
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+static struct tc_module runTimeStatsTc;							///< TC used as the run time counter
+static TaskStatus_t taskStatus[RUN_TIME_STATS_MAX_SAMPLED];		///< Kernel snapshot. Only used with the scheduler suspended
+static UBaseType_t previousTaskNumber[RUN_TIME_STATS_MAX_SAMPLED];	///< Task numbers of the previous sample
+static uint32_t previousRunTime[RUN_TIME_STATS_MAX_SAMPLED];		///< Run time counters of the previous sample
+static UBaseType_t previousCount = 0;							///< Valid entries of the previous sample
+static uint32_t previousTotal = 0;								///< Counter value at the previous sample. 0 is when the scheduler started
+static uint32_t bootMarks[BOOT_MARK_COUNT];						///< Counter value of each startup milestone, 0 if not reached yet
+static const char *const bootMarkNames[BOOT_MARK_COUNT] = {"I2C", "Seesaw", "IMU", "Distance", "Tasks", "Wi-Fi", "MQTT"};	///< Names printed by "boottime"
+
+/******************************************************************************
+ * Local Functions
+ ******************************************************************************/
+
+/**
+ * @fn		static uint32_t RunTimeStatsPreviousRunTime(UBaseType_t taskNumber)
+ * @brief	Returns the run time counter of a task at the previous sample, or 0 for a task created since
+ */
+static uint32_t RunTimeStatsPreviousRunTime(UBaseType_t taskNumber)
+{
+	for (UBaseType_t i = 0; i < previousCount; i++) {
+		if (previousTaskNumber[i] == taskNumber) return previousRunTime[i];
+	}
+	return 0;
+}
+
+/**
+ * @fn		static char RunTimeStatsStateLetter(eTaskState state)
+ * @brief	One letter summary of a task state, as printed by "top"
+ */
+static char RunTimeStatsStateLetter(eTaskState state)
+{
+	switch (state) {
+		case eRunning:
+		case eReady:
+			return 'R';
+		case eBlocked:
+			return 'B';
+		case eSuspended:
+			return 'S';
+		default:
+			return 'D';
+	}
+}
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn		void RunTimeStatsTimerInit(void)
+ * @brief	Starts the free-running counter used as the run time stats clock
+ * @note	Called by the kernel when the scheduler starts (portCONFIGURE_TIMER_FOR_RUN_TIME_STATS)
+ */
+void RunTimeStatsTimerInit(void)
+{
+	struct tc_config config_tc;
+	tc_get_config_defaults(&config_tc);
+	config_tc.counter_size = TC_COUNTER_SIZE_32BIT;
+	config_tc.clock_source = RUN_TIME_STATS_CLOCK_GENERATOR;
+	config_tc.clock_prescaler = TC_CLOCK_PRESCALER_DIV1;
+
+	tc_init(&runTimeStatsTc, RUN_TIME_STATS_TC, &config_tc);
+	tc_enable(&runTimeStatsTc);
+
+	// Keep COUNT continuously synchronized, so reading it never waits for the (slower) TC clock domain
+	while (tc_is_syncing(&runTimeStatsTc)) {
+	}
+	RUN_TIME_STATS_TC->COUNT32.READREQ.reg = TC_READREQ_RCONT | TC_READREQ_ADDR(TC_COUNT32_COUNT_OFFSET);
+}
+
+/**
+ * @fn		uint32_t RunTimeStatsGetCounter(void)
+ * @brief	Returns the run time stats clock, in 1/RUN_TIME_STATS_CLOCK_HZ s
+ * @note	Called by the kernel on every context switch (portGET_RUN_TIME_COUNTER_VALUE), so it must stay a single read
+ */
+uint32_t RunTimeStatsGetCounter(void)
+{
+	return RUN_TIME_STATS_TC->COUNT32.COUNT.reg;
+}
+
+/**
+ * @fn			void RunTimeStatsSample(struct RunTimeStatsReport *report)
+ * @brief		Reads the statistics of every task, with their CPU share since the previous sample
+ * @param[out]	report Statistics. Large (about 200 bytes): callers keep it static
+ * @note		Suspends the scheduler while the kernel walks the task lists and their stacks
+ */
+void RunTimeStatsSample(struct RunTimeStatsReport *report)
+{
+	uint32_t total;
+
+	vTaskSuspendAll();
+	UBaseType_t count = uxTaskGetSystemState(taskStatus, RUN_TIME_STATS_MAX_SAMPLED, &total);
+	uint32_t interval = total - previousTotal;
+
+	report->intervalUs = (uint32_t)(((uint64_t)interval * 1000000u) / RUN_TIME_STATS_CLOCK_HZ);
+	report->taskCount = 0;
+	report->tasksNotListed = 0;
+	for (UBaseType_t i = 0; i < count; i++) {
+		uint32_t ran = taskStatus[i].ulRunTimeCounter - RunTimeStatsPreviousRunTime(taskStatus[i].xTaskNumber);
+
+		if (report->taskCount >= RUN_TIME_STATS_MAX_TASKS) {
+			report->tasksNotListed++;
+			continue;
+		}
+		struct RunTimeStatsTask *task = &report->tasks[report->taskCount++];
+		strncpy(task->name, taskStatus[i].pcTaskName, sizeof(task->name) - 1);
+		task->name[sizeof(task->name) - 1] = '\0';
+		task->cpuPermille = (interval > 0) ? (uint16_t)(((uint64_t)ran * 1000u) / interval) : 0;
+		task->stackFree = taskStatus[i].usStackHighWaterMark;
+		task->priority = (uint8_t)taskStatus[i].uxCurrentPriority;
+		task->state = RunTimeStatsStateLetter(taskStatus[i].eCurrentState);
+	}
+
+	for (UBaseType_t i = 0; i < count; i++) {
+		previousTaskNumber[i] = taskStatus[i].xTaskNumber;
+		previousRunTime[i] = taskStatus[i].ulRunTimeCounter;
+	}
+	previousCount = count;
+	previousTotal = total;
+	(void)xTaskResumeAll();
+
+	report->heapFree = xPortGetFreeHeapSize();
+	report->heapTotal = configTOTAL_HEAP_SIZE;
+}
+
+/**
+ * @fn			int RunTimeStatsToJson(const struct RunTimeStatsReport *report, char *buffer, size_t len)
+ * @brief		Writes a report as a compact JSON object, for MQTT
+ * @details		{"t":<interval ms>,"heap":<free>,"tasks":[["<name>",<cpu 0.1 %>,<stack free words>],...]}
+ * @param[in]	report Statistics from RunTimeStatsSample
+ * @param[out]	buffer Output buffer
+ * @param[in]	len Size of buffer
+ * @return		Returns the length of the JSON text, or -1 if it does not fit in buffer
+ */
+int RunTimeStatsToJson(const struct RunTimeStatsReport *report, char *buffer, size_t len)
+{
+	int pos = snprintf(buffer, len, "{\"t\":%lu,\"heap\":%lu,\"tasks\":[", (unsigned long)(report->intervalUs / 1000), (unsigned long)report->heapFree);
+
+	for (uint8_t i = 0; i < report->taskCount && pos >= 0 && (size_t)pos < len; i++) {
+		const struct RunTimeStatsTask *task = &report->tasks[i];
+		pos += snprintf(buffer + pos, len - pos, "%s[\"%s\",%u,%u]", (i > 0) ? "," : "", task->name, task->cpuPermille, task->stackFree);
+	}
+	if (pos >= 0 && (size_t)pos < len) {
+		pos += snprintf(buffer + pos, len - pos, "]}");
+	}
+
+	return (pos >= 0 && (size_t)pos < len) ? pos : -1;
+}
+
+/**
+ * @fn		void RunTimeStatsMarkBoot(enum RunTimeStatsBootMark mark)
+ * @brief	Records the time of a startup milestone. Only the first call for each milestone counts (reconnects are ignored)
+ * @note	Times are counted from the start of the scheduler. The hardware initialization before it is not included
+ */
+void RunTimeStatsMarkBoot(enum RunTimeStatsBootMark mark)
+{
+	if (mark >= BOOT_MARK_COUNT || bootMarks[mark] != 0) return;
+
+	uint32_t now = RunTimeStatsGetCounter();
+	bootMarks[mark] = (now != 0) ? now : 1;
+}
+
+/**
+ * @fn		uint32_t RunTimeStatsGetBootMark(enum RunTimeStatsBootMark mark)
+ * @brief	Returns the time of a startup milestone in us since the scheduler started, or 0 if it was not reached yet
+ */
+uint32_t RunTimeStatsGetBootMark(enum RunTimeStatsBootMark mark)
+{
+	return (mark < BOOT_MARK_COUNT) ? bootMarks[mark] : 0;
+}
+
+/**
+ * @fn		const char *RunTimeStatsBootMarkName(enum RunTimeStatsBootMark mark)
+ * @brief	Returns the printable name of a startup milestone
+ */
+const char *RunTimeStatsBootMarkName(enum RunTimeStatsBootMark mark)
+{
+	return (mark < BOOT_MARK_COUNT) ? bootMarkNames[mark] : "?";
+}
@@ -0,0 +1,60 @@
+/**************************************************************************//**
+* @file      RunTimeStats.h
+* @brief     Per-task CPU usage, stack and heap statistics, for the "top" CLI command and the MQTT stats topic
+* @details   FreeRTOS is built with configGENERATE_RUN_TIME_STATS: on every context switch it adds the time the outgoing
+*			 task ran to that task's counter. The time base is a free-running 32-bit TC (TC4 + TC5) clocked at
+*			 RUN_TIME_STATS_CLOCK_HZ. It wraps every ~71 minutes, so CPU shares are computed from the difference between
+*			 two samples (which stays correct across a wrap) rather than from the totals since boot. The CPU share of a
+*			 task is therefore its share since the previous call to RunTimeStatsSample, by any caller.
+* @author
+* @date      2026-10-16
+
+******************************************************************************/
+
+#pragma once
+
+#include "asf.h"
+
+#define RUN_TIME_STATS_TC				TC4					///< 32-bit counter: TC4 is the master of the TC4 + TC5 pair
+#define RUN_TIME_STATS_CLOCK_GENERATOR	GCLK_GENERATOR_1	///< OSC8M / 8 (see conf_clocks.h)
+#define RUN_TIME_STATS_CLOCK_HZ			1000000				///< Counter frequency. 1000 counts per RTOS tick
+#define RUN_TIME_STATS_MAX_TASKS		10					///< Tasks reported. Extra tasks are counted in the total but not listed
+
+/// Statistics of one task
+struct RunTimeStatsTask {
+	char name[configMAX_TASK_NAME_LEN];	///< Task name, null terminated
+	uint16_t cpuPermille;				///< Share of the CPU since the previous sample, in 0.1 %
+	uint16_t stackFree;					///< Fewest free stack words since the task started (high water mark)
+	uint8_t priority;					///< Current priority
+	char state;							///< R: running or ready, B: blocked, S: suspended, D: deleted
+};
+
+/// Statistics of every task, as returned by RunTimeStatsSample
+struct RunTimeStatsReport {
+	uint32_t intervalUs;		///< Time covered by the CPU shares, in us
+	uint32_t heapFree;			///< Bytes left in the FreeRTOS heap
+	uint32_t heapTotal;			///< Size of the FreeRTOS heap
+	uint8_t taskCount;			///< Number of valid entries in tasks
+	uint8_t tasksNotListed;		///< Tasks that did not fit in tasks
+	struct RunTimeStatsTask tasks[RUN_TIME_STATS_MAX_TASKS];	///< One entry per task, in FreeRTOS order
+};
+
+/// Startup milestones, each recorded once by RunTimeStatsMarkBoot. Printed by the "boottime" CLI command
+enum RunTimeStatsBootMark {
+	BOOT_MARK_I2C = 0,		///< I2C driver initialized
+	BOOT_MARK_SEESAW,		///< Seesaw initialized
+	BOOT_MARK_IMU,			///< IMU initialized (or not found)
+	BOOT_MARK_DISTANCE,		///< Distance sensor initialized
+	BOOT_MARK_TASKS,		///< Application tasks created
+	BOOT_MARK_WIFI,			///< Wi-Fi connected, IP address received
+	BOOT_MARK_MQTT,			///< MQTT broker accepted the connection
+	BOOT_MARK_COUNT			///< Number of milestones
+};
+
+void RunTimeStatsTimerInit(void);
+uint32_t RunTimeStatsGetCounter(void);
+void RunTimeStatsSample(struct RunTimeStatsReport *report);
+int RunTimeStatsToJson(const struct RunTimeStatsReport *report, char *buffer, size_t len);
+void RunTimeStatsMarkBoot(enum RunTimeStatsBootMark mark);
+uint32_t RunTimeStatsGetBootMark(enum RunTimeStatsBootMark mark);
+const char *RunTimeStatsBootMarkName(enum RunTimeStatsBootMark mark);
@@ -13,6 +13,7 @@
 #include "I2cDriver/I2cDriver.h"
 
 #define NEO_TRELLIS_ADDR 0x2E
+#define NEO_TRELLIS_I2C_SPEED_HZ 400000  ///< Bus speed of the Seesaw (Fast mode)
 
 #define NEO_TRELLIS_NEOPIX_PIN 3
 
@@ -21,6 +22,11 @@
 #define NEO_TRELLIS_NUM_KEYS (NEO_TRELLIS_NUM_ROWS * NEO_TRELLIS_NUM_COLS)
 
 #define NEO_TRELLIS_MAX_CALLBACKS 32
+#define NEO_TRELLIS_LED_TEST_MS 400  ///< Time key 15 stays lit by the LED self-test at the start of the UI task. 0: no self-test
+
+#define SEESAW_MAX_WRITE 32                                   ///< Longest I2C write the Seesaw firmware takes (module base and function included)
+#define SEESAW_NEOPIXEL_BUF_HEADER 4                          ///< Base, function and 16-bit offset before the data of a SEESAW_NEOPIXEL_BUF write
+#define SEESAW_NEOPIXEL_KEYS_PER_WRITE ((SEESAW_MAX_WRITE - SEESAW_NEOPIXEL_BUF_HEADER) / 3)  ///< Whole pixels in one SEESAW_NEOPIXEL_BUF write (9)
 
 #define NEO_TRELLIS_KEY(x) (((x) / 4) * 8 + ((x) % 4))         ///< Converts a number from Key 0 - Key 15 into the number used by the Neotrellis (0-3, 8-11, 16-19, 24-27)
 #define NEO_TRELLIS_SEESAW_KEY(x) (((x) / 8) * 4 + ((x) % 8))  ///< Converts a Neotrellis Key (0-3, 8-11, 16-19, 24-27) into a key number (0 to 15)
@@ -269,5 +275,8 @@ uint8_t SeesawGetKeypadCount(void);
 int32_t SeesawReadKeypad(uint8_t *buffer, uint8_t count);
 int32_t SeesawSetLed(uint8_t key, uint8_t red, uint8_t green, uint8_t blue);
 int32_t SeesawOrderLedUpdate(void);
+int32_t SeesawWriteLeds(uint8_t firstKey, const uint8_t *rgb, uint8_t count);
+int32_t SeesawSetFrame(const uint8_t *rgb);
 int32_t SeesawActivateKey(uint8_t key, uint8_t edge, bool enable);
+int32_t SeesawActivateKeyEdges(uint8_t key, uint8_t edges, bool enable);
 #endif
\ No newline at end of file
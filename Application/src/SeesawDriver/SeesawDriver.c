@@ -23,7 +23,6 @@
 /******************************************************************************
  * Variables
  ******************************************************************************/
-I2C_Data seesawData;  ///< Global variable to use for I2C communications with the Seesaw Device
 /******************************************************************************
  * Forward Declarations
  ******************************************************************************/
@@ -38,16 +37,43 @@ const uint8_t msgKeypadGetCount[2] = {SEESAW_KEYPAD_BASE, SEESAW_KEYPAD_COUNT};
  * Callback Functions
  ******************************************************************************/
 
-static void SeesawTurnOnLedTest(void);
 static void SeesawInitializeKeypad(void);
 /******************************************************************************
  * Functions
  ******************************************************************************/
 
+/**
+ * @fn		static int32_t SeesawWrite(const uint8_t *msg, uint16_t len)
+ * @brief	Sends a command (module base, function, data) to the Seesaw
+ * @details	The I2C description lives on the caller's stack, so any task may call the driver
+ * @return		Returns zero if no I2C errors occurred. Other number in case of error
+ */
+static int32_t SeesawWrite(const uint8_t *msg, uint16_t len)
+{
+    I2C_Data data;
+    data.address = NEO_TRELLIS_ADDR;
+    data.msgOut = msg;
+    data.lenOut = len;
+    data.msgIn = NULL;
+    data.lenIn = 0;
+    return I2cWriteDataWait(&data, 100);
+}
+
+/**
+ * @fn		static int32_t SeesawRead(const uint8_t *cmd, uint8_t *buffer, uint16_t len)
+ * @brief	Reads len bytes of a Seesaw register (cmd: module base, function)
+ * @return		Returns zero if no I2C errors occurred. Other number in case of error
+ */
+static int32_t SeesawRead(const uint8_t *cmd, uint8_t *buffer, uint16_t len)
+{
+    return I2cReadRegister(NEO_TRELLIS_ADDR, cmd, 2, buffer, len, 0, 100);
+}
+
 /**
  * @fn		int InitializeSeesaw(void)
  * @brief	Initializes the Seesaw 4x4
- * @details 	Assumes I2C is already initialized
+ * @details 	Assumes I2C is already initialized. Takes about 20 I2C writes and does not wait: the LED self-test runs
+                in the UI task (NEO_TRELLIS_LED_TEST_MS), so it does not delay the start of the other tasks
 
  * @return		Returns 0 if no errors.
  * @note
@@ -55,15 +81,12 @@ static void SeesawInitializeKeypad(void);
 int InitializeSeesaw(void)
 {
     uint8_t readData[2];
-    seesawData.address = NEO_TRELLIS_ADDR;
-    seesawData.msgOut = &msgBaseGetHWID[0];
-    seesawData.lenOut = sizeof(msgBaseGetHWID);
-    seesawData.msgIn = &readData[0];
-    seesawData.lenIn = 1;
+
+    I2cSetDeviceSpeed(NEO_TRELLIS_ADDR, NEO_TRELLIS_I2C_SPEED_HZ);
 
     // Check if device is on the line - it should answer with its HW ID
 
-    int error = I2cReadDataWait(&seesawData, 0, 100);
+    int error = SeesawRead(&msgBaseGetHWID[0], &readData[0], 1);
 
     if (ERROR_NONE != error) {
         SerialConsoleWriteString("Error initializing Seesaw!/r/n");
@@ -76,34 +99,23 @@ int InitializeSeesaw(void)
     }
 
     // Tell the Seesaw which pins to use
-    seesawData.msgOut = &msgNeopixelPin[0];
-    seesawData.lenOut = sizeof(msgNeopixelPin);
-
-    error = I2cWriteDataWait(&seesawData, 100);
+    error = SeesawWrite(&msgNeopixelPin[0], sizeof(msgNeopixelPin));
     if (ERROR_NONE != error) {
         SerialConsoleWriteString("Could not write Seesaw pin!/r/n");
     }
 
     // Set seesaw Neopixel speed
-    seesawData.msgOut = &msgNeopixelSpeed[0];
-    seesawData.lenOut = sizeof(msgNeopixelSpeed);
-
-    error = I2cWriteDataWait(&seesawData, 100);
+    error = SeesawWrite(&msgNeopixelSpeed[0], sizeof(msgNeopixelSpeed));
     if (ERROR_NONE != error) {
         SerialConsoleWriteString("Could not set seesaw Neopixel speed!/r/n");
     }
 
     // Set seesaw Neopixel number of devices
-    seesawData.msgOut = &msgNeopixelBufLength[0];
-    seesawData.lenOut = sizeof(msgNeopixelBufLength);
-
-    error = I2cWriteDataWait(&seesawData, 100);
+    error = SeesawWrite(&msgNeopixelBufLength[0], sizeof(msgNeopixelBufLength));
     if (ERROR_NONE != error) {
         SerialConsoleWriteString("Could not set seesaw Neopixel number of devices/r/n");
     }
 
-    SeesawTurnOnLedTest();
-
     SeesawInitializeKeypad();
     return error;
 }
@@ -119,13 +131,8 @@ int InitializeSeesaw(void)
 uint8_t SeesawGetKeypadCount(void)
 {
     uint8_t count = 0;
-    seesawData.address = NEO_TRELLIS_ADDR;
-    seesawData.msgOut = &msgKeypadGetCount[0];
-    seesawData.lenOut = sizeof(msgKeypadGetCount);
-    seesawData.msgIn = &count;
-    seesawData.lenIn = 1;
 
-    int error = I2cReadDataWait(&seesawData, 0, 100);
+    int error = SeesawRead(&msgKeypadGetCount[0], &count, 1);
 
     if (ERROR_NONE != error) {
         SerialConsoleWriteString("Error reading Seesaw counts!/r/n");
@@ -145,14 +152,9 @@ uint8_t SeesawGetKeypadCount(void)
 int32_t SeesawReadKeypad(uint8_t *buffer, uint8_t count)
 {
     if (count == 0) return ERROR_NONE;
-    uint8_t cmd[] = {SEESAW_KEYPAD_BASE, SEESAW_KEYPAD_FIFO};
-    seesawData.address = NEO_TRELLIS_ADDR;
-    seesawData.msgOut = (const uint8_t*) &cmd[0];
-    seesawData.lenOut = sizeof(cmd);
-    seesawData.msgIn = buffer;
-    seesawData.lenIn = count;
+    const uint8_t cmd[] = {SEESAW_KEYPAD_BASE, SEESAW_KEYPAD_FIFO};
 
-    int error = I2cReadDataWait(&seesawData, 0, 100);
+    int error = SeesawRead(&cmd[0], buffer, count);
 
     if (ERROR_NONE != error) {
         SerialConsoleWriteString("Error reading Seesaw counts!/r/n");
@@ -171,18 +173,28 @@ int32_t SeesawReadKeypad(uint8_t *buffer, uint8_t count)
  * @note
 */
 int32_t SeesawActivateKey(uint8_t key, uint8_t edge, bool enable)
+{
+    return SeesawActivateKeyEdges(key, (1 << edge), enable);
+}
+
+/**
+ int32_t SeesawActivateKeyEdges(uint8_t key, uint8_t edges, bool enable)
+ * @brief	Like SeesawActivateKey, for several events of a key in one write
+ * @param[in] key  Key number (0 to 15)
+ * @param[in] edges Bit per event to listen to, for example (1 << SEESAW_KEYPAD_EDGE_RISING) | (1 << SEESAW_KEYPAD_EDGE_FALLING)
+ * @param[in]  enable  Boolean. If true, add the events to the listener. If false, remove them
+
+ * @return		Returns zero if no I2C errors occurred. Other number in case of error
+ * @note         The Seesaw takes one key per SEESAW_KEYPAD_EVENT write, so the whole keypad takes 16 writes
+*/
+int32_t SeesawActivateKeyEdges(uint8_t key, uint8_t edges, bool enable)
 {
     union keyState ks;
     ks.bit.STATE = enable;
-    ks.bit.ACTIVE = (1 << edge);
+    ks.bit.ACTIVE = edges;
     uint8_t cmd[] = {SEESAW_KEYPAD_BASE, SEESAW_KEYPAD_EVENT, key, ks.reg};
 
-    seesawData.address = NEO_TRELLIS_ADDR;
-    seesawData.msgOut = (const uint8_t *) &cmd[0];
-    seesawData.lenOut = sizeof(cmd);
-    seesawData.lenIn = 0;
-    int32_t error = I2cWriteDataWait(&seesawData, 100);
-    return error;
+    return SeesawWrite(&cmd[0], sizeof(cmd));
 }
 
 /**
@@ -205,10 +217,7 @@ int32_t SeesawSetLed(uint8_t key, uint8_t red, uint8_t green, uint8_t blue)
     write_buffer1[2] = (offset >> 8);
     write_buffer1[3] = (offset);
 
-    seesawData.msgOut = (const uint8_t *)&write_buffer1[0];
-    seesawData.lenOut = sizeof(write_buffer1);
-    int error = I2cWriteDataWait(&seesawData, 100);
-    return error;
+    return SeesawWrite(&write_buffer1[0], sizeof(write_buffer1));
 }
 
 /**
@@ -223,10 +232,62 @@ int32_t SeesawOrderLedUpdate(void)
 {
     uint8_t orderBuffer[2] = {SEESAW_NEOPIXEL_BASE, SEESAW_NEOPIXEL_SHOW};
 
-    seesawData.msgOut = (const uint8_t *) &orderBuffer[0];
-    seesawData.lenOut = sizeof(orderBuffer);
-    int error = I2cWriteDataWait(&seesawData, 100);
-    return error;
+    return SeesawWrite(&orderBuffer[0], sizeof(orderBuffer));
+}
+
+/**
+ int32_t SeesawWriteLeds(uint8_t firstKey, const uint8_t *rgb, uint8_t count)
+ * @brief	Writes the colors of count consecutive keys into the Seesaw NeoPixel buffer
+ * @details	The keys are sent SEESAW_NEOPIXEL_KEYS_PER_WRITE at a time, so a full frame takes 2 writes instead of 16
+ * @param[in] firstKey  First key number (0 to 15)
+ * @param[in] rgb  Red, green and blue of each key, 3 bytes per key
+ * @param[in] count  Number of keys to write
+
+ * @return		Returns zero if no I2C errors occurred. Other number in case of error
+ * @note         Like SeesawSetLed, the LEDs wont change until you send a "SeesawOrderLedUpdate" command.
+*/
+int32_t SeesawWriteLeds(uint8_t firstKey, const uint8_t *rgb, uint8_t count)
+{
+    uint8_t msg[SEESAW_NEOPIXEL_BUF_HEADER + SEESAW_NEOPIXEL_KEYS_PER_WRITE * 3] = {SEESAW_NEOPIXEL_BASE, SEESAW_NEOPIXEL_BUF};
+
+    if (rgb == NULL || firstKey >= NEO_TRELLIS_NUM_KEYS || count > NEO_TRELLIS_NUM_KEYS - firstKey) return ERROR_INVALID_ARG;
+
+    while (count > 0) {
+        uint8_t keys = (count < SEESAW_NEOPIXEL_KEYS_PER_WRITE) ? count : SEESAW_NEOPIXEL_KEYS_PER_WRITE;
+        uint16_t offset = 3 * firstKey;  // RGB LED
+        msg[2] = (offset >> 8);
+        msg[3] = (offset);
+        for (uint8_t i = 0; i < keys; i++) {
+            // The NeoPixels take green first (GRB)
+            msg[SEESAW_NEOPIXEL_BUF_HEADER + 3 * i] = rgb[3 * i + 1];
+            msg[SEESAW_NEOPIXEL_BUF_HEADER + 3 * i + 1] = rgb[3 * i];
+            msg[SEESAW_NEOPIXEL_BUF_HEADER + 3 * i + 2] = rgb[3 * i + 2];
+        }
+
+        int32_t error = SeesawWrite(&msg[0], SEESAW_NEOPIXEL_BUF_HEADER + 3 * keys);
+        if (ERROR_NONE != error) return error;
+
+        firstKey += keys;
+        rgb += 3 * keys;
+        count -= keys;
+    }
+    return ERROR_NONE;
+}
+
+/**
+ int32_t SeesawSetFrame(const uint8_t *rgb)
+ * @brief	Sets all 16 LEDs and shows them: 2 buffer writes and one SHOW command
+ * @param[in] rgb  Red, green and blue of keys 0 to 15, 3 bytes per key (NEO_TRELLIS_NUM_KEYS * 3 bytes)
+
+ * @return		Returns zero if no I2C errors occurred. Other number in case of error
+ * @note         Use instead of SeesawSetLed on every key followed by SeesawOrderLedUpdate (17 transactions).
+*/
+int32_t SeesawSetFrame(const uint8_t *rgb)
+{
+    int32_t error = SeesawWriteLeds(0, rgb, NEO_TRELLIS_NUM_KEYS);
+    if (ERROR_NONE != error) return error;
+
+    return SeesawOrderLedUpdate();
 }
 
 /*****************************************************************************************
@@ -235,32 +296,16 @@ int32_t SeesawOrderLedUpdate(void)
  ****************************************************************************************/
 static void SeesawInitializeKeypad(void)
 {
-    seesawData.address = NEO_TRELLIS_ADDR;
-    seesawData.msgOut = &msgKeypadEnableInt[0];
-    seesawData.lenOut = sizeof(msgKeypadEnableInt);
-    seesawData.lenIn = 0;
-
-    int32_t error = I2cWriteDataWait(&seesawData, 100);
+    int32_t error = SeesawWrite(&msgKeypadEnableInt[0], sizeof(msgKeypadEnableInt));
     if (ERROR_NONE != error) {
         SerialConsoleWriteString("Could not initialize Keypad!/r/n");
     }
 
-    // Initialize all buttons to register an event for both press and release
+    // Initialize all buttons to register an event for both press and release, one write per key
     for (int i = 0; i < 16; i++) {
-        error = SeesawActivateKey(NEO_TRELLIS_KEY(i), SEESAW_KEYPAD_EDGE_RISING, true);
-        error |= SeesawActivateKey(NEO_TRELLIS_KEY(i), SEESAW_KEYPAD_EDGE_FALLING, true);
+        error = SeesawActivateKeyEdges(NEO_TRELLIS_KEY(i), (1 << SEESAW_KEYPAD_EDGE_RISING) | (1 << SEESAW_KEYPAD_EDGE_FALLING), true);
         if (ERROR_NONE != error) {
             SerialConsoleWriteString("Could not initialize Keypad!/r/n");
         }
     }
-}
-
-static void SeesawTurnOnLedTest(void)
-{
-    SeesawSetLed(15, 255, 255, 255);
-    SeesawOrderLedUpdate();
-    vTaskDelay(400);
-
-    SeesawSetLed(15, 0, 0, 0);
-    SeesawOrderLedUpdate();
 }
\ No newline at end of file
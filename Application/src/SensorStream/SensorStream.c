@@ -0,0 +1,128 @@
+/**************************************************************************/ /**
+ * @file      SensorStream.c
+ * @brief     Feeds the binary sensor stream (DataStream.h) with the IMU and distance sensor samples
+ * @details   See SensorStream.h. The task is created at the first SensorStreamStart (heap_1 can not free it) and sleeps
+ *            on its notification while the stream is off.
+ * @author
+ * @date      2026-10-16
+
+ ******************************************************************************/
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "SensorStream/SensorStream.h"
+
+#include "DistanceDriver/DistanceSensor.h"
+#include "I2cDriver/I2cDriver.h"
+#include "IMU/lsm6dso_reg.h"
+#include "NAU78/NAU7802.h"
+#include "SerialConsole/DataStream.h"
+
+#include <string.h>
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+static TaskHandle_t sensorStreamTaskHandle = NULL;  ///< Stream task, created at the first SensorStreamStart
+
+/******************************************************************************
+ * Local Functions
+ ******************************************************************************/
+
+/**
+ * @fn		static void SensorStreamImu(void)
+ * @brief	Sends the IMU sample, if the LSM6DSO has a new one
+ */
+static void SensorStreamImu(void)
+{
+    struct DataStreamImuRecord record;
+    stmdev_ctx_t *dev_ctx = GetImuStruct();
+    int16_t acceleration[3];
+    int16_t angularRate[3];
+    uint8_t ready = 0;
+
+    if (lsm6dso_xl_flag_data_ready_get(dev_ctx, &ready) != 0 || !ready) return;
+
+    record.timestampMs = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    if (lsm6dso_acceleration_raw_get(dev_ctx, acceleration) != 0) return;
+    if (lsm6dso_angular_rate_raw_get(dev_ctx, angularRate) != 0) return;
+    // The record is packed: copy, do not hand the driver pointers into it
+    memcpy(record.acceleration, acceleration, sizeof(acceleration));
+    memcpy(record.angularRate, angularRate, sizeof(angularRate));
+    DataStreamSend(DATA_STREAM_RECORD_IMU, &record, sizeof(record));
+}
+
+/**
+ * @fn		static void SensorStreamDistance(void)
+ * @brief	Reads the US-100 and sends the distance
+ */
+static void SensorStreamDistance(void)
+{
+    struct DataStreamDistanceRecord record;
+    uint16_t distance = 0;
+
+    record.timestampMs = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    if (DistanceSensorGetDistance(&distance, pdMS_TO_TICKS(SENSOR_STREAM_DISTANCE_TIMEOUT_MS)) != ERROR_NONE) return;
+    record.distanceMm = distance;
+    DataStreamSend(DATA_STREAM_RECORD_DISTANCE, &record, sizeof(record));
+}
+
+/**
+ * @fn		static void vSensorStreamTask(void *pvParameters)
+ * @brief	Polls the sensors at SENSOR_STREAM_PERIOD_MS while the stream is on, sleeps otherwise
+ */
+static void vSensorStreamTask(void *pvParameters)
+{
+    TickType_t lastWake = xTaskGetTickCount();
+    uint8_t distanceCount = 0;
+
+    for (;;) {
+        if (!DataStreamIsEnabled()) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            lastWake = xTaskGetTickCount();
+            continue;
+        }
+
+        SensorStreamImu();
+        if (++distanceCount >= SENSOR_STREAM_DISTANCE_DIVIDER) {
+            distanceCount = 0;
+            SensorStreamDistance();
+        }
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(SENSOR_STREAM_PERIOD_MS));
+    }
+}
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn		int32_t SensorStreamStart(void)
+ * @brief	Turns the binary stream on and starts its producers: the IMU and distance task, and the NAU7802 stream
+ * @return	Returns ERROR_NONE, or ERROR_NO_MEMORY if a task or queue could not be created. The stream is then off
+ */
+int32_t SensorStreamStart(void)
+{
+    if (sensorStreamTaskHandle == NULL) {
+        if (xTaskCreate(vSensorStreamTask, "STREAM", SENSOR_STREAM_TASK_SIZE, NULL, SENSOR_STREAM_PRIORITY, &sensorStreamTaskHandle) != pdPASS) {
+            sensorStreamTaskHandle = NULL;
+            return ERROR_NO_MEMORY;
+        }
+    }
+    if (NAU78_stream_start() != ERROR_NONE) return ERROR_NO_MEMORY;
+
+    DataStreamSetEnabled(true);
+    xTaskNotifyGive(sensorStreamTaskHandle);
+    return ERROR_NONE;
+}
+
+/**
+ * @fn		void SensorStreamStop(void)
+ * @brief	Turns the binary stream off. The task sleeps after its current poll. The NAU7802 stream keeps converting
+ *			for get_weight, but stops sending records
+ */
+void SensorStreamStop(void)
+{
+    DataStreamSetEnabled(false);
+}
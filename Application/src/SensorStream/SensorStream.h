@@ -0,0 +1,40 @@
+/**************************************************************************/ /**
+ * @file      SensorStream.h
+ * @brief     Feeds the binary sensor stream (DataStream.h) with the IMU and distance sensor samples
+ * @details   While the stream is on, a task polls the LSM6DSO and sends every new sample as a DATA_STREAM_RECORD_IMU
+ *            record, and reads the US-100 every SENSOR_STREAM_DISTANCE_DIVIDER polls (DATA_STREAM_RECORD_DISTANCE).
+ *            Weight records are sent by the NAU7802 stream itself, one per conversion. The records are packed
+ *            straight from the raw registers: no formatting on the target.
+ * @author
+ * @date      2026-10-16
+
+ ******************************************************************************/
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "asf.h"
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define SENSOR_STREAM_TASK_SIZE 160                          ///< Size of stack to assign to the stream task. In words
+#define SENSOR_STREAM_PRIORITY (configMAX_PRIORITIES - 3)    ///< Same as the other sensor users
+#define SENSOR_STREAM_PERIOD_MS 20                           ///< IMU data ready poll. Catches every sample of the 12.5 Hz ODR set by InitImu
+#define SENSOR_STREAM_DISTANCE_DIVIDER 5                     ///< A distance reading every 5 polls (10 Hz)
+#define SENSOR_STREAM_DISTANCE_TIMEOUT_MS 50                 ///< Longest wait for each phase of a US-100 reading
+
+/******************************************************************************
+ * Global Function Declaration
+ ******************************************************************************/
+int32_t SensorStreamStart(void);
+void SensorStreamStop(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,325 @@
+/**
+ * @file        BinaryLog.c
+ * @ingroup 	   Serial Console
+ * @brief       Encoder for the deferred (binary) logging mode of LogMessage.
+ * @details     Walks the format string of a call site once to know the type of each argument, then copies the
+ *				arguments in their raw form. This is what lets a log call skip vsnprintf. See BinaryLog.h for the record layout.
+ *
+ * @copyright
+ * @author
+ * @date        October 16, 2026
+ * @version		0.2
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "BinaryLog.h"
+
+#include <string.h>
+
+/******************************************************************************
+ * Structures and Enumerations
+ ******************************************************************************/
+/// Write position inside the record being encoded
+typedef struct BinaryLogWriter {
+    uint8_t *buffer;  ///< Start of the record
+    size_t pos;       ///< Number of bytes written so far
+    size_t maxLen;    ///< Size of the record buffer
+} BinaryLogWriter;
+
+/// State of a signature, in its first byte
+enum eBinaryLogSignatureState {
+    BINARY_LOG_SIGNATURE_NEW = 0,      ///< The site has not been called yet (zero-initialized)
+    BINARY_LOG_SIGNATURE_READY,        ///< The argument types follow
+    BINARY_LOG_SIGNATURE_UNSUPPORTED,  ///< Unknown conversion or too many arguments: the site is sent as text
+};
+
+/// Type of one argument in a signature: how va_arg reads it and how it is sent
+enum eBinaryLogArgument {
+    BINARY_LOG_ARG_END = 0,         ///< No more arguments
+    BINARY_LOG_ARG_INT,             ///< int (also char and short, promoted), zigzag
+    BINARY_LOG_ARG_LONG,            ///< long, zigzag
+    BINARY_LOG_ARG_LONG_LONG,       ///< long long and intmax_t, zigzag
+    BINARY_LOG_ARG_PTRDIFF,         ///< ptrdiff_t (%zd, %td), zigzag
+    BINARY_LOG_ARG_UINT,            ///< unsigned int, varint
+    BINARY_LOG_ARG_ULONG,           ///< unsigned long, varint
+    BINARY_LOG_ARG_ULONG_LONG,      ///< unsigned long long and uintmax_t, varint
+    BINARY_LOG_ARG_SIZE,            ///< size_t, varint
+    BINARY_LOG_ARG_POINTER,         ///< void *, varint
+    BINARY_LOG_ARG_DOUBLE,          ///< double, 8 bytes
+    BINARY_LOG_ARG_LONG_DOUBLE,     ///< long double, sent as a double
+    BINARY_LOG_ARG_WIDTH,           ///< int of a '*' width, zigzag
+    BINARY_LOG_ARG_PRECISION,       ///< int of a '*' precision, zigzag. Also cuts the next %s
+    BINARY_LOG_ARG_SKIP,            ///< void * of %n, not sent
+    BINARY_LOG_ARG_STRING,          ///< const char *, length and characters
+    BINARY_LOG_ARG_STRING_CUT,      ///< %s with a precision: BINARY_LOG_ARG_STRING_CUT + precision (at most BINARY_LOG_MAX_STRING_SIZE)
+};
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+extern const BinaryLogFormat __start_binary_log[];  ///< First format entry. Defined by the linker for the binary_log output section
+
+/******************************************************************************
+ * Local Functions
+ ******************************************************************************/
+
+/**
+ * @fn			static int BinaryLogPutVarint(BinaryLogWriter *writer, uint64_t value)
+ * @brief		Appends an unsigned LEB128 varint to the record
+ * @return		Returns 0 on success, -1 if the record is full
+ */
+static int BinaryLogPutVarint(BinaryLogWriter *writer, uint64_t value)
+{
+    do {
+        if (writer->pos >= writer->maxLen) return -1;
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        writer->buffer[writer->pos++] = (value != 0) ? (byte | 0x80) : byte;
+    } while (value != 0);
+    return 0;
+}
+
+/**
+ * @fn			static int BinaryLogPutSigned(BinaryLogWriter *writer, int64_t value)
+ * @brief		Appends a signed integer as a zigzag varint, so small negative numbers stay short
+ * @return		Returns 0 on success, -1 if the record is full
+ */
+static int BinaryLogPutSigned(BinaryLogWriter *writer, int64_t value)
+{
+    return BinaryLogPutVarint(writer, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+/**
+ * @fn			static int BinaryLogPutDouble(BinaryLogWriter *writer, double value)
+ * @brief		Appends a double as 8 bytes, little endian
+ * @return		Returns 0 on success, -1 if the record is full
+ */
+static int BinaryLogPutDouble(BinaryLogWriter *writer, double value)
+{
+    uint64_t raw;
+    memcpy(&raw, &value, sizeof(raw));
+    if (writer->pos + sizeof(raw) > writer->maxLen) return -1;
+    for (size_t i = 0; i < sizeof(raw); i++) {
+        writer->buffer[writer->pos++] = (uint8_t)(raw >> (8 * i));
+    }
+    return 0;
+}
+
+/**
+ * @fn			static int BinaryLogPutString(BinaryLogWriter *writer, const char *string, int precision)
+ * @brief		Appends a length-prefixed copy of a string. The copy is cut to BINARY_LOG_MAX_STRING_SIZE, to the
+ *				precision of the conversion and to the space left in the record.
+ * @return		Returns 0 on success, -1 if the record is full
+ */
+static int BinaryLogPutString(BinaryLogWriter *writer, const char *string, int precision)
+{
+    if (string == NULL) string = "(null)";
+
+    size_t maxChars = BINARY_LOG_MAX_STRING_SIZE;
+    if (precision >= 0 && (size_t)precision < maxChars) maxChars = (size_t)precision;
+    if (writer->pos + 1 >= writer->maxLen) return -1;
+    if (maxChars > writer->maxLen - writer->pos - 1) maxChars = writer->maxLen - writer->pos - 1;  // Length fits in one varint byte
+
+    size_t len = 0;
+    while (len < maxChars && string[len] != '\0') len++;
+
+    writer->buffer[writer->pos++] = (uint8_t)len;
+    memcpy(&writer->buffer[writer->pos], string, len);
+    writer->pos += len;
+    return 0;
+}
+
+/**
+ * @fn			static uint8_t BinaryLogParse(const char *format, uint8_t *signature)
+ * @brief		Walks a format string once and writes the type of each argument it consumes into signature
+ * @param[in]	format printf-style format string
+ * @param[out]	signature Types from signature[1], followed by BINARY_LOG_ARG_END if there are fewer than BINARY_LOG_MAX_ARGUMENTS
+ * @return		Returns BINARY_LOG_SIGNATURE_READY, or BINARY_LOG_SIGNATURE_UNSUPPORTED for an unknown conversion or too many arguments
+ * @note		Supports the C99 printf conversions (flags, width and precision including '*', length modifiers).
+ */
+static uint8_t BinaryLogParse(const char *format, uint8_t *signature)
+{
+    uint8_t count = 0;
+
+    for (const char *p = format; *p != '\0'; p++) {
+        if (*p != '%') continue;
+        p++;
+        if (*p == '%') continue;
+
+        // Flags and width
+        while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0') p++;
+        if (*p == '*') {
+            if (count >= BINARY_LOG_MAX_ARGUMENTS) return BINARY_LOG_SIGNATURE_UNSUPPORTED;
+            signature[1 + count++] = BINARY_LOG_ARG_WIDTH;
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') p++;
+        }
+
+        // Precision
+        int precision = -1;
+        if (*p == '.') {
+            p++;
+            precision = 0;
+            if (*p == '*') {
+                if (count >= BINARY_LOG_MAX_ARGUMENTS) return BINARY_LOG_SIGNATURE_UNSUPPORTED;
+                signature[1 + count++] = BINARY_LOG_ARG_PRECISION;
+                precision = -1;  // Only known at the call
+                p++;
+            } else {
+                while (*p >= '0' && *p <= '9') {
+                    if (precision <= BINARY_LOG_MAX_STRING_SIZE) precision = precision * 10 + (*p - '0');
+                    p++;
+                }
+            }
+        }
+
+        // Length modifiers
+        char length = 0;  // 0: int, 'l': long, 'q': long long, 'z': size_t/ptrdiff_t, 'L': long double
+        while (*p == 'h' || *p == 'l' || *p == 'z' || *p == 'j' || *p == 't' || *p == 'L') {
+            if (*p == 'l') {
+                length = (length == 'l') ? 'q' : 'l';
+            } else if (*p == 'z' || *p == 'j' || *p == 't') {
+                length = (*p == 'j') ? 'q' : 'z';
+            } else if (*p == 'L') {
+                length = 'L';
+            }
+            p++;
+        }
+
+        uint8_t type;
+        switch (*p) {
+            case 'd':
+            case 'i':
+                type = (length == 'q') ? BINARY_LOG_ARG_LONG_LONG : (length == 'l') ? BINARY_LOG_ARG_LONG : (length == 'z') ? BINARY_LOG_ARG_PTRDIFF : BINARY_LOG_ARG_INT;
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+            case 'c':
+                type = (length == 'q') ? BINARY_LOG_ARG_ULONG_LONG : (length == 'l') ? BINARY_LOG_ARG_ULONG : (length == 'z') ? BINARY_LOG_ARG_SIZE : BINARY_LOG_ARG_UINT;
+                break;
+            case 'p':
+                type = BINARY_LOG_ARG_POINTER;
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                type = (length == 'L') ? BINARY_LOG_ARG_LONG_DOUBLE : BINARY_LOG_ARG_DOUBLE;
+                break;
+            case 's':
+                type = (precision >= 0 && precision <= BINARY_LOG_MAX_STRING_SIZE) ? (uint8_t)(BINARY_LOG_ARG_STRING_CUT + precision) : BINARY_LOG_ARG_STRING;
+                break;
+            case 'n':
+                type = BINARY_LOG_ARG_SKIP;
+                break;
+            default:
+                return BINARY_LOG_SIGNATURE_UNSUPPORTED;  // Unknown conversion, or end of the format string. The decoder could not follow either
+        }
+        if (count >= BINARY_LOG_MAX_ARGUMENTS) return BINARY_LOG_SIGNATURE_UNSUPPORTED;
+        signature[1 + count++] = type;
+    }
+
+    if (count < BINARY_LOG_MAX_ARGUMENTS) signature[1 + count] = BINARY_LOG_ARG_END;
+    return BINARY_LOG_SIGNATURE_READY;
+}
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn			size_t BinaryLogEncode(uint8_t *record, size_t maxLen, const BinaryLogFormat *entry, uint8_t *signature, va_list ap)
+ * @brief		Encodes a log call into a binary log record
+ * @details		The first call of a site fills its signature from the format string. The argument types of later calls
+ *				come from the signature, so the format string is not read again.
+ * @param[out]	record Buffer that receives the record
+ * @param[in]	maxLen Size of the record buffer. Capped to BINARY_LOG_MAX_RECORD_SIZE
+ * @param[in]	entry Format entry of the call site (BINARY_LOG_SITE). Its index in the binary_log section is the ID sent
+ * @param[in,out]	signature Signature of the call site (BINARY_LOG_SITE)
+ * @param[in]	ap Arguments of the log call
+ * @return		Returns the size of the record, or 0 if the format is not supported or the arguments do not fit in the record
+ */
+size_t BinaryLogEncode(uint8_t *record, size_t maxLen, const BinaryLogFormat *entry, uint8_t *signature, va_list ap)
+{
+    BinaryLogWriter writer = {record, BINARY_LOG_HEADER_SIZE, maxLen};
+    if (writer.maxLen > BINARY_LOG_MAX_RECORD_SIZE) writer.maxLen = BINARY_LOG_MAX_RECORD_SIZE;
+    if (writer.maxLen <= BINARY_LOG_HEADER_SIZE + 1) return 0;
+
+    // Two tasks may parse the same new site at once: they write the same types, and the state is published last
+    uint8_t state = __atomic_load_n(&signature[0], __ATOMIC_ACQUIRE);
+    if (state == BINARY_LOG_SIGNATURE_NEW) {
+        state = BinaryLogParse(entry->format, signature);
+        __atomic_store_n(&signature[0], state, __ATOMIC_RELEASE);
+    }
+    if (state != BINARY_LOG_SIGNATURE_READY) return 0;
+
+    int error = BinaryLogPutVarint(&writer, (uint32_t)(entry - __start_binary_log));
+    int precision = -1;
+    for (uint8_t i = 1; error == 0 && i <= BINARY_LOG_MAX_ARGUMENTS && signature[i] != BINARY_LOG_ARG_END; i++) {
+        switch (signature[i]) {
+            case BINARY_LOG_ARG_INT:
+            case BINARY_LOG_ARG_WIDTH:
+                error = BinaryLogPutSigned(&writer, va_arg(ap, int));
+                break;
+            case BINARY_LOG_ARG_PRECISION:
+                precision = va_arg(ap, int);
+                error = BinaryLogPutSigned(&writer, precision);
+                break;
+            case BINARY_LOG_ARG_LONG:
+                error = BinaryLogPutSigned(&writer, va_arg(ap, long));
+                break;
+            case BINARY_LOG_ARG_LONG_LONG:
+                error = BinaryLogPutSigned(&writer, va_arg(ap, long long));
+                break;
+            case BINARY_LOG_ARG_PTRDIFF:
+                error = BinaryLogPutSigned(&writer, (int64_t)va_arg(ap, ptrdiff_t));
+                break;
+            case BINARY_LOG_ARG_UINT:
+                error = BinaryLogPutVarint(&writer, va_arg(ap, unsigned int));
+                break;
+            case BINARY_LOG_ARG_ULONG:
+                error = BinaryLogPutVarint(&writer, va_arg(ap, unsigned long));
+                break;
+            case BINARY_LOG_ARG_ULONG_LONG:
+                error = BinaryLogPutVarint(&writer, va_arg(ap, unsigned long long));
+                break;
+            case BINARY_LOG_ARG_SIZE:
+                error = BinaryLogPutVarint(&writer, va_arg(ap, size_t));
+                break;
+            case BINARY_LOG_ARG_POINTER:
+                error = BinaryLogPutVarint(&writer, (uintptr_t)va_arg(ap, void *));
+                break;
+            case BINARY_LOG_ARG_DOUBLE:
+                error = BinaryLogPutDouble(&writer, va_arg(ap, double));
+                break;
+            case BINARY_LOG_ARG_LONG_DOUBLE:
+                error = BinaryLogPutDouble(&writer, (double)va_arg(ap, long double));
+                break;
+            case BINARY_LOG_ARG_SKIP:
+                (void)va_arg(ap, void *);  // Nothing is printed, nothing to send
+                break;
+            case BINARY_LOG_ARG_STRING:
+                error = BinaryLogPutString(&writer, va_arg(ap, const char *), precision);
+                precision = -1;
+                break;
+            default:  // BINARY_LOG_ARG_STRING_CUT + precision
+                error = BinaryLogPutString(&writer, va_arg(ap, const char *), signature[i] - BINARY_LOG_ARG_STRING_CUT);
+                break;
+        }
+    }
+
+    if (error != 0) return 0;
+
+    record[0] = BINARY_LOG_SYNC;
+    record[1] = (uint8_t)(writer.pos - BINARY_LOG_HEADER_SIZE);
+    return writer.pos;
+}
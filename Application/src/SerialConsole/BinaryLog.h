@@ -0,0 +1,77 @@
+/**************************************************************************
+ * @file        BinaryLog.h
+ * @ingroup 	   Serial Console
+ * @brief       Encoder for the deferred (binary) logging mode of LogMessage.
+ * @details     Instead of running vsnprintf on the caller's thread, a log call is turned into a small record that
+ *				holds the ID of its call site plus the raw arguments. Each call site defines a format entry
+ *				(BINARY_LOG_SITE) in the binary_log section of flash, and the ID is the index of that entry. The format
+ *				string stays in flash and is never sent; the host tool in Tools/LogDecoder reads the entries and the
+ *				strings from the ELF file and prints the text.
+ *
+ *				Record layout (all multi-byte integers are unsigned LEB128 varints):
+ *				--BINARY_LOG_SYNC (0xA5). Never part of console text, which is 7-bit ASCII
+ *				--Length of the rest of the record, one byte
+ *				--Format ID: one byte for the first 128 call sites. The level is in the entry, not in the record
+ *				--One field per argument consumed by the format string:
+ *					signed integers: zigzag varint, unsigned integers/chars/pointers: varint,
+ *					floating point: 8 bytes IEEE 754 little endian, strings: length varint + characters
+ *
+ *				The first call of a site walks its format string once and keeps the argument types in the signature
+ *				of the site (RAM). Later calls only copy the arguments.
+ *
+ *				The linker script must keep the binary_log output section (KEEP), so that __start_binary_log exists.
+ *				The encoder does not depend on ASF or FreeRTOS so it can be built on the host as well.
+ *
+ * @copyright
+ * @author
+ * @date        October 16, 2026
+ * @version		0.2
+ *****************************************************************************/
+
+#ifndef BINARY_LOG_H
+#define BINARY_LOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define BINARY_LOG_SYNC 0xA5            ///< First byte of every binary log record
+#define BINARY_LOG_HEADER_SIZE 2        ///< Sync byte and length byte
+#define BINARY_LOG_MAX_RECORD_SIZE 96   ///< Maximum size of a record, header included. Strings are cut to fit
+#define BINARY_LOG_MAX_STRING_SIZE 32   ///< Maximum number of characters copied for a single %s argument
+#define BINARY_LOG_MAX_ARGUMENTS 8      ///< Arguments of a format, '*' widths included. Formats with more are sent as text
+#define BINARY_LOG_SIGNATURE_SIZE (BINARY_LOG_MAX_ARGUMENTS + 1)  ///< State byte, then one type per argument
+
+/// Defines the format entry of a call site, and its signature. The entry has to be a constant: level and format too
+#define BINARY_LOG_SITE(name, level, format)                                                                           \
+    static const BinaryLogFormat name __attribute__((section("binary_log"), used)) = {(const char *)(format), (level)}; \
+    static uint8_t name##Signature[BINARY_LOG_SIGNATURE_SIZE]
+
+/******************************************************************************
+ * Structures and Enumerations
+ ******************************************************************************/
+/// Format entry of one call site, in the binary_log section. The decoder reads it from the ELF file
+typedef struct BinaryLogFormat {
+    const char *format;  ///< printf-style format string
+    uint8_t level;       ///< Log level of the call site
+} BinaryLogFormat;
+
+/******************************************************************************
+ * Global Function Declarations
+ ******************************************************************************/
+size_t BinaryLogEncode(uint8_t *record, size_t maxLen, const BinaryLogFormat *entry, uint8_t *signature, va_list ap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BINARY_LOG_H */
@@ -0,0 +1,154 @@
+/**
+ * @file        DataStream.c
+ * @ingroup 	   Serial Console
+ * @brief       Binary channel for streaming typed sensor records to a host, multiplexed with the console text.
+ * @details     Frames a record (COBS + CRC-16, see DataStream.h) and queues it on the console TX buffer in one piece.
+ *				Sending never blocks: if the TX buffer has no room for the whole frame, the frame is dropped and counted.
+ *
+ * @copyright
+ * @author
+ * @date        October 16, 2026
+ * @version		0.1
+ */
+
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include "DataStream.h"
+
+#include "SerialConsole.h"
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define DATA_STREAM_CRC_INIT 0xFFFF  ///< Initial value of CRC-16/CCITT-FALSE
+
+/******************************************************************************
+ * Variables
+ ******************************************************************************/
+static volatile bool dataStreamEnabled = false;  ///< Records are only sent while streaming is on, so the console stays readable otherwise
+static uint8_t dataStreamSequence = 0;           ///< Sequence number of the next frame
+static volatile uint32_t dataStreamDropCount = 0;  ///< Frames dropped because the console TX buffer was full
+
+/******************************************************************************
+ * Local Functions
+ ******************************************************************************/
+
+/**
+ * @fn			static uint16_t DataStreamCrc16(const uint8_t *data, size_t len, uint16_t crc)
+ * @brief		Updates a CRC-16/CCITT-FALSE (polynomial 0x1021) with a block of bytes
+ * @details		Uses a 16-entry table, one lookup per nibble. A good trade between speed and flash on the M0+
+ * @return		Returns the updated CRC
+ */
+static uint16_t DataStreamCrc16(const uint8_t *data, size_t len, uint16_t crc)
+{
+    static const uint16_t table[16] = {0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7, 0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF};
+
+    for (size_t i = 0; i < len; i++) {
+        crc = (uint16_t)(crc << 4) ^ table[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (uint16_t)(crc << 4) ^ table[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+    return crc;
+}
+
+/**
+ * @fn			static size_t DataStreamEncodeFrame(uint8_t *frame, uint8_t type, uint8_t sequence, const void *record, size_t len)
+ * @brief		Builds a complete frame: delimiter, COBS(type, sequence, record, CRC), delimiter
+ * @param[out]	frame Buffer of at least DATA_STREAM_MAX_FRAME_SIZE bytes
+ * @param[in]	type Record type
+ * @param[in]	sequence Frame sequence number
+ * @param[in]	record Record bytes
+ * @param[in]	len Size of the record. At most DATA_STREAM_MAX_RECORD_SIZE
+ * @return		Returns the size of the frame
+ */
+static size_t DataStreamEncodeFrame(uint8_t *frame, uint8_t type, uint8_t sequence, const void *record, size_t len)
+{
+    uint8_t payload[DATA_STREAM_MAX_RECORD_SIZE + 4];
+    payload[0] = type;
+    payload[1] = sequence;
+    memcpy(&payload[2], record, len);
+    uint16_t crc = DataStreamCrc16(payload, len + 2, DATA_STREAM_CRC_INIT);
+    payload[len + 2] = (uint8_t)crc;
+    payload[len + 3] = (uint8_t)(crc >> 8);
+
+    // COBS: every zero is replaced by the distance to the next one. The payload is shorter than 254 bytes,
+    // so no extra code bytes are needed
+    size_t pos = 0;
+    frame[pos++] = 0;
+    size_t code = pos++;
+    for (size_t i = 0; i < len + 4; i++) {
+        if (payload[i] == 0) {
+            frame[code] = (uint8_t)(pos - code);
+            code = pos++;
+        } else {
+            frame[pos++] = payload[i];
+        }
+    }
+    frame[code] = (uint8_t)(pos - code);
+    frame[pos++] = 0;
+
+    return pos;
+}
+
+/******************************************************************************
+ * Global Functions
+ ******************************************************************************/
+
+/**
+ * @fn			bool DataStreamSend(enum eDataStreamRecordType type, const void *record, size_t len)
+ * @brief		Sends a typed record to the host, if streaming is enabled
+ * @details		Safe to call from any task. Does not block and does not format anything.
+ * @param[in]	type Record type. Tells the host how to read the record
+ * @param[in]	record Record to send, usually one of the DataStream structures
+ * @param[in]	len Size of the record
+ * @return		Returns true if the frame was queued, false if streaming is off, the record is too big or the
+ *				console was too busy (the frame is counted as dropped)
+ */
+bool DataStreamSend(enum eDataStreamRecordType type, const void *record, size_t len)
+{
+    if (!dataStreamEnabled || record == NULL || len > DATA_STREAM_MAX_RECORD_SIZE) return false;
+
+    taskENTER_CRITICAL();
+    uint8_t sequence = dataStreamSequence++;
+    taskEXIT_CRITICAL();
+
+    uint8_t frame[DATA_STREAM_MAX_FRAME_SIZE];
+    size_t frameLen = DataStreamEncodeFrame(frame, (uint8_t)type, sequence, record, len);
+
+    if (!SerialConsoleWriteBuffer(frame, frameLen)) {
+        taskENTER_CRITICAL();
+        dataStreamDropCount++;
+        taskEXIT_CRITICAL();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @fn			void DataStreamSetEnabled(bool enabled)
+ * @brief		Turns streaming on or off
+ * @param[in]	enabled True to send records, false to ignore them
+ */
+void DataStreamSetEnabled(bool enabled)
+{
+    dataStreamEnabled = enabled;
+}
+
+/**
+ * @fn			bool DataStreamIsEnabled(void)
+ * @brief		Lets producers skip reading or packing a record when nobody listens
+ * @return		Returns true if streaming is on
+ */
+bool DataStreamIsEnabled(void)
+{
+    return dataStreamEnabled;
+}
+
+/**
+ * @fn			uint32_t DataStreamGetDropCount(void)
+ * @brief		Returns the number of frames dropped because the console TX buffer was full
+ */
+uint32_t DataStreamGetDropCount(void)
+{
+    return dataStreamDropCount;
+}
@@ -0,0 +1,86 @@
+/**************************************************************************
+ * @file        DataStream.h
+ * @ingroup 	   Serial Console
+ * @brief       Binary channel for streaming typed sensor records to a host, multiplexed with the console text.
+ * @details     Every record is sent as one frame:
+ *				--0x00 delimiter
+ *				--COBS encoding of: record type, sequence number, record bytes, CRC-16/CCITT-FALSE (little endian)
+ *				  of the three previous fields
+ *				--0x00 delimiter
+ *
+ *				COBS removes every 0x00 from the encoded bytes, and console text never contains 0x00, so the host can
+ *				find frames in the middle of the text. Anything between delimiters that does not decode with a valid
+ *				CRC is console text. The sequence number lets the host count lost frames.
+ *				Records are little endian and packed, exactly as the structures below. The host receiver is in
+ *				Tools/StreamReceiver and uses this header.
+ *
+ *				The channel runs at CONSOLE_BAUDRATE (see SerialConsole.h), which can be raised for streaming.
+ *
+ * @copyright
+ * @author
+ * @date        October 16, 2026
+ * @version		0.1
+ *****************************************************************************/
+
+#ifndef DATA_STREAM_H
+#define DATA_STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * Includes
+ ******************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * Defines
+ ******************************************************************************/
+#define DATA_STREAM_MAX_RECORD_SIZE 32  ///< Largest record that can be sent, in bytes
+#define DATA_STREAM_FRAME_OVERHEAD 7    ///< Two delimiters, COBS code byte, type, sequence number and CRC. Valid for records shorter than 250 bytes
+#define DATA_STREAM_MAX_FRAME_SIZE (DATA_STREAM_MAX_RECORD_SIZE + DATA_STREAM_FRAME_OVERHEAD)  ///< Encoded size of the largest frame
+
+/******************************************************************************
+ * Structures and Enumerations
+ ******************************************************************************/
+/// Type of the record carried by a frame
+enum eDataStreamRecordType {
+    DATA_STREAM_RECORD_IMU = 1,       ///< struct DataStreamImuRecord
+    DATA_STREAM_RECORD_WEIGHT = 2,    ///< struct DataStreamWeightRecord
+    DATA_STREAM_RECORD_DISTANCE = 3,  ///< struct DataStreamDistanceRecord
+};
+
+/// Raw LSM6DSO sample
+struct __attribute__((packed)) DataStreamImuRecord {
+    uint32_t timestampMs;     ///< FreeRTOS tick count when the sample was read, in ms
+    int16_t acceleration[3];  ///< Raw acceleration, X Y Z
+    int16_t angularRate[3];   ///< Raw angular rate, X Y Z
+};
+
+/// Raw NAU7802 conversion
+struct __attribute__((packed)) DataStreamWeightRecord {
+    uint32_t timestampMs;  ///< FreeRTOS tick count when the sample was read, in ms
+    int32_t raw;           ///< 24-bit conversion result, sign extended
+};
+
+/// US-100 distance measurement
+struct __attribute__((packed)) DataStreamDistanceRecord {
+    uint32_t timestampMs;  ///< FreeRTOS tick count when the sample was read, in ms
+    uint16_t distanceMm;   ///< Distance, in mm
+};
+
+/******************************************************************************
+ * Global Function Declarations
+ ******************************************************************************/
+bool DataStreamSend(enum eDataStreamRecordType type, const void *record, size_t len);
+void DataStreamSetEnabled(bool enabled);
+bool DataStreamIsEnabled(void);
+uint32_t DataStreamGetDropCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DATA_STREAM_H */
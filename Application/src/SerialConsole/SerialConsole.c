@@ -8,7 +8,7 @@
  *uses it to receive command from the user as well as print debug information.
  *
  *				The code in this file will:
- *				--Initialize a SERCOM port (SERCOM # ) to be an UART channel operating at 115200 baud/second,
+ *				--Initialize a SERCOM port (SERCOM # ) to be an UART channel operating at CONSOLE_BAUDRATE (115200 by default) baud/second,
  *8N1
  *				--Register callbacks for the device to read and write characters asynchronously as required by
  *the CLI
@@ -27,36 +27,62 @@
  * Includes
  ******************************************************************************/
 #include "SerialConsole.h"
+#include "BinaryLog.h"
 #include "CliThread/CliThread.h"
 
 /******************************************************************************
  * Defines
  ******************************************************************************/
-#define RX_BUFFER_SIZE 512  ///< Size of character buffer for RX, in bytes
-#define TX_BUFFER_SIZE 512  ///< Size of character buffers for TX, in bytes
-
-char debugBuffer[128];
+#define RX_BUFFER_SIZE 512  ///< Size of character buffer for RX, in bytes. Must be a power of two
+#define TX_BUFFER_SIZE 512  ///< Size of character buffers for TX, in bytes. Must be a power of two
+#define TX_DMA_TRIGGER SERCOM4_DMAC_ID_TX  ///< DMAC trigger of the EDBG_CDC_MODULE (SERCOM4) data register empty event
+#define RX_DMA_TRIGGER SERCOM4_DMAC_ID_RX  ///< DMAC trigger of the EDBG_CDC_MODULE (SERCOM4) receive complete event
+#define TX_RETRY_DELAY_MS 2                ///< Time a task waits for room in cbufTx when the console is busy (logger, CLI output)
 
 /******************************************************************************
  * Structures and Enumerations
  ******************************************************************************/
-cbuf_handle_t cbufRx;  ///< Circular buffer handler for receiving characters from the Serial Interface
-cbuf_handle_t cbufTx;  ///< Circular buffer handler for transmitting characters from the Serial Interface
+static circular_buf_t cbufRxStorage;   ///< Circular buffer control structure for RX
+static circular_buf_t cbufTxStorage;   ///< Circular buffer control structure for TX
+cbuf_handle_t cbufRx = &cbufRxStorage;  ///< Circular buffer handler for receiving characters from the Serial Interface. Filled by the DMAC, emptied by the CLI
+cbuf_handle_t cbufTx = &cbufTxStorage;  ///< Circular buffer handler for transmitting characters from the Serial Interface. Filled by tasks, emptied by the DMAC
+
+struct dma_resource usartDmaTxResource;              ///< DMAC channel that feeds the UART data register from cbufTx
+COMPILER_ALIGNED(16) DmacDescriptor usartDmaTxDescriptor;  ///< Transfer descriptor for the span of cbufTx being sent
+static volatile size_t txDmaLength = 0;              ///< Number of bytes of cbufTx owned by the DMAC. Zero when the TX channel is idle
+
+struct dma_resource usartDmaRxResource;              ///< DMAC channel that copies every received character into rxCharacterBuffer, in a loop
+COMPILER_ALIGNED(16) DmacDescriptor usartDmaRxDescriptor;  ///< Transfer descriptor for the whole of rxCharacterBuffer. Linked to itself
+
+/// A message waiting for the logger task
+struct LogSlot {
+    uint8_t len;                   ///< Number of bytes used in data
+    uint8_t data[LOG_SLOT_SIZE];   ///< Formatted text, or a binary log record
+};
 
-char latestRx;  ///< Holds the latest character that was received
-char latestTx;  ///< Holds the latest character to be transmitted.
+static struct LogSlot logSlots[LOG_SLOT_COUNT];          ///< Message pool. Each slot is owned either by logFreeQueue, by one producer or by logReadyQueue
+static QueueHandle_t logFreeQueue = NULL;                ///< Indexes of the slots nobody owns
+static QueueHandle_t logReadyQueue = NULL;               ///< Indexes of the formatted slots, in order, waiting for the logger task
+static volatile bool loggerTaskRunning = false;          ///< Until the logger task runs, messages are written straight to the console
+static volatile uint32_t logDropCount[LOG_OFF_LVL];      ///< Messages dropped because no slot was free, per level
 
 /******************************************************************************
  *  Callback Declaration
  ******************************************************************************/
-void usart_write_callback(struct usart_module *const usart_module);  // Callback for when we finish writing characters to UART
-void usart_read_callback(struct usart_module *const usart_module);   // Callback for when we finis reading characters from UART
+void usart_dma_write_callback(struct dma_resource *const resource);  // Callback for when the DMAC finishes writing a span of characters to UART
+void usart_rx_start_callback(struct usart_module *const usart_module);  // Callback for when the UART detects the start bit of a character
 
 /******************************************************************************
  * Local Function Declaration
  ******************************************************************************/
 static void configure_usart(void);
 static void configure_usart_callbacks(void);
+static void configure_usart_dma(void);
+static void SerialConsoleStartTxDma(void);
+static size_t SerialConsoleQueueTx(const uint8_t *data, size_t len, bool allOrNothing);
+static void SerialConsoleUpdateRx(void);
+static void LogSubmit(enum eDebugLogLevels level, const BinaryLogFormat *site, uint8_t *signature, const char *format, va_list ap);
+static void LogFormatSlot(struct LogSlot *slot, const BinaryLogFormat *site, uint8_t *signature, const char *format, va_list ap);
 
 /******************************************************************************
  * Global Local Variables
@@ -82,14 +108,22 @@ enum eDebugLogLevels currentDebugLevel = LOG_INFO_LVL;  ///< Variable that holds
 void InitializeSerialConsole(void)
 {
     // Initialize circular buffers for RX and TX
-    cbufRx = circular_buf_init((uint8_t *)rxCharacterBuffer, RX_BUFFER_SIZE);
-    cbufTx = circular_buf_init((uint8_t *)txCharacterBuffer, RX_BUFFER_SIZE);
+    circular_buf_init(cbufRx, (uint8_t *)rxCharacterBuffer, RX_BUFFER_SIZE);
+    circular_buf_init(cbufTx, (uint8_t *)txCharacterBuffer, TX_BUFFER_SIZE);
 
     // Configure USART and Callbacks
     configure_usart();
     configure_usart_callbacks();
+    configure_usart_dma();
 
-    usart_read_buffer_job(&usart_instance, (uint8_t *)&latestRx, 1);  // Kicks off constant reading of characters
+    dma_start_transfer_job(&usartDmaRxResource);  // Kicks off constant reading of characters. Never completes
+
+    // Initialize the logger slot pool. All the slots start free
+    logFreeQueue = xQueueCreate(LOG_SLOT_COUNT, sizeof(uint8_t));
+    logReadyQueue = xQueueCreate(LOG_SLOT_COUNT, sizeof(uint8_t));
+    for (uint8_t i = 0; logFreeQueue != NULL && i < LOG_SLOT_COUNT; i++) {
+        xQueueSend(logFreeQueue, &i, 0);
+    }
 
     // Add any other calls you need to do to initialize your Serial Console
 }
@@ -101,6 +135,8 @@ void InitializeSerialConsole(void)
  */
 void DeinitializeSerialConsole(void)
 {
+    dma_abort_job(&usartDmaTxResource);
+    dma_abort_job(&usartDmaRxResource);
     usart_disable(&usart_instance);
 }
 
@@ -109,23 +145,55 @@ void DeinitializeSerialConsole(void)
  * @brief		Writes a string to be written to the uart. Copies the string to a ring buffer that is used to hold the
  *text send to the uart
  * @details		Uses the ringbuffer 'cbufTx', which in turn uses the array 'txCharacterBuffer'. Modified to be
- *thread safe.
+ *thread safe. The characters are sent by the DMAC, which is only started here if it is idle; otherwise
+ *				the DMA completion callback picks up the new characters once the current span is out.
+ *				Characters that do not fit in the ring buffer are dropped, since the DMAC may be reading the oldest ones.
  * @note			Use to send a string of characters to the user via UART
  */
 void SerialConsoleWriteString(const char *string)
 {
-    vTaskSuspendAll();
-    if (string != NULL) {
-        for (size_t iter = 0; iter < strlen(string); iter++) {
-            circular_buf_put(cbufTx, string[iter]);
-        }
+    if (string == NULL) return;
 
-        if (usart_get_job_status(&usart_instance, USART_TRANSCEIVER_TX) == STATUS_OK) {
-            circular_buf_get(cbufTx, (uint8_t *)&latestTx);  // Perform only if the SERCOM TX is free (not busy)
-            usart_write_buffer_job(&usart_instance, (uint8_t *)&latestTx, 1);
-        }
+    SerialConsoleQueueTx((const uint8_t *)string, strlen(string), false);
+}
+
+/**
+ * @fn			bool SerialConsoleWriteBuffer(const uint8_t *data, size_t len)
+ * @brief		Writes a block of bytes to the uart, or nothing at all if it does not fit in the TX ring buffer
+ * @details		Used for binary records (e.g. deferred log records), which the host can only decode if they are complete.
+ * @param[in]	data Bytes to send
+ * @param[in]	len Number of bytes to send
+ * @return		Returns true if the block was queued, false if it was dropped
+ */
+bool SerialConsoleWriteBuffer(const uint8_t *data, size_t len)
+{
+    if (data == NULL) return false;
+
+    return SerialConsoleQueueTx(data, len, true) == len;
+}
+
+/**
+ * @fn			void SerialConsoleWriteBlocking(const uint8_t *data, size_t len)
+ * @brief		Writes a block of bytes to the uart, waiting for room in the TX ring buffer instead of dropping bytes
+ * @details		Queues whatever fits, then sleeps while the DMAC drains cbufTx. Long outputs (e.g. CLI dumps) are
+ *				sent at the uart rate without an intermediate buffer. Other tasks may write between two parts of
+ *				the block.
+ * @param[in]	data Bytes to send
+ * @param[in]	len Number of bytes to send
+ * @note			Blocks the calling task. Only call from a task, after the scheduler started
+ */
+void SerialConsoleWriteBlocking(const uint8_t *data, size_t len)
+{
+    if (data == NULL) return;
+
+    for (;;) {
+        size_t queued = SerialConsoleQueueTx(data, len, false);
+        data += queued;
+        len -= queued;
+        if (len == 0) break;
+
+        vTaskDelay(pdMS_TO_TICKS(TX_RETRY_DELAY_MS));
     }
-    xTaskResumeAll();
 }
 
 /**
@@ -133,17 +201,64 @@ void SerialConsoleWriteString(const char *string)
  * @brief		Reads a character from the RX ring buffer and stores it on the pointer given as an argument.
  *				Also, returns -1 if there is no characters on the buffer
  *				This buffer has values added to it when the UART receives ASCII characters from the terminal
- * @details		Uses the ringbuffer 'cbufTx', which in turn uses the array 'txCharacterBuffer'
+ * @details		Uses the ringbuffer 'cbufRx', which in turn uses the array 'rxCharacterBuffer'
  * @param[in]	Pointer to a character. This function will return the character from the RX buffer into this pointer
  * @return		Returns -1 if there are no characters in the buffer
- * @note			Use to receive characters from the RX buffer (FIFO)
+ * @note			Use to receive characters from the RX buffer (FIFO). Only one task may read from the console
  */
 int SerialConsoleReadCharacter(uint8_t *rxChar)
 {
-    vTaskSuspendAll();
-    int a = circular_buf_get(cbufRx, (uint8_t *)rxChar);
-    xTaskResumeAll();
-    return a;
+    SerialConsoleUpdateRx();
+    return circular_buf_get(cbufRx, (uint8_t *)rxChar);
+}
+
+/**
+ * @fn			size_t SerialConsoleReadSpan(uint8_t **data)
+ * @brief		Gives access to the oldest received characters without copying them
+ * @details		The characters stay in the RX ring buffer until SerialConsoleReleaseSpan is called.
+ * @param[out]	data Set to the first character of the span
+ * @return		Returns the number of characters that can be read from *data (0 if nothing was received)
+ * @note			Only one task may read from the console
+ */
+size_t SerialConsoleReadSpan(uint8_t **data)
+{
+    SerialConsoleUpdateRx();
+    return circular_buf_peek_contiguous(cbufRx, data);
+}
+
+/**
+ * @fn			void SerialConsoleReleaseSpan(size_t len)
+ * @brief		Discards characters read through SerialConsoleReadSpan
+ * @param[in]	len Number of characters consumed. Must not be more than the span that was returned
+ */
+void SerialConsoleReleaseSpan(size_t len)
+{
+    circular_buf_skip(cbufRx, len);
+}
+
+/**
+ * @fn			size_t SerialConsoleGetRxCount(void)
+ * @brief		Returns the number of received characters that were not read yet
+ * @note			Only to be called by the task that reads from the console
+ */
+size_t SerialConsoleGetRxCount(void)
+{
+    SerialConsoleUpdateRx();
+    return circular_buf_size(cbufRx);
+}
+
+/**
+ * @fn			void SerialConsoleEnableRxWakeup(void)
+ * @brief		Asks for a single call to CliCharReadySemaphoreGiveFromISR when the next character starts arriving
+ * @details		Characters are received by the DMAC without interrupts, so this is how a reader that found the RX buffer
+ *				empty can sleep until there is something to read. Use SerialConsoleGetRxCount afterwards to catch
+ *				a character that arrived just before the wakeup was enabled.
+ */
+void SerialConsoleEnableRxWakeup(void)
+{
+    SercomUsart *const usart_hw = &usart_instance.hw->USART;
+    usart_hw->INTFLAG.reg = SERCOM_USART_INTFLAG_RXS;    // Forget start bits seen while nobody was waiting
+    usart_hw->INTENSET.reg = SERCOM_USART_INTFLAG_RXS;  // Disabled again by the USART driver once it fires
 }
 
 /*
@@ -176,21 +291,48 @@ void setLogLevel(enum eDebugLogLevels debugLevel)
 }
 
 /**
- * @fn			LogMessage (Students to fill out this)
- * @brief
- * @note
+ * @fn			void LogMessage(enum eDebugLogLevels level, const char *format, ...)
+ * @brief		Logs a printf-style message to the console if its level is at or above the current debug level
+ * @details		The message is formatted into a free slot of the logger pool and handed to the logger task, which
+ *				copies it to the console. A caller never waits: if every slot is taken the message is dropped and
+ *				counted (see LogGetDropCount). Each caller formats into its own slot, so tasks can log at the same time.
+ *
+ *				The slot holds the text. With LOG_MODE_BINARY the LOG_xxx macros call LogMessageSite instead, which
+ *				sends a binary record; a direct call of LogMessage has no call site entry and is always sent as text.
+ * @param[in]	level Level of the message
+ * @param[in]	format printf-style format string
+ * @note			Not for use from interrupts.
  */
 void LogMessage(enum eDebugLogLevels level, const char *format, ...)
 {
-    if (getLogLevel() <= level) {
-        va_list ap;
-        va_start(ap, format);
-        vsnprintf(debugBuffer, 127, format, ap);
-        SerialConsoleWriteString(debugBuffer);
-        va_end(ap);
-    }
+    va_list ap;
+    va_start(ap, format);
+    LogSubmit(level, NULL, NULL, format, ap);
+    va_end(ap);
 };
 
+#if (LOG_MODE == LOG_MODE_BINARY)
+/**
+ * @fn			void LogMessageSite(enum eDebugLogLevels level, const BinaryLogFormat *site, uint8_t *signature, const char *format, ...)
+ * @brief		LogMessage of a call site defined with BINARY_LOG_SITE, used by the LOG_xxx macros in LOG_MODE_BINARY
+ * @details		The slot holds the ID of the site and the raw arguments (see BinaryLog.h); the host decoder turns them
+ *				back into text. Formats that are not in flash (e.g. built at run time) and formats the encoder does not
+ *				support are sent as text, since the decoder could not print them.
+ * @param[in]	level Level of the message
+ * @param[in]	site Format entry of the call site
+ * @param[in,out]	signature Argument types of the call site, filled at its first call
+ * @param[in]	format printf-style format string, the one of the entry
+ * @note			Not for use from interrupts.
+ */
+void LogMessageSite(enum eDebugLogLevels level, const BinaryLogFormat *site, uint8_t *signature, const char *format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    LogSubmit(level, site, signature, format, ap);
+    va_end(ap);
+}
+#endif
+
 /**
  * @fn			LogMessage Debug(Students to fill out this)
  * @brief
@@ -201,6 +343,61 @@ void LogMessageDebug(const char *format, ...)
     LogMessage(LOG_DEBUG_LVL, format);
 };
 
+/**
+ * @fn			uint32_t LogGetDropCount(enum eDebugLogLevels level)
+ * @brief		Returns the number of messages of the given level dropped because the logger pool was full
+ * @param[in]	level Level to query
+ * @return		Returns the number of dropped messages since boot or since the last LogResetDropCounts
+ */
+uint32_t LogGetDropCount(enum eDebugLogLevels level)
+{
+    if (level >= LOG_OFF_LVL) return 0;
+    return logDropCount[level];
+}
+
+/**
+ * @fn			void LogResetDropCounts(void)
+ * @brief		Clears the dropped message counters of every level
+ */
+void LogResetDropCounts(void)
+{
+    taskENTER_CRITICAL();
+    memset((void *)logDropCount, 0, sizeof(logDropCount));
+    taskEXIT_CRITICAL();
+}
+
+/******************************************************************************
+ * Logger Thread
+ ******************************************************************************/
+
+/**
+ * @fn			void vLoggerTask(void *pvParameters)
+ * @brief		Copies the messages queued by LogMessage to the console, in order
+ * @details		Runs at the lowest application priority. When the console TX buffer is full the task waits for the
+ *				DMAC to make room, so only the logger (never the task that logged) is slowed down by a busy UART.
+ */
+void vLoggerTask(void *pvParameters)
+{
+    uint8_t index;
+
+    (void)pvParameters;
+
+    loggerTaskRunning = (logFreeQueue != NULL && logReadyQueue != NULL);
+    if (!loggerTaskRunning) {
+        SerialConsoleWriteString("ERR: Logger queues could not be allocated!\r\n");
+        vTaskSuspend(NULL);
+    }
+
+    for (;;) {
+        xQueueReceive(logReadyQueue, &index, portMAX_DELAY);
+
+        while (!SerialConsoleWriteBuffer(logSlots[index].data, logSlots[index].len)) {
+            vTaskDelay(pdMS_TO_TICKS(TX_RETRY_DELAY_MS));
+        }
+        xQueueSend(logFreeQueue, &index, 0);
+    }
+}
+
 /*
 COMMAND LINE INTERFACE COMMANDS
 */
@@ -211,7 +408,7 @@ COMMAND LINE INTERFACE COMMANDS
 
 /**
  * @fn			static void configure_usart(void)
- * @brief		Code to configure the SERCOM "EDBG_CDC_MODULE" to be a UART channel running at 115200 8N1
+ * @brief		Code to configure the SERCOM "EDBG_CDC_MODULE" to be a UART channel running at CONSOLE_BAUDRATE 8N1
  * @note
  */
 static void configure_usart(void)
@@ -219,12 +416,13 @@ static void configure_usart(void)
     struct usart_config config_usart;
     usart_get_config_defaults(&config_usart);
 
-    config_usart.baudrate = 115200;
+    config_usart.baudrate = CONSOLE_BAUDRATE;
     config_usart.mux_setting = EDBG_CDC_SERCOM_MUX_SETTING;
     config_usart.pinmux_pad0 = EDBG_CDC_SERCOM_PINMUX_PAD0;
     config_usart.pinmux_pad1 = EDBG_CDC_SERCOM_PINMUX_PAD1;
     config_usart.pinmux_pad2 = EDBG_CDC_SERCOM_PINMUX_PAD2;
     config_usart.pinmux_pad3 = EDBG_CDC_SERCOM_PINMUX_PAD3;
+    config_usart.start_frame_detection_enable = true;  // Start bit interrupt, used to wake the CLI (see SerialConsoleEnableRxWakeup)
     while (usart_init(&usart_instance, EDBG_CDC_MODULE, &config_usart) != STATUS_OK) {
     }
 
@@ -234,14 +432,193 @@ static void configure_usart(void)
 /**
  * @fn			static void configure_usart_callbacks(void)
  * @brief		Code to register callbacks
- * @note
+ * @note			Transmission and reception are handled by the DMAC, so only the start bit callback is registered on the USART
  */
 static void configure_usart_callbacks(void)
 {
-    usart_register_callback(&usart_instance, usart_write_callback, USART_CALLBACK_BUFFER_TRANSMITTED);
-    usart_register_callback(&usart_instance, usart_read_callback, USART_CALLBACK_BUFFER_RECEIVED);
-    usart_enable_callback(&usart_instance, USART_CALLBACK_BUFFER_TRANSMITTED);
-    usart_enable_callback(&usart_instance, USART_CALLBACK_BUFFER_RECEIVED);
+    usart_register_callback(&usart_instance, usart_rx_start_callback, USART_CALLBACK_START_RECEIVED);
+    usart_enable_callback(&usart_instance, USART_CALLBACK_START_RECEIVED);
+}
+
+/**
+ * @fn			static void configure_usart_dma(void)
+ * @brief		Allocates a DMAC channel triggered by the USART data register empty event, and sets up its descriptor
+ *				to move bytes from memory to the USART data register.
+ *				Allocates a second channel, triggered by the USART receive complete event, that copies every received
+ *				character into rxCharacterBuffer. Its descriptor is linked to itself, so it wraps around forever.
+ * @note			Source address and length of TX are filled in by SerialConsoleStartTxDma for every span
+ */
+static void configure_usart_dma(void)
+{
+    struct dma_resource_config config_dma;
+    dma_get_config_defaults(&config_dma);
+    config_dma.peripheral_trigger = TX_DMA_TRIGGER;
+    config_dma.trigger_action = DMA_TRIGGER_ACTION_BEAT;
+    while (dma_allocate(&usartDmaTxResource, &config_dma) != STATUS_OK) {
+    }
+
+    struct dma_descriptor_config config_descriptor;
+    dma_descriptor_get_config_defaults(&config_descriptor);
+    config_descriptor.beat_size = DMA_BEAT_SIZE_BYTE;
+    config_descriptor.dst_increment_enable = false;
+    config_descriptor.block_transfer_count = 1;
+    config_descriptor.source_address = (uint32_t)(uintptr_t)txCharacterBuffer + 1;
+    config_descriptor.destination_address = (uint32_t)(uintptr_t)(&usart_instance.hw->USART.DATA.reg);
+    dma_descriptor_create(&usartDmaTxDescriptor, &config_descriptor);
+    dma_add_descriptor(&usartDmaTxResource, &usartDmaTxDescriptor);
+
+    dma_register_callback(&usartDmaTxResource, usart_dma_write_callback, DMA_CALLBACK_TRANSFER_DONE);
+    dma_enable_callback(&usartDmaTxResource, DMA_CALLBACK_TRANSFER_DONE);
+
+    // RX: no callback, the reader polls the progress of the channel (see SerialConsoleUpdateRx)
+    dma_get_config_defaults(&config_dma);
+    config_dma.peripheral_trigger = RX_DMA_TRIGGER;
+    config_dma.trigger_action = DMA_TRIGGER_ACTION_BEAT;
+    while (dma_allocate(&usartDmaRxResource, &config_dma) != STATUS_OK) {
+    }
+
+    dma_descriptor_get_config_defaults(&config_descriptor);
+    config_descriptor.beat_size = DMA_BEAT_SIZE_BYTE;
+    config_descriptor.src_increment_enable = false;
+    config_descriptor.block_transfer_count = RX_BUFFER_SIZE;
+    config_descriptor.source_address = (uint32_t)(uintptr_t)(&usart_instance.hw->USART.DATA.reg);
+    config_descriptor.destination_address = (uint32_t)(uintptr_t)rxCharacterBuffer + RX_BUFFER_SIZE;
+    config_descriptor.next_descriptor_address = (uint32_t)(uintptr_t)&descriptor_section[usartDmaRxResource.channel_id];  // The first descriptor is copied there
+    dma_descriptor_create(&usartDmaRxDescriptor, &config_descriptor);
+    dma_add_descriptor(&usartDmaRxResource, &usartDmaRxDescriptor);
+}
+
+/**
+ * @fn			static size_t SerialConsoleQueueTx(const uint8_t *data, size_t len, bool allOrNothing)
+ * @brief		Copies bytes into cbufTx and starts the DMAC if it is idle
+ * @param[in]	data Bytes to send
+ * @param[in]	len Number of bytes to send
+ * @param[in]	allOrNothing If true, nothing is queued unless all the bytes fit. Otherwise the bytes that do not fit are dropped
+ * @return		Returns the number of bytes queued
+ */
+static size_t SerialConsoleQueueTx(const uint8_t *data, size_t len, bool allOrNothing)
+{
+    size_t queued = 0;
+
+    taskENTER_CRITICAL();  // Serializes the tasks that share the producer side of cbufTx. The DMA callback only uses the consumer side
+    if (!allOrNothing || circular_buf_capacity(cbufTx) - circular_buf_size(cbufTx) >= len) {
+        queued = circular_buf_put_n(cbufTx, data, len);
+    }
+
+    if (txDmaLength == 0) {
+        SerialConsoleStartTxDma();  // Perform only if the TX DMA channel is free (not busy)
+    }
+    taskEXIT_CRITICAL();
+
+    return queued;
+}
+
+/**
+ * @fn			static void LogSubmit(enum eDebugLogLevels level, const BinaryLogFormat *site, uint8_t *signature, const char *format, va_list ap)
+ * @brief		Formats a log message into a free logger slot and hands it to the logger task. See LogMessage
+ * @param[in]	level Level of the message
+ * @param[in]	site Format entry of the call site, or NULL to send text
+ * @param[in,out]	signature Argument types of the call site, or NULL
+ * @param[in]	format printf-style format string
+ * @param[in]	ap Arguments of the log call
+ */
+static void LogSubmit(enum eDebugLogLevels level, const BinaryLogFormat *site, uint8_t *signature, const char *format, va_list ap)
+{
+    if (getLogLevel() <= level && level < LOG_OFF_LVL) {
+        uint8_t index;
+        if (logFreeQueue == NULL || xQueueReceive(logFreeQueue, &index, 0) != pdPASS) {
+            taskENTER_CRITICAL();
+            logDropCount[level]++;
+            taskEXIT_CRITICAL();
+            return;
+        }
+
+        LogFormatSlot(&logSlots[index], site, signature, format, ap);
+
+        if (loggerTaskRunning) {
+            xQueueSend(logReadyQueue, &index, 0);  // Never full: it has room for every slot
+        } else {
+            SerialConsoleWriteBuffer(logSlots[index].data, logSlots[index].len);
+            xQueueSend(logFreeQueue, &index, 0);
+        }
+    }
+}
+
+/**
+ * @fn			static void LogFormatSlot(struct LogSlot *slot, const BinaryLogFormat *site, uint8_t *signature, const char *format, va_list ap)
+ * @brief		Formats a log message into a logger slot, as a binary record for a call site in LOG_MODE_BINARY, else as text
+ * @param[out]	slot Slot owned by the caller
+ * @param[in]	site Format entry of the call site, or NULL to send text
+ * @param[in,out]	signature Argument types of the call site, or NULL
+ * @param[in]	format printf-style format string
+ * @param[in]	ap Arguments of the log call
+ * @note			slot->len is 0 if nothing could be formatted. Writing 0 bytes to the console is harmless
+ */
+static void LogFormatSlot(struct LogSlot *slot, const BinaryLogFormat *site, uint8_t *signature, const char *format, va_list ap)
+{
+#if (LOG_MODE == LOG_MODE_BINARY)
+    if (site != NULL && (uintptr_t)format < FLASH_ADDR + FLASH_SIZE) {
+        va_list binaryAp;
+        va_copy(binaryAp, ap);  // ap is still needed for the text if the encoder gives up
+        slot->len = (uint8_t)BinaryLogEncode(slot->data, sizeof(slot->data), site, signature, binaryAp);
+        va_end(binaryAp);
+        if (slot->len != 0) return;
+    }
+#else
+    (void)site;
+    (void)signature;
+#endif
+    int len = vsnprintf((char *)slot->data, sizeof(slot->data), format, ap);
+    if (len < 0) len = 0;
+    slot->len = (uint8_t)((len < (int)sizeof(slot->data)) ? (size_t)len : sizeof(slot->data) - 1);  // Cut messages do not send the terminator
+}
+
+/**
+ * @fn			static void SerialConsoleUpdateRx(void)
+ * @brief		Publishes the characters the DMAC wrote into rxCharacterBuffer since the last call
+ * @details		The remaining beat count of the RX channel is in the ACTIVE register while the channel is moving a
+ *				character, and in its write-back descriptor while it waits for the next one. The write position is
+ *				only known modulo the buffer size, so the reader has to come back before RX_BUFFER_SIZE more characters
+ *				arrive (about 44 ms at 115200 baud, less at higher rates). Otherwise the oldest characters are overwritten.
+ * @note			Acts as the producer of cbufRx, so it must only be called by the task that reads from the console
+ */
+static void SerialConsoleUpdateRx(void)
+{
+    const uint8_t channel = usartDmaRxResource.channel_id;
+    const DmacDescriptor *writeBack = (const DmacDescriptor *)(uintptr_t)DMAC->WRBADDR.reg;
+    uint32_t active = DMAC->ACTIVE.reg;
+    uint16_t remaining;
+
+    if ((active & DMAC_ACTIVE_ABUSY) && ((active & DMAC_ACTIVE_ID_Msk) >> DMAC_ACTIVE_ID_Pos) == channel) {
+        remaining = (active & DMAC_ACTIVE_BTCNT_Msk) >> DMAC_ACTIVE_BTCNT_Pos;
+    } else {
+        remaining = writeBack[channel].BTCNT.reg;
+    }
+
+    size_t writeIndex = (RX_BUFFER_SIZE - remaining) & (RX_BUFFER_SIZE - 1);
+    size_t newCharacters = (writeIndex - cbufRx->head) & (RX_BUFFER_SIZE - 1);
+    circular_buf_advance(cbufRx, newCharacters);
+}
+
+/**
+ * @fn			static void SerialConsoleStartTxDma(void)
+ * @brief		Hands the largest contiguous span of cbufTx to the DMAC
+ * @details		The span stays in the ring buffer until the DMA completion callback discards it, so writers
+ *				can never overwrite characters that are still being sent.
+ * @note			Must be called with interrupts disabled or from the DMA callback, and only when no span is in flight.
+ */
+static void SerialConsoleStartTxDma(void)
+{
+    uint8_t *span = NULL;
+    size_t len = circular_buf_peek_contiguous(cbufTx, &span);
+
+    txDmaLength = len;
+    if (len == 0) return;
+
+    // With source increment enabled, the DMAC expects the address one past the last beat
+    usartDmaTxDescriptor.SRCADDR.reg = (uint32_t)(uintptr_t)(span + len);
+    usartDmaTxDescriptor.BTCNT.reg = (uint16_t)len;
+    dma_start_transfer_job(&usartDmaTxResource);
 }
 
 /******************************************************************************
@@ -249,28 +626,26 @@ static void configure_usart_callbacks(void)
  ******************************************************************************/
 
 /**
- * @fn			void usart_read_callback(struct usart_module *const usart_module)
- * @brief		Callback called when the system finishes receives all the bytes requested from a UART read job
- * @note
+ * @fn			void usart_rx_start_callback(struct usart_module *const usart_module)
+ * @brief		Callback called when the UART sees a start bit after SerialConsoleEnableRxWakeup
+ * @note			The character itself is stored by the DMAC. This only wakes the reader, once per batch of characters
  */
-void usart_read_callback(struct usart_module *const usart_module)
+void usart_rx_start_callback(struct usart_module *const usart_module)
 {
-    circular_buf_put(cbufRx, (uint8_t)latestRx);                      // Add the latest read character into the RX circular Buffer
-    usart_read_buffer_job(&usart_instance, (uint8_t *)&latestRx, 1);  // Order the MCU to keep reading
-    CliCharReadySemaphoreGiveFromISR();                               // Give binary semaphore
+    (void)usart_module;
+    CliCharReadySemaphoreGiveFromISR();  // Give binary semaphore
 }
 
 /**
- * @fn			void usart_write_callback(struct usart_module *const usart_module)
- * @brief		Callback called when the system finishes sending all the bytes requested from a UART read job
- * @note
+ * @fn			void usart_dma_write_callback(struct dma_resource *const resource)
+ * @brief		Callback called when the DMAC finishes sending a span of cbufTx to the UART
+ * @note			Releases the span that was sent and starts the next one, if there are more characters to send
  */
-void usart_write_callback(struct usart_module *const usart_module)
+void usart_dma_write_callback(struct dma_resource *const resource)
 {
-    if (circular_buf_get(cbufTx, (uint8_t *)&latestTx) != -1)  // Only continue if there are more characters to send
-    {
-        usart_write_buffer_job(&usart_instance, (uint8_t *)&latestTx, 1);
-    }
+    (void)resource;
+    circular_buf_skip(cbufTx, txDmaLength);
+    SerialConsoleStartTxDma();
 }
 
 struct usart_module *GetUsartModule(void)
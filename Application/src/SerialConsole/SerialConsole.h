@@ -8,7 +8,7 @@
  *uses it to receive command from the user as well as print debug information.
  *
  *				The code in this file will:
- *				--Initialize a SERCOM port (SERCOM # ) to be an UART channel operating at 115200 baud/second,
+ *				--Initialize a SERCOM port (SERCOM # ) to be an UART channel operating at CONSOLE_BAUDRATE (115200 by default) baud/second,
  *8N1
  *				--Register callbacks for the device to read and write characters asycnhronously as required by the
  *CLI
@@ -35,12 +35,28 @@ extern "C" {
 #include <asf.h>
 #include <stdarg.h>
 
+#include "BinaryLog.h"
 #include "circular_buffer.h"
 #include "string.h"
 
 /******************************************************************************
  * Defines
  ******************************************************************************/
+#ifndef CONSOLE_BAUDRATE
+#define CONSOLE_BAUDRATE 115200  ///< Baud rate of the console UART. Can be raised (e.g. CONSOLE_BAUDRATE=1000000 in the project symbols) to stream data to a host
+#endif
+
+#define LOG_MODE_TEXT 0    ///< LogMessage formats the text with vsnprintf on the caller's thread
+#define LOG_MODE_BINARY 1  ///< The LOG_xxx macros send the ID of their call site plus raw arguments. Decode with Tools/LogDecoder
+
+#ifndef LOG_MODE
+#define LOG_MODE LOG_MODE_TEXT  ///< Logging mode, chosen at build time. Add LOG_MODE=LOG_MODE_BINARY to the project symbols to switch
+#endif
+
+#define LOGGER_TASK_SIZE 150                      ///< Size of stack to assign to the logger thread. In words
+#define LOGGER_TASK_PRIORITY (tskIDLE_PRIORITY + 1)  ///< Lowest application priority, so logging never delays the other tasks
+#define LOG_SLOT_COUNT 8                          ///< Number of messages that can wait for the logger task at the same time
+#define LOG_SLOT_SIZE 96                          ///< Maximum size of a formatted message (or binary record), in bytes. Longer messages are cut
 
 /******************************************************************************
  * Structures and Enumerations
@@ -55,18 +71,80 @@ enum eDebugLogLevels {
     N_DEBUG_LEVELS = 6    // Max number of log levels
 };
 
+/******************************************************************************
+ * Logging Macros
+ ******************************************************************************/
+/*
+ * Compile-time log filtering. Use the LOG_xxx macros instead of calling LogMessage directly: a call below the
+ * threshold of its module compiles to nothing (neither the format string nor the argument evaluation survive), and
+ * a call that is compiled in checks the run-time level (setLogLevel) before its arguments are evaluated.
+ *
+ * LOG_COMPILE_LEVEL is the threshold of the whole build. Release builds (NDEBUG) keep warnings and above.
+ * A module can use its own threshold by defining LOG_MODULE_LEVEL before its first #include, e.g.
+ *		#define LOG_MODULE_LEVEL LOG_ERROR_LVL
+ */
+#ifndef LOG_COMPILE_LEVEL
+#ifdef NDEBUG
+#define LOG_COMPILE_LEVEL LOG_WARNING_LVL  ///< Lowest level compiled in, for the modules that do not set LOG_MODULE_LEVEL
+#else
+#define LOG_COMPILE_LEVEL LOG_INFO_LVL  ///< Lowest level compiled in, for the modules that do not set LOG_MODULE_LEVEL
+#endif
+#endif
+
+#ifndef LOG_MODULE_LEVEL
+#define LOG_MODULE_LEVEL LOG_COMPILE_LEVEL  ///< Lowest level compiled in for the current module
+#endif
+
+#define LOG_FORMAT_OF(format, ...) format  ///< First argument of a LOG_xxx call. Called with a 0 after __VA_ARGS__, so "..." is never empty
+
+/// Logs a message if level is compiled in for this module and enabled at run time. level must be a constant
+#if (LOG_MODE == LOG_MODE_BINARY)
+#define LOG_AT(level, ...)                                                    \
+    do {                                                                      \
+        if ((level) >= LOG_MODULE_LEVEL && getLogLevel() <= (level)) {        \
+            BINARY_LOG_SITE(logSite, (level), LOG_FORMAT_OF(__VA_ARGS__, 0)); \
+            LogMessageSite((level), &logSite, logSiteSignature, __VA_ARGS__); \
+        }                                                                     \
+    } while (0)
+#else
+#define LOG_AT(level, ...)                                             \
+    do {                                                               \
+        if ((level) >= LOG_MODULE_LEVEL && getLogLevel() <= (level)) { \
+            LogMessage((level), __VA_ARGS__);                          \
+        }                                                              \
+    } while (0)
+#endif
+
+#define LOG_INFO(...) LOG_AT(LOG_INFO_LVL, __VA_ARGS__)        ///< Logs an INFO message
+#define LOG_DEBUG(...) LOG_AT(LOG_DEBUG_LVL, __VA_ARGS__)      ///< Logs a DEBUG message
+#define LOG_WARNING(...) LOG_AT(LOG_WARNING_LVL, __VA_ARGS__)  ///< Logs a WARNING message
+#define LOG_ERROR(...) LOG_AT(LOG_ERROR_LVL, __VA_ARGS__)      ///< Logs an ERROR message
+#define LOG_FATAL(...) LOG_AT(LOG_FATAL_LVL, __VA_ARGS__)      ///< Logs a FATAL message
+
 /******************************************************************************
  * Global Function Declarations
  ******************************************************************************/
 void InitializeSerialConsole(void);
 void DeinitializeSerialConsole(void);
 void SerialConsoleWriteString(const char *string);
+bool SerialConsoleWriteBuffer(const uint8_t *data, size_t len);
+void SerialConsoleWriteBlocking(const uint8_t *data, size_t len);
 int SerialConsoleReadCharacter(uint8_t *rxChar);
+size_t SerialConsoleReadSpan(uint8_t **data);
+void SerialConsoleReleaseSpan(size_t len);
+size_t SerialConsoleGetRxCount(void);
+void SerialConsoleEnableRxWakeup(void);
 void LogMessage(enum eDebugLogLevels level, const char *format, ...);
+#if (LOG_MODE == LOG_MODE_BINARY)
+void LogMessageSite(enum eDebugLogLevels level, const BinaryLogFormat *site, uint8_t *signature, const char *format, ...);
+#endif
 void setLogLevel(enum eDebugLogLevels debugLevel);
 enum eDebugLogLevels getLogLevel(void);
 struct usart_module *GetUsartModule(void);
 void LogMessageDebug(const char *format, ...);
+uint32_t LogGetDropCount(enum eDebugLogLevels level);
+void LogResetDropCounts(void);
+void vLoggerTask(void *pvParameters);
 
 /******************************************************************************
  * Local Functions
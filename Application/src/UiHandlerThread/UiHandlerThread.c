@@ -16,6 +16,8 @@ Thread for ESE516 Spring (Online) Edition
 
 #include "DistanceDriver/DistanceSensor.h"
 #include "IMU/lsm6dso_reg.h"
+#include "LedFrame/LedFrame.h"
+#include "LedFrame/LedSequence.h"
 #include "SeesawDriver/Seesaw.h"
 #include "SerialConsole.h"
 #include "WifiHandlerThread/WifiHandler.h"
@@ -28,6 +30,17 @@ Thread for ESE516 Spring (Online) Edition
  ******************************************************************************/
 #define BUTTON_PRESSES_MAX 16  ///< Number of maximum button presses to analize in one go
 
+#define UI_KEYPAD_INT_PIN EXT1_PIN_IRQ          ///< Seesaw INT on EXT1 pin 9: open drain, low while key events wait in its FIFO
+#define UI_KEYPAD_INT_EIC_PIN EXT1_IRQ_PIN      ///< Same pin, EIC function
+#define UI_KEYPAD_INT_EIC_MUX EXT1_IRQ_MUX      ///< Pin mux of the EIC function
+#define UI_KEYPAD_INT_EIC_LINE EXT1_IRQ_INPUT   ///< EIC line of the Seesaw INT
+#define UI_KEYPAD_RETRY_MS 10                   ///< Wait before reading the keypad again when INT is low but no event could be read
+
+#define UI_MOVE_ON_MS 600       ///< Time the first move of a game stays lit
+#define UI_MOVE_OFF_MS 200      ///< Dark gap after the first move
+#define UI_MOVE_MIN_ON_MS 150   ///< Shortest time a move stays lit, however long the game
+#define UI_MOVE_SPEEDUP 8       ///< Each move plays 8 % faster than the previous one
+
 /******************************************************************************
  * Variables
  ******************************************************************************/
@@ -43,14 +56,50 @@ uint8_t keysToPress = 0;              ///< Variable that holds the number of new
 bool playIsDone = false;              ///< Boolean flag to indicate if the player has finished moving.
                                       ///< Useful for COntrol to determine when to send back a play.
 uint8_t buttons[BUTTON_PRESSES_MAX];  ///< Array to hold button presses
+
+static TaskHandle_t uiTask = NULL;    ///< UI task, woken by the keypad interrupt and by UiOrderShowMoves
+static bool uiKeypadRetry = false;    ///< INT was low but no event could be read: read again after UI_KEYPAD_RETRY_MS
+static const struct LedSequenceTempo uiMoveTempo = {UI_MOVE_ON_MS, UI_MOVE_OFF_MS, UI_MOVE_MIN_ON_MS, UI_MOVE_SPEEDUP};  ///< Tempo of the move playback
 /******************************************************************************
  * Forward Declarations
  ******************************************************************************/
+static void UiConfigureKeypadInterrupt(void);
+static bool UiKeypadEventPending(void);
+static TickType_t UiSleepTime(void);
 
 /******************************************************************************
  * Callback Functions
  ******************************************************************************/
 
+/**
+ * @fn		static void UiMoveSequenceEvent(enum LedSequenceEvent event, uint8_t step)
+ * @brief	LedSequence events of the move playback: wakes the UI task to send the new frame (lit move or dark gap), or to leave UI_STATE_PLAY_MOVES
+ * @note	Called from the timer task
+ */
+static void UiMoveSequenceEvent(enum LedSequenceEvent event, uint8_t step)
+{
+    (void)event;
+    (void)step;
+    if (uiTask != NULL) {
+        xTaskNotifyGive(uiTask);
+    }
+}
+
+/**
+ * @fn		static void UiKeypadInterruptCallback(void)
+ * @brief	EXTINT callback of the Seesaw INT line (falling edge): wakes the UI task
+ * @note	Called from the EIC interrupt
+ */
+static void UiKeypadInterruptCallback(void)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    if (uiTask != NULL) {
+        vTaskNotifyGiveFromISR(uiTask, &xHigherPriorityTaskWoken);
+    }
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
 /******************************************************************************
  * Task Function
  ******************************************************************************/
@@ -68,6 +117,17 @@ void vUiHandlerTask(void *pvParameters)
     // Do initialization code here
     SerialConsoleWriteString("UI Task Started!");
     uiState = UI_STATE_IGNORE_PRESSES;  // Initial state
+    uiTask = xTaskGetCurrentTaskHandle();
+    UiConfigureKeypadInterrupt();
+
+#if NEO_TRELLIS_LED_TEST_MS > 0
+    // LED self-test. Runs here rather than in InitializeSeesaw, so it does not hold back the start of the other tasks
+    LedFrameSet(15, 255, 255, 255);
+    LedFrameShow();
+    vTaskDelay(pdMS_TO_TICKS(NEO_TRELLIS_LED_TEST_MS));
+    LedFrameSet(15, 0, 0, 0);
+    LedFrameShow();
+#endif
 
     // Graphics Test - Remove if not using
     gfx_mono_init();
@@ -107,23 +167,25 @@ void vUiHandlerTask(void *pvParameters)
                 // the message gets longer might be more fun! After you finish showing
                 // the move should go to state UI_STATE_HANDLE_BUTTONS
 
-                // In the beginner example we turn LED0 and LED15 will turn on for 500
-                // ms then we go to UI_STATE_HANDLE_BUTTONS
-                SeesawSetLed(0, red, green, blue);  // Turn button 1 on
-                SeesawOrderLedUpdate();
-                vTaskDelay(1000);
-                SeesawSetLed(0, 0, 0, 0);            // Turn button 1 off
-                SeesawSetLed(15, red, green, blue);  // Turn button 15 on
-                SeesawOrderLedUpdate();
-                vTaskDelay(1000);
-                SeesawSetLed(15, 0, 0, 0);  // Turn button 15 off
-                SeesawOrderLedUpdate();
-                vTaskDelay(1000);
-                uiState = UI_STATE_HANDLE_BUTTONS;
+                // The moves play on a timer (LedSequence), faster as the game grows, so the task stays
+                // responsive: a new packet restarts the playback. UI_STATE_PLAY_MOVES waits for the end
+                LedFrameFill(0, 0, 0);
+                if (ERROR_NONE != LedSequenceStart(&gamePacketIn, &uiMoveTempo, red, green, blue, UiMoveSequenceEvent)) {
+                    SerialConsoleWriteString("Could not play the moves!\r\n");
+                }
+                uiState = UI_STATE_PLAY_MOVES;
 
                 break;
             }
 
+            case (UI_STATE_PLAY_MOVES): {
+                // Frames are sent by LedFrameFlush below. Key presses wait in the Seesaw FIFO until the playback ends
+                if (!LedSequenceIsRunning()) {
+                    uiState = UI_STATE_HANDLE_BUTTONS;
+                }
+                break;
+            }
+
             case (UI_STATE_HANDLE_BUTTONS): {
                 // This state should accept (gamePacketIn length + 1) moves from the
                 // player (capped to maximum 19 + new move) The moves by the player
@@ -132,27 +194,35 @@ void vUiHandlerTask(void *pvParameters)
 
                 // In this example, we return after only one button press!
 
-                uint8_t numPresses = SeesawGetKeypadCount();
+                // The Seesaw pulls INT low while it has events, so the bus is only used when a key was touched
+                uint8_t numPresses = 0;
+                if (UiKeypadEventPending()) {
+                    numPresses = SeesawGetKeypadCount();
+                    uiKeypadRetry = (numPresses == 0);
+                }
                 memset(buttons, 0, BUTTON_PRESSES_MAX);
 
                 if (numPresses >= BUTTON_PRESSES_MAX) {
                     numPresses = BUTTON_PRESSES_MAX;
                 }
-                if (numPresses != 0 && ERROR_NONE == SeesawReadKeypad(buttons, numPresses)) {
+                if (numPresses != 0 && ERROR_NONE != SeesawReadKeypad(buttons, numPresses)) {
+                    uiKeypadRetry = true;  // INT stays low: read again after UI_KEYPAD_RETRY_MS
+                    numPresses = 0;
+                }
+                if (numPresses != 0) {
                     // Process Buttons
                     for (int iter = 0; iter < numPresses; iter++) {
                         uint8_t keynum = NEO_TRELLIS_SEESAW_KEY((buttons[iter] & 0xFD) >> 2);
                         uint8_t actionButton = buttons[iter] & 0x03;
                         if (actionButton == 0x03) {
-                            SeesawSetLed(keynum, red, green, blue);
+                            LedFrameSet(keynum, red, green, blue);
                         } else {
-                            SeesawSetLed(keynum, 0, 0, 0);
+                            LedFrameSet(keynum, 0, 0, 0);
                             // Button released! Count this into the buttons pressed by user.
                             gamePacketOut.game[pressedKeys] = keynum;
                             pressedKeys++;
                         }
                     }
-                    SeesawOrderLedUpdate();
                 }
 
                 // Check if we are done!
@@ -172,9 +242,66 @@ void vUiHandlerTask(void *pvParameters)
                 break;
         }
 
-        // After execution, you can put a thread to sleep for some time.
-        vTaskDelay(50);
+        // Send the LED changes of this iteration, if any, as one frame
+        LedFrameFlush();
+
+        // Sleep until a key event, a new game to show (UiOrderShowMoves) or the next LED frame
+        TickType_t sleep = UiSleepTime();
+        if (sleep != 0) {
+            ulTaskNotifyTake(pdTRUE, sleep);
+        }
+    }
+}
+
+/******************************************************************************
+ * Local Functions
+ ******************************************************************************/
+
+/**
+ * @fn		static void UiConfigureKeypadInterrupt(void)
+ * @brief	Routes the Seesaw INT line to the EIC. The Seesaw keypad interrupt is enabled by InitializeSeesaw
+ */
+static void UiConfigureKeypadInterrupt(void)
+{
+    struct extint_chan_conf config_extint_chan;
+    extint_chan_get_config_defaults(&config_extint_chan);
+    config_extint_chan.gpio_pin = UI_KEYPAD_INT_EIC_PIN;
+    config_extint_chan.gpio_pin_mux = UI_KEYPAD_INT_EIC_MUX;
+    config_extint_chan.gpio_pin_pull = EXTINT_PULL_UP;
+    config_extint_chan.detection_criteria = EXTINT_DETECT_FALLING;
+    extint_chan_set_config(UI_KEYPAD_INT_EIC_LINE, &config_extint_chan);
+
+    extint_register_callback(UiKeypadInterruptCallback, UI_KEYPAD_INT_EIC_LINE, EXTINT_CALLBACK_TYPE_DETECT);
+    extint_chan_enable_callback(UI_KEYPAD_INT_EIC_LINE, EXTINT_CALLBACK_TYPE_DETECT);
+}
+
+/**
+ * @fn		static bool UiKeypadEventPending(void)
+ * @brief	Returns true while the Seesaw holds INT low (key events in its FIFO)
+ * @details	The pin level, not the notification, tells if events wait: one notification may stand for several edges,
+ *			or for a LedSequence event, and the FIFO may still hold events after a read.
+ */
+static bool UiKeypadEventPending(void)
+{
+    return !port_pin_get_input_level(UI_KEYPAD_INT_PIN);
+}
+
+/**
+ * @fn		static TickType_t UiSleepTime(void)
+ * @brief	Returns how long the UI task may sleep before it has work: 0 if it has work now
+ * @details	Key events are ignored outside UI_STATE_HANDLE_BUTTONS: they wait in the Seesaw FIFO, which
+ *			UI_STATE_SHOW_MOVES empties. An interrupt edge or UiOrderShowMoves ends the sleep early.
+ */
+static TickType_t UiSleepTime(void)
+{
+    TickType_t sleep = LedFrameFlushDelay();
+
+    if (uiState == UI_STATE_SHOW_MOVES) return 0;
+    if (uiState == UI_STATE_HANDLE_BUTTONS && UiKeypadEventPending()) {
+        TickType_t retry = uiKeypadRetry ? pdMS_TO_TICKS(UI_KEYPAD_RETRY_MS) : 0;
+        if (retry < sleep) sleep = retry;
     }
+    return sleep;
 }
 
 /******************************************************************************
@@ -185,6 +312,9 @@ void UiOrderShowMoves(struct GameDataPacket *packetIn)
     memcpy(&gamePacketIn, packetIn, sizeof(gamePacketIn));
     uiState = UI_STATE_SHOW_MOVES;
     playIsDone = false;  // Set play to false
+    if (uiTask != NULL) {
+        xTaskNotifyGive(uiTask);
+    }
 }
 
 bool UiPlayIsDone(void)
@@ -24,6 +24,7 @@ typedef enum uiStateMachine_state {
     UI_STATE_HANDLE_BUTTONS = 0,  ///< State used to handle buttons
     UI_STATE_IGNORE_PRESSES,      ///< State to ignore button presses
     UI_STATE_SHOW_MOVES,          ///< State to show opponent's moves
+    UI_STATE_PLAY_MOVES,          ///< State while the opponent's moves play on the LEDs (LedSequence)
     UI_STATE_MAX_STATES           ///< Max number of states
 
 } uiStateMachine_state;
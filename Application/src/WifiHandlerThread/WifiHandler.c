@@ -9,6 +9,10 @@
 /******************************************************************************
  * Includes
  ******************************************************************************/
+#ifndef WIFI_LOG_LEVEL
+#define WIFI_LOG_LEVEL LOG_COMPILE_LEVEL  ///< Lowest log level compiled into this module. Set WIFI_LOG_LEVEL=LOG_OFF_LVL in the project symbols to drop all of its logs
+#endif
+#define LOG_MODULE_LEVEL WIFI_LOG_LEVEL  // Must be defined before SerialConsole.h is included
 
 #include "WifiHandlerThread/WifiHandler.h"
 
@@ -16,6 +20,9 @@
 
 #include "ControlThread/ControlThread.h"
 #include "UiHandlerThread/UiHandlerThread.h"
+#include "RunTimeStats/RunTimeStats.h"
+#include "Bench/BenchTarget.h"
+#include "I2cDriver/I2cDriver.h"
 
 /******************************************************************************
  * Defines
@@ -33,6 +40,9 @@ QueueHandle_t xQueueWifiState = NULL;       ///< Queue to determine the Wifi sta
 QueueHandle_t xQueueGameBuffer = NULL;      ///< Queue to send the next play to the cloud
 QueueHandle_t xQueueImuBuffer = NULL;       ///< Queue to send IMU data to the cloud
 QueueHandle_t xQueueDistanceBuffer = NULL;  ///< Queue to send the distance to the cloud
+QueueHandle_t xQueueBenchRequest = NULL;    ///< Queue of benchmarks to run in this task (see BenchTarget.h)
+SemaphoreHandle_t xBenchDoneSemaphore = NULL;  ///< Given by this task when it is done with the benchmark of WifiRunBench
+static struct BenchRequest *volatile benchInFlight = NULL;  ///< Benchmark handed to this task and not finished yet
 
 /*HTTP DOWNLOAD RELATED DEFINES AND VARIABLES*/
 
@@ -67,6 +77,10 @@ char mqtt_user[64] = "Unit1";
 /* Instance of MQTT service. */
 static struct mqtt_module mqtt_inst;
 
+/* Benchmark round trips: sequence number of the message in flight, and whether the broker sent it back. */
+static uint32_t benchEchoSequence = 0;
+static volatile bool benchEchoReceived = false;
+
 /* Receive buffer of the MQTT service. */
 static unsigned char mqtt_read_buffer[MAIN_MQTT_BUFFER_SIZE];
 static unsigned char mqtt_send_buffer[MAIN_MQTT_BUFFER_SIZE];
@@ -77,6 +91,8 @@ static unsigned char mqtt_send_buffer[MAIN_MQTT_BUFFER_SIZE];
 static void MQTT_InitRoutine(void);
 static void MQTT_HandleGameMessages(void);
 static void MQTT_HandleImuMessages(void);
+static void MQTT_HandleStatsMessages(void);
+static void WifiHandleBenchRequests(void);
 static void HTTP_DownloadFileInit(void);
 static void HTTP_DownloadFileTransaction(void);
 /******************************************************************************
@@ -216,27 +232,27 @@ static bool rename_to_unique(FIL *fp, char *file_path_name, uint8_t max_len)
 static void start_download(void)
 {
     if (!is_state_set(STORAGE_READY)) {
-        LogMessage(LOG_DEBUG_LVL, "start_download: MMC storage not ready.\r\n");
+        LOG_DEBUG("start_download: MMC storage not ready.\r\n");
         return;
     }
 
     if (!is_state_set(WIFI_CONNECTED)) {
-        LogMessage(LOG_DEBUG_LVL, "start_download: Wi-Fi is not connected.\r\n");
+        LOG_DEBUG("start_download: Wi-Fi is not connected.\r\n");
         return;
     }
 
     if (is_state_set(GET_REQUESTED)) {
-        LogMessage(LOG_DEBUG_LVL, "start_download: request is sent already.\r\n");
+        LOG_DEBUG("start_download: request is sent already.\r\n");
         return;
     }
 
     if (is_state_set(DOWNLOADING)) {
-        LogMessage(LOG_DEBUG_LVL, "start_download: running download already.\r\n");
+        LOG_DEBUG("start_download: running download already.\r\n");
         return;
     }
 
     /* Send the HTTP request. */
-    LogMessage(LOG_DEBUG_LVL, "start_download: sending HTTP request...\r\n");
+    LOG_DEBUG("start_download: sending HTTP request...\r\n");
     int http_req_status = http_client_send_request(&http_client_module_inst, MAIN_HTTP_FILE_URL, HTTP_METHOD_GET, NULL, NULL);
 }
 
@@ -249,7 +265,7 @@ static void store_file_packet(char *data, uint32_t length)
 {
     FRESULT ret;
     if ((data == NULL) || (length < 1)) {
-        LogMessage(LOG_DEBUG_LVL, "store_file_packet: empty data.\r\n");
+        LOG_DEBUG("store_file_packet: empty data.\r\n");
         return;
     }
 
@@ -265,16 +281,16 @@ static void store_file_packet(char *data, uint32_t length)
             cp++;
             strcpy(&save_file_name[2], cp);
         } else {
-            LogMessage(LOG_DEBUG_LVL, "store_file_packet: file name is invalid. Download canceled.\r\n");
+            LOG_DEBUG("store_file_packet: file name is invalid. Download canceled.\r\n");
             add_state(CANCELED);
             return;
         }
 
         rename_to_unique(&file_object, save_file_name, MAIN_MAX_FILE_NAME_LENGTH);
-        LogMessage(LOG_DEBUG_LVL, "store_file_packet: creating file [%s]\r\n", save_file_name);
+        LOG_DEBUG("store_file_packet: creating file [%s]\r\n", save_file_name);
         ret = f_open(&file_object, (char const *)save_file_name, FA_CREATE_ALWAYS | FA_WRITE);
         if (ret != FR_OK) {
-            LogMessage(LOG_DEBUG_LVL, "store_file_packet: file creation error! ret:%d\r\n", ret);
+            LOG_DEBUG("store_file_packet: file creation error! ret:%d\r\n", ret);
             return;
         }
 
@@ -288,15 +304,15 @@ static void store_file_packet(char *data, uint32_t length)
         if (ret != FR_OK) {
             f_close(&file_object);
             add_state(CANCELED);
-            LogMessage(LOG_DEBUG_LVL, "store_file_packet: file write error, download canceled.\r\n");
+            LOG_DEBUG("store_file_packet: file write error, download canceled.\r\n");
             return;
         }
 
         received_file_size += wsize;
-        LogMessage(LOG_DEBUG_LVL, "store_file_packet: received[%lu], file size[%lu]\r\n", (unsigned long)received_file_size, (unsigned long)http_file_size);
+        LOG_DEBUG("store_file_packet: received[%lu], file size[%lu]\r\n", (unsigned long)received_file_size, (unsigned long)http_file_size);
         if (received_file_size >= http_file_size) {
             f_close(&file_object);
-            LogMessage(LOG_DEBUG_LVL, "store_file_packet: file downloaded successfully.\r\n");
+            LOG_DEBUG("store_file_packet: file downloaded successfully.\r\n");
             port_pin_set_output_level(LED_0_PIN, false);
             add_state(COMPLETED);
             return;
@@ -315,16 +331,16 @@ static void http_client_callback(struct http_client_module *module_inst, int typ
 {
     switch (type) {
         case HTTP_CLIENT_CALLBACK_SOCK_CONNECTED:
-            LogMessage(LOG_DEBUG_LVL, "http_client_callback: HTTP client socket connected.\r\n");
+            LOG_DEBUG("http_client_callback: HTTP client socket connected.\r\n");
             break;
 
         case HTTP_CLIENT_CALLBACK_REQUESTED:
-            LogMessage(LOG_DEBUG_LVL, "http_client_callback: request completed.\r\n");
+            LOG_DEBUG("http_client_callback: request completed.\r\n");
             add_state(GET_REQUESTED);
             break;
 
         case HTTP_CLIENT_CALLBACK_RECV_RESPONSE:
-            LogMessage(LOG_DEBUG_LVL, "http_client_callback: received response %u data size %u\r\n", (unsigned int)data->recv_response.response_code, (unsigned int)data->recv_response.content_length);
+            LOG_DEBUG("http_client_callback: received response %u data size %u\r\n", (unsigned int)data->recv_response.response_code, (unsigned int)data->recv_response.content_length);
             if ((unsigned int)data->recv_response.response_code == 200) {
                 http_file_size = data->recv_response.content_length;
                 received_file_size = 0;
@@ -347,7 +363,7 @@ static void http_client_callback(struct http_client_module *module_inst, int typ
             break;
 
         case HTTP_CLIENT_CALLBACK_DISCONNECTED:
-            LogMessage(LOG_DEBUG_LVL, "http_client_callback: disconnection reason:%d\r\n", data->disconnected.reason);
+            LOG_DEBUG("http_client_callback: disconnection reason:%d\r\n", data->disconnected.reason);
 
             /* If disconnect reason is equal to -ECONNRESET(-104),
              * It means the server has closed the connection (timeout).
@@ -403,13 +419,12 @@ static void socket_cb(SOCKET sock, uint8_t u8Msg, void *pvMsg)
  */
 static void resolve_cb(uint8_t *pu8DomainName, uint32_t u32ServerIP)
 {
-    LogMessage(LOG_DEBUG_LVL,
-               "resolve_cb: %s IP address is %d.%d.%d.%d\r\n\r\n",
-               pu8DomainName,
-               (int)IPV4_BYTE(u32ServerIP, 0),
-               (int)IPV4_BYTE(u32ServerIP, 1),
-               (int)IPV4_BYTE(u32ServerIP, 2),
-               (int)IPV4_BYTE(u32ServerIP, 3));
+    LOG_DEBUG("resolve_cb: %s IP address is %d.%d.%d.%d\r\n\r\n",
+              pu8DomainName,
+              (int)IPV4_BYTE(u32ServerIP, 0),
+              (int)IPV4_BYTE(u32ServerIP, 1),
+              (int)IPV4_BYTE(u32ServerIP, 2),
+              (int)IPV4_BYTE(u32ServerIP, 3));
     http_client_socket_resolve_handler(pu8DomainName, u32ServerIP);
 }
 
@@ -444,10 +459,10 @@ static void wifi_cb(uint8_t u8MsgType, void *pvMsg)
         case M2M_WIFI_RESP_CON_STATE_CHANGED: {
             tstrM2mWifiStateChanged *pstrWifiState = (tstrM2mWifiStateChanged *)pvMsg;
             if (pstrWifiState->u8CurrState == M2M_WIFI_CONNECTED) {
-                LogMessage(LOG_DEBUG_LVL, "wifi_cb: M2M_WIFI_CONNECTED\r\n");
+                LOG_DEBUG("wifi_cb: M2M_WIFI_CONNECTED\r\n");
                 m2m_wifi_request_dhcp_client();
             } else if (pstrWifiState->u8CurrState == M2M_WIFI_DISCONNECTED) {
-                LogMessage(LOG_DEBUG_LVL, "wifi_cb: M2M_WIFI_DISCONNECTED\r\n");
+                LOG_DEBUG("wifi_cb: M2M_WIFI_DISCONNECTED\r\n");
                 clear_state(WIFI_CONNECTED);
                 if (is_state_set(DOWNLOADING)) {
                     f_close(&file_object);
@@ -470,8 +485,9 @@ static void wifi_cb(uint8_t u8MsgType, void *pvMsg)
 
         case M2M_WIFI_REQ_DHCP_CONF: {
             uint8_t *pu8IPAddress = (uint8_t *)pvMsg;
-            LogMessage(LOG_DEBUG_LVL, "wifi_cb: IP address is %u.%u.%u.%u\r\n", pu8IPAddress[0], pu8IPAddress[1], pu8IPAddress[2], pu8IPAddress[3]);
+            LOG_DEBUG("wifi_cb: IP address is %u.%u.%u.%u\r\n", pu8IPAddress[0], pu8IPAddress[1], pu8IPAddress[2], pu8IPAddress[3]);
             add_state(WIFI_CONNECTED);
+            RunTimeStatsMarkBoot(BOOT_MARK_WIFI);
 
             if (do_download_flag == 1) {
                 start_download();
@@ -479,7 +495,7 @@ static void wifi_cb(uint8_t u8MsgType, void *pvMsg)
             } else {
                 /* Try to connect to MQTT broker when Wi-Fi was connected. */
                 if (mqtt_connect(&mqtt_inst, main_mqtt_broker)) {
-                    LogMessage(LOG_DEBUG_LVL, "Error connecting to MQTT Broker!\r\n");
+                    LOG_DEBUG("Error connecting to MQTT Broker!\r\n");
                 }
             }
         } break;
@@ -500,28 +516,28 @@ void init_storage(void)
     /* Initialize SD/MMC stack. */
     sd_mmc_init();
     while (true) {
-        LogMessage(LOG_DEBUG_LVL, "init_storage: please plug an SD/MMC card in slot...\r\n");
+        LOG_DEBUG("init_storage: please plug an SD/MMC card in slot...\r\n");
 
         /* Wait card present and ready. */
         do {
             status = sd_mmc_test_unit_ready(0);
             if (CTRL_FAIL == status) {
-                LogMessage(LOG_DEBUG_LVL, "init_storage: SD Card install failed.\r\n");
-                LogMessage(LOG_DEBUG_LVL, "init_storage: try unplug and re-plug the card.\r\n");
+                LOG_DEBUG("init_storage: SD Card install failed.\r\n");
+                LOG_DEBUG("init_storage: try unplug and re-plug the card.\r\n");
                 while (CTRL_NO_PRESENT != sd_mmc_check(0)) {
                 }
             }
         } while (CTRL_GOOD != status);
 
-        LogMessage(LOG_DEBUG_LVL, "init_storage: mounting SD card...\r\n");
+        LOG_DEBUG("init_storage: mounting SD card...\r\n");
         memset(&fatfs, 0, sizeof(FATFS));
         res = f_mount(LUN_ID_SD_MMC_0_MEM, &fatfs);
         if (FR_INVALID_DRIVE == res) {
-            LogMessage(LOG_DEBUG_LVL, "init_storage: SD card mount failed! (res %d)\r\n", res);
+            LOG_DEBUG("init_storage: SD card mount failed! (res %d)\r\n", res);
             return;
         }
 
-        LogMessage(LOG_DEBUG_LVL, "init_storage: SD card mount OK.\r\n");
+        LOG_DEBUG("init_storage: SD card mount OK.\r\n");
         add_state(STORAGE_READY);
         return;
     }
@@ -580,7 +596,7 @@ static void configure_http_client(void)
 
     ret = http_client_init(&http_client_module_inst, &httpc_conf);
     if (ret < 0) {
-        LogMessage(LOG_DEBUG_LVL, "configure_http_client: HTTP client initialization failed! (res %d)\r\n", ret);
+        LOG_DEBUG("configure_http_client: HTTP client initialization failed! (res %d)\r\n", ret);
         while (1) {
         } /* Loop forever. */
     }
@@ -633,7 +649,7 @@ static void socket_resolve_handler(uint8_t *doamin_name, uint32_t server_ip)
 void SubscribeHandlerLedTopic(MessageData *msgData)
 {
     uint8_t rgb[3] = {0, 0, 0};
-    LogMessage(LOG_DEBUG_LVL, "\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
+    LOG_DEBUG("\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
     // Will receive something of the style "rgb(222, 224, 189)"
     if (strncmp(msgData->message->payload, "rgb(", 4) == 0) {
         char *p = (char *)&msgData->message->payload[4];
@@ -643,7 +659,7 @@ void SubscribeHandlerLedTopic(MessageData *msgData)
             if (*p != ',') break;
             p++; /* skip, */
         }
-        LogMessage(LOG_DEBUG_LVL, "\r\nRGB %d %d %d\r\n", rgb[0], rgb[1], rgb[2]);
+        LOG_DEBUG("\r\nRGB %d %d %d\r\n", rgb[0], rgb[1], rgb[2]);
         UIChangeColors(rgb[0], rgb[1], rgb[2]);
     }
 }
@@ -655,9 +671,9 @@ void SubscribeHandlerGameTopic(MessageData *msgData)
 
     // Parse input. The start string must be '{"game":['
     if (strncmp(msgData->message->payload, "{\"game\":[", 9) == 0) {
-        LogMessage(LOG_DEBUG_LVL, "\r\nGame message received!\r\n");
-        LogMessage(LOG_DEBUG_LVL, "\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
-        LogMessage(LOG_DEBUG_LVL, "%.*s", msgData->message->payloadlen, (char *)msgData->message->payload);
+        LOG_DEBUG("\r\nGame message received!\r\n");
+        LOG_DEBUG("\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
+        LOG_DEBUG("%.*s", msgData->message->payloadlen, (char *)msgData->message->payload);
 
         int nb = 0;
         char *p = &msgData->message->payload[9];
@@ -666,41 +682,59 @@ void SubscribeHandlerGameTopic(MessageData *msgData)
             if (*p != ',') break;
             p++; /* skip, */
         }
-        LogMessage(LOG_DEBUG_LVL, "\r\nParsed Command: ");
+        LOG_DEBUG("\r\nParsed Command: ");
         for (int i = 0; i < GAME_SIZE; i++) {
-            LogMessage(LOG_DEBUG_LVL, "%d,", game.game[i]);
+            LOG_DEBUG("%d,", game.game[i]);
         }
 
         if (pdTRUE == ControlAddGameData(&game)) {
-            LogMessage(LOG_DEBUG_LVL, "\r\nSent play to control!\r\n");
+            LOG_DEBUG("\r\nSent play to control!\r\n");
         }
 
     } else {
-        LogMessage(LOG_DEBUG_LVL, "\r\nGame message received but not understood!\r\n");
-        LogMessage(LOG_DEBUG_LVL, "\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
-        LogMessage(LOG_DEBUG_LVL, "%.*s", msgData->message->payloadlen, (char *)msgData->message->payload);
+        LOG_DEBUG("\r\nGame message received but not understood!\r\n");
+        LOG_DEBUG("\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
+        LOG_DEBUG("%.*s", msgData->message->payloadlen, (char *)msgData->message->payload);
     }
 }
 
 void SubscribeHandlerImuTopic(MessageData *msgData)
 {
-    LogMessage(LOG_DEBUG_LVL, "\r\nIMU topic received!\r\n");
-    LogMessage(LOG_DEBUG_LVL, "\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
+    LOG_DEBUG("\r\nIMU topic received!\r\n");
+    LOG_DEBUG("\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
+}
+
+/**
+ void SubscribeHandlerBenchTopic(MessageData *msgData)
+ * @brief	Marks the benchmark round trip as done when the broker sends back the message in flight
+ * @note	Messages from a round trip that already timed out carry an older sequence number and are ignored
+*/
+void SubscribeHandlerBenchTopic(MessageData *msgData)
+{
+    char sequence[12];
+    size_t len = msgData->message->payloadlen;
+    if (len >= sizeof(sequence)) return;
+
+    memcpy(sequence, msgData->message->payload, len);
+    sequence[len] = '\0';
+    if (strtoul(sequence, NULL, 10) == benchEchoSequence) {
+        benchEchoReceived = true;
+    }
 }
 
 void SubscribeHandlerDistanceTopic(MessageData *msgData)
 {
-    LogMessage(LOG_DEBUG_LVL, "\r\nDistance topic received!\r\n");
-    LogMessage(LOG_DEBUG_LVL, "\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
+    LOG_DEBUG("\r\nDistance topic received!\r\n");
+    LOG_DEBUG("\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
 }
 
 void SubscribeHandler(MessageData *msgData)
 {
     /* You received publish message which you had subscribed. */
     /* Print Topic and message */
-    LogMessage(LOG_DEBUG_LVL, "\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
-    LogMessage(LOG_DEBUG_LVL, " >> ");
-    LogMessage(LOG_DEBUG_LVL, "%.*s", msgData->message->payloadlen, (char *)msgData->message->payload);
+    LOG_DEBUG("\r\n %.*s", msgData->topicName->lenstring.len, msgData->topicName->lenstring.data);
+    LOG_DEBUG(" >> ");
+    LOG_DEBUG("%.*s", msgData->message->payloadlen, (char *)msgData->message->payload);
 
     // Handle LedData message
     if (strncmp((char *)msgData->topicName->lenstring.data, LED_TOPIC, msgData->message->payloadlen) == 0) {
@@ -735,14 +769,14 @@ static void mqtt_callback(struct mqtt_module *module_inst, int type, union mqtt_
              * Or else retry to connect to broker server.
              */
             if (data->sock_connected.result >= 0) {
-                LogMessage(LOG_DEBUG_LVL, "\r\nConnecting to Broker...");
+                LOG_DEBUG("\r\nConnecting to Broker...");
                 if (0 != mqtt_connect_broker(module_inst, 1, CLOUDMQTT_USER_ID, CLOUDMQTT_USER_PASSWORD, CLOUDMQTT_USER_ID, NULL, NULL, 0, 0, 0)) {
-                    LogMessage(LOG_DEBUG_LVL, "MQTT  Error - NOT Connected to broker\r\n");
+                    LOG_DEBUG("MQTT  Error - NOT Connected to broker\r\n");
                 } else {
-                    LogMessage(LOG_DEBUG_LVL, "MQTT Connected to broker\r\n");
+                    LOG_DEBUG("MQTT Connected to broker\r\n");
                 }
             } else {
-                LogMessage(LOG_DEBUG_LVL, "Connect fail to server(%s)! retry it automatically.\r\n", main_mqtt_broker);
+                LOG_DEBUG("Connect fail to server(%s)! retry it automatically.\r\n", main_mqtt_broker);
                 mqtt_connect(module_inst, main_mqtt_broker); /* Retry that. */
             }
         } break;
@@ -753,19 +787,21 @@ static void mqtt_callback(struct mqtt_module *module_inst, int type, union mqtt_
                 mqtt_subscribe(module_inst, GAME_TOPIC_IN, 2, SubscribeHandlerGameTopic);
                 mqtt_subscribe(module_inst, LED_TOPIC, 2, SubscribeHandlerLedTopic);
                 mqtt_subscribe(module_inst, IMU_TOPIC, 2, SubscribeHandlerImuTopic);
+                mqtt_subscribe(module_inst, BENCH_TOPIC, 1, SubscribeHandlerBenchTopic);
                 /* Enable USART receiving callback. */
+                RunTimeStatsMarkBoot(BOOT_MARK_MQTT);
 
-                LogMessage(LOG_DEBUG_LVL, "MQTT Connected\r\n");
+                LOG_DEBUG("MQTT Connected\r\n");
             } else {
                 /* Cannot connect for some reason. */
-                LogMessage(LOG_DEBUG_LVL, "MQTT broker decline your access! error code %d\r\n", data->connected.result);
+                LOG_DEBUG("MQTT broker decline your access! error code %d\r\n", data->connected.result);
             }
 
             break;
 
         case MQTT_CALLBACK_DISCONNECTED:
             /* Stop timer and USART callback. */
-            LogMessage(LOG_DEBUG_LVL, "MQTT disconnected\r\n");
+            LOG_DEBUG("MQTT disconnected\r\n");
             // usart_disable_callback(&cdc_uart_module, USART_CALLBACK_BUFFER_RECEIVED);
             break;
     }
@@ -790,14 +826,14 @@ static void configure_mqtt(void)
 
     result = mqtt_init(&mqtt_inst, &mqtt_conf);
     if (result < 0) {
-        LogMessage(LOG_DEBUG_LVL, "MQTT initialization failed. Error code is (%d)\r\n", result);
+        LOG_DEBUG("MQTT initialization failed. Error code is (%d)\r\n", result);
         while (1) {
         }
     }
 
     result = mqtt_register_callback(&mqtt_inst, mqtt_callback);
     if (result < 0) {
-        LogMessage(LOG_DEBUG_LVL, "MQTT register callback failed. Error code is (%d)\r\n", result);
+        LOG_DEBUG("MQTT register callback failed. Error code is (%d)\r\n", result);
         while (1) {
         }
     }
@@ -843,7 +879,7 @@ void extint_detection_callback(void)
 static void HTTP_DownloadFileInit(void)
 {
     if (mqtt_disconnect(&mqtt_inst, main_mqtt_broker)) {
-        LogMessage(LOG_DEBUG_LVL, "Error connecting to MQTT Broker!\r\n");
+        LOG_DEBUG("Error connecting to MQTT Broker!\r\n");
     }
     while ((mqtt_inst.isConnected)) {
         m2m_wifi_handle_events(NULL);
@@ -889,7 +925,7 @@ static void HTTP_DownloadFileTransaction(void)
     FRESULT res = f_open(&file_object, (char const *)test_file_name, FA_CREATE_ALWAYS | FA_WRITE);
 
     if (res != FR_OK) {
-        LogMessage(LOG_INFO_LVL, "[FAIL] res %d\r\n", res);
+        LOG_ERROR("[FAIL] res %d\r\n", res);
     } else {
         SerialConsoleWriteString("FlagA.txt added!\r\n");
     }
@@ -914,12 +950,12 @@ static void MQTT_InitRoutine(void)
     /* Connect to router. */
     if (!(mqtt_inst.isConnected)) {
         if (mqtt_connect(&mqtt_inst, main_mqtt_broker)) {
-            LogMessage(LOG_DEBUG_LVL, "Error connecting to MQTT Broker!\r\n");
+            LOG_DEBUG("Error connecting to MQTT Broker!\r\n");
         }
     }
 
     if (mqtt_inst.isConnected) {
-        LogMessage(LOG_DEBUG_LVL, "Connected to MQTT Broker!\r\n");
+        LOG_DEBUG("Connected to MQTT Broker!\r\n");
     }
     wifiStateMachine = WIFI_MQTT_HANDLE;
 }
@@ -939,6 +975,7 @@ static void MQTT_HandleTransactions(void)
     // Check if data has to be sent!
     MQTT_HandleGameMessages();
     MQTT_HandleImuMessages();
+    MQTT_HandleStatsMessages();
 
     // Handle MQTT messages
     if (mqtt_inst.isConnected) mqtt_yield(&mqtt_inst, 100);
@@ -953,6 +990,52 @@ static void MQTT_HandleImuMessages(void)
     }
 }
 
+/**
+ static void MQTT_HandleStatsMessages(void)
+ * @brief	Publishes the task run time statistics (see RunTimeStats.h) every STATS_PUBLISH_PERIOD_MS
+ * @details	With I2C_STATS_PUBLISH, also publishes the statistics of each I2C device (see I2cStatsToJson), one message per device
+ * @note	The CPU shares cover the time since the previous sample, so they are per period unless "top" was run in between
+*/
+static void MQTT_HandleStatsMessages(void)
+{
+    static struct RunTimeStatsReport report;
+    static char statsMsg[STATS_MSG_SIZE];
+    static TickType_t lastPublish = 0;
+
+    if (!mqtt_inst.isConnected || (xTaskGetTickCount() - lastPublish) < pdMS_TO_TICKS(STATS_PUBLISH_PERIOD_MS)) return;
+    lastPublish = xTaskGetTickCount();
+
+    RunTimeStatsSample(&report);
+    int len = RunTimeStatsToJson(&report, statsMsg, sizeof(statsMsg));
+    if (len > 0) {
+        mqtt_publish(&mqtt_inst, STATS_TOPIC, statsMsg, len, 1, 0);
+    }
+
+#if I2C_STATS_PUBLISH
+    static I2C_DeviceStats i2cStats;
+    for (uint8_t i = 0; I2cGetDeviceStats(i, &i2cStats); i++) {
+        len = I2cStatsToJson(&i2cStats, statsMsg, sizeof(statsMsg));
+        if (len > 0) {
+            mqtt_publish(&mqtt_inst, I2C_STATS_TOPIC, statsMsg, len, 1, 0);
+        }
+    }
+#endif
+}
+
+/**
+ static void WifiHandleBenchRequests(void)
+ * @brief	Runs the benchmark queued by WifiRunBench, if any, and wakes the task that asked for it
+*/
+static void WifiHandleBenchRequests(void)
+{
+    struct BenchRequest *request;
+    if (pdPASS == xQueueReceive(xQueueBenchRequest, &request, 0)) {
+        BenchTargetRun(request);
+        benchInFlight = NULL;
+        xSemaphoreGive(xBenchDoneSemaphore);
+    }
+}
+
 static void MQTT_HandleGameMessages(void)
 {
     struct GameDataPacket gamePacket;
@@ -972,8 +1055,8 @@ static void MQTT_HandleGameMessages(void)
             }
         }
         strcat(mqtt_msg, "]}");
-        LogMessage(LOG_DEBUG_LVL, mqtt_msg);
-        LogMessage(LOG_DEBUG_LVL, "\r\n");
+        LOG_DEBUG(mqtt_msg);
+        LOG_DEBUG("\r\n");
         mqtt_publish(&mqtt_inst, GAME_TOPIC_OUT, mqtt_msg, strlen(mqtt_msg), 1, 0);
     }
 }
@@ -995,8 +1078,11 @@ void vWifiTask(void *pvParameters)
     xQueueImuBuffer = xQueueCreate(5, sizeof(struct ImuDataPacket));
     xQueueGameBuffer = xQueueCreate(2, sizeof(struct GameDataPacket));
     xQueueDistanceBuffer = xQueueCreate(5, sizeof(uint16_t));
+    xQueueBenchRequest = xQueueCreate(1, sizeof(struct BenchRequest *));
+    xBenchDoneSemaphore = xSemaphoreCreateBinary();
 
-    if (xQueueWifiState == NULL || xQueueImuBuffer == NULL || xQueueGameBuffer == NULL || xQueueDistanceBuffer == NULL) {
+    if (xQueueWifiState == NULL || xQueueImuBuffer == NULL || xQueueGameBuffer == NULL || xQueueDistanceBuffer == NULL || xQueueBenchRequest == NULL ||
+        xBenchDoneSemaphore == NULL) {
         SerialConsoleWriteString("ERROR Initializing Wifi Data queues!\r\n");
     }
 
@@ -1026,12 +1112,12 @@ void vWifiTask(void *pvParameters)
     param.pfAppWifiCb = wifi_cb;
     ret = m2m_wifi_init(&param);
     if (M2M_SUCCESS != ret) {
-        LogMessage(LOG_DEBUG_LVL, "main: m2m_wifi_init call error! (res %d)\r\n", ret);
+        LOG_DEBUG("main: m2m_wifi_init call error! (res %d)\r\n", ret);
         while (1) {
         }
     }
 
-    LogMessage(LOG_DEBUG_LVL, "main: connecting to WiFi AP %s...\r\n", (char *)MAIN_WLAN_SSID);
+    LOG_DEBUG("main: connecting to WiFi AP %s...\r\n", (char *)MAIN_WLAN_SSID);
 
     // Re-enable socket for MQTT Transfer
     socketInit();
@@ -1076,6 +1162,8 @@ void vWifiTask(void *pvParameters)
                 wifiStateMachine = WIFI_MQTT_INIT;
                 break;
         }
+        WifiHandleBenchRequests();
+
         // Check if a new state was called
         uint8_t DataToReceive = 0;
         if (pdPASS == xQueueReceive(xQueueWifiState, &DataToReceive, 0)) {
@@ -1085,7 +1173,7 @@ void vWifiTask(void *pvParameters)
         // Check if we need to publish something. In this example, we publish the "temperature" when the button was pressed.
         if (isPressed) {
             mqtt_publish(&mqtt_inst, TEMPERATURE_TOPIC, mqtt_msg_temp, strlen(mqtt_msg_temp), 1, 0);
-            LogMessage(LOG_DEBUG_LVL, "MQTT send %s\r\n", mqtt_msg_temp);
+            LOG_DEBUG("MQTT send %s\r\n", mqtt_msg_temp);
             isPressed = false;
         }
 
@@ -1145,3 +1233,65 @@ int WifiAddGameDataToQueue(struct GameDataPacket *game)
     int error = xQueueSend(xQueueGameBuffer, game, (TickType_t)10);
     return error;
 }
+
+/**
+ int32_t WifiRunBench(struct BenchRequest *request)
+ * @brief	Runs a benchmark in the Wi-Fi task, which owns the WINC driver, FatFs and the MQTT client, and waits for it
+ * @param[in,out] request Benchmark to run (see BenchTargetRun). Must stay valid until the Wi-Fi task is done with it
+ * @return	Returns the status of the benchmark, ERROR_BUSY if the Wi-Fi task still has a benchmark (queued, or left
+ *			running by a timed out call) or ERROR_TIMEOUT if the Wi-Fi task did not finish within BENCH_WIFI_TIMEOUT_MS
+ * @note	Waits on xBenchDoneSemaphore, not on the task notification of the caller. After ERROR_TIMEOUT the request
+ *			still belongs to the Wi-Fi task: do not reuse it before a later call stops returning ERROR_BUSY
+*/
+int32_t WifiRunBench(struct BenchRequest *request)
+{
+    if (xQueueBenchRequest == NULL || xBenchDoneSemaphore == NULL) return ERROR_NOT_INITIALIZED;
+    if (benchInFlight != NULL) return ERROR_BUSY;
+
+    xSemaphoreTake(xBenchDoneSemaphore, 0);  // Completion of a benchmark that timed out, if it came late
+    benchInFlight = request;
+    if (xQueueSend(xQueueBenchRequest, &request, 0) != pdPASS) {
+        benchInFlight = NULL;
+        return ERROR_BUSY;
+    }
+
+    if (xSemaphoreTake(xBenchDoneSemaphore, pdMS_TO_TICKS(BENCH_WIFI_TIMEOUT_MS)) != pdTRUE) return ERROR_TIMEOUT;
+    return request->status;
+}
+
+/**
+ bool WifiBenchIsBusy(void)
+ * @brief	Returns true while a benchmark handed over by WifiRunBench is queued or running in the Wi-Fi task
+*/
+bool WifiBenchIsBusy(void)
+{
+    return benchInFlight != NULL;
+}
+
+/**
+ int32_t WifiBenchMqttRoundTrip(uint8_t qos, uint32_t timeoutMs)
+ * @brief	Publishes a numbered message on BENCH_TOPIC and processes MQTT traffic until the broker sends it back
+ * @param[in] qos QoS of the publication. At QoS 1, mqtt_publish also waits for the PUBACK
+ * @param[in] timeoutMs Longest wait for the message
+ * @return	Returns ERROR_NONE when the message came back, ERROR_NOT_READY if MQTT is not connected, ERROR_IO if the
+ *			publication failed, ERROR_TIMEOUT if the message did not come back in time
+ * @note	Wi-Fi task only. Yields 1 ms at a time, so the round trip is measured to about 1 ms
+*/
+int32_t WifiBenchMqttRoundTrip(uint8_t qos, uint32_t timeoutMs)
+{
+    char msg[12];
+    if (!mqtt_inst.isConnected) return ERROR_NOT_READY;
+
+    benchEchoSequence++;
+    benchEchoReceived = false;
+    int len = snprintf(msg, sizeof(msg), "%lu", (unsigned long)benchEchoSequence);
+
+    TickType_t start = xTaskGetTickCount();
+    if (mqtt_publish(&mqtt_inst, BENCH_TOPIC, msg, len, qos, 0) != 0) return ERROR_IO;
+
+    while (!benchEchoReceived) {
+        if ((xTaskGetTickCount() - start) >= pdMS_TO_TICKS(timeoutMs)) return ERROR_TIMEOUT;
+        mqtt_yield(&mqtt_inst, 1);
+    }
+    return ERROR_NONE;
+}
@@ -93,6 +93,9 @@ struct RgbColorPacket {
 
 /* Max size of MQTT buffer. */
 #define MAIN_MQTT_BUFFER_SIZE 512
+#define STATS_PUBLISH_PERIOD_MS 10000  ///< Period of the task statistics publication on STATS_TOPIC
+#define STATS_MSG_SIZE 256             ///< Largest statistics message. Must leave room for the MQTT header in MAIN_MQTT_BUFFER_SIZE
+#define I2C_STATS_PUBLISH 1            ///< 1: also publish the statistics of each I2C device (see I2cDriver.h) on I2C_STATS_TOPIC. 0: do not
 
 /* Limitation of user name. */
 #define MAIN_CHAT_USER_NAME_SIZE 64
@@ -107,6 +110,9 @@ struct RgbColorPacket {
 #define IMU_TOPIC "P1_IMU_ESE516_T0"                  // Students to change to an unique identifier for each device! IMU Data
 #define DISTANCE_TOPIC "P1_DISTANCE_ESE516_T0"        // Students to change to an unique identifier for each device! Distance Data
 #define TEMPERATURE_TOPIC "P1_TEMPERATURE_ESE516_T0"  // Students to change to an unique identifier for each device! Distance Data
+#define STATS_TOPIC "P1_STATS_ESE516_T0"              // Students to change to an unique identifier for each device! Task run time statistics
+#define BENCH_TOPIC "P1_BENCH_ESE516_T0"              // Students to change to an unique identifier for each device! Benchmark echo (see BenchTarget.h)
+#define I2C_STATS_TOPIC "P1_I2CSTATS_ESE516_T0"       // Students to change to an unique identifier for each device! I2C statistics, one message per device
 
 #else
 /* Chat MQTT topic. */
@@ -116,6 +122,9 @@ struct RgbColorPacket {
 #define IMU_TOPIC "P2_IMU_ESE516_T0"                  // Students to change to an unique identifier for each device! IMU Data
 #define DISTANCE_TOPIC "P2_DISTANCE_ESE516_T0"        // Students to change to an unique identifier for each device! Distance Data
 #define TEMPERATURE_TOPIC "P2_TEMPERATURE_ESE516_T0"  // Students to change to an unique identifier for each device! Distance Data
+#define STATS_TOPIC "P2_STATS_ESE516_T0"              // Students to change to an unique identifier for each device! Task run time statistics
+#define BENCH_TOPIC "P2_BENCH_ESE516_T0"              // Students to change to an unique identifier for each device! Benchmark echo (see BenchTarget.h)
+#define I2C_STATS_TOPIC "P2_I2CSTATS_ESE516_T0"       // Students to change to an unique identifier for each device! I2C statistics, one message per device
 
 #endif
 
@@ -162,6 +171,11 @@ void SubscribeHandlerImuTopic(MessageData *msgData);
 void SubscribeHandlerDistanceTopic(MessageData *msgData);
 void configure_extint_channel(void);
 void configure_extint_callbacks(void);
+void SubscribeHandlerBenchTopic(MessageData *msgData);
+struct BenchRequest;
+int32_t WifiRunBench(struct BenchRequest *request);
+bool WifiBenchIsBusy(void);
+int32_t WifiBenchMqttRoundTrip(uint8_t qos, uint32_t timeoutMs);
 
 #ifdef __cplusplus
 }
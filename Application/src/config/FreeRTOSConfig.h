@@ -42,6 +42,8 @@
 #include <gclk.h>
 #include <stdint.h>
 void assert_triggered(const char *file, uint32_t line);
+void RunTimeStatsTimerInit(void);
+uint32_t RunTimeStatsGetCounter(void);
 #endif
 
 #define configUSE_PREEMPTION 1
@@ -53,7 +55,8 @@ void assert_triggered(const char *file, uint32_t line);
 #define configMAX_PRIORITIES (5)
 #define configMINIMAL_STACK_SIZE ((unsigned short)100)
 /* configTOTAL_HEAP_SIZE is not used when heap_3.c is used. */
-#define configTOTAL_HEAP_SIZE ((size_t)(12000))
+/* heap_1: all the tasks, queues and timers, never freed. About 14.9 KB once every task runs (free bytes in "top") */
+#define configTOTAL_HEAP_SIZE ((size_t)(16384))
 #define configMAX_TASK_NAME_LEN (8)
 #define configUSE_TRACE_FACILITY 1
 #define configUSE_16_BIT_TICKS 0
@@ -65,7 +68,10 @@ void assert_triggered(const char *file, uint32_t line);
 #define configUSE_MALLOC_FAILED_HOOK 1
 #define configUSE_COUNTING_SEMAPHORES 1
 #define configUSE_QUEUE_SETS 1
-#define configGENERATE_RUN_TIME_STATS 0
+#define configGENERATE_RUN_TIME_STATS 1
+/* Run time stats clock: free-running 32-bit TC at 1 MHz, see RunTimeStats.h */
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() RunTimeStatsTimerInit()
+#define portGET_RUN_TIME_COUNTER_VALUE() RunTimeStatsGetCounter()
 #define configENABLE_BACKWARD_COMPATIBILITY 1
 #define configUSE_DAEMON_TASK_STARTUP_HOOK 1  // Ported from FreeRToS 9.0.0
 
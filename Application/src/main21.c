@@ -20,6 +20,7 @@
 #include "DistanceDriver\DistanceSensor.h"
 #include "FreeRTOS.h"
 #include "IMU\lsm6dso_reg.h"
+#include "RunTimeStats/RunTimeStats.h"
 #include "SeesawDriver/Seesaw.h"
 #include "SerialConsole.h"
 #include "UiHandlerThread\UiHandlerThread.h"
@@ -51,10 +52,10 @@ void vApplicationTickHook(void);
  * Variables
  ******************************************************************************/
 static TaskHandle_t cliTaskHandle = NULL;      //!< CLI task handle
-static TaskHandle_t daemonTaskHandle = NULL;   //!< Daemon task handle
 static TaskHandle_t wifiTaskHandle = NULL;     //!< Wifi task handle
 static TaskHandle_t uiTaskHandle = NULL;       //!< UI task handle
 static TaskHandle_t controlTaskHandle = NULL;  //!< Control task handle
+static TaskHandle_t loggerTaskHandle = NULL;   //!< Logger task handle
 
 char bufferPrint[64];  ///< Buffer for daemon task
 
@@ -98,12 +99,14 @@ void vApplicationDaemonTaskStartupHook(void)
     } else {
         SerialConsoleWriteString("Initialized I2C Driver!\r\n");
     }
+    RunTimeStatsMarkBoot(BOOT_MARK_I2C);
 
     if (0 != InitializeSeesaw()) {
         SerialConsoleWriteString("Error initializing Seesaw!\r\n");
     } else {
         SerialConsoleWriteString("Initialized Seesaw!\r\n");
     }
+    RunTimeStatsMarkBoot(BOOT_MARK_SEESAW);
 
     uint8_t whoamI = 0;
     (lsm6dso_device_id_get(GetImuStruct(), &whoamI));
@@ -118,14 +121,17 @@ void vApplicationDaemonTaskStartupHook(void)
             SerialConsoleWriteString("Could not initialize IMU\r\n");
         }
     }
+    RunTimeStatsMarkBoot(BOOT_MARK_IMU);
 
     SerialConsoleWriteString("Initializing distance sensor\r\n");
     InitializeDistanceSensor();
     SerialConsoleWriteString("Distance sensor initialized\r\n");
+    RunTimeStatsMarkBoot(BOOT_MARK_DISTANCE);
 
     StartTasks();
+    RunTimeStatsMarkBoot(BOOT_MARK_TASKS);
 
-    vTaskSuspend(daemonTaskHandle);
+    // Return, do not suspend: this hook runs in the timer task, which must keep serving the software timers (LedSequence)
 }
 
 /**
@@ -142,6 +148,10 @@ static void StartTasks(void)
 
     // Initialize Tasks here
 
+    if (xTaskCreate(vLoggerTask, "LOGGER_TASK", LOGGER_TASK_SIZE, NULL, LOGGER_TASK_PRIORITY, &loggerTaskHandle) != pdPASS) {
+        SerialConsoleWriteString("ERR: Logger task could not be initialized!\r\n");
+    }
+
     if (xTaskCreate(vCommandConsoleTask, "CLI_TASK", CLI_TASK_SIZE, NULL, CLI_PRIORITY, &cliTaskHandle) != pdPASS) {
         SerialConsoleWriteString("ERR: CLI task could not be initialized!\r\n");
     }
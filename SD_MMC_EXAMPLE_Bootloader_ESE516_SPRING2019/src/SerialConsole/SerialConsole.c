@@ -29,17 +29,19 @@
 /******************************************************************************
 * Defines
 ******************************************************************************/
-#define RX_BUFFER_SIZE 1024	///<Size of character buffer for RX, in bytes
-#define TX_BUFFER_SIZE 1024	///<Size of character buffers for TX, in bytes
+#define RX_BUFFER_SIZE 1024	///<Size of character buffer for RX, in bytes. Must be a power of two
+#define TX_BUFFER_SIZE 1024	///<Size of character buffers for TX, in bytes. Must be a power of two
 
 /******************************************************************************
 * Structures and Enumerations
 ******************************************************************************/
-cbuf_handle_t cbufRx;	///<Circular buffer handler for receiving characters from the Serial Interface
-cbuf_handle_t cbufTx;	///<Circular buffer handler for transmitting characters from the Serial Interface
+static circular_buf_t cbufRxStorage;	///<Circular buffer control structure for RX
+static circular_buf_t cbufTxStorage;	///<Circular buffer control structure for TX
+cbuf_handle_t cbufRx = &cbufRxStorage;	///<Circular buffer handler for receiving characters from the Serial Interface
+cbuf_handle_t cbufTx = &cbufTxStorage;	///<Circular buffer handler for transmitting characters from the Serial Interface
 
 char latestRx;	///< Holds the latest character that was received
-char latestTx;	///< Holds the latest character to be transmitted.
+static volatile size_t txLength = 0;	///< Number of bytes of cbufTx being sent by the current USART job. Zero when TX is idle
 
 /******************************************************************************
 *  Callback Declaration
@@ -52,6 +54,7 @@ void usart_read_callback(struct usart_module *const usart_module);	//Callback fo
 ******************************************************************************/
 static void configure_usart(void);
 static void configure_usart_callbacks(void);
+static void SerialConsoleStartTx(void);
 
 /******************************************************************************
 * Global Local Variables
@@ -80,8 +83,8 @@ void InitializeSerialConsole()
 {
 
 	//Initialize circular buffers for RX and TX
-	cbufRx = circular_buf_init((uint8_t*)rxCharacterBuffer, RX_BUFFER_SIZE);
-	cbufTx = circular_buf_init((uint8_t*)txCharacterBuffer, RX_BUFFER_SIZE);
+	circular_buf_init(cbufRx, (uint8_t*)rxCharacterBuffer, RX_BUFFER_SIZE);
+	circular_buf_init(cbufTx, (uint8_t*)txCharacterBuffer, TX_BUFFER_SIZE);
 
 	//Configure USART and Callbacks
 	configure_usart();
@@ -101,23 +104,21 @@ void DeinitializeSerialConsole()
 /**************************************************************************//**
 * @fn			void SerialConsoleWriteString(char * string)
 * @brief		Writes a string to be written to the uart. Copies the string to a ring buffer that is used to hold the text send to the uart
-* @details		Uses the ringbuffer 'cbufTx', which in turn uses the array 'txCharacterBuffer'
+* @details		Uses the ringbuffer 'cbufTx', which in turn uses the array 'txCharacterBuffer'. Characters that do not fit are dropped.
 * @note			Use to send a string of characters to the user via UART
 *****************************************************************************/
 void SerialConsoleWriteString(const char * string)
 {
 	if(string != NULL)
 	{
-		for (size_t iter = 0; iter < strlen(string); iter++)
-		{
-			circular_buf_put(cbufTx, string[iter]);
-		}
-		
-		if(usart_get_job_status(&usart_instance, USART_TRANSCEIVER_TX) == STATUS_OK)
+		system_interrupt_enter_critical_section(); //The RX callback also writes to cbufTx (echo), so producers must be serialized
+		circular_buf_put_n(cbufTx, (const uint8_t*) string, strlen(string));
+
+		if(txLength == 0)
 		{
-			circular_buf_get(cbufTx, (uint8_t*) &latestTx); //Perform only if the SERCOM TX is free (not busy)
-			usart_write_buffer_job(&usart_instance, (uint8_t*) &latestTx, 1);
+			SerialConsoleStartTx(); //Perform only if the SERCOM TX is free (not busy)
 		}
+		system_interrupt_leave_critical_section();
 	}
 }
 
@@ -240,6 +241,24 @@ static void configure_usart_callbacks(void)
 
 
 
+/**************************************************************************//**
+* @fn			static void SerialConsoleStartTx(void)
+* @brief		Orders the USART to send the largest contiguous span of cbufTx
+* @note			The span stays in cbufTx until usart_write_callback discards it
+*****************************************************************************/
+static void SerialConsoleStartTx(void)
+{
+	uint8_t *span = NULL;
+	txLength = circular_buf_peek_contiguous(cbufTx, &span);
+
+	if(txLength != 0)
+	{
+		usart_write_buffer_job(&usart_instance, span, txLength);
+	}
+}
+
+
+
 /******************************************************************************
 * Callback Functions
 ******************************************************************************/
@@ -273,9 +292,7 @@ void usart_read_callback(struct usart_module *const usart_module)
 *****************************************************************************/
 void usart_write_callback(struct usart_module *const usart_module)
 {
-	if(circular_buf_get(cbufTx, (uint8_t*) &latestTx) != -1) //Only continue if there are more characters to send
-	{
-		usart_write_buffer_job(&usart_instance, (uint8_t*) &latestTx, 1);
-	}
+	circular_buf_skip(cbufTx, txLength);
+	SerialConsoleStartTx(); //Only continues if there are more characters to send
 	
 }
@@ -1,85 +1,53 @@
-
 /**************************************************************************//**
 * @file        circular_buffer library
 * @ingroup 	   Serial Console
-* @brief       This library for a circular buffer is taken from https://github.com/embeddedartistry/embedded-resources/blob/master/examples/c/circular_buffer/circular_buffer.c
-*				Author: Phillips Johnston
-* @details     Please refer to the github code above and to "https://embeddedartistry.com/blog/2017/4/6/circular-buffers-in-cc" for more information
+* @brief       Single-producer/single-consumer byte ring buffer. API follows the embeddedartistry circular buffer
+*				(https://github.com/embeddedartistry/embedded-resources/blob/master/examples/c/circular_buffer/circular_buffer.c)
+* @details     See circular_buffer.h for the producer/consumer rules.
 *
-*				See "https://github.com/embeddedartistry/embedded-resources/blob/master/examples/c/circular_buffer_test.c" for examples on how to use the buffer
+*				The producer fills the storage first and publishes the new head afterwards, and the consumer reads
+*				the storage first and publishes the new tail afterwards. The barrier between both steps keeps the
+*				compiler (and the core) from reordering them, which is all the synchronization the two sides need.
 *
 * @copyright
 * @author		Phillips Johnston
 * @date        Aug 6, 2018
-* @version		0.1
+* @version		0.2
 *****************************************************************************/
 
 
- #include <stdlib.h>
  #include <stdint.h>
  #include <stddef.h>
  #include <stdbool.h>
+ #include <string.h>
  #include <assert.h>
 
  #include "circular_buffer.h"
 
+ #define CBUF_MEMORY_BARRIER() __atomic_thread_fence(__ATOMIC_ACQ_REL)	///< Orders storage accesses against head/tail publication. A DMB on the M0+, no instruction on x86
 
- // The definition of our circular buffer structure is hidden from the user
- struct circular_buf_t {
-	 uint8_t * buffer;
-	 size_t head;
-	 size_t tail;
-	 size_t max; //of the buffer
-	 bool full;
- };
-
- #pragma mark - Private Functions -
+ // Private Functions
 
- static void advance_pointer(cbuf_handle_t cbuf)
+ static inline size_t cbuf_used(cbuf_handle_t cbuf)
  {
-	 //assert(cbuf);
-
-	 if(cbuf->full)
-	 {
-		 cbuf->tail = (cbuf->tail + 1) % cbuf->max;
-	 }
-
-	 cbuf->head = (cbuf->head + 1) % cbuf->max;
-
-	 // We mark full because we will advance tail on the next time around
-	 cbuf->full = (cbuf->head == cbuf->tail);
+	 // Free-running counters: the difference is correct even after they wrap around
+	 return cbuf->head - cbuf->tail;
  }
 
- static void retreat_pointer(cbuf_handle_t cbuf)
+ static inline size_t cbuf_min(size_t a, size_t b)
  {
-	 //assert(cbuf);
-
-	 cbuf->full = false;
-	 cbuf->tail = (cbuf->tail + 1) % cbuf->max;
+	 return (a < b) ? a : b;
  }
 
- #pragma mark - APIs -
+ // APIs
 
- cbuf_handle_t circular_buf_init(uint8_t* buffer, size_t size)
+ void circular_buf_init(cbuf_handle_t cbuf, uint8_t* buffer, size_t size)
  {
-	// assert(buffer && size);
-
-	 cbuf_handle_t cbuf = malloc(sizeof(circular_buf_t));
-	 //assert(cbuf);
+	// assert(cbuf && buffer && size && ((size & (size - 1)) == 0));
 
 	 cbuf->buffer = buffer;
-	 cbuf->max = size;
+	 cbuf->mask = size - 1;
 	 circular_buf_reset(cbuf);
-
-	// assert(circular_buf_empty(cbuf));
-
-	 return cbuf;
- }
-
- void circular_buf_free(cbuf_handle_t cbuf)
- {
-	// assert(cbuf);
-	 free(cbuf);
  }
 
  void circular_buf_reset(cbuf_handle_t cbuf)
@@ -88,73 +56,73 @@
 
 	 cbuf->head = 0;
 	 cbuf->tail = 0;
-	 cbuf->full = false;
  }
 
  size_t circular_buf_size(cbuf_handle_t cbuf)
  {
 	// assert(cbuf);
 
-	 size_t size = cbuf->max;
-
-	 if(!cbuf->full)
-	 {
-		 if(cbuf->head >= cbuf->tail)
-		 {
-			 size = (cbuf->head - cbuf->tail);
-		 }
-		 else
-		 {
-			 size = (cbuf->max + cbuf->head - cbuf->tail);
-		 }
-
-	 }
-
-	 return size;
+	 return cbuf_used(cbuf);
  }
 
  size_t circular_buf_capacity(cbuf_handle_t cbuf)
  {
 	 //assert(cbuf);
 
-	 return cbuf->max;
- }
-
- void circular_buf_put(cbuf_handle_t cbuf, uint8_t data)
- {
-	 //assert(cbuf && cbuf->buffer);
-
-	 cbuf->buffer[cbuf->head] = data;
-
-	 advance_pointer(cbuf);
+	 return cbuf->mask + 1;
  }
 
- int circular_buf_put2(cbuf_handle_t cbuf, uint8_t data)
+ int circular_buf_put(cbuf_handle_t cbuf, uint8_t data)
  {
 	 int r = -1;
 
 	 //assert(cbuf && cbuf->buffer);
 
-	 if(!circular_buf_full(cbuf))
+	 size_t head = cbuf->head;
+	 if((head - cbuf->tail) <= cbuf->mask)
 	 {
-		 cbuf->buffer[cbuf->head] = data;
-		 advance_pointer(cbuf);
+		 cbuf->buffer[head & cbuf->mask] = data;
+		 CBUF_MEMORY_BARRIER();
+		 cbuf->head = head + 1;
 		 r = 0;
 	 }
 
 	 return r;
  }
 
+ size_t circular_buf_put_n(cbuf_handle_t cbuf, const uint8_t * data, size_t len)
+ {
+	 //assert(cbuf && cbuf->buffer && data);
+
+	 size_t head = cbuf->head;
+	 size_t space = (cbuf->mask + 1) - (head - cbuf->tail);
+	 len = cbuf_min(len, space);
+
+	 // Copy in at most two pieces: up to the end of the storage, then from its start
+	 size_t index = head & cbuf->mask;
+	 size_t first = cbuf_min(len, (cbuf->mask + 1) - index);
+	 memcpy(&cbuf->buffer[index], data, first);
+	 memcpy(&cbuf->buffer[0], data + first, len - first);
+
+	 CBUF_MEMORY_BARRIER();
+	 cbuf->head = head + len;
+
+	 return len;
+ }
+
  int circular_buf_get(cbuf_handle_t cbuf, uint8_t * data)
  {
 	 //assert(cbuf && data && cbuf->buffer);
-	 
+
 	 int r = -1;
 
-	 if(!circular_buf_empty(cbuf))
+	 size_t tail = cbuf->tail;
+	 if(cbuf->head != tail)
 	 {
-		 *data = cbuf->buffer[cbuf->tail];
-		 retreat_pointer(cbuf);
+		 CBUF_MEMORY_BARRIER();
+		 *data = cbuf->buffer[tail & cbuf->mask];
+		 CBUF_MEMORY_BARRIER();
+		 cbuf->tail = tail + 1;
 
 		 r = 0;
 	 }
@@ -162,16 +130,58 @@
 	 return r;
  }
 
+ size_t circular_buf_get_n(cbuf_handle_t cbuf, uint8_t * data, size_t len)
+ {
+	 //assert(cbuf && data && cbuf->buffer);
+
+	 size_t tail = cbuf->tail;
+	 len = cbuf_min(len, cbuf->head - tail);
+	 CBUF_MEMORY_BARRIER();
+
+	 size_t index = tail & cbuf->mask;
+	 size_t first = cbuf_min(len, (cbuf->mask + 1) - index);
+	 memcpy(data, &cbuf->buffer[index], first);
+	 memcpy(data + first, &cbuf->buffer[0], len - first);
+
+	 CBUF_MEMORY_BARRIER();
+	 cbuf->tail = tail + len;
+
+	 return len;
+ }
+
+ size_t circular_buf_peek_contiguous(cbuf_handle_t cbuf, uint8_t ** data)
+ {
+	 //assert(cbuf && data && cbuf->buffer);
+
+	 size_t tail = cbuf->tail;
+	 size_t index = tail & cbuf->mask;
+
+	 // Either up to the head, or up to the end of the storage if the data wraps around
+	 size_t len = cbuf_min(cbuf->head - tail, (cbuf->mask + 1) - index);
+	 CBUF_MEMORY_BARRIER();
+
+	 *data = &cbuf->buffer[index];
+	 return len;
+ }
+
+ void circular_buf_skip(cbuf_handle_t cbuf, size_t len)
+ {
+	 //assert(cbuf && len <= circular_buf_size(cbuf));
+
+	 CBUF_MEMORY_BARRIER();
+	 cbuf->tail += len;
+ }
+
  bool circular_buf_empty(cbuf_handle_t cbuf)
  {
 	 //assert(cbuf);
 
-	 return (!cbuf->full && (cbuf->head == cbuf->tail));
+	 return (cbuf->head == cbuf->tail);
  }
 
  bool circular_buf_full(cbuf_handle_t cbuf)
  {
 	// assert(cbuf);
 
-	 return cbuf->full;
- }
\ No newline at end of file
+	 return (cbuf_used(cbuf) > cbuf->mask);
+ }
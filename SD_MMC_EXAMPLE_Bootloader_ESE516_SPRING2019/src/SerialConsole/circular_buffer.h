@@ -1,57 +1,79 @@
 /**************************************************************************//**
 * @file        circular_buffer library
 * @ingroup 	   Serial Console
-* @brief       This library for a circular buffer is taken from https://github.com/embeddedartistry/embedded-resources/blob/master/examples/c/circular_buffer/circular_buffer.c
-*				Author: Phillips Johnston
-* @details     Please refer to the github code above and to "https://embeddedartistry.com/blog/2017/4/6/circular-buffers-in-cc" for more information
-*
+* @brief       Single-producer/single-consumer byte ring buffer. API follows the embeddedartistry circular buffer
+*				(https://github.com/embeddedartistry/embedded-resources/blob/master/examples/c/circular_buffer/circular_buffer.c)
+*				so that the Serial Console code did not need to change shape.
+* @details     The storage size must be a power of two, so the indexes are advanced with a mask instead of a modulo.
+*				Head and tail are free-running counters: the producer is the only one writing head and the consumer
+*				is the only one writing tail, so one side can live in an ISR and the other in a task without
+*				suspending the scheduler or disabling interrupts. Several producers (or several consumers) still
+*				need to be serialized by the caller.
 *
+*				The control structure is owned by the caller (usually a static variable), nothing is allocated.
 *
 * @copyright
 * @author		Phillips Johnston
 * @date        Aug 6, 2018
-* @version		0.1
+* @version		0.2
 *****************************************************************************/
 
 
 #ifndef CIRCULAR_BUFFER_H_
 #define CIRCULAR_BUFFER_H_
 
-/// Opaque circular buffer structure
-typedef struct circular_buf_t circular_buf_t;
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/// Circular buffer structure. Declare one per buffer (e.g. static) and pass its address to circular_buf_init
+typedef struct circular_buf_t {
+	uint8_t * buffer;		///< Storage for the data, owned by the caller
+	size_t mask;			///< Size of the storage minus one. Size is a power of two
+	volatile size_t head;	///< Free-running write counter. Only written by the producer
+	volatile size_t tail;	///< Free-running read counter. Only written by the consumer
+} circular_buf_t;
 
 /// Handle type, the way users interact with the API
 typedef circular_buf_t* cbuf_handle_t;
 
-/// Pass in a storage buffer and size, returns a circular buffer handle
-/// Requires: buffer is not NULL, size > 0
-/// Ensures: cbuf has been created and is returned in an empty state
-cbuf_handle_t circular_buf_init(uint8_t* buffer, size_t size);
-
-/// Free a circular buffer structure
-/// Requires: cbuf is valid and created by circular_buf_init
-/// Does not free data buffer; owner is responsible for that
-void circular_buf_free(cbuf_handle_t cbuf);
+/// Attach a storage buffer to a circular buffer structure and leave it empty
+/// Requires: cbuf and buffer are not NULL, size is a power of two
+void circular_buf_init(cbuf_handle_t cbuf, uint8_t* buffer, size_t size);
 
 /// Reset the circular buffer to empty, head == tail. Data not cleared
-/// Requires: cbuf is valid and created by circular_buf_init
+/// Requires: cbuf is valid and no producer or consumer is using it
 void circular_buf_reset(cbuf_handle_t cbuf);
 
-/// Put version 1 continues to add data if the buffer is full
-/// Old data is overwritten
-/// Requires: cbuf is valid and created by circular_buf_init
-void circular_buf_put(cbuf_handle_t cbuf, uint8_t data);
-
-/// Put Version 2 rejects new data if the buffer is full
-/// Requires: cbuf is valid and created by circular_buf_init
+/// Add a value to the buffer. New data is rejected if the buffer is full
+/// Requires: cbuf is valid and created by circular_buf_init. Producer side only
 /// Returns 0 on success, -1 if buffer is full
-int circular_buf_put2(cbuf_handle_t cbuf, uint8_t data);
+int circular_buf_put(cbuf_handle_t cbuf, uint8_t data);
+
+/// Add up to len values to the buffer. Values that do not fit are rejected
+/// Requires: cbuf is valid and created by circular_buf_init. Producer side only
+/// Returns the number of values added
+size_t circular_buf_put_n(cbuf_handle_t cbuf, const uint8_t * data, size_t len);
 
 /// Retrieve a value from the buffer
-/// Requires: cbuf is valid and created by circular_buf_init
+/// Requires: cbuf is valid and created by circular_buf_init. Consumer side only
 /// Returns 0 on success, -1 if the buffer is empty
 int circular_buf_get(cbuf_handle_t cbuf, uint8_t * data);
 
+/// Retrieve up to len values from the buffer
+/// Requires: cbuf is valid and created by circular_buf_init. Consumer side only
+/// Returns the number of values retrieved
+size_t circular_buf_get_n(cbuf_handle_t cbuf, uint8_t * data, size_t len);
+
+/// Look at the oldest data without removing it
+/// Requires: cbuf is valid and created by circular_buf_init. Consumer side only
+/// Returns the number of elements that can be read starting at *data without wrapping around (0 if empty)
+size_t circular_buf_peek_contiguous(cbuf_handle_t cbuf, uint8_t ** data);
+
+/// Discard the oldest elements, usually after they were consumed through circular_buf_peek_contiguous
+/// Requires: cbuf is valid and created by circular_buf_init, len <= circular_buf_size(cbuf). Consumer side only
+void circular_buf_skip(cbuf_handle_t cbuf, size_t len);
+
 /// CHecks if the buffer is empty
 /// Requires: cbuf is valid and created by circular_buf_init
 /// Returns true if the buffer is empty
@@ -72,7 +94,4 @@ size_t circular_buf_capacity(cbuf_handle_t cbuf);
 /// Returns the current number of elements in the buffer
 size_t circular_buf_size(cbuf_handle_t cbuf);
 
-//TODO: int circular_buf_get_range(circular_buf_t cbuf, uint8_t *data, size_t len);
-//TODO: int circular_buf_put_range(circular_buf_t cbuf, uint8_t * data, size_t len);
-
-#endif //CIRCULAR_BUFFER_H_
\ No newline at end of file
+#endif //CIRCULAR_BUFFER_H_
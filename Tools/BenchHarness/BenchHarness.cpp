@@ -0,0 +1,253 @@
+/**
+ * @file        BenchHarness.cpp
+ * @brief       Host side of the on-target benchmarks (see Application/src/Bench/BenchCore.h).
+ * @details     Two modes:
+ *				--Device: sends "bench <name> <count>" commands on the console, collects the BENCH result lines and appends
+ *				  them to a CSV file, one row per result, so runs of different firmware builds can be compared.
+ *				--Simulation (--sim): runs the firmware benchmark core (BenchCore.c) on the PC against simulated I2C, SPI,
+ *				  SD and MQTT backends driven by a virtual microsecond clock. Checks the core and the result format
+ *				  without a board. The numbers only reflect the models below.
+ *
+ *				Build:	g++ -std=c++17 -O2 -I../../Application/src/Bench -o BenchHarness BenchHarness.cpp ../../Application/src/Bench/BenchCore.c
+ *				Use:	BenchHarness [-b baud] [-c count] [-o results.csv] <device> [i2c|spi|sd|mqtt|all]...
+ *						BenchHarness --sim [count]
+ *
+ * @copyright
+ * @author
+ * @date        October 16, 2026
+ * @version		0.1
+ */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "BenchCore.h"
+
+namespace {
+
+constexpr const char *kCsvHeader = "build,name,unit,samples,errors,min,median,p99,max,bytes_per_s";
+
+/******************************************************************************
+ * Simulated backends
+ ******************************************************************************/
+
+uint32_t simNowUs = 0;   ///< Virtual clock, advanced by the simulated operations
+uint32_t simRandom = 1;  ///< LCG state. Fixed seed, so runs are repeatable
+
+uint32_t SimClock() { return simNowUs; }
+
+uint32_t SimJitter(uint32_t range)
+{
+    simRandom = simRandom * 1103515245u + 12345u;
+    return (simRandom >> 16) % (range + 1);
+}
+
+/// Write-then-read of one register at 100 kHz: address + 2 bytes out, address + 1 byte in, plus driver overhead.
+/// One transaction in 50 is delayed by a tick of a higher priority task
+int32_t SimI2c(void *)
+{
+    simNowUs += 5 * 9 * 10 + 60 + SimJitter(40);
+    if (SimJitter(49) == 0) simNowUs += 1000;
+    return 0;
+}
+
+/// WINC register read: about 12 bytes on an 8 MHz SPI, with the per-byte polling of spi_rw
+int32_t SimSpi(void *)
+{
+    simNowUs += 12 * 1 + 12 * 2 + 8 + SimJitter(4);
+    return 0;
+}
+
+/// 512-byte sector write on a 4 MHz SPI SD card, with an erase stall every 32 sectors
+int32_t SimSdWrite(void *)
+{
+    static uint32_t sector = 0;
+    simNowUs += 512 * 2 + 300 + SimJitter(100);
+    if (++sector % 32 == 0) simNowUs += 15000;
+    return 0;
+}
+
+int32_t SimSdRead(void *)
+{
+    simNowUs += 512 * 2 + 150 + SimJitter(60);
+    return 0;
+}
+
+/// Broker round trip of 45-65 ms. QoS 1 also waits for the PUBACK. One message in 100 is lost (timeout)
+int32_t SimMqtt(void *context)
+{
+    const uint8_t qos = *static_cast<const uint8_t *>(context);
+    if (SimJitter(99) == 0) {
+        simNowUs += 2000000;
+        return -8;
+    }
+    simNowUs += 45000 + SimJitter(20000) + (qos == 1 ? 45000 + SimJitter(10000) : 0);
+    return 0;
+}
+
+int Simulate(uint32_t count)
+{
+    static uint32_t samples[BENCH_MAX_SAMPLES];
+    static const uint8_t qos0 = 0, qos1 = 1;
+    struct Bench {
+        const char *name;
+        BenchOperation operation;
+        void *context;
+        uint32_t bytes;
+    } benches[] = {
+        {"i2c_wr", SimI2c, nullptr, 0},
+        {"winc_spi_reg", SimSpi, nullptr, 4},
+        {"sd_write", SimSdWrite, nullptr, 512},
+        {"sd_read", SimSdRead, nullptr, 512},
+        {"mqtt_rtt_qos0", SimMqtt, const_cast<uint8_t *>(&qos0), 0},
+        {"mqtt_rtt_qos1", SimMqtt, const_cast<uint8_t *>(&qos1), 0},
+    };
+
+    for (const Bench &bench : benches) {
+        BenchResult result = {};
+        result.name = bench.name;
+        result.unit = "us";
+        result.bytesPerOperation = bench.bytes;
+        BenchRun(bench.operation, bench.context, SimClock, count, samples, &result);
+
+        char line[160];
+        BenchFormatResult(&result, "sim", line, sizeof(line));
+        fputs(line, stdout);
+    }
+    return 0;
+}
+
+/******************************************************************************
+ * Device
+ ******************************************************************************/
+
+speed_t BaudToSpeed(long baud)
+{
+    switch (baud) {
+        case 9600: return B9600;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        case 921600: return B921600;
+        case 1000000: return B1000000;
+        case 2000000: return B2000000;
+        default: return B0;
+    }
+}
+
+/// Result lines produced by each benchmark (see BenchTargetRun)
+int ExpectedResults(const std::string &bench)
+{
+    if (bench == "sd" || bench == "mqtt") return 2;
+    if (bench == "all") return 6;
+    return 1;
+}
+
+/// Reads console lines until the expected result lines, a failure message or a silence of timeoutMs
+std::vector<std::string> RunOnDevice(int fd, const std::string &bench, uint32_t count, int timeoutMs)
+{
+    std::vector<std::string> results;
+    const std::string command = "bench " + bench + " " + std::to_string(count) + "\r";
+    if (write(fd, command.data(), command.size()) != ssize_t(command.size())) return results;
+
+    std::string line;
+    int expected = ExpectedResults(bench);
+    pollfd pfd = {fd, POLLIN, 0};
+    while (int(results.size()) < expected && poll(&pfd, 1, timeoutMs) > 0) {
+        char c;
+        if (read(fd, &c, 1) != 1) break;
+        if (c != '\n' && c != '\r') {
+            line += c;
+            continue;
+        }
+        if (line.rfind(BENCH_LINE_PREFIX, 0) == 0) {
+            results.push_back(line.substr(strlen(BENCH_LINE_PREFIX)));
+        } else if (line.find("Benchmark") != std::string::npos && line.find("failed") != std::string::npos) {
+            fprintf(stderr, "%s\n", line.c_str());
+            expected--;  // The failed part printed no result line
+        }
+        line.clear();
+    }
+    return results;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    long baud = 115200;
+    uint32_t count = 50;
+    const char *output = nullptr;
+    const char *device = nullptr;
+    std::vector<std::string> benches;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--sim") return Simulate(i + 1 < argc ? uint32_t(atol(argv[i + 1])) : count);
+        if (arg == "-b" && i + 1 < argc) {
+            baud = atol(argv[++i]);
+        } else if (arg == "-c" && i + 1 < argc) {
+            count = uint32_t(atol(argv[++i]));
+        } else if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (device == nullptr) {
+            device = argv[i];
+        } else {
+            benches.push_back(arg);
+        }
+    }
+    if (device == nullptr) {
+        fprintf(stderr, "Usage: %s [-b baud] [-c count] [-o results.csv] <device> [i2c|spi|sd|mqtt|all]...\n       %s --sim [count]\n", argv[0], argv[0]);
+        return 2;
+    }
+    if (benches.empty()) benches.push_back("all");
+
+    int fd = open(device, O_RDWR | O_NOCTTY);
+    termios tio;
+    if (fd < 0 || tcgetattr(fd, &tio) != 0) {
+        perror(device);
+        return 1;
+    }
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, BaudToSpeed(baud));
+    cfsetospeed(&tio, BaudToSpeed(baud));
+    tcsetattr(fd, TCSANOW, &tio);
+    tcflush(fd, TCIOFLUSH);
+
+    FILE *csv = nullptr;
+    if (output != nullptr) {
+        bool exists = access(output, F_OK) == 0;
+        csv = fopen(output, "a");
+        if (csv == nullptr) {
+            perror(output);
+            return 1;
+        }
+        if (!exists) fprintf(csv, "%s\n", kCsvHeader);
+    }
+
+    int failures = 0;
+    printf("%s\n", kCsvHeader);
+    for (const std::string &bench : benches) {
+        // MQTT round trips may time out one by one (BENCH_MQTT_TIMEOUT_MS), so allow for a long silence
+        std::vector<std::string> results = RunOnDevice(fd, bench, count, 10000);
+        if (int(results.size()) < ExpectedResults(bench)) failures++;
+        for (const std::string &result : results) {
+            printf("%s\n", result.c_str());
+            if (csv != nullptr) fprintf(csv, "%s\n", result.c_str());
+        }
+    }
+
+    if (csv != nullptr) fclose(csv);
+    close(fd);
+    return failures == 0 ? 0 : 1;
+}
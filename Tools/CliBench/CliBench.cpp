@@ -0,0 +1,181 @@
+/**
+ * @file        CliBench.cpp
+ * @brief       Host benchmark of the CLI command dispatch: FreeRTOS_CLIProcessCommand against CliProcessCommand (CliDispatch.c)
+ * @details     Registers N commands of 3 parameters each with CliRegisterCommand, which also registers them with
+ *				FreeRTOS+CLI, then runs the same command lines through both dispatchers and prints commands per second:
+ *				--FreeRTOS_CLIProcessCommand: walks the command list with a string compare per command, and the callback
+ *				  reads each parameter with FreeRTOS_CLIGetParameter, which scans the line again from its start.
+ *				--CliProcessCommand: one hash of the command name, and the line is split once; the callback reads the
+ *				  parameters with CliGetParameter.
+ *				The lines call the N commands in a shuffled order, so the list walk averages half the list. Both runs must
+ *				read the same parameters. The callbacks do no other work, so the numbers are the dispatch cost alone.
+ *
+ *				Build:	cc -c -O2 -Wall -Wextra -Ishim -I../../Application/src -I$CLI -DCLI_COMMAND_TABLE_SIZE=512
+ *						  ../../Application/src/CliThread/CliDispatch.c $CLI/FreeRTOS_CLI.c
+ *						g++ -std=c++17 -O2 -Wall -Wextra -Ishim -I../../Application/src/CliThread -I$CLI -DCLI_COMMAND_TABLE_SIZE=512 -o CliBench
+ *						  CliBench.cpp CliDispatch.o FreeRTOS_CLI.o
+ *						with CLI=../../Application/src/ASF/thirdparty/freertos/freertos-10.0.0/Source/FreeRTOS-Plus-CLI
+ *				Use:	CliBench [-c calls] [command count]...
+ *						Default: 10, 50 and 200 commands, 2000000 calls each
+ *
+ * @copyright
+ * @author
+ * @date        October 16, 2026
+ * @version		0.1
+ */
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "CliDispatch.h"
+}
+
+namespace {
+
+constexpr int kParameters = 3;  ///< Parameters of every command, e.g. "led" has 4, "bench" up to 3
+constexpr size_t kOutputLen = 100;  ///< MAX_OUTPUT_LENGTH_CLI
+
+bool useDispatch = false;  ///< Which parameter API the callbacks use
+uint64_t parameterSum = 0;  ///< What the callbacks read, to check both dispatchers saw the same parameters
+
+/// Parses an unsigned decimal parameter, which is not null terminated
+uint32_t ParseParameter(const char *param, BaseType_t len)
+{
+    uint32_t value = 0;
+    for (BaseType_t i = 0; i < len; i++) value = value * 10 + uint32_t(param[i] - '0');
+    return value;
+}
+
+BaseType_t BenchCommand(char *writeBuffer, size_t writeBufferLen, const char *commandString)
+{
+    (void)writeBuffer;
+    (void)writeBufferLen;
+    for (UBaseType_t i = 1; i <= kParameters; i++) {
+        BaseType_t len = 0;
+        const char *param = useDispatch ? CliGetParameter(i, &len) : FreeRTOS_CLIGetParameter(commandString, i, &len);
+        if (param != nullptr) parameterSum += ParseParameter(param, len);
+    }
+    return pdFALSE;
+}
+
+/// Runs every line calls times in total through one dispatcher
+double Run(const std::vector<std::string> &lines, uint32_t calls, bool dispatch)
+{
+    static char output[kOutputLen];
+
+    useDispatch = dispatch;
+    parameterSum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < calls; i++) {
+        const char *line = lines[i % lines.size()].c_str();
+        if (dispatch) {
+            CliProcessCommand(line, output, sizeof(output));
+        } else {
+            FreeRTOS_CLIProcessCommand(line, output, sizeof(output));
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    return calls / std::chrono::duration<double>(end - start).count();
+}
+
+int RunCount(uint32_t count, uint32_t calls)
+{
+    // Command names of the lengths the application uses ("i2c" to "getdistance")
+    static const char *const kStems[] = {"imu", "led", "i2cstat", "getbutton", "weight", "stream", "getdistance", "boot"};
+    std::vector<std::string> names;
+    std::vector<CLI_Command_Definition_t> commands;
+    names.reserve(count);
+    commands.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        names.push_back(std::string(kStems[i % 8]) + std::to_string(i));
+        commands.push_back({names.back().c_str(), "bench command\r\n", BenchCommand, kParameters});
+        if (CliRegisterCommand(&commands.back()) != pdPASS) {
+            printf("  FAIL: command %u not registered, raise CLI_COMMAND_TABLE_SIZE\n", i);
+            return 1;
+        }
+    }
+
+    std::vector<std::string> lines;
+    std::mt19937 random(count);
+    for (int pass = 0; pass < 4; pass++) {
+        std::vector<uint32_t> order(count);
+        for (uint32_t i = 0; i < count; i++) order[i] = i;
+        std::shuffle(order.begin(), order.end(), random);
+        for (uint32_t i : order) {
+            lines.push_back(names[i] + " " + std::to_string(random() % 16) + " " + std::to_string(random() % 256) + " " + std::to_string(random() % 65536));
+        }
+    }
+
+    Run(lines, calls / 10, false);  // Warm up
+    double list = Run(lines, calls, false);
+    uint64_t listSum = parameterSum;
+    Run(lines, calls / 10, true);
+    double hashed = Run(lines, calls, true);
+    uint64_t hashedSum = parameterSum;
+
+    printf("  %4u commands: FreeRTOS_CLIProcessCommand %6.2f M commands/s, CliProcessCommand %6.2f M commands/s (%.1fx)\n",
+           count,
+           list / 1e6,
+           hashed / 1e6,
+           hashed / list);
+    if (listSum != hashedSum || listSum == 0) {
+        printf("  FAIL: the dispatchers read different parameters (%llu, %llu)\n", (unsigned long long)listSum, (unsigned long long)hashedSum);
+        return 1;
+    }
+    return 0;
+}
+
+}  // namespace
+
+/// Console output of CliWrite and CliPrintf. The bench commands print nothing
+extern "C" void SerialConsoleWriteBlocking(const uint8_t *data, size_t len)
+{
+    (void)data;
+    (void)len;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<uint32_t> counts;
+    uint32_t calls = 2000000;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            calls = uint32_t(strtoul(argv[++i], nullptr, 10));
+        } else if (strtoul(argv[i], nullptr, 10) > 0) {
+            counts.push_back(uint32_t(strtoul(argv[i], nullptr, 10)));
+        } else {
+            fprintf(stderr, "Usage: %s [-c calls] [command count]...\n", argv[0]);
+            return 2;
+        }
+    }
+    if (counts.empty()) counts = {10, 50, 200};
+    if (calls == 0) calls = 1;
+
+    printf("%u calls, %d parameters per command, CLI_COMMAND_TABLE_SIZE %d\n", calls, kParameters, CLI_COMMAND_TABLE_SIZE);
+    int failures = 0;
+    for (uint32_t count : counts) {
+        // Neither dispatcher can unregister commands: a fresh process per command count
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            int result = RunCount(count, calls);
+            fflush(stdout);
+            _exit(result);
+        }
+        int status = 0;
+        if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) failures++;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,26 @@
+/**
+ * @file        FreeRTOS.h
+ * @brief       Host stand-in for the FreeRTOS types and configuration that FreeRTOS_CLI.c and CliDispatch.c use (see CliBench.cpp)
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+
+/// Same values as Application/src/config/FreeRTOSConfig.h
+#define configCOMMAND_INT_MAX_OUTPUT_SIZE 32
+#define configAPPLICATION_PROVIDES_cOutputBuffer 0
+#define configASSERT(x) ((void)(x))
+
+#define pvPortMalloc malloc
@@ -0,0 +1,8 @@
+/**
+ * @file        asf.h
+ * @brief       Host stand-in for the ASF header included by SerialConsole.h. CliDispatch.c only needs the console prototypes
+ */
+
+#pragma once
+
+#include "FreeRTOS.h"
@@ -0,0 +1,11 @@
+/**
+ * @file        task.h
+ * @brief       Host stand-in for the FreeRTOS task macros used by FreeRTOS_CLI.c. The benchmark has a single thread
+ */
+
+#pragma once
+
+#include "FreeRTOS.h"
+
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
@@ -0,0 +1,575 @@
+/**
+ * @file        ConsoleSim.cpp
+ * @brief       Console TX throughput benchmark: the unmodified SerialConsole.c on the PC, against a simulated USART and DMAC.
+ * @details     Application/src/SerialConsole/SerialConsole.c and circular_buffer.c run as they are, logger task included,
+ *				on the simulated kernel of Tools/I2cSim (SimKernel.cpp). This file is the hardware: SERCOM4 as a USART
+ *				with its data and shift registers, the DRE and TXC flags and interrupt, and the DMAC channels of the
+ *				console, plus the ASF USART and DMA calls SerialConsole.c makes.
+ *
+ *				Each scenario sends the same bytes through two engines and prints bytes/s, interrupts per KB and the
+ *				CPU time spent in interrupts:
+ *				--dma: SerialConsole.c. The DMAC sends the largest contiguous span of the TX ring, one interrupt per span.
+ *				--byte: the engine it replaced, modeled here. Every byte is a 1-byte ASF write job: a DRE interrupt
+ *				  writes DATA, then a TXC interrupt runs the callback that starts the job of the next byte.
+ *				The interrupt costs are estimates (see the constants below), so use the numbers to compare the engines,
+ *				not as board timings.
+ *
+ *				Build:	cc -c -O2 -Wall -Wextra -Ishim -I../I2cSim/shim -I../../Application/src
+ *						  ../../Application/src/SerialConsole/SerialConsole.c ../../Application/src/SerialConsole/circular_buffer.c
+ *						g++ -std=c++17 -O2 -Wall -Wextra -no-pie -Ishim -I../I2cSim -I../I2cSim/shim -I../../Application/src
+ *						  -o ConsoleSim ConsoleSim.cpp ../I2cSim/SimKernel.cpp SerialConsole.o circular_buffer.o
+ *				Use:	ConsoleSim [-b baud] [bulk|lines|log|all]...
+ *						-b	USART rate. Default CONSOLE_BAUDRATE (115200)
+ *
+ * @copyright
+ * @author
+ * @date        October 16, 2026
+ * @version		0.1
+ */
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Sim.h"
+
+extern "C" {
+#include "SerialConsole/SerialConsole.h"
+}
+
+namespace {
+
+constexpr uint32_t kDmacIrqCycles = 180;   ///< DMAC_Handler of ASF: channel lookup, status, callback call
+constexpr uint32_t kSpanCycles = 60;       ///< usart_dma_write_callback: skip the span, peek the next one, start the job
+constexpr uint32_t kUsartIrqCycles = 150;  ///< _usart_interrupt_handler of ASF: flags, enabled interrupts, one branch
+constexpr uint32_t kByteJobCycles = 80;    ///< Callback of the byte engine: circular_buf_get and usart_write_buffer_job
+constexpr unsigned kWriterPriority = configMAX_PRIORITIES - 3;  ///< A producer among the application tasks
+
+uint32_t simBaud = CONSOLE_BAUDRATE;  ///< Rate of the simulated USART (-b)
+
+/******************************************************************************
+ * SERCOM4 USART and DMAC
+ ******************************************************************************/
+
+/// Transmitter of the USART: DATA, then the shift register. DRE is set while DATA is empty
+struct Usart {
+    bool enabled = false;
+    bool dataFull = false;
+    uint8_t data = 0;
+    bool shifting = false;
+    uint8_t shift = 0;         ///< Byte on the line
+    bool txc = false;          ///< Transmit complete: the shift register emptied with DATA empty
+    bool dreIrq = false;       ///< INTENSET.DRE (byte engine)
+    bool txcIrq = false;       ///< INTENSET.TXC (byte engine)
+    std::string sent;          ///< Bytes that left the shift register
+    uint64_t lastNs = 0;       ///< Time the last byte left
+} usart;
+
+/// Console TX channel of the DMAC
+struct TxChannel {
+    struct dma_resource *resource = nullptr;
+    bool active = false;
+    const uint8_t *source = nullptr;
+    uint16_t count = 0;
+    uint16_t done = 0;
+    bool pending = false;  ///< Transfer complete interrupt
+} txChannel;
+
+struct dma_resource *channels[CONF_MAX_USED_CHANNEL_NUM];
+uint8_t channelCount = 0;
+DmacDescriptor writeBack[CONF_MAX_USED_CHANNEL_NUM];
+uint32_t violations = 0;
+
+void Violation(const char *what)
+{
+    printf("  VIOLATION: %s\n", what);
+    violations++;
+}
+
+uint64_t ByteNs()
+{
+    return 10ull * 1000000000ull / simBaud;  // 8N1: start, 8 data bits, stop
+}
+
+bool Dre()
+{
+    return usart.enabled && !usart.dataFull;
+}
+
+void DmaBeats();
+
+void ShiftDone()
+{
+    usart.sent.push_back(char(usart.shift));
+    usart.lastNs = sim::NowNs();
+    if (usart.dataFull) {
+        usart.dataFull = false;  // The next byte moves into the shift register
+        usart.shift = usart.data;
+        sim::At(sim::NowNs() + ByteNs(), ShiftDone);
+        DmaBeats();
+    } else {
+        usart.shifting = false;
+        usart.txc = true;
+    }
+}
+
+/// A write to DATA: into the shift register at once if it is empty
+void WriteData(uint8_t byte)
+{
+    if (usart.dataFull) {
+        Violation("DATA written while DRE is clear");
+        return;
+    }
+    usart.txc = false;
+    if (usart.shifting) {
+        usart.dataFull = true;
+        usart.data = byte;
+        return;
+    }
+    usart.shifting = true;
+    usart.shift = byte;
+    sim::At(sim::NowNs() + ByteNs(), ShiftDone);
+}
+
+/// Moves one byte per DRE trigger while the TX channel has beats left
+void DmaBeats()
+{
+    while (txChannel.active && Dre()) {
+        WriteData(txChannel.source[txChannel.done++]);
+        if (txChannel.done == txChannel.count) {
+            txChannel.active = false;
+            txChannel.pending = true;
+        }
+    }
+}
+
+bool DmacIrqPending()
+{
+    return txChannel.pending;
+}
+
+void DmacIrqHandler()
+{
+    txChannel.pending = false;
+    struct dma_resource *resource = txChannel.resource;
+    resource->job_status = STATUS_OK;
+    resource->transfered_size = txChannel.count;
+    if ((resource->callback_enable & (1 << DMA_CALLBACK_TRANSFER_DONE)) && resource->callback[DMA_CALLBACK_TRANSFER_DONE] != nullptr) {
+        sim::Busy(sim::CyclesNs(kSpanCycles));
+        resource->callback[DMA_CALLBACK_TRANSFER_DONE](resource);
+    }
+}
+
+/******************************************************************************
+ * Byte engine: the interrupt driven TX that SerialConsole.c replaced
+ ******************************************************************************/
+
+circular_buf_t byteRing;
+uint8_t byteStorage[512];  ///< Same size as TX_BUFFER_SIZE
+uint8_t byteCurrent = 0;   ///< Buffer of the 1-byte write job
+bool byteBusy = false;
+
+/// usart_write_buffer_job(&usart_instance, &byteCurrent, 1) for the next byte of the ring, if there is one
+void ByteEngineStart()
+{
+    byteBusy = circular_buf_get(&byteRing, &byteCurrent) == 0;
+    usart.dreIrq = byteBusy;
+}
+
+size_t ByteEngineQueue(const uint8_t *data, size_t len)
+{
+    size_t queued = circular_buf_put_n(&byteRing, data, len);
+    if (!byteBusy) ByteEngineStart();
+    return queued;
+}
+
+bool UsartIrqPending()
+{
+    return (usart.dreIrq && Dre()) || (usart.txcIrq && usart.txc);
+}
+
+/// Buffer job of ASF with one byte: DRE writes it, TXC ends the job and calls the transmitted callback
+void UsartIrqHandler()
+{
+    if (usart.dreIrq && Dre()) {
+        WriteData(byteCurrent);
+        usart.dreIrq = false;
+        usart.txcIrq = true;
+        return;
+    }
+    usart.txc = false;
+    usart.txcIrq = false;
+    sim::Busy(sim::CyclesNs(kByteJobCycles));
+    ByteEngineStart();
+}
+
+const sim::Irq dmacIrq = {"DMAC", kDmacIrqCycles, DmacIrqPending, DmacIrqHandler};
+const sim::Irq usartIrq = {"SERCOM4", kUsartIrqCycles, UsartIrqPending, UsartIrqHandler};
+
+/******************************************************************************
+ * Scenarios
+ ******************************************************************************/
+
+enum class Engine { Dma, Byte };
+
+const char *EngineName(Engine engine)
+{
+    return engine == Engine::Dma ? "dma" : "byte";
+}
+
+int simFailures = 0;
+
+void Check(bool condition, const char *what)
+{
+    if (!condition) {
+        printf("  FAIL: %s\n", what);
+        simFailures++;
+    }
+}
+
+/// Writes len bytes, waiting for room as SerialConsoleWriteBlocking does
+void WriteBlocking(Engine engine, const uint8_t *data, size_t len)
+{
+    if (engine == Engine::Dma) {
+        SerialConsoleWriteBlocking(data, len);
+        return;
+    }
+    for (;;) {
+        size_t queued = ByteEngineQueue(data, len);
+        data += queued;
+        len -= queued;
+        if (len == 0) break;
+        vTaskDelay(pdMS_TO_TICKS(2));
+    }
+}
+
+/// Sleeps until every byte of expected left the USART
+void WaitSent(size_t expected)
+{
+    while (usart.sent.size() < expected) vTaskDelay(1);
+}
+
+/// Prints the throughput and interrupt load of the bytes sent since startNs
+void PrintResult(Engine engine, uint64_t startNs, const std::string &expected)
+{
+    const sim::CpuStats &cpu = sim::Cpu();
+    uint64_t irqs = 0;
+    for (const auto &irq : cpu.irq) irqs += irq.second.count;
+    uint64_t elapsedNs = usart.lastNs - startNs;
+    double kb = usart.sent.size() / 1024.0;
+
+    printf("  %-5s %7lu baud %7zu bytes %9.1f ms %8.0f B/s (%5.1f%% of the line) %7llu irqs %7.1f irqs/KB %6.2f%% CPU in irqs\n",
+           EngineName(engine),
+           (unsigned long)simBaud,
+           usart.sent.size(),
+           elapsedNs / 1e6,
+           elapsedNs ? usart.sent.size() * 1e9 / elapsedNs : 0.0,
+           elapsedNs ? 100.0 * usart.sent.size() * ByteNs() / elapsedNs : 0.0,
+           (unsigned long long)irqs,
+           kb > 0 ? irqs / kb : 0.0,
+           elapsedNs ? 100.0 * cpu.IrqNs() / elapsedNs : 0.0);
+    Check(usart.sent == expected, "the USART sent every byte, in order");
+}
+
+std::string Line(const char *what, int index, size_t len)
+{
+    char text[128];
+    int n = snprintf(text, sizeof(text), "%s %05d ", what, index);
+    std::string line(text, size_t(n));
+    while (line.size() < len - 2) line.push_back(char('a' + line.size() % 26));
+    return line + "\r\n";
+}
+
+/// 32 KB of 64-byte lines written as fast as the TX ring takes them (a CLI dump, an OTA progress flood)
+void ScenarioBulk(Engine engine)
+{
+    std::string expected;
+    for (int i = 0; i < 512; i++) expected += Line("bulk", i, 64);
+
+    sim::ResetCpu();
+    uint64_t start = sim::NowNs();
+    for (size_t i = 0; i < expected.size(); i += 64) {
+        WriteBlocking(engine, reinterpret_cast<const uint8_t *>(expected.data() + i), 64);
+    }
+    WaitSent(expected.size());
+    PrintResult(engine, start, expected);
+    Check(engine == Engine::Byte || usart.sent.size() * ByteNs() * 100 >= (usart.lastNs - start) * 99, "the DMAC keeps the line busy");
+}
+
+/// One 48-byte line every 20 ms: a light, steady log load
+void ScenarioLines(Engine engine)
+{
+    std::string expected;
+    for (int i = 0; i < 100; i++) expected += Line("line", i, 48);
+
+    sim::ResetCpu();
+    uint64_t start = sim::NowNs();
+    for (size_t i = 0; i < expected.size(); i += 48) {
+        WriteBlocking(engine, reinterpret_cast<const uint8_t *>(expected.data() + i), 48);
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    WaitSent(expected.size());
+    PrintResult(engine, start, expected);
+}
+
+/// Bursts of LOG_SLOT_COUNT messages through LogMessage and the logger task, as during an MQTT reconnect
+void ScenarioLog(Engine engine)
+{
+    if (engine == Engine::Byte) return;  // LogMessage only runs on SerialConsole.c
+
+    std::string expected;
+    xTaskCreate(vLoggerTask, "Logger", LOGGER_TASK_SIZE, NULL, LOGGER_TASK_PRIORITY, NULL);
+    vTaskDelay(1);
+
+    sim::ResetCpu();
+    uint64_t start = sim::NowNs();
+    for (int burst = 0; burst < 20; burst++) {
+        for (int i = 0; i < LOG_SLOT_COUNT; i++) {
+            int index = burst * LOG_SLOT_COUNT + i;
+            LogMessage(LOG_INFO_LVL, "MQTT reconnect %05d, state %d, retry in %d ms\r\n", index, i, 100 * i);
+            char text[96];
+            snprintf(text, sizeof(text), "MQTT reconnect %05d, state %d, retry in %d ms\r\n", index, i, 100 * i);
+            expected += text;
+        }
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    WaitSent(expected.size());
+    PrintResult(engine, start, expected);
+    Check(LogGetDropCount(LOG_INFO_LVL) == 0, "no message dropped");
+}
+
+struct Scenario {
+    const char *name;
+    void (*run)(Engine engine);
+};
+
+const Scenario kScenarios[] = {
+    {"bulk", ScenarioBulk},
+    {"lines", ScenarioLines},
+    {"log", ScenarioLog},
+};
+
+const Scenario *simScenario = nullptr;
+Engine simEngine = Engine::Dma;
+
+void ScenarioTask()
+{
+    InitializeSerialConsole();
+    circular_buf_init(&byteRing, byteStorage, sizeof(byteStorage));
+    simScenario->run(simEngine);
+    Check(violations == 0, "the engine only does what the USART and the DMAC allow");
+}
+
+int RunScenario(const Scenario &scenario, Engine engine)
+{
+    sim::AddIrq(&dmacIrq);
+    sim::AddIrq(&usartIrq);
+    simScenario = &scenario;
+    simEngine = engine;
+    Check(sim::Run(ScenarioTask, kWriterPriority), "the scenario ran to its end (every task blocked)");
+    fflush(stdout);
+    return simFailures == 0 ? 0 : 1;
+}
+
+/// The DMAC descriptors hold 32-bit addresses of the TX ring and of the USART
+bool AddressesFit()
+{
+    return (uint64_t(uintptr_t(&simSercom4)) >> 32) == 0 && (uint64_t(uintptr_t(descriptor_section)) >> 32) == 0;
+}
+
+}  // namespace
+
+/******************************************************************************
+ * ASF USART and DMA calls of SerialConsole.c
+ ******************************************************************************/
+
+extern "C" {
+
+Dmac simDmac;
+Sercom simSercom4;
+DmacDescriptor descriptor_section[CONF_MAX_USED_CHANNEL_NUM];
+
+void CliCharReadySemaphoreGiveFromISR(void)
+{
+}
+
+void usart_get_config_defaults(struct usart_config *const config)
+{
+    memset(config, 0, sizeof(*config));
+    config->baudrate = 9600;
+}
+
+enum status_code usart_init(struct usart_module *const module, Sercom *const hw, const struct usart_config *const config)
+{
+    if (hw != &simSercom4) return STATUS_ERR_INVALID_ARG;
+    memset(module, 0, sizeof(*module));
+    module->hw = hw;
+    if (config->baudrate != CONSOLE_BAUDRATE) Violation("baud rate other than CONSOLE_BAUDRATE");
+    return STATUS_OK;
+}
+
+void usart_enable(const struct usart_module *const module)
+{
+    (void)module;
+    usart.enabled = true;
+}
+
+void usart_disable(const struct usart_module *const module)
+{
+    (void)module;
+    usart.enabled = false;
+}
+
+void usart_register_callback(struct usart_module *const module, usart_callback_t callback_func, enum usart_callback callback_type)
+{
+    module->callback[callback_type] = callback_func;
+    module->callback_reg_mask |= uint8_t(1 << callback_type);
+}
+
+void usart_enable_callback(struct usart_module *const module, enum usart_callback callback_type)
+{
+    module->callback_enable_mask |= uint8_t(1 << callback_type);
+}
+
+void dma_get_config_defaults(struct dma_resource_config *config)
+{
+    config->peripheral_trigger = 0;
+    config->trigger_action = DMA_TRIGGER_ACTION_TRANSACTION;
+}
+
+enum status_code dma_allocate(struct dma_resource *resource, struct dma_resource_config *config)
+{
+    if (channelCount >= CONF_MAX_USED_CHANNEL_NUM) return STATUS_ERR_DENIED;
+    if (config->trigger_action != DMA_TRIGGER_ACTION_BEAT) Violation("console DMAC channel not triggered per beat");
+    memset(resource, 0, sizeof(*resource));
+    resource->channel_id = channelCount;
+    channels[channelCount++] = resource;
+    if (config->peripheral_trigger == SERCOM4_DMAC_ID_TX) txChannel.resource = resource;
+    simDmac.WRBADDR.reg = uint32_t(uintptr_t(writeBack));
+    return STATUS_OK;
+}
+
+void dma_descriptor_get_config_defaults(struct dma_descriptor_config *config)
+{
+    memset(config, 0, sizeof(*config));
+    config->descriptor_valid = true;
+    config->src_increment_enable = true;
+    config->dst_increment_enable = true;
+}
+
+void dma_descriptor_create(DmacDescriptor *descriptor, struct dma_descriptor_config *config)
+{
+    descriptor->BTCTRL.reg = uint16_t((config->descriptor_valid ? DMAC_BTCTRL_VALID : 0) | (config->src_increment_enable ? DMAC_BTCTRL_SRCINC : 0) |
+                                      (config->dst_increment_enable ? DMAC_BTCTRL_DSTINC : 0) | (config->beat_size << DMAC_BTCTRL_BEATSIZE_Pos));
+    descriptor->BTCNT.reg = config->block_transfer_count;
+    descriptor->SRCADDR.reg = config->source_address;
+    descriptor->DSTADDR.reg = config->destination_address;
+    descriptor->DESCADDR.reg = config->next_descriptor_address;
+}
+
+enum status_code dma_add_descriptor(struct dma_resource *resource, DmacDescriptor *descriptor)
+{
+    resource->descriptor = descriptor;
+    return STATUS_OK;
+}
+
+void dma_register_callback(struct dma_resource *resource, dma_callback_t callback, enum dma_callback_type type)
+{
+    resource->callback[type] = callback;
+}
+
+void dma_enable_callback(struct dma_resource *resource, enum dma_callback_type type)
+{
+    resource->callback_enable |= uint8_t(1 << type);
+}
+
+/// TX: moves the descriptor span to DATA, one beat per DRE. RX: the channel waits for characters, none arrive here
+enum status_code dma_start_transfer_job(struct dma_resource *resource)
+{
+    const DmacDescriptor *descriptor = resource->descriptor;
+
+    if (resource->job_status == STATUS_BUSY) return STATUS_BUSY;
+    descriptor_section[resource->channel_id] = *descriptor;
+    writeBack[resource->channel_id] = *descriptor;
+    if (resource != txChannel.resource) {
+        resource->job_status = STATUS_BUSY;
+        return STATUS_OK;
+    }
+
+    if (!(descriptor->BTCTRL.reg & DMAC_BTCTRL_VALID) || descriptor->BTCNT.reg == 0) Violation("TX descriptor not valid");
+    if (!(descriptor->BTCTRL.reg & DMAC_BTCTRL_SRCINC) || (descriptor->BTCTRL.reg & DMAC_BTCTRL_DSTINC)) Violation("TX increments");
+    if (descriptor->DSTADDR.reg != uint32_t(uintptr_t(&simSercom4.USART.DATA.reg))) Violation("TX destination is not the USART DATA");
+    resource->job_status = STATUS_BUSY;
+    txChannel.count = descriptor->BTCNT.reg;
+    txChannel.source = reinterpret_cast<const uint8_t *>(uintptr_t(descriptor->SRCADDR.reg)) - txChannel.count;
+    txChannel.done = 0;
+    txChannel.active = true;
+    DmaBeats();
+    return STATUS_OK;
+}
+
+void dma_abort_job(struct dma_resource *resource)
+{
+    if (resource == txChannel.resource) txChannel.active = false;
+    resource->job_status = STATUS_ABORTED;
+}
+
+}  // extern "C"
+
+int main(int argc, char **argv)
+{
+    std::vector<const Scenario *> selected;
+    int failures = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-b" && i + 1 < argc) {
+            simBaud = uint32_t(strtoul(argv[++i], nullptr, 10));
+            continue;
+        }
+        bool found = false;
+        for (const Scenario &scenario : kScenarios) {
+            if (arg == scenario.name || arg == "all") {
+                selected.push_back(&scenario);
+                found = true;
+            }
+        }
+        if (!found || simBaud == 0) {
+            fprintf(stderr, "Usage: %s [-b baud] [bulk|lines|log|all]...\n", argv[0]);
+            return 2;
+        }
+    }
+    if (selected.empty()) {
+        for (const Scenario &scenario : kScenarios) selected.push_back(&scenario);
+    }
+    if (!AddressesFit()) {
+        fprintf(stderr, "%s: addresses above 4 GB, the DMAC cannot reach them: link with -no-pie\n", argv[0]);
+        return 2;
+    }
+
+    for (const Scenario *scenario : selected) {
+        printf("%s\n", scenario->name);
+        for (Engine engine : {Engine::Byte, Engine::Dma}) {
+            // The console and the kernel keep their state in statics: a fresh process per run, as after a reset
+            fflush(stdout);
+            pid_t pid = fork();
+            if (pid == 0) _exit(RunScenario(*scenario, engine));
+
+            int status = 0;
+            if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                if (pid > 0 && WIFSIGNALED(status)) printf("  FAIL: killed by signal %d\n", WTERMSIG(status));
+                failures++;
+            }
+        }
+    }
+
+    printf("%s\n", failures == 0 ? "All checks passed" : "Some checks failed");
+    return failures == 0 ? 0 : 1;
+}
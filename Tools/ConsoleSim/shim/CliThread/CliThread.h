@@ -0,0 +1,16 @@
+/**
+ * @file        CliThread.h
+ * @brief       Host stand-in for the CLI: only the start bit wakeup that SerialConsole.c calls (see ConsoleSim.cpp)
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void CliCharReadySemaphoreGiveFromISR(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,159 @@
+/**
+ * @file        asf.h
+ * @brief       Host stand-in for the ASF services used by SerialConsole.c: the SERCOM4 USART driver and the DMAC
+ * @details     Implemented by ConsoleSim.cpp on the virtual clock of Tools/I2cSim/SimKernel.cpp. The FreeRTOS headers and
+ *              the DMAC driver declarations (dma.h) are the ones of Tools/I2cSim/shim.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "task.h"
+
+/// Same values as the ASF status_codes.h
+enum status_code {
+    STATUS_OK = 0x00,
+    STATUS_ABORTED = 0x04,
+    STATUS_BUSY = 0x05,
+    STATUS_ERR_INVALID_ARG = 0x17,
+    STATUS_ERR_DENIED = 0x1c,
+};
+
+#define COMPILER_ALIGNED(a) __attribute__((__aligned__(a)))
+
+#include "dma.h"
+
+#define FLASH_ADDR (0x00000000u)
+#define FLASH_SIZE (0x40000u)
+
+/******************************************************************************
+ * DMAC
+ ******************************************************************************/
+
+#define CONF_MAX_USED_CHANNEL_NUM 4
+#define DMAC_ACTIVE_ID_Pos 8
+#define DMAC_ACTIVE_ID_Msk (0x1Fu << DMAC_ACTIVE_ID_Pos)
+#define DMAC_ACTIVE_ABUSY (1u << 15)
+#define DMAC_ACTIVE_BTCNT_Pos 16
+#define DMAC_ACTIVE_BTCNT_Msk (0xFFFFu << DMAC_ACTIVE_BTCNT_Pos)
+
+/// The registers of the DMAC that SerialConsole.c reads
+typedef struct {
+    struct {
+        uint32_t reg;
+    } WRBADDR;
+    struct {
+        uint32_t reg;
+    } ACTIVE;
+} Dmac;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern Dmac simDmac;
+extern DmacDescriptor descriptor_section[CONF_MAX_USED_CHANNEL_NUM];
+
+#ifdef __cplusplus
+}
+#endif
+
+#define DMAC (&simDmac)
+
+/******************************************************************************
+ * SERCOM4 USART
+ ******************************************************************************/
+
+#define SERCOM4_DMAC_ID_RX 0x09
+#define SERCOM4_DMAC_ID_TX 0x0A
+
+#define SERCOM_USART_INTFLAG_DRE (1u << 0)
+#define SERCOM_USART_INTFLAG_TXC (1u << 1)
+#define SERCOM_USART_INTFLAG_RXC (1u << 2)
+#define SERCOM_USART_INTFLAG_RXS (1u << 3)
+
+/// The registers of the USART that SerialConsole.c touches. Flags and interrupts are modeled in ConsoleSim.cpp
+typedef struct {
+    struct {
+        uint16_t reg;
+    } DATA;
+    struct {
+        uint8_t reg;
+    } INTENSET;
+    struct {
+        uint8_t reg;
+    } INTFLAG;
+} SercomUsart;
+
+typedef union {
+    SercomUsart USART;
+} Sercom;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern Sercom simSercom4;
+
+#ifdef __cplusplus
+}
+#endif
+
+#define EDBG_CDC_MODULE (&simSercom4)
+#define EDBG_CDC_SERCOM_MUX_SETTING 0x00310000u
+#define EDBG_CDC_SERCOM_PINMUX_PAD0 0xFFFFFFFFu
+#define EDBG_CDC_SERCOM_PINMUX_PAD1 0xFFFFFFFFu
+#define EDBG_CDC_SERCOM_PINMUX_PAD2 0x000A0002u
+#define EDBG_CDC_SERCOM_PINMUX_PAD3 0x000B0002u
+
+enum usart_callback {
+    USART_CALLBACK_BUFFER_TRANSMITTED,
+    USART_CALLBACK_BUFFER_RECEIVED,
+    USART_CALLBACK_ERROR,
+    USART_CALLBACK_BREAK_RECEIVED,
+    USART_CALLBACK_CTS_INPUT_CHANGE,
+    USART_CALLBACK_START_RECEIVED,
+    USART_CALLBACK_N,
+};
+
+struct usart_module;
+typedef void (*usart_callback_t)(struct usart_module *const module);
+
+struct usart_module {
+    Sercom *hw;
+    usart_callback_t callback[USART_CALLBACK_N];
+    uint8_t callback_reg_mask;
+    uint8_t callback_enable_mask;
+};
+
+struct usart_config {
+    uint32_t baudrate;
+    uint32_t mux_setting;
+    uint32_t pinmux_pad0;
+    uint32_t pinmux_pad1;
+    uint32_t pinmux_pad2;
+    uint32_t pinmux_pad3;
+    bool start_frame_detection_enable;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void usart_get_config_defaults(struct usart_config *const config);
+enum status_code usart_init(struct usart_module *const module, Sercom *const hw, const struct usart_config *const config);
+void usart_enable(const struct usart_module *const module);
+void usart_disable(const struct usart_module *const module);
+void usart_register_callback(struct usart_module *const module, usart_callback_t callback_func, enum usart_callback callback_type);
+void usart_enable_callback(struct usart_module *const module, enum usart_callback callback_type);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,1112 @@
+/**
+ * @file        I2cSim.cpp
+ * @brief       Runs the unmodified I2C driver and sensor drivers on the PC, against a simulated SERCOM and sensor bus.
+ * @details     Application/src/I2cDriver/I2cDriver.c runs as it is, bus manager task included, on a simulated SAMD21 at
+ *				48 MHz (SimSercom.cpp: SERCOM0, the DMAC and the ASF drivers; SimKernel.cpp: FreeRTOS), so every transfer
+ *				goes through the real driver: speed profiles, byte interrupts, DMAC transfers, repeated STARTs, error
+ *				checks and completion. SeesawDriver.c, lsm6dso_reg.c, NAU7802.c and LedFrame.c build for Linux as they
+ *				are. The bus has byte-level models of:
+ *				--The NeoTrellis Seesaw: NeoPixel buffer and SHOW, keypad event registration, COUNT and FIFO.
+ *				--The LSM6DSO: register banks, auto-increment, software reset, output data at the ODR, FIFO with tags.
+ *				--The NAU7802: register reset, power-up, calibration time, conversions at the CRS rate and the CR flag,
+ *				  an oscillator error, and the conversions that were overwritten before being read.
+ *
+ *				Bit times come from the BAUD values the driver writes, and the CPU is charged for the interrupts, the
+ *				kernel calls, the context switches and the polling loops (see Sim.h), so each scenario ends with the bus
+ *				time per device and where the CPU time went. The numbers only reflect these models, so use them to
+ *				compare changes to the drivers, not as board timings.
+ *
+ *				Each scenario runs in its own process, as a task at the priority of the sensor users, after
+ *				I2cInitializeDriver. It fails if the driver recovered the bus or did something the SERCOM does not allow.
+ *
+ *				Build:	cc -c -O2 -Wall -Wextra -Ishim -I../../Application/src
+ *						  ../../Application/src/SeesawDriver/SeesawDriver.c ../../Application/src/IMU/lsm6dso_reg.c
+ *						  ../../Application/src/NAU78/NAU7802.c ../../Application/src/LedFrame/LedFrame.c
+ *						g++ -std=c++17 -O2 -Wall -Wextra -Ishim -I../../Application/src -x c++
+ *						  -c ../../Application/src/I2cDriver/I2cDriver.c
+ *						g++ -std=c++17 -O2 -Wall -Wextra -no-pie -Ishim -I../../Application/src -o I2cSim I2cSim.cpp
+ *						  SimKernel.cpp SimSercom.cpp I2cDriver.o SeesawDriver.o lsm6dso_reg.o NAU7802.o LedFrame.o
+ *				Use:	I2cSim [-v] [--no-speed] [seesaw|keypad|leds|imu|restart|fifo|drain|nau|all]...
+ *
+ * @copyright
+ * @author
+ * @date        October 16, 2026
+ * @version		0.2
+ */
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Sim.h"
+
+extern "C" {
+#include "I2cDriver/I2cDriver.h"
+#include "IMU/lsm6dso_reg.h"
+#include "LedFrame/LedFrame.h"
+#include "NAU78/NAU7802.h"
+#include "SeesawDriver/Seesaw.h"
+#include "SerialConsole/DataStream.h"
+}
+
+namespace {
+
+constexpr unsigned kScenarioPriority = configMAX_PRIORITIES - 3;  ///< Same as the UI, the sensor stream and the NAU7802 task
+
+bool simVerbose = false;  ///< Print the console messages of the drivers
+bool simNoSpeed = false;  ///< Every transfer at the default BAUD, whatever I2cSetDeviceSpeed asked
+
+/******************************************************************************
+ * Device models
+ ******************************************************************************/
+
+/// NeoTrellis Seesaw: one write is base, function, data. A read returns the register of the previous write
+class SeesawModel : public sim::Device {
+public:
+    static constexpr uint16_t kMaxWrite = 32;  ///< Longest write taken by the Seesaw firmware. Longer ones are NACKed
+
+    uint8_t buffer[NEO_TRELLIS_NUM_KEYS * 3] = {};  ///< NeoPixel buffer, written by SEESAW_NEOPIXEL_BUF
+    uint8_t shown[NEO_TRELLIS_NUM_KEYS * 3] = {};   ///< Pixels displayed by the last SEESAW_NEOPIXEL_SHOW
+    uint16_t bufLength = 0;                         ///< SEESAW_NEOPIXEL_BUF_LENGTH
+    uint32_t shows = 0;                             ///< SHOW commands
+    uint32_t tooLong = 0;                           ///< Writes NACKed because they were longer than kMaxWrite
+    uint8_t keyActive[32] = {};                     ///< Registered edges (bit per edge) of each Seesaw key number
+    bool keypadInterrupt = false;                   ///< SEESAW_KEYPAD_INTENSET written
+
+    const char *Name() const override { return "seesaw"; }
+
+    /// Presses (rising edge) or releases (falling edge) a key, 0 to 15. Queues an event if that edge is registered
+    void Key(uint8_t key, bool press)
+    {
+        uint8_t number = NEO_TRELLIS_KEY(key);
+        uint8_t edge = press ? SEESAW_KEYPAD_EDGE_RISING : SEESAW_KEYPAD_EDGE_FALLING;
+        if (keyActive[number] & (1 << edge)) fifo.push_back(uint8_t((number << 2) | edge));
+    }
+
+    bool AcceptByte(uint16_t index) override
+    {
+        if (index == 0) overflow = false;
+        if (index < kMaxWrite) return true;
+        if (!overflow) tooLong++;
+        overflow = true;
+        return false;
+    }
+
+    void Write(const uint8_t *data, uint16_t len) override
+    {
+        if (overflow || len < 2) return;  // The firmware drops a write it NACKed
+        base = data[0];
+        function = data[1];
+        const uint8_t *payload = data + 2;
+        uint16_t payloadLen = len - 2;
+
+        if (base == SEESAW_NEOPIXEL_BASE) {
+            if (function == SEESAW_NEOPIXEL_BUF_LENGTH && payloadLen >= 2) {
+                bufLength = uint16_t((payload[0] << 8) | payload[1]);
+            } else if (function == SEESAW_NEOPIXEL_BUF && payloadLen >= 2) {
+                uint16_t offset = uint16_t((payload[0] << 8) | payload[1]);
+                for (uint16_t i = 2; i < payloadLen; i++) {
+                    size_t index = size_t(offset) + i - 2;
+                    if (index < bufLength && index < sizeof(buffer)) buffer[index] = payload[i];
+                }
+            } else if (function == SEESAW_NEOPIXEL_SHOW) {
+                memcpy(shown, buffer, sizeof(shown));
+                shows++;
+            }
+        } else if (base == SEESAW_KEYPAD_BASE) {
+            if (function == SEESAW_KEYPAD_EVENT && payloadLen >= 2 && payload[0] < sizeof(keyActive)) {
+                uint8_t edges = (payload[1] >> 1) & 0x0F;
+                if (payload[1] & 0x01) {
+                    keyActive[payload[0]] |= edges;
+                } else {
+                    keyActive[payload[0]] &= uint8_t(~edges);
+                }
+            } else if (function == SEESAW_KEYPAD_INTENSET) {
+                keypadInterrupt = true;
+            }
+        }
+    }
+
+    void StartRead() override { readIndex = 0; }
+
+    uint8_t ReadByte() override
+    {
+        uint16_t index = readIndex++;
+
+        if (base == SEESAW_STATUS_BASE && function == SEESAW_STATUS_HW_ID) {
+            return (index == 0) ? SEESAW_HW_ID_CODE : 0;
+        }
+        if (base == SEESAW_KEYPAD_BASE && function == SEESAW_KEYPAD_COUNT) {
+            return (index == 0) ? uint8_t(fifo.size() < 255 ? fifo.size() : 255) : 0;
+        }
+        if (base == SEESAW_KEYPAD_BASE && function == SEESAW_KEYPAD_FIFO) {
+            if (fifo.empty()) return 0xFF;
+            uint8_t event = fifo.front();
+            fifo.pop_front();
+            return event;
+        }
+        return 0;
+    }
+
+private:
+    uint8_t base = 0;
+    uint8_t function = 0;
+    bool overflow = false;  ///< The write on the bus went past kMaxWrite
+    uint16_t readIndex = 0;
+    std::deque<uint8_t> fifo;
+};
+
+/// LSM6DSO: register pointer with auto-increment, three banks, output data generated at the ODR, FIFO with tags
+class Lsm6dsoModel : public sim::Device {
+public:
+    static constexpr size_t kFifoDepth = 512;  ///< FIFO words (tag + 6 bytes) without compression
+
+    uint32_t fifoOverruns = 0;  ///< Words dropped by the FIFO in continuous mode
+
+    Lsm6dsoModel() { Reset(); }
+
+    const char *Name() const override { return "lsm6dso"; }
+
+    void Write(const uint8_t *data, uint16_t len) override
+    {
+        if (len == 0) return;
+        pointer = data[0];
+        for (uint16_t i = 1; i < len; i++) {
+            WriteRegister(pointer, data[i]);
+            Advance();
+        }
+    }
+
+    uint8_t ReadByte() override
+    {
+        uint8_t value = ReadRegister(pointer);
+        Advance();
+        return value;
+    }
+
+private:
+    struct FifoWord {
+        uint8_t tag;
+        uint8_t data[6];
+    };
+
+    uint8_t regs[3][128];  ///< User, embedded functions and sensor hub banks
+    uint8_t pointer = 0;
+    std::deque<FifoWord> fifo;
+    FifoWord current = {};      ///< Word popped by the last read of FIFO_DATA_OUT_TAG
+    uint64_t fifoUs = 0;        ///< Time the FIFO was brought up to date
+    uint64_t xlReadSample = 0;  ///< Accelerometer sample last read from the output registers
+    uint64_t gyReadSample = 0;  ///< Gyroscope sample last read from the output registers
+
+    void Reset()
+    {
+        memset(regs, 0, sizeof(regs));
+        regs[0][LSM6DSO_WHO_AM_I] = LSM6DSO_ID;
+        regs[0][LSM6DSO_CTRL3_C] = 0x04;  // IF_INC
+        fifo.clear();
+        fifoUs = sim::NowUs();
+    }
+
+    uint8_t Bank() const
+    {
+        uint8_t access = regs[0][LSM6DSO_FUNC_CFG_ACCESS];
+        return (access & 0x80) ? 1 : ((access & 0x40) ? 2 : 0);
+    }
+
+    void Advance()
+    {
+        if (!(regs[0][LSM6DSO_CTRL3_C] & 0x04)) return;
+        // Burst reads of the FIFO output roll back to the tag, one word after the other
+        pointer = (pointer == LSM6DSO_FIFO_DATA_OUT_Z_H) ? LSM6DSO_FIFO_DATA_OUT_TAG : uint8_t((pointer + 1) & 0x7F);
+    }
+
+    /// Output data rate of an ODR or BDR code, in 0.1 Hz
+    static uint32_t RateDeciHz(uint8_t code)
+    {
+        static const uint32_t rates[16] = {0, 125, 260, 520, 1040, 2080, 4160, 8330, 16670, 33330, 66670, 16, 0, 0, 0, 0};
+        return rates[code & 0x0F];
+    }
+
+    /// Number of samples of a sensor at an ODR code since boot
+    static uint64_t SampleIndex(uint8_t code, uint64_t us) { return us * RateDeciHz(code) / 10000000u; }
+
+    /// Accelerometer: 1 g on Z and a slow swing on X. Gyroscope: a slow rotation on Z. Raw values at the set full scale
+    void Sample(bool gyro, uint64_t us, uint8_t *out) const
+    {
+        double t = double(us) / 1e6;
+        int16_t v[3];
+        if (gyro) {
+            v[0] = 0;
+            v[1] = 0;
+            v[2] = int16_t(10.0 * std::sin(t) / 0.070);  // 10 dps at 2000 dps full scale
+        } else {
+            static const double mgPerLsb[4] = {0.061, 0.488, 0.122, 0.244};  // FS_XL 2, 16, 4, 8 g
+            double sensitivity = mgPerLsb[(regs[0][LSM6DSO_CTRL1_XL] >> 2) & 3];
+            v[0] = int16_t(100.0 * std::sin(t) / sensitivity);
+            v[1] = 0;
+            v[2] = int16_t(1000.0 / sensitivity);
+        }
+        for (int i = 0; i < 3; i++) {
+            out[2 * i] = uint8_t(v[i]);
+            out[2 * i + 1] = uint8_t(uint16_t(v[i]) >> 8);
+        }
+    }
+
+    /// Adds the words batched since the last update. Bypass mode empties the FIFO
+    void UpdateFifo()
+    {
+        uint64_t now = sim::NowUs();
+        uint8_t mode = regs[0][LSM6DSO_FIFO_CTRL4] & 0x07;
+        uint8_t bdrXl = regs[0][LSM6DSO_FIFO_CTRL3] & 0x0F;
+        uint8_t bdrGy = regs[0][LSM6DSO_FIFO_CTRL3] >> 4;
+        bool xlOn = (regs[0][LSM6DSO_CTRL1_XL] >> 4) != 0;
+        bool gyOn = (regs[0][LSM6DSO_CTRL2_G] >> 4) != 0;
+
+        if (mode == 0) {
+            fifo.clear();
+        } else {
+            uint64_t xl = (bdrXl && xlOn) ? SampleIndex(bdrXl, now) - SampleIndex(bdrXl, fifoUs) : 0;
+            uint64_t gy = (bdrGy && gyOn) ? SampleIndex(bdrGy, now) - SampleIndex(bdrGy, fifoUs) : 0;
+            for (uint64_t i = 0; i < xl || i < gy; i++) {
+                for (int gyro = 1; gyro >= 0; gyro--) {
+                    if (i >= (gyro ? gy : xl)) continue;
+                    FifoWord word;
+                    word.tag = uint8_t((gyro ? LSM6DSO_GYRO_NC_TAG : LSM6DSO_XL_NC_TAG) << 3);
+                    Sample(gyro, now, word.data);
+                    if (fifo.size() >= kFifoDepth) {
+                        if (mode == 1) break;  // FIFO mode: stops when full
+                        fifo.pop_front();      // Continuous: the oldest word is lost
+                        fifoOverruns++;
+                    }
+                    fifo.push_back(word);
+                }
+            }
+        }
+        fifoUs = now;
+    }
+
+    void WriteRegister(uint8_t reg, uint8_t value)
+    {
+        if (reg == LSM6DSO_FUNC_CFG_ACCESS) {
+            regs[0][reg] = value;
+            return;
+        }
+        uint8_t bank = Bank();
+        if (bank != 0) {
+            regs[bank][reg] = value;
+            return;
+        }
+        UpdateFifo();  // Samples before a configuration change use the old one
+        if (reg == LSM6DSO_CTRL3_C && (value & 0x01)) {
+            Reset();  // SW_RESET reads back as 0 once done
+            return;
+        }
+        regs[0][reg] = value;
+        if (reg == LSM6DSO_FIFO_CTRL4) UpdateFifo();
+    }
+
+    uint8_t ReadRegister(uint8_t reg)
+    {
+        if (reg == LSM6DSO_FUNC_CFG_ACCESS) return regs[0][reg];
+        uint8_t bank = Bank();
+        if (bank != 0) return regs[bank][reg];
+
+        uint64_t now = sim::NowUs();
+        uint8_t odrXl = regs[0][LSM6DSO_CTRL1_XL] >> 4;
+        uint8_t odrGy = regs[0][LSM6DSO_CTRL2_G] >> 4;
+        uint64_t xlSample = SampleIndex(odrXl, now);
+        uint64_t gySample = SampleIndex(odrGy, now);
+        uint8_t out[6];
+
+        if (reg == LSM6DSO_STATUS_REG) {
+            return uint8_t((odrXl && xlSample != xlReadSample) ? 0x01 : 0) | uint8_t((odrGy && gySample != gyReadSample) ? 0x02 : 0);
+        }
+        if (reg >= LSM6DSO_OUTX_L_G && reg < LSM6DSO_OUTX_L_G + 6) {
+            gyReadSample = gySample;
+            Sample(true, now, out);
+            return out[reg - LSM6DSO_OUTX_L_G];
+        }
+        if (reg >= LSM6DSO_OUTX_L_A && reg < LSM6DSO_OUTX_L_A + 6) {
+            xlReadSample = xlSample;
+            Sample(false, now, out);
+            return out[reg - LSM6DSO_OUTX_L_A];
+        }
+        if (reg == LSM6DSO_FIFO_STATUS1 || reg == LSM6DSO_FIFO_STATUS2) {
+            UpdateFifo();
+            uint16_t level = uint16_t(fifo.size());
+            uint16_t watermark = uint16_t(regs[0][LSM6DSO_FIFO_CTRL1] | ((regs[0][LSM6DSO_FIFO_CTRL2] & 0x01) << 8));
+            if (reg == LSM6DSO_FIFO_STATUS1) return uint8_t(level);
+            return uint8_t(((level >> 8) & 0x03) | (fifo.size() >= kFifoDepth ? 0x20 : 0) | (watermark != 0 && level >= watermark ? 0x80 : 0));
+        }
+        if (reg == LSM6DSO_FIFO_DATA_OUT_TAG) {
+            UpdateFifo();
+            current = FifoWord{};
+            if (!fifo.empty()) {
+                current = fifo.front();
+                fifo.pop_front();
+            }
+            return current.tag;
+        }
+        if (reg >= LSM6DSO_FIFO_DATA_OUT_X_L && reg <= LSM6DSO_FIFO_DATA_OUT_Z_H) {
+            return current.data[reg - LSM6DSO_FIFO_DATA_OUT_X_L];
+        }
+        return regs[0][reg];
+    }
+};
+
+/// NAU7802: one register per address, power-up and calibration take time, conversions run while CS is set
+class Nau7802Model : public sim::Device {
+public:
+    static constexpr uint32_t kPowerUpUs = 200;        ///< PUD to PUR
+    static constexpr uint32_t kCalibrationPeriods = 2; ///< Conversion periods of an internal offset calibration
+    static constexpr int32_t kCountsPerGram = 100;     ///< Modeled load cell and gain
+
+    int32_t grams = 250;       ///< Load on the cell
+    double clockScale = 1.0;  ///< Conversion period relative to the nominal one (oscillator error)
+    uint64_t missed = 0;      ///< Conversions overwritten before ADCO was read
+
+    Nau7802Model() { Reset(); }
+
+    const char *Name() const override { return "nau7802"; }
+
+    bool IsConverting() const { return Converting(); }
+
+    void Write(const uint8_t *data, uint16_t len) override
+    {
+        if (len == 0) return;
+        pointer = data[0];
+        for (uint16_t i = 1; i < len; i++) {
+            WriteRegister(pointer, data[i]);
+            pointer = uint8_t((pointer + 1) & 0x1F);
+        }
+    }
+
+    uint8_t ReadByte() override
+    {
+        uint8_t value = ReadRegister(pointer);
+        pointer = uint8_t((pointer + 1) & 0x1F);
+        return value;
+    }
+
+private:
+    uint8_t regs[32] = {};
+    uint8_t pointer = 0;
+    uint64_t powerUpUs = 0;          ///< Time PUD was set
+    uint64_t cycleStartUs = 0;       ///< Time CS was set
+    uint64_t readConversion = 0;     ///< Conversion last read from ADCO
+    uint64_t calibrationDoneUs = 0;  ///< End of the running calibration
+
+    void Reset()
+    {
+        uint8_t pu = regs[PU_CTRL_ADDR];
+        memset(regs, 0, sizeof(regs));
+        regs[PU_CTRL_ADDR] = pu & 0x01;
+        regs[GCAL1_B2_ADDR] = 0x80;  // Gain calibration 1.0
+        regs[DEVICE_REVISION_ADDR] = 0x0F;
+    }
+
+    uint32_t PeriodUs() const
+    {
+        static const uint32_t rates[8] = {10, 20, 40, 80, 10, 10, 10, 320};
+        return uint32_t(1000000.0 * clockScale / rates[(regs[CTRL2_ADDR] >> 4) & 0x07]);
+    }
+
+    bool Converting() const { return (regs[PU_CTRL_ADDR] & 0x16) == 0x16; }  // PUD, PUA and CS
+
+    uint64_t Conversion() const { return Converting() ? (sim::NowUs() - cycleStartUs) / PeriodUs() : 0; }
+
+    void WriteRegister(uint8_t reg, uint8_t value)
+    {
+        if (reg == PU_CTRL_ADDR) {
+            uint8_t previous = regs[reg];
+            if (value & 0x01) {
+                regs[reg] = 0x01;
+                Reset();
+                return;
+            }
+            regs[reg] = uint8_t((value & 0xD7) | (previous & 0x28));  // PUR and CR are read only
+            if ((value & 0x02) && !(previous & 0x02)) powerUpUs = sim::NowUs();
+            if ((value & CS_Msk) && !(previous & CS_Msk)) {
+                cycleStartUs = sim::NowUs();
+                readConversion = 0;
+            }
+            return;
+        }
+        if (reg == CTRL2_ADDR) {
+            regs[reg] = uint8_t(value & ~CAL_ERR_Msk);
+            if (value & CALS_Msk) calibrationDoneUs = sim::NowUs() + kCalibrationPeriods * PeriodUs();
+            return;
+        }
+        if (reg >= ADCO_B2_ADDR && reg <= ADCO_B0_ADDR) return;  // Read only
+        regs[reg] = value;
+    }
+
+    uint8_t ReadRegister(uint8_t reg)
+    {
+        if (reg == PU_CTRL_ADDR) {
+            uint8_t value = uint8_t(regs[reg] & ~0x28);
+            if ((regs[reg] & 0x02) && sim::NowUs() - powerUpUs >= kPowerUpUs) value |= 0x08;  // PUR
+            if (Conversion() > readConversion) value |= CR_DATA_RDY;
+            return value;
+        }
+        if (reg == CTRL2_ADDR) {
+            if ((regs[reg] & CALS_Msk) && sim::NowUs() >= calibrationDoneUs) regs[reg] &= uint8_t(~CALS_Msk);
+            return regs[reg];
+        }
+        if (reg >= ADCO_B2_ADDR && reg <= ADCO_B0_ADDR) {
+            int32_t sample = grams * kCountsPerGram + int32_t(Conversion() % 7) - 3;  // A few counts of noise
+            if (reg == ADCO_B0_ADDR) {                                               // Reading the last byte clears CR
+                if (Conversion() > readConversion + 1) missed += Conversion() - readConversion - 1;
+                readConversion = Conversion();
+            }
+            return uint8_t(uint32_t(sample) >> (8 * (ADCO_B0_ADDR - reg)));
+        }
+        return regs[reg];
+    }
+};
+
+/******************************************************************************
+ * Simulated board
+ ******************************************************************************/
+
+std::map<uint8_t, std::unique_ptr<sim::Device>> simDevices;
+SeesawModel *simSeesaw = nullptr;
+Lsm6dsoModel *simImu = nullptr;
+Nau7802Model *simAdc = nullptr;
+
+/// Devices on the sensor bus, as after a power cycle
+void SimReset()
+{
+    simSeesaw = new SeesawModel();
+    simImu = new Lsm6dsoModel();
+    simAdc = new Nau7802Model();
+    simDevices[NEO_TRELLIS_ADDR].reset(simSeesaw);
+    simDevices[LSM6DSO_I2C_ADD_H >> 1].reset(simImu);
+    simDevices[ADC_SLAVE_ADDR].reset(simAdc);
+    for (const auto &entry : simDevices) sim::AttachDevice(entry.first, entry.second.get());
+}
+
+/// Starts the bus, driver and CPU statistics again
+void ClearStats()
+{
+    sim::ClearBus();
+    sim::ResetCpu();
+    I2cResetStats();
+}
+
+/// Median of per-iteration counts: one read that meets an interrupt at an unlucky instant does not tip a comparison
+uint64_t Median(std::vector<uint64_t> values)
+{
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    return values[values.size() / 2];
+}
+
+const sim::BusStats &BusOf(uint8_t address)
+{
+    static const sim::BusStats none;
+    auto it = sim::Bus().find(address);
+    return (it != sim::Bus().end()) ? it->second : none;
+}
+
+/// SCL frequency the driver configured for a device
+uint32_t SpeedHzOf(uint8_t address)
+{
+    I2C_SpeedProfile profiles[I2C_MAX_SPEED_PROFILES];
+    uint8_t count = I2cGetSpeedProfiles(profiles, I2C_MAX_SPEED_PROFILES);
+
+    if (count == 0) return 0;
+    for (uint8_t i = 1; i < count && !simNoSpeed; i++) {
+        if (profiles[i].address == address) return profiles[i].actualHz;
+    }
+    return profiles[0].actualHz;
+}
+
+/// Transaction statistics of the driver for a device
+I2C_DeviceStats DriverStatsOf(uint8_t address)
+{
+    I2C_DeviceStats stats;
+
+    for (uint8_t i = 0; I2cGetDeviceStats(i, &stats); i++) {
+        if (stats.address == address) return stats;
+    }
+    memset(&stats, 0, sizeof(stats));
+    return stats;
+}
+
+/******************************************************************************
+ * Scenarios
+ ******************************************************************************/
+
+int simFailures = 0;
+
+void Check(bool condition, const char *what)
+{
+    if (!condition) {
+        printf("  FAIL: %s\n", what);
+        simFailures++;
+    }
+}
+
+double Percent(uint64_t part, uint64_t whole)
+{
+    return whole ? 100.0 * double(part) / double(whole) : 0.0;
+}
+
+void PrintStats()
+{
+    printf("  %-8s %4s %8s %6s %6s %6s %8s %10s %8s %8s %6s %6s %6s\n", "device", "addr", "speed", "starts", "Sr", "errors", "bytes", "bus us",
+           "max us", "queue us", "irqs", "dma", "kB/s");
+    for (const auto &entry : sim::Bus()) {
+        const sim::BusStats &bus = entry.second;
+        I2C_DeviceStats driver = DriverStatsOf(entry.first);
+        auto it = simDevices.find(entry.first);
+        uint64_t busUs = bus.busNs / 1000;
+        printf("  %-8s 0x%02x %7luk %6lu %6lu %6lu %8lu %10llu %8lu %8lu %6lu %6lu %6llu\n",
+               it != simDevices.end() ? it->second->Name() : "-",
+               entry.first,
+               (unsigned long)(SpeedHzOf(entry.first) / 1000),
+               (unsigned long)bus.starts,
+               (unsigned long)bus.restarts,
+               (unsigned long)driver.errors,
+               (unsigned long)bus.bytes,
+               (unsigned long long)busUs,
+               (unsigned long)driver.maxUs,
+               (unsigned long)driver.queueWaitUs,
+               (unsigned long)bus.sercomIrqs,
+               (unsigned long)bus.dmaBeats,
+               (unsigned long long)(busUs ? uint64_t(bus.bytes) * 1000 / busUs : 0));
+    }
+
+    const sim::CpuStats &cpu = sim::Cpu();
+    uint64_t elapsed = cpu.ElapsedNs();
+    printf("  CPU over %.1f ms:", elapsed / 1e6);
+    for (const auto &task : cpu.taskNs) printf(" %s %.2f%%,", task.first.c_str(), Percent(task.second, elapsed));
+    for (const auto &irq : cpu.irq) {
+        printf(" %s %.2f%% (%llu),", irq.first.c_str(), Percent(irq.second.ns, elapsed), (unsigned long long)irq.second.count);
+    }
+    printf(" switches %.2f%% (%llu), idle %.1f%%\n", Percent(cpu.switchNs, elapsed), (unsigned long long)cpu.switches,
+           Percent(cpu.idleNs, elapsed));
+}
+
+/// True if the Seesaw displays frame: red, green and blue of each key, colors derived from the frame number
+bool SeesawShows(int frame)
+{
+    bool match = true;
+    for (uint8_t key = 0; key < NEO_TRELLIS_NUM_KEYS; key++) {
+        const uint8_t *pixel = &simSeesaw->shown[3 * key];
+        match &= pixel[0] == key * 8 && pixel[1] == frame * 10 && pixel[2] == 255 - frame * 10;  // GRB
+    }
+    return match;
+}
+
+/// InitializeSeesaw, then full LED frames through the per-key path (SeesawSetLed, SeesawOrderLedUpdate) and the
+/// frame path (SeesawSetFrame)
+void ScenarioSeesaw()
+{
+    const int frames = 10;
+    uint64_t start = sim::NowUs();
+
+    Check(InitializeSeesaw() == ERROR_NONE, "InitializeSeesaw");
+    printf("  InitializeSeesaw: %.1f ms\n", (sim::NowUs() - start) / 1000.0);
+    int keys = 0;
+    for (uint8_t key = 0; key < NEO_TRELLIS_NUM_KEYS; key++) {
+        uint8_t both = (1 << SEESAW_KEYPAD_EDGE_RISING) | (1 << SEESAW_KEYPAD_EDGE_FALLING);
+        if ((simSeesaw->keyActive[NEO_TRELLIS_KEY(key)] & both) == both) keys++;
+    }
+    Check(keys == NEO_TRELLIS_NUM_KEYS, "every key reports both edges");
+
+    sim::ClearBus();
+    start = sim::NowUs();
+    for (int frame = 0; frame < frames; frame++) {
+        for (uint8_t key = 0; key < NEO_TRELLIS_NUM_KEYS; key++) {
+            SeesawSetLed(key, uint8_t(frame * 10), uint8_t(key * 8), uint8_t(255 - frame * 10));
+        }
+        SeesawOrderLedUpdate();
+    }
+    uint64_t perKeyUs = (sim::NowUs() - start) / frames;
+    uint32_t perKeyTransfers = BusOf(NEO_TRELLIS_ADDR).starts / frames;
+    Check(SeesawShows(frames - 1), "per-key path: displayed pixels are the last frame");
+
+    sim::ClearBus();
+    start = sim::NowUs();
+    for (int frame = 0; frame < frames; frame++) {
+        uint8_t rgb[NEO_TRELLIS_NUM_KEYS * 3];
+        for (uint8_t key = 0; key < NEO_TRELLIS_NUM_KEYS; key++) {
+            rgb[3 * key] = uint8_t(frame * 10);
+            rgb[3 * key + 1] = uint8_t(key * 8);
+            rgb[3 * key + 2] = uint8_t(255 - frame * 10);
+        }
+        Check(SeesawSetFrame(rgb) == ERROR_NONE, "SeesawSetFrame");
+    }
+    uint64_t frameUs = (sim::NowUs() - start) / frames;
+    uint32_t frameTransfers = BusOf(NEO_TRELLIS_ADDR).starts / frames;
+    Check(SeesawShows(frames - 1), "frame path: displayed pixels are the last frame");
+    Check(frameTransfers == 3, "frame path: 2 buffer writes and one SHOW");
+    Check(I2C_DMA_THRESHOLD > SeesawModel::kMaxWrite || BusOf(NEO_TRELLIS_ADDR).dmaBeats > 0, "frame path: the buffer writes go through the DMAC");
+
+    printf("  LED frame, 16 x SeesawSetLed + SeesawOrderLedUpdate: %llu us, %lu transfers\n", (unsigned long long)perKeyUs, (unsigned long)perKeyTransfers);
+    printf("  LED frame, SeesawSetFrame: %llu us, %lu transfers (%.1fx faster)\n",
+           (unsigned long long)frameUs,
+           (unsigned long)frameTransfers,
+           frameUs ? double(perKeyUs) / frameUs : 0.0);
+    Check(simSeesaw->tooLong == 0, "no write longer than the Seesaw takes");
+}
+
+/// Key events through SeesawGetKeypadCount and SeesawReadKeypad
+void ScenarioKeypad()
+{
+    InitializeSeesaw();
+    ClearStats();
+
+    simSeesaw->Key(0, true);
+    simSeesaw->Key(5, true);
+    simSeesaw->Key(0, false);
+
+    uint64_t start = sim::NowUs();
+    uint8_t count = SeesawGetKeypadCount();
+    uint8_t events[8] = {};
+    Check(count == 3, "three events counted");
+    Check(SeesawReadKeypad(events, count) == ERROR_NONE, "SeesawReadKeypad");
+    printf("  Keypad poll (count + FIFO): %.1f us\n", double(sim::NowUs() - start));
+    Check(events[0] == ((NEO_TRELLIS_KEY(0) << 2) | SEESAW_KEYPAD_EDGE_RISING), "event 1 is key 0 pressed");
+    Check(events[1] == ((NEO_TRELLIS_KEY(5) << 2) | SEESAW_KEYPAD_EDGE_RISING), "event 2 is key 5 pressed");
+    Check(events[2] == ((NEO_TRELLIS_KEY(0) << 2) | SEESAW_KEYPAD_EDGE_FALLING), "event 3 is key 0 released");
+
+    start = sim::NowUs();
+    for (int i = 0; i < 100; i++) SeesawGetKeypadCount();
+    printf("  Idle poll (count only): %.1f us\n", double(sim::NowUs() - start) / 100);
+}
+
+/// A burst of key edges, one every 5 ms, echoed on the LEDs: directly (SeesawSetLed + SeesawOrderLedUpdate per edge)
+/// and through the LedFrame shadow, flushed by a loop that runs every tick. Then one idle second of flushes
+void ScenarioLeds()
+{
+    const int edges = 32;
+    const TickType_t edgePeriod = 5;
+
+    InitializeSeesaw();
+
+    ClearStats();
+    uint64_t start = sim::NowUs();
+    for (int i = 0; i < edges; i++) {
+        uint8_t key = uint8_t((i / 2) % NEO_TRELLIS_NUM_KEYS);
+        bool press = (i % 2) == 0;
+        SeesawSetLed(key, 0, press ? 100 : 0, press ? 50 : 0);
+        SeesawOrderLedUpdate();
+        vTaskDelay(edgePeriod);
+    }
+    uint32_t directTransfers = BusOf(NEO_TRELLIS_ADDR).starts;
+    uint64_t directBusUs = BusOf(NEO_TRELLIS_ADDR).busNs / 1000;
+    printf("  Direct: %d edges in %.0f ms, %lu transfers, %llu us of bus\n", edges, (sim::NowUs() - start) / 1000.0,
+           (unsigned long)directTransfers, (unsigned long long)directBusUs);
+
+    sim::ClearBus();
+    start = sim::NowUs();
+    uint32_t shows = simSeesaw->shows;
+    for (int i = 0; i < edges; i++) {
+        uint8_t key = uint8_t((i / 2) % NEO_TRELLIS_NUM_KEYS);
+        bool press = (i % 2) == 0;
+        LedFrameSet(key, 0, press ? 100 : 0, press ? 50 : 0);
+        for (TickType_t tick = 0; tick < edgePeriod; tick++) {
+            Check(LedFrameFlush() == ERROR_NONE, "LedFrameFlush");
+            vTaskDelay(1);
+        }
+    }
+    Check(LedFrameShow() == ERROR_NONE, "LedFrameShow");
+    uint32_t frames = simSeesaw->shows - shows;
+    printf("  LedFrame at %d Hz: %lu frames, %lu transfers, %llu us of bus\n", LED_FRAME_RATE_HZ, (unsigned long)frames,
+           (unsigned long)BusOf(NEO_TRELLIS_ADDR).starts, (unsigned long long)(BusOf(NEO_TRELLIS_ADDR).busNs / 1000));
+    Check(frames <= (sim::NowUs() - start) / 1000 / LED_FRAME_PERIOD + 1, "frame rate limited");
+    Check(!LedFrameIsDirty(), "shadow flushed");
+    bool allOff = true;
+    for (uint8_t byte : simSeesaw->shown) allOff &= byte == 0;
+    Check(allOff, "every key released: LEDs off");
+
+    sim::ClearBus();
+    for (int i = 0; i < 1000; i++) {
+        LedFrameFlush();
+        vTaskDelay(1);
+    }
+    Check(BusOf(NEO_TRELLIS_ADDR).starts == 0, "no I2C traffic while nothing changes");
+}
+
+/// InitImu, then one second of polling the data ready flag and the accelerometer every 10 ms
+void ScenarioImu()
+{
+    stmdev_ctx_t *ctx = GetImuStruct();
+    uint8_t id = 0;
+    uint64_t start = sim::NowUs();
+
+    Check(InitImu() == 0, "InitImu");
+    printf("  InitImu: %.1f ms\n", (sim::NowUs() - start) / 1000.0);
+    lsm6dso_device_id_get(ctx, &id);
+    Check(id == LSM6DSO_ID, "WHO_AM_I");
+
+    ClearStats();
+    start = sim::NowUs();
+    int samples = 0;
+    int16_t acc[3] = {};
+    for (int i = 0; i < 100; i++) {
+        uint8_t ready = 0;
+        vTaskDelay(10);
+        lsm6dso_xl_flag_data_ready_get(ctx, &ready);
+        if (ready) {
+            lsm6dso_acceleration_raw_get(ctx, acc);
+            samples++;
+        }
+    }
+    printf("  Polling at 100 Hz for the 12.5 Hz ODR: %d samples in %.0f ms\n", samples, (sim::NowUs() - start) / 1000.0);
+    Check(samples >= 11 && samples <= 14, "about 12 samples per second");
+    Check(std::abs(acc[2] - 16393) < 10, "1 g on Z");
+}
+
+/// Accelerometer batched in the FIFO at 104 Hz, read back word by word
+void ScenarioFifo()
+{
+    stmdev_ctx_t *ctx = GetImuStruct();
+    uint16_t level = 0;
+
+    InitImu();
+    lsm6dso_xl_data_rate_set(ctx, LSM6DSO_XL_ODR_104Hz);
+    lsm6dso_fifo_xl_batch_set(ctx, LSM6DSO_XL_BATCHED_AT_104Hz);
+    lsm6dso_fifo_mode_set(ctx, LSM6DSO_STREAM_MODE);
+    vTaskDelay(200);
+
+    ClearStats();
+    uint64_t start = sim::NowUs();
+    lsm6dso_fifo_data_level_get(ctx, &level);
+    Check(level >= 19 && level <= 22, "about 20 words after 200 ms at 104 Hz");
+
+    int xlWords = 0;
+    uint8_t raw[6] = {};
+    for (uint16_t i = 0; i < level; i++) {
+        lsm6dso_fifo_tag_t tag;
+        lsm6dso_fifo_sensor_tag_get(ctx, &tag);
+        lsm6dso_fifo_out_raw_get(ctx, raw);
+        if (tag == LSM6DSO_XL_NC_TAG) xlWords++;
+    }
+    uint32_t words = level ? level : 1;
+    printf("  FIFO drain: %u words in %.1f us, %.1f us per word\n", level, double(sim::NowUs() - start), double(sim::NowUs() - start) / words);
+    Check(xlWords == level, "every word is tagged accelerometer");
+    Check(int16_t(raw[4] | (raw[5] << 8)) > 16000, "1 g on Z in the FIFO");
+}
+
+/// Register reads as one write, repeated START, read transfer against a write and a separate read, each with its
+/// STOP. Then a 256-byte write-read: longer than ADDR.LEN, so the DMAC moves 255 bytes and the driver NACKs the last
+void ScenarioRestart()
+{
+    const int reads = 100;
+    const uint8_t whoAmI = LSM6DSO_WHO_AM_I;
+    const uint8_t imuAddress = LSM6DSO_I2C_ADD_H >> 1;
+    uint8_t id = 0;
+
+    InitImu();
+
+    std::vector<uint64_t> combinedPerRead, splitPerRead;
+    ClearStats();
+    uint64_t start = sim::NowUs();
+    bool ids = true;
+    for (int i = 0; i < reads; i++) {
+        uint64_t switches = sim::Cpu().switches;
+        id = 0;
+        Check(I2cReadRegister(imuAddress, &whoAmI, 1, &id, 1, 0, 100) == ERROR_NONE, "I2cReadRegister");
+        ids &= id == LSM6DSO_ID;
+        combinedPerRead.push_back(sim::Cpu().switches - switches);
+    }
+    uint64_t combinedUs = (sim::NowUs() - start) / reads;
+    uint64_t combinedSwitches = sim::Cpu().switches;
+    Check(ids, "every write-read returns WHO_AM_I");
+    Check(BusOf(imuAddress).starts == reads && BusOf(imuAddress).restarts == reads, "one START and one repeated START per read");
+
+    ClearStats();
+    start = sim::NowUs();
+    ids = true;
+    for (int i = 0; i < reads; i++) {
+        I2C_Data pointer = {imuAddress, &whoAmI, NULL, 0, 1};
+        I2C_Transaction value;
+        uint64_t switches = sim::Cpu().switches;
+        id = 0;
+        Check(I2cWriteDataWait(&pointer, 100) == ERROR_NONE, "I2cWriteDataWait");
+        I2cTransactionInit(&value, imuAddress, NULL, 0, &id, 1, 0, 100);
+        Check(I2cSubmitTransaction(&value, 100) == ERROR_NONE && I2cWaitTransaction(&value) == ERROR_NONE, "read transaction");
+        ids &= id == LSM6DSO_ID;
+        splitPerRead.push_back(sim::Cpu().switches - switches);
+    }
+    uint64_t splitUs = (sim::NowUs() - start) / reads;
+    uint64_t splitSwitches = sim::Cpu().switches;
+    Check(ids, "every write then read returns WHO_AM_I");
+    Check(BusOf(imuAddress).starts == 2 * reads && BusOf(imuAddress).restarts == 0, "two transfers with their STOP per read");
+
+    printf("  Register read, write + Sr + read: %llu us, %.1f context switches\n", (unsigned long long)combinedUs, double(combinedSwitches) / reads);
+    printf("  Register read, write + STOP, read + STOP: %llu us, %.1f context switches\n", (unsigned long long)splitUs, double(splitSwitches) / reads);
+    Check(2 * Median(combinedPerRead) <= Median(splitPerRead), "at least half the context switches (median per read)");
+    Check(combinedUs < splitUs, "lower latency");
+
+    // The NAU7802 pointer wraps at 0x1F: DEVICE_REVISION every 32 bytes, the NACKed last byte included
+    const uint8_t first = PU_CTRL_ADDR;
+    uint8_t burst[256];
+    ClearStats();
+    memset(burst, 0, sizeof(burst));
+    Check(I2cReadRegister(ADC_SLAVE_ADDR, &first, 1, burst, sizeof(burst), 0, 100) == ERROR_NONE, "256-byte write-read");
+    bool wrapped = true;
+    for (size_t i = DEVICE_REVISION_ADDR; i < sizeof(burst); i += 32) wrapped &= burst[i] == 0x0F;
+    Check(wrapped, "256-byte write-read: every byte in place, the last one included");
+    Check(BusOf(ADC_SLAVE_ADDR).starts == 1 && BusOf(ADC_SLAVE_ADDR).restarts == 1, "256-byte write-read: one repeated START");
+    Check((I2C_DMA_THRESHOLD > sizeof(burst)) || BusOf(ADC_SLAVE_ADDR).dmaBeats == sizeof(burst) - 1, "256-byte write-read: 255 bytes on the DMAC");
+}
+
+/// 511-byte burst of the LSM6DSO FIFO (73 words of tag and data) at 400 kHz, in one register read: the CPU load of
+/// the DMAC path. Build I2cDriver.o with -DI2C_DMA_THRESHOLD=65535 for the same drain on the byte interrupts
+void ScenarioDrain()
+{
+    const uint16_t words = 73;
+    stmdev_ctx_t *ctx = GetImuStruct();
+    uint8_t burst[words * 7];
+    uint16_t level = 0;
+
+    InitImu();
+    Check(I2cSetDeviceSpeed(LSM6DSO_I2C_ADD_H >> 1, 400000) == ERROR_NONE, "I2cSetDeviceSpeed");
+    lsm6dso_xl_data_rate_set(ctx, LSM6DSO_XL_ODR_833Hz);
+    lsm6dso_gy_data_rate_set(ctx, LSM6DSO_GY_ODR_833Hz);
+    lsm6dso_fifo_xl_batch_set(ctx, LSM6DSO_XL_BATCHED_AT_833Hz);
+    lsm6dso_fifo_gy_batch_set(ctx, LSM6DSO_GY_BATCHED_AT_833Hz);
+    lsm6dso_fifo_mode_set(ctx, LSM6DSO_STREAM_MODE);
+    vTaskDelay(pdMS_TO_TICKS(60));
+    lsm6dso_fifo_data_level_get(ctx, &level);
+    Check(level >= words, "73 words batched after 60 ms at 2 x 833 Hz");
+
+    ClearStats();
+    uint64_t start = sim::NowUs();
+    Check(lsm6dso_read_reg(ctx, LSM6DSO_FIFO_DATA_OUT_TAG, burst, sizeof(burst)) == 0, "FIFO burst read");
+    uint64_t drainUs = sim::NowUs() - start;
+
+    bool tagged = true;
+    for (uint16_t i = 0; i < words; i++) {
+        uint8_t tag = burst[7 * i] >> 3;
+        tagged &= tag == LSM6DSO_XL_NC_TAG || tag == LSM6DSO_GYRO_NC_TAG;
+    }
+    Check(tagged, "every word of the burst is tagged");
+    Check((I2C_DMA_THRESHOLD > sizeof(burst)) || BusOf(LSM6DSO_I2C_ADD_H >> 1).dmaBeats == sizeof(burst) - 1,
+          "the DMAC moves all but the NACKed last byte");
+
+    const sim::CpuStats &cpu = sim::Cpu();
+    uint64_t busyNs = cpu.ElapsedNs() - cpu.idleNs;
+    printf("  FIFO drain, %u bytes at 400 kHz on the %s: %llu us, %lu SERCOM interrupts, CPU busy %llu us (%.1f%%)\n",
+           (unsigned)sizeof(burst),
+           (I2C_DMA_THRESHOLD > sizeof(burst)) ? "byte interrupts" : "DMAC",
+           (unsigned long long)drainUs,
+           (unsigned long)BusOf(LSM6DSO_I2C_ADD_H >> 1).sercomIrqs,
+           (unsigned long long)(busyNs / 1000),
+           Percent(busyNs, cpu.ElapsedNs()));
+}
+
+/// NAU7802: a one-shot get_weight, then the stream: one initialization and calibration, continuous conversion, polls
+/// aligned to the conversion period. get_raw_data reads the newest sample of the stream without taking it from the queue
+void ScenarioNau()
+{
+    const uint64_t periodUs = 1000000 / NAU78_SPS;
+    struct nau78_sample sample;
+
+    simAdc->clockScale = 0.97;  // ADC oscillator 3 % fast
+    uint64_t start = sim::NowUs();
+    float weight = get_weight();
+    printf("  First get_weight (init, calibration, one conversion): %.1f ms, weight %.2f\n", (sim::NowUs() - start) / 1000.0, weight);
+    Check(sim::SercomInits() == 1, "the NAU7802 driver does not initialize the I2C driver");
+    Check(!simAdc->IsConverting(), "a one-shot read leaves the ADC stopped");
+    Check(!NAU78_stream_read(&sample, 0), "a one-shot read queues nothing");
+
+    Check(NAU78_stream_start() == ERROR_NONE, "NAU78_stream_start");
+
+    // 100 periods, read a few periods at a time
+    const int periods = 100;
+    ClearStats();
+    int count = 0;
+    bool consecutive = true, loaded = true;
+    uint16_t previous = 0;
+    for (int i = 0; i < periods; i += NAU78_STREAM_QUEUE_LENGTH / 2) {
+        vTaskDelay(pdMS_TO_TICKS(NAU78_STREAM_QUEUE_LENGTH / 2 * periodUs / 1000));
+        while (NAU78_stream_read(&sample, 0)) {
+            if (count > 0 && uint16_t(sample.sequence - previous) != 1) consecutive = false;
+            if (std::abs(sample.raw - simAdc->grams * Nau7802Model::kCountsPerGram) > 3) loaded = false;
+            previous = sample.sequence;
+            count++;
+        }
+    }
+    const sim::BusStats &stats = BusOf(ADC_SLAVE_ADDR);
+    double perSample = count ? double(stats.starts) / count : 0;
+    printf("  Stream: %d samples in %d periods, %.1f transfers and %.0f us of bus per sample, %llu conversions missed\n",
+           count,
+           periods,
+           perSample,
+           count ? double(stats.busNs) / 1000 / count : 0.0,
+           (unsigned long long)simAdc->missed);
+    Check(count >= periods, "one sample per conversion");
+    Check(consecutive, "no sample dropped");
+    Check(loaded, "samples of the load");
+    Check(perSample <= 4, "at most four transfers per sample");
+    Check(simAdc->missed == 0, "the polls keep up with a fast ADC oscillator");
+
+    vTaskDelay(pdMS_TO_TICKS(2 * periodUs / 1000));
+    start = sim::NowUs();
+    int32_t raw = get_raw_data();
+    printf("  get_raw_data while streaming: %.1f ms, raw %ld\n", (sim::NowUs() - start) / 1000.0, (long)raw);
+    Check(sim::NowUs() - start <= periodUs, "a sample within one conversion period");
+    Check(std::abs(raw - simAdc->grams * Nau7802Model::kCountsPerGram) <= 3, "raw sample of the load");
+    int queued = 0;
+    while (NAU78_stream_read(&sample, 0)) queued++;
+    Check(queued >= 2, "get_raw_data leaves the queued samples to the stream consumer");
+
+    NAU78_stream_stop();
+    vTaskDelay(pdMS_TO_TICKS(periodUs / 1000));
+    Check(!simAdc->IsConverting(), "conversions stop");
+
+    start = sim::NowUs();
+    raw = get_raw_data();
+    printf("  get_raw_data with the stream stopped: %.1f ms, raw %ld\n", (sim::NowUs() - start) / 1000.0, (long)raw);
+    Check(std::abs(raw - simAdc->grams * Nau7802Model::kCountsPerGram) <= 3, "one-shot sample of the load");
+    Check(!simAdc->IsConverting(), "the ADC stays stopped");
+    Check(!NAU78_stream_read(&sample, 0), "the stream stays stopped");
+}
+
+struct Scenario {
+    const char *name;
+    void (*run)();
+};
+
+const Scenario kScenarios[] = {
+    {"seesaw", ScenarioSeesaw},
+    {"keypad", ScenarioKeypad},
+    {"leds", ScenarioLeds},
+    {"imu", ScenarioImu},
+    {"restart", ScenarioRestart},
+    {"fifo", ScenarioFifo},
+    {"drain", ScenarioDrain},
+    {"nau", ScenarioNau},
+};
+
+const Scenario *simScenario = nullptr;
+
+/// Task of the scenario: the driver starts as on the board, then the scenario runs and the bus is checked
+void ScenarioTask()
+{
+    I2C_RecoveryStats recoveries[I2C_MAX_RECOVERY_DEVICES];
+
+    Check(I2cInitializeDriver() == ERROR_NONE, "I2cInitializeDriver");
+    ClearStats();
+    simScenario->run();
+    vTaskDelay(1);  // The driver returns before its last STOP is on the bus
+    PrintStats();
+    Check(I2cGetRecoveryStats(recoveries, I2C_MAX_RECOVERY_DEVICES) == 0, "no bus recovery");
+    Check(sim::Violations() == 0, "the driver only does what the SERCOM allows");
+}
+
+/// Runs one scenario in this process
+/// @return Returns the exit status: 0 if every check passed
+int RunScenario(const Scenario &scenario)
+{
+    SimReset();
+    sim::SetDefaultSpeedOnly(simNoSpeed);
+    printf("%s\n", scenario.name);
+    simScenario = &scenario;
+    Check(sim::Run(ScenarioTask, kScenarioPriority), "the scenario ran to its end (every task blocked)");
+    fflush(stdout);
+    return simFailures == 0 ? 0 : 1;
+}
+
+/// The DMAC descriptors hold 32-bit addresses of the driver buffers, the task stacks and SERCOM0
+bool AddressesFit()
+{
+    std::unique_ptr<uint8_t[]> heap(new uint8_t[64]);
+    return (uint64_t(uintptr_t(&simSercom0)) >> 32) == 0 && (uint64_t(uintptr_t(heap.get())) >> 32) == 0;
+}
+
+}  // namespace
+
+/******************************************************************************
+ * Console and data stream stand-ins
+ ******************************************************************************/
+
+extern "C" {
+
+void SerialConsoleWriteString(const char *string)
+{
+    if (simVerbose) fputs(string, stderr);
+}
+
+/// The binary stream is off: NAU78_stream_service only queues its samples
+bool DataStreamIsEnabled(void)
+{
+    return false;
+}
+
+bool DataStreamSend(enum eDataStreamRecordType type, const void *record, size_t len)
+{
+    (void)type;
+    (void)record;
+    (void)len;
+    return false;
+}
+
+}  // extern "C"
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> names;
+    int failures = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-v") {
+            simVerbose = true;
+        } else if (arg == "--no-speed") {
+            simNoSpeed = true;
+        } else if (arg == "all") {
+            for (const Scenario &scenario : kScenarios) names.push_back(scenario.name);
+        } else {
+            names.push_back(arg);
+        }
+    }
+    if (names.empty()) {
+        for (const Scenario &scenario : kScenarios) names.push_back(scenario.name);
+    }
+    if (!AddressesFit()) {
+        fprintf(stderr, "%s: addresses above 4 GB, the DMAC cannot reach them: link with -no-pie\n", argv[0]);
+        return 2;
+    }
+
+    for (const std::string &name : names) {
+        const Scenario *found = nullptr;
+        for (const Scenario &scenario : kScenarios) {
+            if (name == scenario.name) found = &scenario;
+        }
+        if (found == nullptr) {
+            fprintf(stderr, "Usage: %s [-v] [--no-speed] [seesaw|keypad|leds|imu|restart|fifo|drain|nau|all]...\n", argv[0]);
+            return 2;
+        }
+
+        // The driver and the kernel keep their state in statics: a fresh process per scenario, as after a reset
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) _exit(RunScenario(*found));
+
+        int status = 0;
+        if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            if (pid > 0 && WIFSIGNALED(status)) printf("  FAIL: killed by signal %d\n", WTERMSIG(status));
+            failures++;
+        }
+    }
+
+    printf("%s\n", failures == 0 ? "All checks passed" : "Some checks failed");
+    return failures == 0 ? 0 : 1;
+}
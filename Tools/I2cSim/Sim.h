@@ -0,0 +1,130 @@
+/**
+ * @file        Sim.h
+ * @brief       Virtual time, FreeRTOS tasks and the simulated sensor bus of I2cSim, shared by its three sources
+ * @details     SimKernel.cpp runs the FreeRTOS tasks as coroutines on a virtual nanosecond clock, with an event timeline
+ *				for the hardware and the interrupts. SimSercom.cpp is the hardware: SERCOM0 in I2C master mode, the DMAC,
+ *				the PORT and GCLK calls, and the ASF I2C master driver on top of them. I2cSim.cpp has the devices and the
+ *				scenarios. Tools/ConsoleSim uses the kernel part with its own hardware (the console USART and DMAC).
+ *
+ *				Task code runs in zero time, except the CPU time it is charged with Busy (kernel calls, polling loops on
+ *				the run time stats counter, delay_ms). Interrupts run between two events of the timeline and are charged
+ *				their own time, so the CPU load of a scenario splits into tasks, interrupts, context switches and idle.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+namespace sim {
+
+constexpr uint32_t kCpuHz = 48000000;         ///< GCLK generator 0: CPU, DMAC and SERCOM0 clock
+constexpr uint64_t kTickNs = 1000000;         ///< configTICK_RATE_HZ
+constexpr uint32_t kKernelCallCycles = 150;   ///< One FreeRTOS call (queue, semaphore, notification, tick count)
+constexpr uint32_t kContextSwitchCycles = 250;  ///< PendSV, task selection and register save and restore
+
+/// CPU cycles to nanoseconds
+constexpr uint64_t CyclesNs(uint64_t cycles)
+{
+    return cycles * 1000000000ull / kCpuHz;
+}
+
+uint64_t NowNs();
+inline uint64_t NowUs()
+{
+    return NowNs() / 1000;
+}
+
+/// Runs fn at the time ns, from the hardware: no CPU time. Events at the same time run in the order they were added
+void At(uint64_t ns, std::function<void()> fn);
+
+/// An interrupt line. Checked after every event: while pending() is true and no interrupt runs, handler runs and the
+/// CPU spends cycles plus the kernel calls it made in it
+struct Irq {
+    const char *name;
+    uint32_t cycles;
+    bool (*pending)();
+    void (*handler)();
+};
+void AddIrq(const Irq *irq);
+
+/// Charges CPU time to the running task, or to the running interrupt. The events that fall in it run, and a higher
+/// priority task made ready by an interrupt takes the CPU first
+void Busy(uint64_t ns);
+
+/// Runs scenario as a task of the given priority until it returns
+/// @return Returns false if every task blocked forever first
+bool Run(void (*scenario)(), unsigned priority);
+
+/// Time of one interrupt line
+struct IrqStats {
+    uint64_t count = 0;
+    uint64_t ns = 0;
+};
+
+/// Where the CPU time went since ResetCpu
+struct CpuStats {
+    uint64_t sinceNs = 0;
+    uint64_t idleNs = 0;
+    uint64_t switchNs = 0;
+    uint64_t switches = 0;
+    std::map<std::string, uint64_t> taskNs;
+    std::map<std::string, IrqStats> irq;
+
+    uint64_t ElapsedNs() const { return NowNs() - sinceNs; }
+    uint64_t IrqNs() const
+    {
+        uint64_t ns = 0;
+        for (const auto &entry : irq) ns += entry.second.ns;
+        return ns;
+    }
+};
+const CpuStats &Cpu();
+void ResetCpu();
+
+/******************************************************************************
+ * Sensor bus
+ ******************************************************************************/
+
+/// A device on the sensor bus, driven byte by byte by the SERCOM
+class Device {
+public:
+    virtual ~Device() = default;
+    virtual const char *Name() const = 0;
+    /// Returns false to NACK data byte index of a write (0 is the first byte after the address)
+    virtual bool AcceptByte(uint16_t) { return true; }
+    /// Gets the acknowledged bytes of a write, at its STOP or repeated START
+    virtual void Write(const uint8_t *data, uint16_t len) = 0;
+    /// The device was addressed for a read
+    virtual void StartRead() {}
+    /// Next byte of a read
+    virtual uint8_t ReadByte() = 0;
+};
+
+void AttachDevice(uint8_t address, Device *device);
+
+/// Bus use of one device address, counted by the SERCOM
+struct BusStats {
+    uint32_t starts = 0;      ///< START conditions
+    uint32_t restarts = 0;    ///< Repeated STARTs
+    uint32_t nacks = 0;       ///< Address or data bytes the device did not acknowledge
+    uint32_t bytes = 0;       ///< Data bytes written and read
+    uint32_t dmaBeats = 0;    ///< Bytes moved by the DMAC
+    uint32_t sercomIrqs = 0;  ///< SERCOM interrupts while the device owned the bus
+    uint64_t busNs = 0;       ///< Time from START to STOP
+};
+const std::map<uint8_t, BusStats> &Bus();
+void ClearBus();
+
+/// Runs every transfer at the 100 kHz default BAUD, whatever the speed profiles of the driver
+void SetDefaultSpeedOnly(bool on);
+
+/// Driver actions the chip does not allow (e.g. BAUD written while enabled, DATA written while the bus is not held)
+uint32_t Violations();
+
+/// Calls of i2c_master_init since the start of the process
+uint32_t SercomInits();
+
+}  // namespace sim
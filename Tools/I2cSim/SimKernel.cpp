@@ -0,0 +1,561 @@
+/**
+ * @file        SimKernel.cpp
+ * @brief       FreeRTOS on the virtual clock of I2cSim and ConsoleSim: tasks, queues, semaphores, notifications and delays
+ * @details     Each task is a ucontext coroutine with its stack in .bss. The scheduler always runs the ready task of the
+ *				highest priority, the oldest one first among equals. A task gives the CPU back when it blocks, or when a
+ *				kernel call or an interrupt makes a task of a higher priority ready (preemption). Time only advances
+ *				while a task is charged CPU time (Busy) or while no task is ready (idle): the events of the hardware
+ *				then run in order, and the interrupt lines are checked after each one.
+ *
+ *				Costs charged to the CPU: kKernelCallCycles per kernel call, kContextSwitchCycles per switch between
+ *				two tasks, Irq::cycles per interrupt (plus the kernel calls made in it), and the busy waits of the
+ *				drivers (delay_ms, polling loops on RunTimeStatsGetCounter).
+ */
+
+#include <ucontext.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <queue>
+#include <vector>
+
+#include "Sim.h"
+#include "asf.h"
+#include "queue.h"
+#include "semphr.h"
+#include "task.h"
+
+#include "RunTimeStats/RunTimeStats.h"
+
+namespace sim {
+namespace {
+
+constexpr size_t kMaxTasks = 8;                ///< Scenario, bus manager, NAU7802 stream, and room for the scenarios
+constexpr size_t kStackBytes = 256 * 1024;     ///< Host stack of each task: the drivers run with glibc and -O0 frames
+constexpr uint32_t kTickCountCycles = 20;      ///< xTaskGetTickCount and RunTimeStatsGetCounter (a TC read)
+constexpr uint32_t kMaxChainedIrqs = 100000;   ///< Interrupts in a row without a task running: the line never clears
+
+enum class TaskState { Ready, Blocked, Done };
+
+struct Task;
+using WaitList = std::vector<Task *>;
+
+struct Task {
+    std::string name;
+    unsigned priority = 0;
+    TaskFunction_t code = nullptr;
+    void *parameters = nullptr;
+    ucontext_t context;
+    TaskState state = TaskState::Ready;
+    uint64_t readySeq = 0;         ///< Order of arrival among the ready tasks of one priority
+    uint64_t waitSeq = 0;          ///< Incremented at each block, so a late timeout of an earlier wait is ignored
+    WaitList *waitList = nullptr;  ///< List the task waits in, if any
+    WaitList notifyList;           ///< The task itself, while it waits for a notification
+    uint32_t notifyCount = 0;
+};
+
+struct Semaphore {
+    bool mutex;
+    uint32_t count;
+    Task *owner;
+    WaitList waiters;
+};
+
+struct Queue {
+    size_t itemSize;
+    size_t length;
+    std::deque<std::vector<uint8_t>> items;
+    WaitList receivers;
+    WaitList senders;
+};
+
+struct Event {
+    uint64_t ns;
+    uint64_t seq;
+    std::function<void()> fn;
+};
+
+struct EventLater {
+    bool operator()(const Event &a, const Event &b) const { return (a.ns != b.ns) ? a.ns > b.ns : a.seq > b.seq; }
+};
+
+/// Task stacks in .bss, below 4 GB in a -no-pie build: the DMAC descriptors hold 32-bit addresses of stack buffers
+alignas(16) uint8_t taskStacks[kMaxTasks][kStackBytes];
+Task tasks[kMaxTasks];
+size_t taskCount = 0;
+
+std::priority_queue<Event, std::vector<Event>, EventLater> events;
+uint64_t eventSeq = 0;
+uint64_t nowNs = 0;
+uint64_t readySeq = 0;
+
+std::vector<const Irq *> irqs;
+bool inIrq = false;        ///< An interrupt handler runs: no nesting, and Busy adds to its time
+uint64_t irqExtraNs = 0;  ///< Kernel calls made by the running interrupt handler
+
+Task *current = nullptr;  ///< Running task, NULL while the scheduler runs
+Task *lastRun = nullptr;  ///< Task whose registers the CPU holds, for the context switch cost
+ucontext_t schedulerContext;
+void (*scenarioCode)() = nullptr;
+CpuStats cpu;
+
+void RunEvent()
+{
+    Event event = events.top();
+    events.pop();
+    if (event.ns > nowNs) nowNs = event.ns;
+    event.fn();
+}
+
+/// Runs the hardware until the time until, without interrupts (one is running)
+void RunHardware(uint64_t until)
+{
+    while (!events.empty() && events.top().ns <= until) RunEvent();
+    nowNs = until;
+}
+
+/// Runs the pending interrupts, first line first, until none is pending
+void DispatchIrqs()
+{
+    uint32_t chained = 0;
+
+    if (inIrq) return;
+    for (bool again = true; again;) {
+        again = false;
+        for (const Irq *irq : irqs) {
+            if (!irq->pending()) continue;
+            if (++chained > kMaxChainedIrqs) {
+                fprintf(stderr, "%s interrupt storm at %.3f ms\n", irq->name, nowNs / 1e6);
+                exit(3);
+            }
+            inIrq = true;
+            irqExtraNs = 0;
+            irq->handler();
+            uint64_t ns = CyclesNs(irq->cycles) + irqExtraNs;
+            RunHardware(nowNs + ns);
+            IrqStats &stats = cpu.irq[irq->name];
+            stats.count++;
+            stats.ns += ns;
+            inIrq = false;
+            again = true;
+            break;
+        }
+    }
+}
+
+bool AnyReady()
+{
+    for (size_t i = 0; i < taskCount; i++) {
+        if (tasks[i].state == TaskState::Ready) return true;
+    }
+    return false;
+}
+
+bool HigherReady()
+{
+    for (size_t i = 0; i < taskCount; i++) {
+        if (tasks[i].state == TaskState::Ready && tasks[i].priority > current->priority) return true;
+    }
+    return false;
+}
+
+Task *PickReady()
+{
+    Task *best = nullptr;
+    for (size_t i = 0; i < taskCount; i++) {
+        Task *task = &tasks[i];
+        if (task->state != TaskState::Ready) continue;
+        if (best == nullptr || task->priority > best->priority || (task->priority == best->priority && task->readySeq < best->readySeq)) {
+            best = task;
+        }
+    }
+    return best;
+}
+
+/// Spends up to ns of CPU time on account, with the events and interrupts that fall in it
+/// @return Returns the time left when stop turned true, else 0
+uint64_t Advance(uint64_t ns, uint64_t *account, bool (*stop)())
+{
+    DispatchIrqs();
+    while (stop == nullptr || !stop()) {
+        if (!events.empty() && events.top().ns <= nowNs + ns) {
+            uint64_t step = (events.top().ns > nowNs) ? events.top().ns - nowNs : 0;
+            *account += step;
+            ns -= step;
+            nowNs += step;
+            RunEvent();
+            DispatchIrqs();
+            continue;
+        }
+        *account += ns;
+        nowNs += ns;
+        return 0;
+    }
+    return ns;
+}
+
+/// No task is ready: runs the hardware until an interrupt or a timeout makes one ready
+/// @return Returns false if nothing is left to happen
+bool IdleUntilReady()
+{
+    while (!AnyReady()) {
+        if (events.empty()) return false;
+        if (events.top().ns > nowNs) {
+            cpu.idleNs += events.top().ns - nowNs;
+            nowNs = events.top().ns;
+        }
+        RunEvent();
+        DispatchIrqs();
+    }
+    return true;
+}
+
+void SwitchToScheduler()
+{
+    swapcontext(&current->context, &schedulerContext);
+}
+
+void MakeReady(Task *task)
+{
+    if (task->waitList != nullptr) {
+        WaitList &list = *task->waitList;
+        for (size_t i = 0; i < list.size(); i++) {
+            if (list[i] == task) {
+                list.erase(list.begin() + long(i));
+                break;
+            }
+        }
+        task->waitList = nullptr;
+    }
+    task->state = TaskState::Ready;
+    task->readySeq = ++readySeq;
+}
+
+/// Makes the first waiter of the highest priority ready
+Task *WakeOne(WaitList &list)
+{
+    Task *best = nullptr;
+    for (Task *task : list) {
+        if (best == nullptr || task->priority > best->priority) best = task;
+    }
+    if (best != nullptr) MakeReady(best);
+    return best;
+}
+
+/// Gives the CPU to the scheduler until a wakeup or the deadline
+void Block(WaitList *list, uint64_t deadline)
+{
+    Task *task = current;
+    uint64_t seq = ++task->waitSeq;
+
+    task->state = TaskState::Blocked;
+    task->waitList = list;
+    if (list != nullptr) list->push_back(task);
+    if (deadline != UINT64_MAX) {
+        At(deadline, [task, seq] {
+            if (task->state == TaskState::Blocked && task->waitSeq == seq) MakeReady(task);
+        });
+    }
+    SwitchToScheduler();
+}
+
+/// Blocks until ready() or for ticks. Deadlines fall on tick boundaries, as with the FreeRTOS delayed list
+template <typename Ready>
+bool WaitUntil(Ready ready, WaitList *list, TickType_t ticks)
+{
+    uint64_t deadline = (ticks == portMAX_DELAY) ? UINT64_MAX : (nowNs / kTickNs + ticks) * kTickNs;
+
+    while (!ready()) {
+        if (inIrq || current == nullptr || nowNs >= deadline) return false;
+        Block(list, deadline);
+    }
+    return true;
+}
+
+/// A kernel call made a higher priority task ready: it runs first
+void Reschedule()
+{
+    if (!inIrq && current != nullptr && HigherReady()) {
+        SwitchToScheduler();
+    }
+}
+
+void KernelCall(uint32_t cycles = kKernelCallCycles)
+{
+    Busy(CyclesNs(cycles));
+}
+
+void TaskEntry()
+{
+    current->code(current->parameters);
+    current->state = TaskState::Done;
+    SwitchToScheduler();
+}
+
+void ScenarioTask(void *)
+{
+    scenarioCode();
+}
+
+Task *CreateTask(TaskFunction_t code, const char *name, void *parameters, unsigned priority)
+{
+    if (taskCount >= kMaxTasks) return nullptr;
+
+    // No local lives across getcontext: the compiler cannot tell that it returns only once
+    tasks[taskCount].name = name;
+    tasks[taskCount].priority = priority;
+    tasks[taskCount].code = code;
+    tasks[taskCount].parameters = parameters;
+    getcontext(&tasks[taskCount].context);
+    tasks[taskCount].context.uc_stack.ss_sp = taskStacks[taskCount];
+    tasks[taskCount].context.uc_stack.ss_size = kStackBytes;
+    tasks[taskCount].context.uc_link = &schedulerContext;
+    makecontext(&tasks[taskCount].context, TaskEntry, 0);
+    MakeReady(&tasks[taskCount]);
+    return &tasks[taskCount++];
+}
+
+}  // namespace
+
+uint64_t NowNs()
+{
+    return nowNs;
+}
+
+void At(uint64_t ns, std::function<void()> fn)
+{
+    events.push(Event{(ns < nowNs) ? nowNs : ns, eventSeq++, std::move(fn)});
+}
+
+void AddIrq(const Irq *irq)
+{
+    irqs.push_back(irq);
+}
+
+void Busy(uint64_t ns)
+{
+    if (inIrq) {
+        irqExtraNs += ns;
+        return;
+    }
+    if (current == nullptr) {
+        RunHardware(nowNs + ns);
+        return;
+    }
+
+    uint64_t left = ns;
+    for (;;) {
+        left = Advance(left, &cpu.taskNs[current->name], HigherReady);
+        if (HigherReady()) SwitchToScheduler();
+        if (left == 0) return;
+    }
+}
+
+bool Run(void (*scenario)(), unsigned priority)
+{
+    scenarioCode = scenario;
+    Task *main = CreateTask(ScenarioTask, "Scenario", nullptr, priority);
+
+    for (;;) {
+        if (main->state == TaskState::Done) return true;
+
+        Task *next = PickReady();
+        if (next == nullptr) {
+            if (!IdleUntilReady()) return false;
+            continue;
+        }
+        if (next != lastRun) {
+            if (lastRun != nullptr) {
+                Advance(CyclesNs(kContextSwitchCycles), &cpu.switchNs, nullptr);
+                cpu.switches++;
+            }
+            next = PickReady();
+            lastRun = next;
+        }
+        current = next;
+        swapcontext(&schedulerContext, &next->context);
+        current = nullptr;
+    }
+}
+
+const CpuStats &Cpu()
+{
+    return cpu;
+}
+
+void ResetCpu()
+{
+    cpu = CpuStats();
+    cpu.sinceNs = nowNs;
+}
+
+}  // namespace sim
+
+using namespace sim;
+
+/******************************************************************************
+ * FreeRTOS and ASF functions of the drivers
+ ******************************************************************************/
+
+extern "C" {
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode,
+                       const char *pcName,
+                       uint16_t usStackDepth,
+                       void *pvParameters,
+                       UBaseType_t uxPriority,
+                       TaskHandle_t *pxCreatedTask)
+{
+    (void)usStackDepth;  // Checked by the heap budget of FreeRTOSConfig.h, not here
+    KernelCall();
+    Task *task = CreateTask(pxTaskCode, pcName, pvParameters, unsigned(uxPriority));
+    if (task == nullptr) return pdFAIL;
+    if (pxCreatedTask != NULL) *pxCreatedTask = task;
+    Reschedule();
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+    Task *task = static_cast<Task *>(xTaskToNotify);
+
+    KernelCall();
+    task->notifyCount++;
+    WakeOne(task->notifyList);
+    Reschedule();
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    KernelCall();
+    Task *task = current;
+    if (!WaitUntil([task] { return task->notifyCount > 0; }, &task->notifyList, xTicksToWait)) return 0;
+
+    uint32_t value = task->notifyCount;
+    task->notifyCount = xClearCountOnExit ? 0 : value - 1;
+    return value;
+}
+
+void vTaskDelay(TickType_t xTicksToDelay)
+{
+    KernelCall();
+    if (xTicksToDelay == 0) return;
+    Block(nullptr, (nowNs / kTickNs + xTicksToDelay) * kTickNs);
+}
+
+/// Only a task suspending itself (vTaskSuspend(NULL)) is supported: it never runs again
+void vTaskSuspend(TaskHandle_t xTaskToSuspend)
+{
+    KernelCall();
+    if (xTaskToSuspend == NULL || xTaskToSuspend == current) Block(nullptr, UINT64_MAX);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    KernelCall(kTickCountCycles);
+    return TickType_t(nowNs / kTickNs);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize)
+{
+    KernelCall();
+    return new Queue{uxItemSize, uxQueueLength, {}, {}, {}};
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait)
+{
+    Queue *queue = static_cast<Queue *>(xQueue);
+
+    KernelCall();
+    if (!WaitUntil([queue] { return queue->items.size() < queue->length; }, &queue->senders, xTicksToWait)) return pdFAIL;
+
+    const uint8_t *item = static_cast<const uint8_t *>(pvItemToQueue);
+    queue->items.emplace_back(item, item + queue->itemSize);
+    WakeOne(queue->receivers);
+    Reschedule();
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait)
+{
+    Queue *queue = static_cast<Queue *>(xQueue);
+
+    KernelCall();
+    if (!WaitUntil([queue] { return !queue->items.empty(); }, &queue->receivers, xTicksToWait)) return pdFAIL;
+
+    memcpy(pvBuffer, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    WakeOne(queue->senders);
+    Reschedule();
+    return pdPASS;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    KernelCall();
+    return new Semaphore{true, 1, nullptr, {}};
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    KernelCall();
+    return new Semaphore{false, 0, nullptr, {}};
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime)
+{
+    Semaphore *semaphore = static_cast<Semaphore *>(xSemaphore);
+
+    KernelCall();
+    if (!WaitUntil([semaphore] { return semaphore->count > 0; }, &semaphore->waiters, xBlockTime)) return pdFALSE;
+
+    semaphore->count--;
+    if (semaphore->mutex) semaphore->owner = current;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore)
+{
+    Semaphore *semaphore = static_cast<Semaphore *>(xSemaphore);
+
+    KernelCall();
+    if (semaphore->count > 0 || (semaphore->mutex && semaphore->owner != current)) return pdFALSE;
+
+    semaphore->count++;
+    semaphore->owner = nullptr;
+    WakeOne(semaphore->waiters);
+    Reschedule();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t xSemaphore, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    Semaphore *semaphore = static_cast<Semaphore *>(xSemaphore);
+
+    KernelCall();
+    if (semaphore->count > 0) return pdFALSE;
+
+    semaphore->count++;
+    Task *woken = WakeOne(semaphore->waiters);
+    if (woken != nullptr && pxHigherPriorityTaskWoken != NULL && (current == nullptr || woken->priority > current->priority)) {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+    return pdTRUE;
+}
+
+void delay_ms(uint32_t delay)
+{
+    Busy(uint64_t(delay) * 1000000);
+}
+
+}  // extern "C"
+
+/// The board counts a 1 MHz TC: here, the virtual clock
+uint32_t RunTimeStatsGetCounter(void)
+{
+    Busy(CyclesNs(kTickCountCycles));
+    return uint32_t(NowUs());
+}
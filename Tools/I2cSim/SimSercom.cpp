@@ -0,0 +1,1088 @@
+/**
+ * @file        SimSercom.cpp
+ * @brief       SERCOM0 in I2C master mode, the DMAC and the ASF drivers on top of them, on the virtual clock of I2cSim
+ * @details     The register model follows the SAMD21 datasheet for smart mode (CTRLB.SMEN), which is how ASF runs it:
+ *				writing ADDR sends a START (or a repeated START while the bus is held) and the address; MB is set when a
+ *				write byte or a write address is done, SB when a read byte is in DATA; writing DATA sends the next byte,
+ *				reading DATA acknowledges the byte by CTRLB.ACKACT and receives the next one; CTRLB.CMD sends a STOP, a
+ *				repeated START or an acknowledge. With ADDR.LENEN, the SERCOM NACKs the last byte of a read and sends the
+ *				STOP by itself. Every bit takes (10 + BAUD + BAUDLOW) SERCOM clocks plus the rise time, as in the formula
+ *				of I2cComputeSpeed.
+ *
+ *				The ASF functions are the code of the ASF sources of the application (i2c_master.c,
+ *				i2c_master_interrupt.c, dma.c), with the bit-field accesses written as masks. Anything the chip does not
+ *				allow (BAUD written while enabled, DATA written while no write is held, a DMAC descriptor that does not
+ *				point at DATA) is counted as a violation and printed.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Sim.h"
+#include "asf.h"
+
+Sercom simSercom0;
+
+namespace sim {
+namespace {
+
+constexpr uint32_t kSercomIrqCycles = 220;  ///< Entry, _i2c_master_interrupt_handler and exit, without its callbacks
+constexpr uint32_t kDmacIrqCycles = 180;    ///< Entry, the ASF DMAC handler and exit, without its callbacks
+constexpr uint32_t kDmaBeatCycles = 12;     ///< Trigger to beat: arbitration, descriptor fetch and the bus access
+constexpr uint32_t kRiseNs = 215;           ///< SDA and SCL rise time of the board (I2C_SDA_SCL_RISE_TIME_NS)
+constexpr uint32_t kDefaultBaud = 230;      ///< BAUD of 100 kHz at 48 MHz, as computed by ASF
+constexpr uint32_t kIntMask = SERCOM_I2CM_INTFLAG_MB | SERCOM_I2CM_INTFLAG_SB | SERCOM_I2CM_INTFLAG_ERROR;
+constexpr uint32_t kStatusErrors = SERCOM_I2CM_STATUS_BUSERR | SERCOM_I2CM_STATUS_ARBLOST | SERCOM_I2CM_STATUS_LOWTOUT |
+                                   SERCOM_I2CM_STATUS_LENERR;
+
+enum BusState : uint32_t { kBusUnknown = 0, kBusIdle = 1, kBusOwner = 2 };
+
+/// Where the SERCOM is in a transfer
+enum class Phase {
+    Idle,        ///< No transfer, or disabled
+    Address,     ///< START or repeated START and the address on the wire
+    WriteReady,  ///< A write byte or address is done: the bus is held until DATA, ADDR or a STOP command
+    WriteByte,   ///< A write byte on the wire
+    ReadByte,    ///< Acknowledge of the previous byte, if any, and a read byte on the wire
+    ReadReady,   ///< A read byte is in DATA: the bus is held until DATA is read, ADDR or a command
+    Hold,        ///< After a NACKed read address or a NACK sent: the bus is held until ADDR or a STOP command
+    Stopping,    ///< Acknowledge bit, if any, and the STOP on the wire
+};
+
+struct Sercom0 {
+    uint32_t ctrla = 0;
+    uint32_t ctrlb = 0;
+    uint32_t baud = 0;
+    uint32_t inten = 0;
+    uint32_t intflag = 0;
+    uint32_t status = 0;  ///< Without BUSSTATE
+    uint32_t busState = kBusUnknown;
+    uint32_t addr = 0;
+    uint8_t data = 0;
+    bool nvic = false;
+
+    Phase phase = Phase::Idle;
+    uint32_t generation = 0;  ///< Incremented by a reset or a disable: the events of the transfer on the wire are dropped
+    uint8_t address = 0;
+    bool read = false;
+    bool lenen = false;
+    uint8_t len = 0;
+    uint16_t count = 0;        ///< Data bytes of the transfer done on the wire
+    uint8_t txByte = 0;
+    bool stopPending = false;  ///< STOP command received during a byte: sent at its end
+    bool startPending = false; ///< ADDR written during the STOP: the START follows it
+    uint32_t pendingAddr = 0;
+    Device *device = nullptr;
+    std::vector<uint8_t> written;  ///< Acknowledged bytes of the write on the wire
+    uint8_t owner = 0;             ///< Address of the first transfer since the START, for the bus statistics
+    uint64_t startNs = 0;
+    struct i2c_master_module *module = nullptr;  ///< _sercom_instances[0]
+};
+
+struct Channel {
+    struct dma_resource *resource = nullptr;
+    uint8_t trigger = 0;
+    bool active = false;
+    bool beatPending = false;
+    DmacDescriptor descriptor;  ///< Copy made by dma_start_transfer_job, as in the descriptor section of the DMAC
+    uint16_t done = 0;
+};
+
+Sercom0 sercom;
+Channel channels[2];
+uint8_t channelCount = 0;
+uint8_t dmacPending = 0;  ///< CHINTFLAG.TCMPL, one bit per channel
+
+std::map<uint8_t, Device *> devices;
+std::map<uint8_t, BusStats> busStats;
+bool defaultSpeedOnly = false;
+uint32_t violations = 0;
+uint32_t sercomInits = 0;
+bool pinLow[64];     ///< Output level of the PORT pins
+bool pinOutput[64];  ///< Direction of the PORT pins
+
+void Violation(const char *what)
+{
+    violations++;
+    fprintf(stderr, "I2cSim: %.3f ms: %s\n", NowNs() / 1e6, what);
+}
+
+bool Enabled()
+{
+    return (sercom.ctrla & SERCOM_I2CM_CTRLA_ENABLE) != 0;
+}
+
+uint64_t BitNs()
+{
+    uint32_t high = sercom.baud & 0xff;
+    uint32_t low = (sercom.baud >> 8) & 0xff;
+
+    if (low == 0) low = high;
+    if (defaultSpeedOnly) high = low = kDefaultBaud;
+    return (uint64_t(10 + high + low) * 1000000000ull) / kCpuHz + kRiseNs;
+}
+
+/// Runs fn after bits bit times, unless the SERCOM is reset or disabled first
+void After(uint32_t bits, void (*fn)())
+{
+    uint32_t generation = sercom.generation;
+    At(NowNs() + bits * BitNs(), [generation, fn] {
+        if (generation == sercom.generation) fn();
+    });
+}
+
+void TriggerDma();
+void Begin(uint32_t addr, bool restart, uint32_t extraBits);
+
+/// Hands the acknowledged bytes of the write on the wire to the device, at its STOP or repeated START
+void DeliverWrite()
+{
+    if (!sercom.read && sercom.device != nullptr && !sercom.written.empty()) {
+        sercom.device->Write(sercom.written.data(), uint16_t(sercom.written.size()));
+    }
+    sercom.written.clear();
+}
+
+void StopDone()
+{
+    DeliverWrite();
+    busStats[sercom.owner].busNs += NowNs() - sercom.startNs;
+    sercom.phase = Phase::Idle;
+    sercom.busState = kBusIdle;
+    if (sercom.startPending) {
+        sercom.startPending = false;
+        Begin(sercom.pendingAddr, false, 0);
+    }
+}
+
+/// Sends the STOP, after the acknowledge bit of a read byte if one is due
+void Stop(uint32_t bits)
+{
+    sercom.phase = Phase::Stopping;
+    sercom.stopPending = false;
+    After(bits, StopDone);
+}
+
+/// A STOP command came during the byte that just ended
+bool StopIfPending()
+{
+    if (!sercom.stopPending) return false;
+    sercom.intflag &= ~(SERCOM_I2CM_INTFLAG_MB | SERCOM_I2CM_INTFLAG_SB);
+    Stop(sercom.read ? 2 : 1);
+    return true;
+}
+
+void ReadByteDone()
+{
+    sercom.data = sercom.device->ReadByte();
+    sercom.count++;
+    busStats[sercom.address].bytes++;
+    if (StopIfPending()) return;
+    sercom.phase = Phase::ReadReady;
+    sercom.intflag |= SERCOM_I2CM_INTFLAG_SB;
+    TriggerDma();
+}
+
+void WriteByteDone()
+{
+    bool ack = (sercom.device != nullptr) && sercom.device->AcceptByte(sercom.count);
+
+    sercom.count++;
+    if (ack) {
+        sercom.written.push_back(sercom.txByte);
+        sercom.status &= ~SERCOM_I2CM_STATUS_RXNACK;
+        busStats[sercom.address].bytes++;
+    } else {
+        sercom.status |= SERCOM_I2CM_STATUS_RXNACK;
+        busStats[sercom.address].nacks++;
+    }
+    sercom.phase = Phase::WriteReady;
+    if (sercom.lenen && sercom.count >= sercom.len) {
+        sercom.intflag |= SERCOM_I2CM_INTFLAG_MB;
+        Stop(1);
+        return;
+    }
+    if (sercom.lenen && !ack) {
+        sercom.status |= SERCOM_I2CM_STATUS_LENERR;
+        sercom.intflag |= SERCOM_I2CM_INTFLAG_MB | SERCOM_I2CM_INTFLAG_ERROR;
+        Stop(1);
+        return;
+    }
+    if (StopIfPending()) return;
+    sercom.intflag |= SERCOM_I2CM_INTFLAG_MB;
+    TriggerDma();
+}
+
+void AddressDone()
+{
+    bool ack = (sercom.device != nullptr);
+
+    if (!ack) busStats[sercom.address].nacks++;
+    if (ack) {
+        sercom.status &= ~SERCOM_I2CM_STATUS_RXNACK;
+    } else {
+        sercom.status |= SERCOM_I2CM_STATUS_RXNACK;
+    }
+    if (StopIfPending()) return;
+
+    if (!sercom.read) {
+        sercom.phase = Phase::WriteReady;
+        sercom.intflag |= SERCOM_I2CM_INTFLAG_MB;
+    } else if (!ack) {
+        sercom.phase = Phase::Hold;
+        sercom.intflag |= SERCOM_I2CM_INTFLAG_MB;
+    } else {
+        sercom.device->StartRead();
+        sercom.phase = Phase::ReadByte;
+        After(8, ReadByteDone);
+    }
+    TriggerDma();
+}
+
+/// Sends a START, or a repeated START while the bus is held, then the address of ADDR
+void Begin(uint32_t addr, bool restart, uint32_t extraBits)
+{
+    if (restart) {
+        DeliverWrite();
+    } else {
+        sercom.startNs = NowNs();
+        sercom.owner = uint8_t((addr >> 1) & 0x7f);
+    }
+    sercom.addr = addr;
+    sercom.address = uint8_t((addr >> 1) & 0x7f);
+    sercom.read = (addr & 1) != 0;
+    sercom.lenen = (addr & SERCOM_I2CM_ADDR_LENEN) != 0;
+    sercom.len = uint8_t((addr >> 16) & 0xff);
+    sercom.count = 0;
+    sercom.written.clear();
+    auto device = devices.find(sercom.address);
+    sercom.device = (device != devices.end()) ? device->second : nullptr;
+
+    BusStats &stats = busStats[sercom.address];
+    if (restart) {
+        stats.restarts++;
+    } else {
+        stats.starts++;
+    }
+    sercom.phase = Phase::Address;
+    sercom.busState = kBusOwner;
+    After(10 + extraBits, AddressDone);
+}
+
+void WriteAddr(uint32_t value)
+{
+    if (!Enabled()) {
+        Violation("ADDR written while the SERCOM is disabled");
+        return;
+    }
+    sercom.intflag &= ~(SERCOM_I2CM_INTFLAG_MB | SERCOM_I2CM_INTFLAG_SB);
+    sercom.status &= ~SERCOM_I2CM_STATUS_LENERR;
+    switch (sercom.phase) {
+        case Phase::Idle:
+            Begin(value, false, 0);
+            break;
+        case Phase::WriteReady:
+        case Phase::Hold:
+            Begin(value, true, 0);
+            break;
+        case Phase::ReadReady:
+            Begin(value, true, 1);  // Acknowledge bit of the byte in DATA first
+            break;
+        case Phase::Stopping:
+            sercom.startPending = true;
+            sercom.pendingAddr = value;
+            break;
+        default:
+            Violation("ADDR written during a byte");
+            break;
+    }
+}
+
+void WriteData(uint32_t value)
+{
+    if (sercom.phase != Phase::WriteReady) {
+        Violation("DATA written while no write holds the bus");
+        return;
+    }
+    sercom.intflag &= ~SERCOM_I2CM_INTFLAG_MB;
+    sercom.txByte = uint8_t(value);
+    sercom.phase = Phase::WriteByte;
+    After(9, WriteByteDone);
+}
+
+/// Smart mode: reading the byte of a read acknowledges it by CTRLB.ACKACT
+uint8_t ReadData()
+{
+    if (sercom.phase != Phase::ReadReady || !(sercom.ctrlb & SERCOM_I2CM_CTRLB_SMEN)) return sercom.data;
+
+    sercom.intflag &= ~SERCOM_I2CM_INTFLAG_SB;
+    if (sercom.lenen && sercom.count >= sercom.len) {
+        Stop(2);
+    } else if (!(sercom.ctrlb & SERCOM_I2CM_CTRLB_ACKACT)) {
+        sercom.phase = Phase::ReadByte;
+        After(9, ReadByteDone);
+    } else {
+        sercom.phase = Phase::Hold;
+    }
+    return sercom.data;
+}
+
+void Command(uint32_t cmd)
+{
+    if (!Enabled()) {
+        Violation("CTRLB.CMD written while the SERCOM is disabled");
+        return;
+    }
+    sercom.intflag &= ~(SERCOM_I2CM_INTFLAG_MB | SERCOM_I2CM_INTFLAG_SB);
+    switch (sercom.phase) {
+        case Phase::WriteReady:
+        case Phase::Hold:
+            if (cmd == 3) Stop(1);
+            if (cmd == 1) Begin(sercom.addr, true, 0);
+            break;
+        case Phase::ReadReady:
+            if (cmd == 3) Stop(2);
+            if (cmd == 1) Begin(sercom.addr, true, 1);
+            if (cmd == 2 && (sercom.ctrlb & SERCOM_I2CM_CTRLB_ACKACT)) sercom.phase = Phase::Hold;
+            if (cmd == 2 && !(sercom.ctrlb & SERCOM_I2CM_CTRLB_ACKACT)) {
+                sercom.phase = Phase::ReadByte;
+                After(9, ReadByteDone);
+            }
+            break;
+        case Phase::Address:
+        case Phase::WriteByte:
+        case Phase::ReadByte:
+            if (cmd == 3) sercom.stopPending = true;
+            break;
+        default:
+            break;  // The bus is not owned: the chip ignores the command
+    }
+}
+
+/// Drops the transfer on the wire: the lines are released at once
+void Abort()
+{
+    sercom.generation++;
+    sercom.phase = Phase::Idle;
+    sercom.stopPending = false;
+    sercom.startPending = false;
+    sercom.written.clear();
+}
+
+void WriteCtrla(uint32_t value)
+{
+    if (value & SERCOM_I2CM_CTRLA_SWRST) {
+        Abort();
+        struct i2c_master_module *module = sercom.module;
+        uint32_t generation = sercom.generation;
+        sercom = Sercom0();
+        sercom.module = module;
+        sercom.generation = generation;
+        return;
+    }
+
+    bool wasEnabled = Enabled();
+    bool enable = (value & SERCOM_I2CM_CTRLA_ENABLE) != 0;
+    if (wasEnabled && enable && ((value ^ sercom.ctrla) & ~SERCOM_I2CM_CTRLA_ENABLE)) {
+        Violation("CTRLA written while the SERCOM is enabled");
+    }
+    sercom.ctrla = value;
+    if (!wasEnabled && enable) sercom.busState = kBusUnknown;
+    if (wasEnabled && !enable) {
+        Abort();
+        sercom.busState = kBusUnknown;
+    }
+}
+
+bool DmaTriggered(const Channel &channel)
+{
+    if (channel.trigger == SERCOM0_DMAC_ID_TX) {
+        return (sercom.intflag & SERCOM_I2CM_INTFLAG_MB) && sercom.phase == Phase::WriteReady &&
+               !(sercom.status & SERCOM_I2CM_STATUS_RXNACK);
+    }
+    return (sercom.intflag & SERCOM_I2CM_INTFLAG_SB) && sercom.phase == Phase::ReadReady;
+}
+
+uint32_t DataAddress()
+{
+    return uint32_t(uintptr_t(&simSercom0.I2CM.DATA.reg));
+}
+
+/// One beat of a channel, if its trigger is still on when the DMAC gets to it
+void DmaBeat(Channel &channel)
+{
+    channel.beatPending = false;
+    if (!channel.active || !DmaTriggered(channel)) return;
+
+    DmacDescriptor &descriptor = channel.descriptor;
+    if (channel.trigger == SERCOM0_DMAC_ID_TX) {
+        uint32_t src = descriptor.SRCADDR.reg - descriptor.BTCNT.reg + channel.done;
+        SimSercomWrite(SIM_SERCOM_DATA, *reinterpret_cast<const uint8_t *>(uintptr_t(src)));
+    } else {
+        uint32_t dst = descriptor.DSTADDR.reg - descriptor.BTCNT.reg + channel.done;
+        *reinterpret_cast<uint8_t *>(uintptr_t(dst)) = uint8_t(SimSercomRead(SIM_SERCOM_DATA));
+    }
+    busStats[sercom.address].dmaBeats++;
+    channel.done++;
+    if (channel.done == descriptor.BTCNT.reg) {
+        channel.active = false;
+        dmacPending |= uint8_t(1u << channel.resource->channel_id);
+    }
+}
+
+/// Schedules a beat on every active channel whose trigger is on
+void TriggerDma()
+{
+    for (uint8_t i = 0; i < channelCount; i++) {
+        Channel &channel = channels[i];
+        if (!channel.active || channel.beatPending || !DmaTriggered(channel)) continue;
+        channel.beatPending = true;
+        At(NowNs() + CyclesNs(kDmaBeatCycles), [i] { DmaBeat(channels[i]); });
+    }
+}
+
+}  // namespace
+
+void AttachDevice(uint8_t address, Device *device)
+{
+    devices[address] = device;
+}
+
+const std::map<uint8_t, BusStats> &Bus()
+{
+    return busStats;
+}
+
+void ClearBus()
+{
+    busStats.clear();
+}
+
+void SetDefaultSpeedOnly(bool on)
+{
+    defaultSpeedOnly = on;
+}
+
+uint32_t Violations()
+{
+    return violations;
+}
+
+uint32_t SercomInits()
+{
+    return sercomInits;
+}
+
+}  // namespace sim
+
+using namespace sim;
+
+static void AddIrqs();
+
+/******************************************************************************
+ * Registers
+ ******************************************************************************/
+
+uint32_t SimSercomRead(SimSercomRegisterId id)
+{
+    switch (id) {
+        case SIM_SERCOM_CTRLA:
+            return sercom.ctrla;
+        case SIM_SERCOM_CTRLB:
+            return sercom.ctrlb;  // CMD reads as zero
+        case SIM_SERCOM_BAUD:
+            return sercom.baud;
+        case SIM_SERCOM_INTENCLR:
+        case SIM_SERCOM_INTENSET:
+            return sercom.inten;
+        case SIM_SERCOM_INTFLAG:
+            return sercom.intflag;
+        case SIM_SERCOM_STATUS:
+            return sercom.status | SERCOM_I2CM_STATUS_BUSSTATE(sercom.busState);
+        case SIM_SERCOM_SYNCBUSY:
+            return 0;
+        case SIM_SERCOM_ADDR:
+            return sercom.addr;
+        case SIM_SERCOM_DATA: {
+            uint8_t data = ReadData();
+            TriggerDma();
+            return data;
+        }
+    }
+    return 0;
+}
+
+void SimSercomWrite(SimSercomRegisterId id, uint32_t value)
+{
+    switch (id) {
+        case SIM_SERCOM_CTRLA:
+            WriteCtrla(value);
+            break;
+        case SIM_SERCOM_CTRLB:
+            sercom.ctrlb = value & ~SERCOM_I2CM_CTRLB_CMD_Msk;
+            if (value & SERCOM_I2CM_CTRLB_CMD_Msk) Command((value & SERCOM_I2CM_CTRLB_CMD_Msk) >> 16);
+            break;
+        case SIM_SERCOM_BAUD:
+            if (Enabled()) {
+                Violation("BAUD written while the SERCOM is enabled");
+                break;
+            }
+            sercom.baud = value;
+            break;
+        case SIM_SERCOM_INTENCLR:
+            sercom.inten &= ~value;
+            break;
+        case SIM_SERCOM_INTENSET:
+            sercom.inten |= value & kIntMask;
+            break;
+        case SIM_SERCOM_INTFLAG:
+            sercom.intflag &= ~value;
+            break;
+        case SIM_SERCOM_STATUS:
+            sercom.status &= ~(value & kStatusErrors);
+            if (value & SERCOM_I2CM_STATUS_BUSSTATE_Msk) sercom.busState = (value & SERCOM_I2CM_STATUS_BUSSTATE_Msk) >> 4;
+            break;
+        case SIM_SERCOM_SYNCBUSY:
+            break;
+        case SIM_SERCOM_ADDR:
+            WriteAddr(value);
+            break;
+        case SIM_SERCOM_DATA:
+            WriteData(value);
+            break;
+    }
+    TriggerDma();
+}
+
+/******************************************************************************
+ * ASF SERCOM I2C master driver (i2c_master.c, i2c_master.h, i2c_master_interrupt.c)
+ ******************************************************************************/
+
+extern "C" {
+
+void _i2c_master_wait_for_sync(const struct i2c_master_module *const module)
+{
+    while (module->hw->I2CM.SYNCBUSY.reg) {
+    }
+}
+
+void i2c_master_get_config_defaults(struct i2c_master_config *const config)
+{
+    memset(config, 0, sizeof(*config));
+    config->baud_rate = I2C_MASTER_BAUD_RATE_100KHZ;
+    config->transfer_speed = I2C_MASTER_SPEED_STANDARD_AND_FAST;
+    config->buffer_timeout = 65535;
+    config->unknown_bus_state_timeout = 65535;
+    config->inactive_timeout = I2C_MASTER_INACTIVE_TIMEOUT_DISABLED;
+    config->sda_scl_rise_time_ns = 215;
+}
+
+static enum status_code _i2c_master_set_config(struct i2c_master_module *const module, const struct i2c_master_config *const config)
+{
+    SercomI2cm *const i2c_module = &(module->hw->I2CM);
+    uint32_t tmp_ctrla = 0;
+
+    module->unknown_bus_state_timeout = config->unknown_bus_state_timeout;
+    module->buffer_timeout = config->buffer_timeout;
+
+    tmp_ctrla |= config->transfer_speed;
+    if (config->scl_low_timeout) tmp_ctrla |= SERCOM_I2CM_CTRLA_LOWTOUTEN;
+    if (config->inactive_timeout != I2C_MASTER_INACTIVE_TIMEOUT_DISABLED) tmp_ctrla |= config->inactive_timeout;
+    if (config->scl_stretch_only_after_ack_bit || (config->transfer_speed == I2C_MASTER_SPEED_HIGH_SPEED)) {
+        tmp_ctrla |= SERCOM_I2CM_CTRLA_SCLSM;
+    }
+    i2c_module->CTRLA.reg |= tmp_ctrla;
+    i2c_module->CTRLB.reg = SERCOM_I2CM_CTRLB_SMEN;
+
+    uint32_t fgclk = system_gclk_chan_get_hz(SERCOM0_GCLK_ID_CORE);
+    uint32_t fscl = 1000 * config->baud_rate;
+    uint32_t trise = config->sda_scl_rise_time_ns;
+    int32_t tmp_baud = (int32_t)((fgclk - fscl * (10 + (fgclk * 0.000000001) * trise) + 2 * fscl - 1) / (2 * fscl));
+
+    if (tmp_baud > 255 || tmp_baud < 0) return STATUS_ERR_BAUDRATE_UNAVAILABLE;
+    i2c_module->BAUD.reg = SERCOM_I2CM_BAUD_BAUD(tmp_baud);
+    return STATUS_OK;
+}
+
+enum status_code i2c_master_init(struct i2c_master_module *const module, Sercom *const hw, const struct i2c_master_config *const config)
+{
+    module->hw = hw;
+    SercomI2cm *const i2c_module = &(module->hw->I2CM);
+
+    AddIrqs();
+    sercomInits++;
+    if (i2c_module->CTRLA.reg & SERCOM_I2CM_CTRLA_ENABLE) return STATUS_ERR_DENIED;
+    if (i2c_module->CTRLA.reg & SERCOM_I2CM_CTRLA_SWRST) return STATUS_BUSY;
+
+    sercom.module = module;
+    module->registered_callback = 0;
+    module->enabled_callback = 0;
+    module->buffer_length = 0;
+    module->buffer_remaining = 0;
+    module->status = STATUS_OK;
+    module->buffer = NULL;
+
+    i2c_module->CTRLA.reg = SERCOM_I2CM_CTRLA_MODE_I2C_MASTER;
+    return _i2c_master_set_config(module, config);
+}
+
+void i2c_master_enable(const struct i2c_master_module *const module)
+{
+    SercomI2cm *const i2c_module = &(module->hw->I2CM);
+    uint32_t timeout_counter = 0;
+
+    _i2c_master_wait_for_sync(module);
+    i2c_module->CTRLA.reg |= SERCOM_I2CM_CTRLA_ENABLE;
+    sercom.nvic = true;
+
+    // Start timeout if bus state is unknown
+    while (!(i2c_module->STATUS.reg & SERCOM_I2CM_STATUS_BUSSTATE(1))) {
+        timeout_counter++;
+        if (timeout_counter >= (module->unknown_bus_state_timeout)) {
+            // Timeout, force bus state to idle
+            i2c_module->STATUS.reg = SERCOM_I2CM_STATUS_BUSSTATE(1);
+            return;
+        }
+    }
+}
+
+void i2c_master_disable(const struct i2c_master_module *const module)
+{
+    SercomI2cm *const i2c_module = &(module->hw->I2CM);
+
+    sercom.nvic = false;
+    _i2c_master_wait_for_sync(module);
+    i2c_module->INTENCLR.reg = kIntMask;
+    i2c_module->INTFLAG.reg = kIntMask;
+    i2c_module->CTRLA.reg &= ~SERCOM_I2CM_CTRLA_ENABLE;
+}
+
+void i2c_master_reset(struct i2c_master_module *const module)
+{
+    SercomI2cm *const i2c_module = &(module->hw->I2CM);
+
+    _i2c_master_wait_for_sync(module);
+    i2c_master_disable(module);
+    _i2c_master_wait_for_sync(module);
+    i2c_module->CTRLA.reg = SERCOM_I2CM_CTRLA_SWRST;
+}
+
+void i2c_master_send_stop(struct i2c_master_module *const module)
+{
+    SercomI2cm *const i2c_module = &(module->hw->I2CM);
+
+    _i2c_master_wait_for_sync(module);
+    i2c_module->CTRLB.reg |= SERCOM_I2CM_CTRLB_CMD(3);
+}
+
+void i2c_master_dma_set_transfer(struct i2c_master_module *const module,
+                                 uint16_t address,
+                                 uint8_t length,
+                                 enum i2c_transfer_direction direction)
+{
+    module->hw->I2CM.ADDR.reg = SERCOM_I2CM_ADDR_ADDR(address << 1) | SERCOM_I2CM_ADDR_LENEN | SERCOM_I2CM_ADDR_LEN(length) | direction;
+}
+
+static void _i2c_master_read(struct i2c_master_module *const module)
+{
+    SercomI2cm *const i2c_module = &(module->hw->I2CM);
+    bool sclsm_flag = (i2c_module->CTRLA.reg & SERCOM_I2CM_CTRLA_SCLSM) != 0;
+
+    // Find index to save next value in buffer
+    uint16_t buffer_index = module->buffer_length;
+    buffer_index -= module->buffer_remaining;
+    module->buffer_remaining--;
+
+    if (sclsm_flag) {
+        if (module->send_nack && module->buffer_remaining == 1) i2c_module->CTRLB.reg |= SERCOM_I2CM_CTRLB_ACKACT;
+    } else {
+        if (module->send_nack && module->buffer_remaining == 0) i2c_module->CTRLB.reg |= SERCOM_I2CM_CTRLB_ACKACT;
+    }
+    if (module->buffer_remaining == 0 && module->send_stop) {
+        _i2c_master_wait_for_sync(module);
+        i2c_module->CTRLB.reg |= SERCOM_I2CM_CTRLB_CMD(3);
+    }
+
+    // Read byte from slave and put in buffer
+    _i2c_master_wait_for_sync(module);
+    module->buffer[buffer_index] = i2c_module->DATA.reg;
+}
+
+static void _i2c_master_write(struct i2c_master_module *const module)
+{
+    SercomI2cm *const i2c_module = &(module->hw->I2CM);
+
+    // Check for ack from slave
+    if (i2c_module->STATUS.reg & SERCOM_I2CM_STATUS_RXNACK) {
+        module->status = STATUS_ERR_OVERFLOW;
+        return;
+    }
+
+    uint16_t buffer_index = module->buffer_length;
+    buffer_index -= module->buffer_remaining;
+    module->buffer_remaining--;
+
+    _i2c_master_wait_for_sync(module);
+    i2c_module->DATA.reg = module->buffer[buffer_index];
+}
+
+static void _i2c_master_async_address_response(struct i2c_master_module *const module)
+{
+    SercomI2cm *const i2c_module = &(module->hw->I2CM);
+
+    if (i2c_module->INTFLAG.reg & SERCOM_I2CM_INTFLAG_MB) {
+        i2c_module->INTFLAG.reg = SERCOM_I2CM_INTENCLR_MB;
+        if (i2c_module->STATUS.reg & SERCOM_I2CM_STATUS_ARBLOST) {
+            module->status = STATUS_ERR_PACKET_COLLISION;
+        } else if (i2c_module->STATUS.reg & SERCOM_I2CM_STATUS_RXNACK) {
+            // No slave responds
+            module->status = STATUS_ERR_BAD_ADDRESS;
+            module->buffer_remaining = 0;
+            if (module->send_stop) {
+                _i2c_master_wait_for_sync(module);
+                i2c_module->CTRLB.reg |= SERCOM_I2CM_CTRLB_CMD(3);
+            }
+        }
+    }
+
+    module->buffer_length = module->buffer_remaining;
+    if (module->status == STATUS_BUSY) {
+        if (module->transfer_direction == I2C_TRANSFER_WRITE) {
+            _i2c_master_write(module);
+        } else {
+            _i2c_master_read(module);
+        }
+    }
+}
+
+void i2c_master_register_callback(struct i2c_master_module *const module,
+                                  i2c_master_callback_t callback,
+                                  enum i2c_master_callback callback_type)
+{
+    module->callbacks[callback_type] = callback;
+    module->registered_callback |= (1 << callback_type);
+}
+
+void i2c_master_enable_callback(struct i2c_master_module *const module, enum i2c_master_callback callback_type)
+{
+    module->enabled_callback |= (1 << callback_type);
+}
+
+static enum status_code _i2c_master_read_packet(struct i2c_master_module *const module, struct i2c_master_packet *const packet)
+{
+    SercomI2cm *const i2c_module = &(module->hw->I2CM);
+
+    module->buffer = packet->data;
+    module->buffer_remaining = packet->data_length;
+    module->transfer_direction = I2C_TRANSFER_READ;
+    module->status = STATUS_BUSY;
+
+    bool sclsm_flag = (i2c_module->CTRLA.reg & SERCOM_I2CM_CTRLA_SCLSM) != 0;
+    if (sclsm_flag && packet->data_length == 1) {
+        i2c_module->CTRLB.reg |= SERCOM_I2CM_CTRLB_ACKACT;
+    } else {
+        i2c_module->CTRLB.reg &= ~SERCOM_I2CM_CTRLB_ACKACT;
+    }
+
+    i2c_module->INTENSET.reg = SERCOM_I2CM_INTENSET_MB | SERCOM_I2CM_INTENSET_SB;
+    i2c_module->ADDR.reg = (packet->address << 1) | I2C_TRANSFER_READ;
+    return STATUS_OK;
+}
+
+enum status_code i2c_master_read_packet_job(struct i2c_master_module *const module, struct i2c_master_packet *const packet)
+{
+    if (module->buffer_remaining > 0) return STATUS_BUSY;
+    module->send_stop = true;
+    module->send_nack = true;
+    return _i2c_master_read_packet(module, packet);
+}
+
+static enum status_code _i2c_master_write_packet(struct i2c_master_module *const module, struct i2c_master_packet *const packet)
+{
+    SercomI2cm *const i2c_module = &(module->hw->I2CM);
+
+    i2c_module->CTRLB.reg &= ~SERCOM_I2CM_CTRLB_ACKACT;
+
+    module->buffer = packet->data;
+    module->buffer_remaining = packet->data_length;
+    module->transfer_direction = I2C_TRANSFER_WRITE;
+    module->status = STATUS_BUSY;
+
+    i2c_module->INTENSET.reg = SERCOM_I2CM_INTENSET_MB | SERCOM_I2CM_INTENSET_SB;
+    i2c_module->ADDR.reg = (packet->address << 1) | I2C_TRANSFER_WRITE;
+    return STATUS_OK;
+}
+
+enum status_code i2c_master_write_packet_job(struct i2c_master_module *const module, struct i2c_master_packet *const packet)
+{
+    if (module->buffer_remaining > 0) return STATUS_BUSY;
+    module->send_stop = true;
+    module->send_nack = true;
+    return _i2c_master_write_packet(module, packet);
+}
+
+enum status_code i2c_master_write_packet_job_no_stop(struct i2c_master_module *const module, struct i2c_master_packet *const packet)
+{
+    if (module->buffer_remaining > 0) return STATUS_BUSY;
+    module->send_stop = false;
+    module->send_nack = true;
+    return _i2c_master_write_packet(module, packet);
+}
+
+}  // extern "C"
+
+/// _i2c_master_interrupt_handler of SERCOM0
+static void SercomIrqHandler()
+{
+    struct i2c_master_module *module = sercom.module;
+    SercomI2cm *const i2c_module = &(module->hw->I2CM);
+    bool sclsm_flag = (i2c_module->CTRLA.reg & SERCOM_I2CM_CTRLA_SCLSM) != 0;
+
+    busStats[sercom.address].sercomIrqs++;
+
+    // Combine callback registered and enabled masks
+    uint8_t callback_mask = module->enabled_callback;
+    callback_mask &= module->registered_callback;
+
+    if ((module->buffer_length <= 0) && (module->buffer_remaining > 0)) {
+        // Address response
+        _i2c_master_async_address_response(module);
+    } else if ((module->buffer_length > 0) && (module->buffer_remaining <= 0) && (module->status == STATUS_BUSY) &&
+               (module->transfer_direction == I2C_TRANSFER_WRITE)) {
+        // Buffer write is done: stop packet operation
+        i2c_module->INTENCLR.reg = SERCOM_I2CM_INTENCLR_MB | SERCOM_I2CM_INTENCLR_SB;
+        module->buffer_length = 0;
+        module->status = STATUS_OK;
+
+        if (module->send_stop) {
+            _i2c_master_wait_for_sync(module);
+            i2c_module->CTRLB.reg |= SERCOM_I2CM_CTRLB_CMD(3);
+        } else {
+            i2c_module->INTFLAG.reg = SERCOM_I2CM_INTFLAG_MB;
+        }
+        if (callback_mask & (1 << I2C_MASTER_CALLBACK_WRITE_COMPLETE)) {
+            module->callbacks[I2C_MASTER_CALLBACK_WRITE_COMPLETE](module);
+        }
+    } else if ((module->buffer_length > 0) && (module->buffer_remaining > 0)) {
+        // Continue buffer write or read, unless bus ownership is lost
+        if ((!(i2c_module->STATUS.reg & SERCOM_I2CM_STATUS_BUSSTATE(2))) && (!(sclsm_flag && (module->buffer_remaining == 1)))) {
+            module->status = STATUS_ERR_PACKET_COLLISION;
+        } else if (module->transfer_direction == I2C_TRANSFER_WRITE) {
+            _i2c_master_write(module);
+        } else {
+            _i2c_master_read(module);
+        }
+    }
+
+    // Read buffer transfer is complete
+    if ((module->buffer_length > 0) && (module->buffer_remaining <= 0) && (module->status == STATUS_BUSY) &&
+        (module->transfer_direction == I2C_TRANSFER_READ)) {
+        if (i2c_module->INTFLAG.reg & SERCOM_I2CM_INTFLAG_SB) {
+            i2c_module->INTFLAG.reg = SERCOM_I2CM_INTFLAG_SB;
+        }
+        i2c_module->INTENCLR.reg = SERCOM_I2CM_INTENCLR_MB | SERCOM_I2CM_INTENCLR_SB;
+        module->buffer_length = 0;
+        module->status = STATUS_OK;
+
+        if (callback_mask & (1 << I2C_MASTER_CALLBACK_READ_COMPLETE)) {
+            module->callbacks[I2C_MASTER_CALLBACK_READ_COMPLETE](module);
+        }
+    }
+
+    // Error: send NACK and STOP unless arbitration is lost
+    if ((module->status != STATUS_BUSY) && (module->status != STATUS_OK)) {
+        i2c_module->INTENCLR.reg = SERCOM_I2CM_INTENCLR_MB | SERCOM_I2CM_INTENCLR_SB;
+        module->buffer_length = 0;
+        module->buffer_remaining = 0;
+
+        if ((module->status != STATUS_ERR_PACKET_COLLISION) && module->send_stop) {
+            _i2c_master_wait_for_sync(module);
+            i2c_module->CTRLB.reg |= SERCOM_I2CM_CTRLB_ACKACT | SERCOM_I2CM_CTRLB_CMD(3);
+        }
+        if (callback_mask & (1 << I2C_MASTER_CALLBACK_ERROR)) {
+            module->callbacks[I2C_MASTER_CALLBACK_ERROR](module);
+        }
+    }
+}
+
+/******************************************************************************
+ * ASF DMAC driver (dma.c)
+ ******************************************************************************/
+
+/// DMAC_Handler: transfer complete of each channel
+static void DmacIrqHandler()
+{
+    for (uint8_t i = 0; i < channelCount; i++) {
+        struct dma_resource *resource = channels[i].resource;
+        uint8_t bit = uint8_t(1u << resource->channel_id);
+
+        if (!(dmacPending & bit)) continue;
+        dmacPending &= uint8_t(~bit);
+        resource->job_status = STATUS_OK;
+        resource->transfered_size = channels[i].descriptor.BTCNT.reg;
+        if ((resource->callback_enable & (1 << DMA_CALLBACK_TRANSFER_DONE)) && resource->callback[DMA_CALLBACK_TRANSFER_DONE] != NULL) {
+            resource->callback[DMA_CALLBACK_TRANSFER_DONE](resource);
+        }
+    }
+}
+
+extern "C" {
+
+void dma_get_config_defaults(struct dma_resource_config *config)
+{
+    memset(config, 0, sizeof(*config));
+    config->trigger_action = DMA_TRIGGER_ACTION_TRANSACTION;
+}
+
+enum status_code dma_allocate(struct dma_resource *resource, struct dma_resource_config *config)
+{
+    AddIrqs();
+    if (channelCount >= sizeof(channels) / sizeof(channels[0])) return STATUS_ERR_NOT_FOUND;
+    if (config->trigger_action != DMA_TRIGGER_ACTION_BEAT) Violation("DMAC channel of the SERCOM not triggered per beat");
+
+    memset(resource, 0, sizeof(*resource));
+    resource->channel_id = channelCount;
+    resource->job_status = STATUS_OK;
+    channels[channelCount] = Channel();
+    channels[channelCount].resource = resource;
+    channels[channelCount].trigger = config->peripheral_trigger;
+    channelCount++;
+    return STATUS_OK;
+}
+
+void dma_descriptor_get_config_defaults(struct dma_descriptor_config *config)
+{
+    memset(config, 0, sizeof(*config));
+    config->descriptor_valid = true;
+    config->beat_size = DMA_BEAT_SIZE_BYTE;
+    config->src_increment_enable = true;
+    config->dst_increment_enable = true;
+}
+
+void dma_descriptor_create(DmacDescriptor *descriptor, struct dma_descriptor_config *config)
+{
+    descriptor->BTCTRL.reg = uint16_t((config->descriptor_valid ? DMAC_BTCTRL_VALID : 0) | (config->beat_size << DMAC_BTCTRL_BEATSIZE_Pos) |
+                                      (config->src_increment_enable ? DMAC_BTCTRL_SRCINC : 0) |
+                                      (config->dst_increment_enable ? DMAC_BTCTRL_DSTINC : 0));
+    descriptor->BTCNT.reg = config->block_transfer_count;
+    descriptor->SRCADDR.reg = config->source_address;
+    descriptor->DSTADDR.reg = config->destination_address;
+    descriptor->DESCADDR.reg = config->next_descriptor_address;
+}
+
+enum status_code dma_add_descriptor(struct dma_resource *resource, DmacDescriptor *descriptor)
+{
+    resource->descriptor = descriptor;
+    return STATUS_OK;
+}
+
+void dma_register_callback(struct dma_resource *resource, dma_callback_t callback, enum dma_callback_type type)
+{
+    resource->callback[type] = callback;
+}
+
+void dma_enable_callback(struct dma_resource *resource, enum dma_callback_type type)
+{
+    resource->callback_enable |= uint8_t(1u << type);
+}
+
+enum status_code dma_start_transfer_job(struct dma_resource *resource)
+{
+    Channel &channel = channels[resource->channel_id];
+    const DmacDescriptor &descriptor = *resource->descriptor;
+
+    if (resource->job_status == STATUS_BUSY) return STATUS_BUSY;
+    if (descriptor.BTCNT.reg == 0) return STATUS_ERR_INVALID_ARG;
+
+    bool tx = (channel.trigger == SERCOM0_DMAC_ID_TX);
+    uint32_t peripheral = tx ? descriptor.DSTADDR.reg : descriptor.SRCADDR.reg;
+    uint16_t memoryIncrement = tx ? DMAC_BTCTRL_SRCINC : DMAC_BTCTRL_DSTINC;
+    uint16_t peripheralIncrement = tx ? DMAC_BTCTRL_DSTINC : DMAC_BTCTRL_SRCINC;
+    if (!(descriptor.BTCTRL.reg & DMAC_BTCTRL_VALID) || peripheral != DataAddress() || (descriptor.BTCTRL.reg & peripheralIncrement) ||
+        !(descriptor.BTCTRL.reg & memoryIncrement)) {
+        Violation("DMAC descriptor does not move bytes between memory and SERCOM0 DATA");
+        return STATUS_ERR_INVALID_ARG;
+    }
+
+    resource->job_status = STATUS_BUSY;
+    channel.descriptor = descriptor;
+    channel.active = true;
+    channel.done = 0;
+    TriggerDma();
+    return STATUS_OK;
+}
+
+void dma_abort_job(struct dma_resource *resource)
+{
+    Channel &channel = channels[resource->channel_id];
+
+    channel.active = false;
+    dmacPending &= uint8_t(~(1u << resource->channel_id));
+    resource->transfered_size = channel.done;
+    resource->job_status = STATUS_ABORTED;
+}
+
+/******************************************************************************
+ * PORT and GCLK
+ ******************************************************************************/
+
+void port_get_config_defaults(struct port_config *const config)
+{
+    config->direction = PORT_PIN_DIR_INPUT;
+    config->input_pull = PORT_PIN_PULL_UP;
+    config->powersave = false;
+}
+
+void port_pin_set_config(const uint8_t gpio_pin, const struct port_config *const config)
+{
+    pinOutput[gpio_pin % 64] = (config->direction != PORT_PIN_DIR_INPUT);
+}
+
+void port_pin_set_output_level(const uint8_t gpio_pin, const bool level)
+{
+    pinLow[gpio_pin % 64] = !level;
+}
+
+/// The devices never hold a line: a line is low only while the pin drives it
+bool port_pin_get_input_level(const uint8_t gpio_pin)
+{
+    return !(pinOutput[gpio_pin % 64] && pinLow[gpio_pin % 64]);
+}
+
+uint32_t system_gclk_chan_get_hz(const uint8_t channel)
+{
+    (void)channel;
+    return kCpuHz;
+}
+
+}  // extern "C"
+
+/******************************************************************************
+ * Interrupt lines
+ ******************************************************************************/
+
+static bool SercomIrqPending()
+{
+    return sercom.nvic && (sercom.intflag & sercom.inten & kIntMask);
+}
+
+static bool DmacIrqPending()
+{
+    return dmacPending != 0;
+}
+
+static const Irq sercomIrq = {"SERCOM0", kSercomIrqCycles, SercomIrqPending, SercomIrqHandler};
+static const Irq dmacIrq = {"DMAC", kDmacIrqCycles, DmacIrqPending, DmacIrqHandler};
+
+/// Registered by the first i2c_master_init or dma_allocate
+static void AddIrqs()
+{
+    static bool added = false;
+
+    if (added) return;
+    AddIrq(&sercomIrq);
+    AddIrq(&dmacIrq);
+    added = true;
+}
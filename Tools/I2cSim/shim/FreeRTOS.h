@@ -0,0 +1,32 @@
+/**
+ * @file        FreeRTOS.h
+ * @brief       Host stand-in for the FreeRTOS types and macros that the I2C driver and the sensor drivers use.
+ * @details     Part of Tools/I2cSim. The kernel functions are implemented by SimKernel.cpp on its virtual clock.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef void *TaskHandle_t;
+typedef void *SemaphoreHandle_t;
+typedef void *QueueHandle_t;
+
+#define configMAX_PRIORITIES 5
+#define configMAX_TASK_NAME_LEN 8
+#define configTICK_RATE_HZ 1000
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(xTimeInMs) ((TickType_t)(xTimeInMs))
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+
+/// The simulated kernel switches tasks when the interrupt handler returns
+#define portYIELD_FROM_ISR(x) ((void)(x))
@@ -0,0 +1,16 @@
+/**
+ * @file        SerialConsole.h
+ * @brief       Host stand-in for the console: the messages of the drivers go to stderr with -v (see I2cSim.cpp)
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void SerialConsoleWriteString(const char *string);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,99 @@
+/**
+ * @file        asf.h
+ * @brief       Host stand-in for the ASF services used by the I2C driver and the sensor drivers
+ * @details     Status codes, delays, the PORT and GCLK calls of the bus recovery and the speed profiles, and the SERCOM
+ *              I2C master and DMAC drivers (i2c_master.h, dma.h). Implemented by SimSercom.cpp and SimKernel.cpp.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+/// Same values as the ASF status_codes.h
+enum status_code {
+    STATUS_OK = 0x00,
+    STATUS_VALID_DATA = 0x01,
+    STATUS_NO_CHANGE = 0x02,
+    STATUS_ABORTED = 0x04,
+    STATUS_BUSY = 0x05,
+    STATUS_SUSPEND = 0x06,
+    STATUS_ERR_IO = 0x10,
+    STATUS_ERR_REQ_FLUSHED = 0x11,
+    STATUS_ERR_TIMEOUT = 0x12,
+    STATUS_ERR_BAD_DATA = 0x13,
+    STATUS_ERR_NOT_FOUND = 0x14,
+    STATUS_ERR_UNSUPPORTED_DEV = 0x15,
+    STATUS_ERR_NO_MEMORY = 0x16,
+    STATUS_ERR_INVALID_ARG = 0x17,
+    STATUS_ERR_BAD_ADDRESS = 0x18,
+    STATUS_ERR_BAD_FORMAT = 0x1A,
+    STATUS_ERR_BAD_FRQ = 0x1B,
+    STATUS_ERR_DENIED = 0x1c,
+    STATUS_ERR_ALREADY_INITIALIZED = 0x1d,
+    STATUS_ERR_OVERFLOW = 0x1e,
+    STATUS_ERR_NOT_INITIALIZED = 0x1f,
+    STATUS_ERR_SAMPLERATE_UNAVAILABLE = 0x20,
+    STATUS_ERR_RESOLUTION_UNAVAILABLE = 0x21,
+    STATUS_ERR_BAUDRATE_UNAVAILABLE = 0x22,
+    STATUS_ERR_PACKET_COLLISION = 0x23,
+    STATUS_ERR_PROTOCOL = 0x24,
+    STATUS_ERR_PIN_MUX_INVALID = 0x25,
+};
+typedef enum status_code status_code_genare_t;
+
+#define ERR_INVALID_ARG (-8)  ///< status_code_t of the ASF common services
+
+#define COMPILER_ALIGNED(a) __attribute__((__aligned__(a)))
+
+#include "sercom.h"
+#include "dma.h"
+#include "i2c_master.h"
+#include "i2c_master_interrupt.h"
+
+#define SERCOM0_GCLK_ID_CORE 20
+#define SERCOM0_DMAC_ID_TX 2
+#define SERCOM0_DMAC_ID_RX 1
+
+#define PIN_PA08 8
+#define PIN_PA09 9
+#define PINMUX_PA08C_SERCOM0_PAD0 ((PIN_PA08 << 16) | 2)
+#define PINMUX_PA09C_SERCOM0_PAD1 ((PIN_PA09 << 16) | 2)
+
+enum port_pin_dir {
+    PORT_PIN_DIR_INPUT,
+    PORT_PIN_DIR_OUTPUT,
+    PORT_PIN_DIR_OUTPUT_WTH_READBACK,
+};
+
+enum port_pin_pull {
+    PORT_PIN_PULL_NONE,
+    PORT_PIN_PULL_UP,
+    PORT_PIN_PULL_DOWN,
+};
+
+struct port_config {
+    enum port_pin_dir direction;
+    enum port_pin_pull input_pull;
+    bool powersave;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void delay_ms(uint32_t delay);
+
+void port_get_config_defaults(struct port_config *const config);
+void port_pin_set_config(const uint8_t gpio_pin, const struct port_config *const config);
+void port_pin_set_output_level(const uint8_t gpio_pin, const bool level);
+bool port_pin_get_input_level(const uint8_t gpio_pin);
+
+uint32_t system_gclk_chan_get_hz(const uint8_t channel);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,100 @@
+/**
+ * @file        dma.h
+ * @brief       Host stand-in for the ASF DMAC driver: the channels and descriptors the I2C driver uses on the sensor bus
+ * @details     The simulated DMAC (SimSercom.cpp) moves one beat per SERCOM trigger between memory and the DATA register,
+ *              and calls the TRANSFER_DONE callback from its interrupt after the last beat. Included by asf.h.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DMAC_BTCTRL_VALID (1u << 0)
+#define DMAC_BTCTRL_BEATSIZE_Pos 8
+#define DMAC_BTCTRL_SRCINC (1u << 10)
+#define DMAC_BTCTRL_DSTINC (1u << 11)
+
+/// Transfer descriptor, as read by the DMAC from SRAM
+typedef struct {
+    struct {
+        uint16_t reg;
+    } BTCTRL;
+    struct {
+        uint16_t reg;
+    } BTCNT;
+    struct {
+        uint32_t reg;
+    } SRCADDR;  ///< Address one past the last beat when SRCINC is set
+    struct {
+        uint32_t reg;
+    } DSTADDR;  ///< Address one past the last beat when DSTINC is set
+    struct {
+        uint32_t reg;
+    } DESCADDR;
+} DmacDescriptor;
+
+enum dma_beat_size {
+    DMA_BEAT_SIZE_BYTE = 0,
+    DMA_BEAT_SIZE_HWORD,
+    DMA_BEAT_SIZE_WORD,
+};
+
+enum dma_transfer_trigger_action {
+    DMA_TRIGGER_ACTION_BLOCK = 0,
+    DMA_TRIGGER_ACTION_BEAT = 2,
+    DMA_TRIGGER_ACTION_TRANSACTION = 3,
+};
+
+enum dma_callback_type {
+    DMA_CALLBACK_TRANSFER_ERROR,
+    DMA_CALLBACK_TRANSFER_DONE,
+    DMA_CALLBACK_CHANNEL_SUSPEND,
+    DMA_CALLBACK_N,
+};
+
+struct dma_resource;
+typedef void (*dma_callback_t)(struct dma_resource *const resource);
+
+struct dma_resource_config {
+    uint8_t peripheral_trigger;
+    enum dma_transfer_trigger_action trigger_action;
+};
+
+struct dma_descriptor_config {
+    bool descriptor_valid;
+    enum dma_beat_size beat_size;
+    bool src_increment_enable;
+    bool dst_increment_enable;
+    uint16_t block_transfer_count;
+    uint32_t source_address;
+    uint32_t destination_address;
+    uint32_t next_descriptor_address;
+};
+
+struct dma_resource {
+    uint8_t channel_id;
+    dma_callback_t callback[DMA_CALLBACK_N];
+    uint8_t callback_enable;
+    volatile enum status_code job_status;
+    uint32_t transfered_size;
+    DmacDescriptor *descriptor;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void dma_get_config_defaults(struct dma_resource_config *config);
+enum status_code dma_allocate(struct dma_resource *resource, struct dma_resource_config *config);
+void dma_descriptor_get_config_defaults(struct dma_descriptor_config *config);
+void dma_descriptor_create(DmacDescriptor *descriptor, struct dma_descriptor_config *config);
+enum status_code dma_add_descriptor(struct dma_resource *resource, DmacDescriptor *descriptor);
+void dma_register_callback(struct dma_resource *resource, dma_callback_t callback, enum dma_callback_type type);
+void dma_enable_callback(struct dma_resource *resource, enum dma_callback_type type);
+enum status_code dma_start_transfer_job(struct dma_resource *resource);
+void dma_abort_job(struct dma_resource *resource);
+
+#ifdef __cplusplus
+}
+#endif
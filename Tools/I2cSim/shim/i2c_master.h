@@ -0,0 +1,111 @@
+/**
+ * @file        i2c_master.h
+ * @brief       Host stand-in for the ASF SERCOM I2C master driver (callback mode)
+ * @details     Same module structure and functions as ASF 3. SimSercom.cpp implements them on the simulated SERCOM
+ *              registers with the code paths of the ASF sources, so the interrupt handler behaves as on the board.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sercom.h"
+
+enum i2c_transfer_direction {
+    I2C_TRANSFER_WRITE = 0,
+    I2C_TRANSFER_READ = 1,
+};
+
+enum i2c_master_callback {
+    I2C_MASTER_CALLBACK_WRITE_COMPLETE = 0,
+    I2C_MASTER_CALLBACK_READ_COMPLETE = 1,
+    I2C_MASTER_CALLBACK_ERROR = 2,
+    I2C_MASTER_CALLBACK_N,
+};
+
+enum i2c_master_baud_rate {
+    I2C_MASTER_BAUD_RATE_100KHZ = 100,
+    I2C_MASTER_BAUD_RATE_400KHZ = 400,
+};
+
+enum i2c_master_transfer_speed {
+    I2C_MASTER_SPEED_STANDARD_AND_FAST = SERCOM_I2CM_CTRLA_SPEED(0),
+    I2C_MASTER_SPEED_FAST_MODE_PLUS = SERCOM_I2CM_CTRLA_SPEED(1),
+    I2C_MASTER_SPEED_HIGH_SPEED = SERCOM_I2CM_CTRLA_SPEED(2),
+};
+
+enum i2c_master_inactive_timeout {
+    I2C_MASTER_INACTIVE_TIMEOUT_DISABLED = SERCOM_I2CM_CTRLA_INACTOUT(0),
+    I2C_MASTER_INACTIVE_TIMEOUT_55US = SERCOM_I2CM_CTRLA_INACTOUT(1),
+    I2C_MASTER_INACTIVE_TIMEOUT_105US = SERCOM_I2CM_CTRLA_INACTOUT(2),
+    I2C_MASTER_INACTIVE_TIMEOUT_205US = SERCOM_I2CM_CTRLA_INACTOUT(3),
+};
+
+struct i2c_master_module;
+typedef void (*i2c_master_callback_t)(struct i2c_master_module *const module);
+
+struct i2c_master_module {
+    Sercom *hw;
+    uint16_t unknown_bus_state_timeout;
+    uint16_t buffer_timeout;
+    bool ten_bit_address;
+    volatile uint8_t registered_callback;
+    volatile uint8_t enabled_callback;
+    volatile uint16_t buffer_length;
+    volatile uint16_t buffer_remaining;
+    volatile uint8_t *buffer;
+    volatile uint8_t transfer_direction;
+    volatile enum status_code status;
+    i2c_master_callback_t callbacks[I2C_MASTER_CALLBACK_N];
+    bool send_stop;
+    bool send_nack;
+};
+
+struct i2c_master_packet {
+    uint16_t address;
+    uint16_t data_length;
+    uint8_t *data;
+    bool ten_bit_address;
+    bool high_speed;
+    uint8_t hs_master_code;
+};
+
+struct i2c_master_config {
+    uint32_t baud_rate;
+    uint32_t baud_rate_high_speed;
+    enum i2c_master_transfer_speed transfer_speed;
+    uint8_t generator_source;
+    bool run_in_standby;
+    uint32_t start_hold_time;
+    uint16_t buffer_timeout;
+    uint16_t unknown_bus_state_timeout;
+    uint32_t pinmux_pad0;
+    uint32_t pinmux_pad1;
+    bool scl_low_timeout;
+    enum i2c_master_inactive_timeout inactive_timeout;
+    bool scl_stretch_only_after_ack_bit;
+    bool slave_scl_low_extend_timeout;
+    bool master_scl_low_extend_timeout;
+    uint16_t sda_scl_rise_time_ns;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void i2c_master_get_config_defaults(struct i2c_master_config *const config);
+enum status_code i2c_master_init(struct i2c_master_module *const module, Sercom *const hw, const struct i2c_master_config *const config);
+void i2c_master_enable(const struct i2c_master_module *const module);
+void i2c_master_disable(const struct i2c_master_module *const module);
+void i2c_master_reset(struct i2c_master_module *const module);
+void i2c_master_send_stop(struct i2c_master_module *const module);
+void i2c_master_dma_set_transfer(struct i2c_master_module *const module,
+                                 uint16_t address,
+                                 uint8_t length,
+                                 enum i2c_transfer_direction direction);
+void _i2c_master_wait_for_sync(const struct i2c_master_module *const module);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,24 @@
+/**
+ * @file        i2c_master_interrupt.h
+ * @brief       Host stand-in for the ASF I2C master job and callback functions (see i2c_master.h)
+ */
+
+#pragma once
+
+#include "i2c_master.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void i2c_master_register_callback(struct i2c_master_module *const module,
+                                  i2c_master_callback_t callback,
+                                  enum i2c_master_callback callback_type);
+void i2c_master_enable_callback(struct i2c_master_module *const module, enum i2c_master_callback callback_type);
+enum status_code i2c_master_read_packet_job(struct i2c_master_module *const module, struct i2c_master_packet *const packet);
+enum status_code i2c_master_write_packet_job(struct i2c_master_module *const module, struct i2c_master_packet *const packet);
+enum status_code i2c_master_write_packet_job_no_stop(struct i2c_master_module *const module, struct i2c_master_packet *const packet);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,20 @@
+/**
+ * @file        queue.h
+ * @brief       Host stand-in for the FreeRTOS queue functions used by the I2C driver and NAU7802.c (see SimKernel.cpp)
+ */
+
+#pragma once
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize);
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait);
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait);
+
+#ifdef __cplusplus
+}
+#endif
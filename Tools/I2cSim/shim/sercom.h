@@ -0,0 +1,137 @@
+/**
+ * @file        sercom.h
+ * @brief       Host stand-in for the SERCOM I2C master registers (component/sercom.h of the SAMD21 device pack)
+ * @details     In C++, every register access through SERCOM0->I2CM.<register>.reg is a call into the simulated SERCOM
+ *              (SimSercom.cpp), so I2cDriver.c, built as C++, drives it exactly as it drives the chip. The C sources only
+ *              pass the module around by pointer and see an incomplete type.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define SERCOM_I2CM_CTRLA_SWRST (1u << 0)
+#define SERCOM_I2CM_CTRLA_ENABLE (1u << 1)
+#define SERCOM_I2CM_CTRLA_MODE_I2C_MASTER (5u << 2)
+#define SERCOM_I2CM_CTRLA_SPEED_Pos 24
+#define SERCOM_I2CM_CTRLA_SPEED_Msk (3u << SERCOM_I2CM_CTRLA_SPEED_Pos)
+#define SERCOM_I2CM_CTRLA_SPEED(value) (SERCOM_I2CM_CTRLA_SPEED_Msk & ((uint32_t)(value) << SERCOM_I2CM_CTRLA_SPEED_Pos))
+#define SERCOM_I2CM_CTRLA_SCLSM (1u << 27)
+#define SERCOM_I2CM_CTRLA_INACTOUT(value) (0x30000000u & ((uint32_t)(value) << 28))
+#define SERCOM_I2CM_CTRLA_LOWTOUTEN (1u << 30)
+
+#define SERCOM_I2CM_CTRLB_SMEN (1u << 8)
+#define SERCOM_I2CM_CTRLB_CMD_Msk (3u << 16)
+#define SERCOM_I2CM_CTRLB_CMD(value) (SERCOM_I2CM_CTRLB_CMD_Msk & ((uint32_t)(value) << 16))
+#define SERCOM_I2CM_CTRLB_ACKACT (1u << 18)
+
+#define SERCOM_I2CM_BAUD_BAUD(value) (0xffu & (uint32_t)(value))
+#define SERCOM_I2CM_BAUD_BAUDLOW(value) (0xff00u & ((uint32_t)(value) << 8))
+
+#define SERCOM_I2CM_INTFLAG_MB (1u << 0)
+#define SERCOM_I2CM_INTFLAG_SB (1u << 1)
+#define SERCOM_I2CM_INTFLAG_ERROR (1u << 7)
+#define SERCOM_I2CM_INTENSET_MB SERCOM_I2CM_INTFLAG_MB
+#define SERCOM_I2CM_INTENSET_SB SERCOM_I2CM_INTFLAG_SB
+#define SERCOM_I2CM_INTENSET_ERROR SERCOM_I2CM_INTFLAG_ERROR
+#define SERCOM_I2CM_INTENCLR_MB SERCOM_I2CM_INTFLAG_MB
+#define SERCOM_I2CM_INTENCLR_SB SERCOM_I2CM_INTFLAG_SB
+#define SERCOM_I2CM_INTENCLR_ERROR SERCOM_I2CM_INTFLAG_ERROR
+
+#define SERCOM_I2CM_STATUS_BUSERR (1u << 0)
+#define SERCOM_I2CM_STATUS_ARBLOST (1u << 1)
+#define SERCOM_I2CM_STATUS_RXNACK (1u << 2)
+#define SERCOM_I2CM_STATUS_BUSSTATE_Msk (3u << 4)
+#define SERCOM_I2CM_STATUS_BUSSTATE(value) (SERCOM_I2CM_STATUS_BUSSTATE_Msk & ((uint32_t)(value) << 4))
+#define SERCOM_I2CM_STATUS_LOWTOUT (1u << 6)
+#define SERCOM_I2CM_STATUS_CLKHOLD (1u << 7)
+#define SERCOM_I2CM_STATUS_LENERR (1u << 10)
+
+#define SERCOM_I2CM_ADDR_ADDR(value) (0x7ffu & (uint32_t)(value))
+#define SERCOM_I2CM_ADDR_LENEN (1u << 13)
+#define SERCOM_I2CM_ADDR_LEN(value) (0xff0000u & ((uint32_t)(value) << 16))
+
+#ifdef __cplusplus
+
+extern "C++" {
+
+/// Registers of the simulated SERCOM
+enum SimSercomRegisterId {
+    SIM_SERCOM_CTRLA,
+    SIM_SERCOM_CTRLB,
+    SIM_SERCOM_BAUD,
+    SIM_SERCOM_INTENCLR,
+    SIM_SERCOM_INTENSET,
+    SIM_SERCOM_INTFLAG,
+    SIM_SERCOM_STATUS,
+    SIM_SERCOM_SYNCBUSY,
+    SIM_SERCOM_ADDR,
+    SIM_SERCOM_DATA,
+};
+
+uint32_t SimSercomRead(SimSercomRegisterId id);
+void SimSercomWrite(SimSercomRegisterId id, uint32_t value);
+
+/// One register: reads and writes have the side effects of the chip (flags cleared by writing one, commands, bus
+/// transfers started by ADDR and DATA). Read-modify-writes are a read then a write, as on the Cortex-M0+
+template <SimSercomRegisterId R>
+struct SimSercomRegister {
+    uint32_t unused;  ///< Gives each register its own address, for the DMAC descriptors
+
+    operator uint32_t() const { return SimSercomRead(R); }
+    SimSercomRegister &operator=(uint32_t value)
+    {
+        SimSercomWrite(R, value);
+        return *this;
+    }
+    SimSercomRegister &operator|=(uint32_t value) { return *this = SimSercomRead(R) | value; }
+    SimSercomRegister &operator&=(uint32_t value) { return *this = SimSercomRead(R) & value; }
+};
+
+typedef struct {
+    struct {
+        SimSercomRegister<SIM_SERCOM_CTRLA> reg;
+    } CTRLA;
+    struct {
+        SimSercomRegister<SIM_SERCOM_CTRLB> reg;
+    } CTRLB;
+    struct {
+        SimSercomRegister<SIM_SERCOM_BAUD> reg;
+    } BAUD;
+    struct {
+        SimSercomRegister<SIM_SERCOM_INTENCLR> reg;
+    } INTENCLR;
+    struct {
+        SimSercomRegister<SIM_SERCOM_INTENSET> reg;
+    } INTENSET;
+    struct {
+        SimSercomRegister<SIM_SERCOM_INTFLAG> reg;
+    } INTFLAG;
+    struct {
+        SimSercomRegister<SIM_SERCOM_STATUS> reg;
+    } STATUS;
+    struct {
+        SimSercomRegister<SIM_SERCOM_SYNCBUSY> reg;
+    } SYNCBUSY;
+    struct {
+        SimSercomRegister<SIM_SERCOM_ADDR> reg;
+    } ADDR;
+    struct {
+        SimSercomRegister<SIM_SERCOM_DATA> reg;
+    } DATA;
+} SercomI2cm;
+
+typedef union Sercom {
+    SercomI2cm I2CM;
+} Sercom;
+
+}  // extern "C++"
+
+extern Sercom simSercom0;  ///< The sensor bus SERCOM. The board has others; the driver only uses this one
+#define SERCOM0 (&simSercom0)
+
+#else
+
+typedef union Sercom Sercom;
+
+#endif
@@ -0,0 +1,38 @@
+/**
+ * @file        task.h
+ * @brief       Host stand-in for the FreeRTOS task functions used by the I2C driver, the sensor drivers, LedFrame.c, the
+ *              NAU7802 stream and the console logger task (see SimKernel.cpp)
+ */
+
+#pragma once
+
+#include "FreeRTOS.h"
+
+/// Tasks only switch inside kernel calls and interrupts only run while a task waits, so a critical section has nothing to mask
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+
+#define tskIDLE_PRIORITY ((UBaseType_t)0U)
+
+typedef void (*TaskFunction_t)(void *);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode,
+                       const char *pcName,
+                       uint16_t usStackDepth,
+                       void *pvParameters,
+                       UBaseType_t uxPriority,
+                       TaskHandle_t *pxCreatedTask);
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify);
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait);
+
+void vTaskDelay(TickType_t xTicksToDelay);
+void vTaskSuspend(TaskHandle_t xTaskToSuspend);
+TickType_t xTaskGetTickCount(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,394 @@
+/**
+ * @file        LogDecoder.cpp
+ * @brief       Host decoder for the binary (deferred) logging mode of the Application console.
+ * @details     Reads the console capture (file or stdin), passes plain text through and turns every binary log record
+ *				(see Application/src/SerialConsole/BinaryLog.h) back into text. The ID of a record is the index of its
+ *				format entry in the binary_log section of the firmware ELF file. The entry gives the level and the address
+ *				of the format string, which is read from the loadable sections. The ELF must match the running image.
+ *
+ *				Build:	g++ -std=c++17 -O2 -o LogDecoder LogDecoder.cpp
+ *				Use:	LogDecoder [-l] Application.elf [capture.bin]
+ *						-l prefixes every decoded message with its log level.
+ *				For a live board, pipe the serial port into it, e.g. "stty -F /dev/ttyACM0 115200 raw && LogDecoder app.elf < /dev/ttyACM0"
+ *
+ * @copyright
+ * @author
+ * @date        October 16, 2026
+ * @version		0.2
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t kSync = 0xA5;        ///< BINARY_LOG_SYNC
+constexpr size_t kHeaderSize = 2;      ///< BINARY_LOG_HEADER_SIZE
+const char *const kLevelNames[] = {"INFO", "DEBUG", "WARNING", "ERROR", "FATAL"};
+
+/// Loadable sections of the ELF file, used to read the format entries and the format strings
+class ElfImage
+{
+   public:
+    bool Load(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+        data_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if (data_.size() < 52 || memcmp(data_.data(), "\x7f"
+                                                      "ELF",
+                                        4) != 0) {
+            return false;
+        }
+
+        const bool is64 = data_[4] == 2;
+        const uint64_t shoff = is64 ? Read(0x28, 8) : Read(0x20, 4);
+        const uint64_t shentsize = Read(is64 ? 0x3A : 0x2E, 2);
+        const uint64_t shnum = Read(is64 ? 0x3C : 0x30, 2);
+        const uint64_t shstrndx = Read(is64 ? 0x3E : 0x32, 2);
+        pointerSize_ = is64 ? 8 : 4;
+
+        const uint64_t names = shoff + shstrndx * shentsize;
+        if (shstrndx >= shnum || names + shentsize > data_.size()) return false;
+        const uint64_t namesOffset = is64 ? Read(names + 24, 8) : Read(names + 16, 4);
+
+        for (uint64_t i = 0; i < shnum; i++) {
+            const uint64_t sh = shoff + i * shentsize;
+            if (sh + shentsize > data_.size()) return false;
+            const uint64_t name = namesOffset + Read(sh, 4);
+            const uint32_t type = Read(sh + 4, 4);
+            const uint64_t flags = is64 ? Read(sh + 8, 8) : Read(sh + 8, 4);
+            const uint64_t addr = is64 ? Read(sh + 16, 8) : Read(sh + 12, 4);
+            const uint64_t offset = is64 ? Read(sh + 24, 8) : Read(sh + 16, 4);
+            const uint64_t size = is64 ? Read(sh + 32, 8) : Read(sh + 20, 4);
+            const uint32_t kProgBits = 1, kAlloc = 2;
+            if (type == kProgBits && (flags & kAlloc) && offset + size <= data_.size()) {
+                sections_.push_back({addr, offset, size});
+                if (name < data_.size() && strncmp(reinterpret_cast<const char *>(&data_[name]), "binary_log", data_.size() - name) == 0) {
+                    formats_ = sections_.back();
+                }
+            }
+        }
+        return formats_.size != 0;
+    }
+
+    /// Reads the format entry of an ID (BinaryLogFormat: format pointer, then the level padded to a pointer). Returns
+    /// the format string, or nullptr if the ID or the string is not in the image
+    const char *FormatOf(uint64_t id, uint8_t &level) const
+    {
+        const uint64_t entrySize = 2 * pointerSize_;
+        if (id >= formats_.size / entrySize) return nullptr;
+        const uint64_t entry = formats_.offset + id * entrySize;
+        level = data_[entry + pointerSize_];
+        return StringAt(Read(entry, pointerSize_));
+    }
+
+    /// Returns the NUL-terminated string at a target address, or nullptr if it is not in the image
+    const char *StringAt(uint64_t address) const
+    {
+        for (const Section &s : sections_) {
+            if (address >= s.addr && address < s.addr + s.size) {
+                const char *start = reinterpret_cast<const char *>(&data_[s.offset + (address - s.addr)]);
+                if (memchr(start, '\0', s.size - (address - s.addr)) == nullptr) return nullptr;
+                return start;
+            }
+        }
+        return nullptr;
+    }
+
+   private:
+    struct Section {
+        uint64_t addr;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    uint64_t Read(uint64_t offset, int bytes) const  // ELF files of the SAMD21 are little endian
+    {
+        uint64_t value = 0;
+        for (int i = bytes - 1; i >= 0; i--) value = (value << 8) | data_[offset + i];
+        return value;
+    }
+
+    std::vector<uint8_t> data_;
+    std::vector<Section> sections_;
+    Section formats_ = {0, 0, 0};  ///< The binary_log section
+    int pointerSize_ = 4;
+};
+
+/// Read position inside the payload of one record
+class RecordReader
+{
+   public:
+    RecordReader(const uint8_t *data, size_t len) : data_(data), len_(len) {}
+
+    bool Varint(uint64_t &value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos_ >= len_) return false;
+            const uint8_t byte = data_[pos_++];
+            value |= uint64_t(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        return false;
+    }
+
+    bool Signed(int64_t &value)
+    {
+        uint64_t raw;
+        if (!Varint(raw)) return false;
+        value = int64_t(raw >> 1) ^ -int64_t(raw & 1);
+        return true;
+    }
+
+    bool Double(double &value)
+    {
+        if (pos_ + 8 > len_) return false;
+        uint64_t raw = 0;
+        for (int i = 7; i >= 0; i--) raw = (raw << 8) | data_[pos_ + i];
+        pos_ += 8;
+        memcpy(&value, &raw, sizeof(value));
+        return true;
+    }
+
+    bool String(std::string &value)
+    {
+        uint64_t len;
+        if (!Varint(len) || pos_ + len > len_) return false;
+        value.assign(reinterpret_cast<const char *>(&data_[pos_]), len);
+        pos_ += len;
+        return true;
+    }
+
+    bool AtEnd() const { return pos_ == len_; }
+
+   private:
+    const uint8_t *data_;
+    size_t len_;
+    size_t pos_ = 0;
+};
+
+/// Appends one printf conversion to out, using the host snprintf
+template <typename T>
+void AppendFormatted(std::string &out, const std::string &spec, T value)
+{
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), spec.c_str(), value);
+    out += buffer;
+}
+
+/**
+ * Rebuilds the text of one record payload (format ID onwards). Walks the format string with the same rules as
+ * BinaryLogEncode. Integer sizes follow the target (int and long are 32 bits on the Cortex-M0+).
+ * Returns false if the ID is unknown or the payload does not match the format string.
+ */
+bool DecodeRecord(const ElfImage &elf, const uint8_t *payload, size_t len, bool showLevel, std::string &out)
+{
+    RecordReader reader(payload, len);
+
+    uint64_t id;
+    uint8_t level = 0;
+    if (!reader.Varint(id)) return false;
+    const char *format = elf.FormatOf(id, level);
+    if (format == nullptr) return false;
+
+    std::string text;
+    if (showLevel) {
+        text += "[";
+        text += level < sizeof(kLevelNames) / sizeof(kLevelNames[0]) ? kLevelNames[level] : "?";
+        text += "] ";
+    }
+
+    for (const char *p = format; *p != '\0'; p++) {
+        if (*p != '%') {
+            text += *p;
+            continue;
+        }
+        if (p[1] == '%') {
+            text += '%';
+            p++;
+            continue;
+        }
+
+        // Rebuild the conversion with '*' replaced by the recorded values and without the length modifier
+        std::string spec = "%";
+        p++;
+        while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0') spec += *p++;
+        int64_t star;
+        if (*p == '*') {
+            if (!reader.Signed(star)) return false;
+            spec += std::to_string(star);
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') spec += *p++;
+        }
+        if (*p == '.') {
+            spec += *p++;
+            if (*p == '*') {
+                if (!reader.Signed(star)) return false;
+                spec += std::to_string(star < 0 ? 0 : star);
+                p++;
+            } else {
+                while (*p >= '0' && *p <= '9') spec += *p++;
+            }
+        }
+
+        int bits = 32;  // int, long, size_t and pointers on the target
+        while (*p == 'h' || *p == 'l' || *p == 'z' || *p == 'j' || *p == 't' || *p == 'L') {
+            if (*p == 'h') bits = (bits == 16) ? 8 : 16;
+            if (*p == 'l' && p[1] == 'l') {
+                bits = 64;
+                p++;
+            }
+            if (*p == 'j') bits = 64;
+            p++;
+        }
+
+        const char conversion = *p;
+        switch (conversion) {
+            case 'd':
+            case 'i': {
+                int64_t value;
+                if (!reader.Signed(value)) return false;
+                if (bits == 8) value = int8_t(value);
+                if (bits == 16) value = int16_t(value);
+                if (bits == 32) value = int32_t(value);
+                AppendFormatted(text, spec + "ll" + conversion, (long long)value);
+                break;
+            }
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o': {
+                uint64_t value;
+                if (!reader.Varint(value)) return false;
+                if (bits < 64) value &= (uint64_t(1) << bits) - 1;
+                AppendFormatted(text, spec + "ll" + conversion, (unsigned long long)value);
+                break;
+            }
+            case 'c': {
+                uint64_t value;
+                if (!reader.Varint(value)) return false;
+                AppendFormatted(text, spec + 'c', int(value & 0xFF));
+                break;
+            }
+            case 'p': {
+                uint64_t value;
+                if (!reader.Varint(value)) return false;
+                AppendFormatted(text, spec + "#llx", (unsigned long long)value);
+                break;
+            }
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A': {
+                double value;
+                if (!reader.Double(value)) return false;
+                AppendFormatted(text, spec + conversion, value);
+                break;
+            }
+            case 's': {
+                std::string value;
+                if (!reader.String(value)) return false;
+                AppendFormatted(text, spec + 's', value.c_str());
+                break;
+            }
+            case 'n':
+                break;
+            default:
+                return false;
+        }
+    }
+
+    if (!reader.AtEnd()) return false;
+    out += text;
+    return true;
+}
+
+/**
+ * Decodes as much of the capture as possible. Returns the number of bytes consumed; an incomplete record at the end
+ * is left in the buffer for the next read. A byte that starts an invalid record is dropped and decoding resumes on
+ * the next byte, so a lost byte only costs the record it was part of.
+ */
+size_t DecodeStream(const ElfImage &elf, const std::vector<uint8_t> &in, bool showLevel, bool flush, std::string &out)
+{
+    size_t pos = 0;
+    while (pos < in.size()) {
+        if (in[pos] != kSync) {
+            out += char(in[pos++]);
+            continue;
+        }
+        if (pos + kHeaderSize > in.size() || pos + kHeaderSize + in[pos + 1] > in.size()) {
+            if (!flush) break;  // Wait for the rest of the record
+            pos++;
+            continue;
+        }
+        const size_t len = in[pos + 1];
+        if (DecodeRecord(elf, &in[pos + kHeaderSize], len, showLevel, out)) {
+            pos += kHeaderSize + len;
+        } else {
+            pos++;
+        }
+    }
+    return pos;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    bool showLevel = false;
+    int arg = 1;
+    if (arg < argc && strcmp(argv[arg], "-l") == 0) {
+        showLevel = true;
+        arg++;
+    }
+    if (arg >= argc) {
+        fprintf(stderr, "Usage: %s [-l] firmware.elf [capture.bin]\n", argv[0]);
+        return 2;
+    }
+
+    ElfImage elf;
+    if (!elf.Load(argv[arg])) {
+        fprintf(stderr, "Could not read the binary_log section of %s\n", argv[arg]);
+        return 1;
+    }
+
+    FILE *input = stdin;
+    if (arg + 1 < argc) {
+        input = fopen(argv[arg + 1], "rb");
+        if (input == nullptr) {
+            fprintf(stderr, "Could not open %s\n", argv[arg + 1]);
+            return 1;
+        }
+    }
+
+    std::vector<uint8_t> pending;
+    uint8_t chunk[512];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), input)) > 0) {
+        pending.insert(pending.end(), chunk, chunk + n);
+        std::string out;
+        pending.erase(pending.begin(), pending.begin() + DecodeStream(elf, pending, showLevel, false, out));
+        fwrite(out.data(), 1, out.size(), stdout);
+        fflush(stdout);
+    }
+
+    std::string out;
+    DecodeStream(elf, pending, showLevel, true, out);
+    fwrite(out.data(), 1, out.size(), stdout);
+
+    if (input != stdin) fclose(input);
+    return 0;
+}
@@ -0,0 +1,293 @@
+/**
+ * @file        LogRoundTrip.cpp
+ * @brief       Round-trip test of the binary logging mode: BinaryLog.c encodes, LogDecoder decodes, vsnprintf is the reference.
+ * @details     Every case is a log call site with its format entry in this program's binary_log section, as the
+ *				LOG_xxx macros define them. The call is encoded with the firmware encoder
+ *				(Application/src/SerialConsole/BinaryLog.c) into a capture file, between lines of plain text as on the
+ *				console, and formatted with vsnprintf for the expected text. LogDecoder then decodes the capture with this
+ *				program as the ELF file, and its output must match the expected text exactly. The cases run several
+ *				times, so the signatures the first calls keep are used too.
+ *
+ *				The capture also has a record with an unknown ID, a record cut at the end of the file and more than one
+ *				read buffer of data, so the resynchronization and the records split across two reads are checked too.
+ *				Integer arguments stay within 32 bits for int and long: the decoder follows the Cortex-M0+ sizes.
+ *
+ *				Two sizes are printed: the cases, which try every conversion, and a mix of the firmware's own log lines
+ *				(most of them constant text, some with a few integers or a short string). The mix must be at least
+ *				5 times smaller as records than as text. The host time to encode the mix and to vsnprintf it is printed
+ *				as well; on the Cortex-M0+ the ratio is larger, as vsnprintf there is a software division per digit.
+ *
+ *				Build:	g++ -std=c++17 -O2 -o LogDecoder LogDecoder.cpp
+ *						cc -c -O2 -Wall -Wextra ../../Application/src/SerialConsole/BinaryLog.c
+ *						g++ -std=c++17 -O2 -Wall -Wextra -no-pie -I../../Application/src/SerialConsole -o LogRoundTrip
+ *						  LogRoundTrip.cpp BinaryLog.o
+ *				Use:	LogRoundTrip [./LogDecoder]
+ *				-no-pie keeps the run time addresses of the format strings equal to the ones in the ELF file.
+ *
+ * @copyright
+ * @author
+ * @date        October 16, 2026
+ * @version		0.2
+ */
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "BinaryLog.h"
+}
+
+namespace {
+
+constexpr uint8_t kLevel = 3;      ///< LOG_ERROR_LVL, any level decodes the same without -l
+constexpr uint8_t kUnknownId = 0x7F;  ///< More than the number of call sites in this program
+
+/// Bytes of the valid records, and of the same messages as text
+struct Tally {
+    size_t record = 0;
+    size_t text = 0;
+};
+
+/// What Log does with a message
+enum class Mode { kRoundTrip, kEncodeOnly, kTextOnly };
+
+std::vector<uint8_t> capture;  ///< What the console would send
+std::string expected;          ///< What LogDecoder must print
+Tally cases;                   ///< Tally of Cases
+Tally firmware;                ///< Tally of FirmwareLines
+Tally *tally = &cases;         ///< Where Log counts
+Mode mode = Mode::kRoundTrip;
+int failures = 0;
+
+#define FORMAT_OF(format, ...) format
+
+/// A log call site, as LOG_AT defines it in LOG_MODE_BINARY
+#define LOG(...)                                                         \
+    do {                                                                 \
+        BINARY_LOG_SITE(site, kLevel, FORMAT_OF(__VA_ARGS__, 0));        \
+        Log(&site, siteSignature, __VA_ARGS__);                          \
+    } while (0)
+
+/// Encodes one call of a new site into record, and sets len to the size of the record
+#define ENCODE(len, record, ...)                                         \
+    do {                                                                 \
+        BINARY_LOG_SITE(site, kLevel, FORMAT_OF(__VA_ARGS__, 0));        \
+        len = Encode(record, &site, siteSignature, __VA_ARGS__);         \
+    } while (0)
+
+void Text(const std::string &text)
+{
+    capture.insert(capture.end(), text.begin(), text.end());
+    expected += text;
+}
+
+/// BinaryLogEncode with the arguments of a log call
+__attribute__((format(printf, 4, 5))) size_t Encode(uint8_t *record, const BinaryLogFormat *site, uint8_t *signature, const char *format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    size_t len = BinaryLogEncode(record, BINARY_LOG_MAX_RECORD_SIZE, site, signature, ap);
+    va_end(ap);
+    return len;
+}
+
+/// Encodes one log call, and formats it with vsnprintf. A record the encoder refuses is a failure
+__attribute__((format(printf, 3, 4))) void Log(const BinaryLogFormat *site, uint8_t *signature, const char *format, ...)
+{
+    static uint8_t record[BINARY_LOG_MAX_RECORD_SIZE];
+    static char text[256];
+    size_t len = 0;
+    int textLen = 0;
+    va_list ap;
+
+    if (mode != Mode::kTextOnly) {
+        va_start(ap, format);
+        len = BinaryLogEncode(record, sizeof(record), site, signature, ap);
+        va_end(ap);
+    }
+    if (mode != Mode::kEncodeOnly) {
+        va_start(ap, format);
+        textLen = vsnprintf(text, sizeof(text), format, ap);
+        va_end(ap);
+    }
+    if (mode != Mode::kRoundTrip) return;
+
+    if (len == 0) {
+        printf("  FAIL: \"%s\" not encoded\n", format);
+        failures++;
+        return;
+    }
+    capture.insert(capture.end(), record, record + len);
+    expected.append(text, size_t(textLen));
+    tally->record += len;
+    tally->text += size_t(textLen);
+    Text("\n");
+}
+
+/// A record the encoder shortened (long %s), with the text LogDecoder must print for it
+void LogCut(const uint8_t *record, size_t len, const char *decoded)
+{
+    capture.insert(capture.end(), record, record + len);
+    expected += decoded;
+    Text("\n");
+}
+
+void Cases()
+{
+    Text("Plain text before the first record\r\n");
+    LOG("Boot %d", 1);
+    LOG("no arguments at all");
+    LOG("%d %d %d %d", 0, -1, 2147483647, -2147483647 - 1);
+    LOG("%u %x %X %o %#x", 4294967295u, 0xdeadbeefu, 0xabcu, 8u, 255u);
+    LOG("%ld %lu %lx", -123456l, 3000000000ul, 0x1234ul);
+    LOG("%lld %llu %llx", -9000000000000ll, 18000000000000000000ull, 0xfedcba9876543210ull);
+    LOG("%hd %hu %hhd %hhu", 70000, 70000u, 300, 300u);  // Narrowed as by printf
+    LOG("%zu %zd", size_t(4096), ptrdiff_t(-4096));
+    LOG("[%5d] [%-5d] [%05d] [%+d] [% d]", 42, 42, 42, 42, 42);
+    LOG("[%*d] [%-*d] [%.*d]", 6, 7, 6, 7, 4, 7);
+    LOG("%c%c%c", 'O', 'K', '!');
+    LOG("%f %.2f %e %g %G", 3.14159, -2.5, 12345.678, 0.0001, 1e20);
+    LOG("%8.3f|%-8.1f|", 1.5, 2.25);
+    LOG("%s and %s", "first", "second");
+    LOG("[%10s] [%-10s] [%.3s]", "right", "left", "cut here");
+    LOG("%s", "");
+    LOG("100%% done, %d%%", 50);
+    LOG("%p", reinterpret_cast<void *>(0x20001234));
+    LOG("Temp %d.%02d C, weight %ld g, name %s, state 0x%02x", 23, 5, 1250l, "scale", 0x1fu);
+    uint8_t record[BINARY_LOG_MAX_RECORD_SIZE];
+    size_t len = 0;
+    ENCODE(len, record, "%s end", "0123456789abcdef0123456789abcdefXYZ");
+    LogCut(record, len, "0123456789abcdef0123456789abcdef end");  // BINARY_LOG_MAX_STRING_SIZE characters are kept
+}
+
+/// Log lines of the firmware (Application/src), with typical arguments: the mix the console carries
+void FirmwareLines()
+{
+    LOG("MQTT Connected to broker\r\n");
+    LOG("wifi_cb: M2M_WIFI_CONNECTED\r\n");
+    LOG("wifi_cb: IP address is %u.%u.%u.%u\r\n", 192u, 168u, 1u, 42u);
+    LOG("init_storage: SD card mount OK.\r\n");
+    LOG("init_storage: SD card mount failed! (res %d)\r\n", 3);
+    LOG("start_download: sending HTTP request...\r\n");
+    LOG("http_client_callback: received response %u data size %u\r\n", 200u, 5120u);
+    LOG("store_file_packet: received[%lu], file size[%lu]\r\n", 1024ul, 20480ul);
+    LOG("http_client_callback: request completed.\r\n");
+    LOG("Error connecting to MQTT Broker!\r\n");
+    LOG("\r\nGame message received!\r\n");
+    LOG("\r\n %.*s", 17, "P1_GAME_ESE516_T0 and more");  // MQTT topic: not null terminated
+    LOG("\r\nRGB %d %d %d\r\n", 255, 128, 0);
+    LOG("MQTT send %s\r\n", "{\"d\":{\"temp\":17}}");
+    LOG("Control Thread: Consumed game packet!\r\n");
+    LOG("Could not allocate semaphore\r\n");
+}
+
+/// Host time of one pass of FirmwareLines, in ns per message
+double TimeFirmwareLines(Mode timed)
+{
+    constexpr int kPasses = 20000;
+    constexpr int kLines = 16;
+
+    mode = timed;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kPasses; i++) FirmwareLines();
+    auto end = std::chrono::steady_clock::now();
+    mode = Mode::kRoundTrip;
+    return std::chrono::duration<double, std::nano>(end - start).count() / (kPasses * kLines);
+}
+
+/// A sync byte with an ID that is not in the ELF file: dropped, and decoding resumes on the next byte
+void Corruption()
+{
+    Text("before corruption\n");
+    const uint8_t junk[] = {BINARY_LOG_SYNC, 3, kUnknownId, 0xff};
+    capture.insert(capture.end(), junk, junk + sizeof(junk));
+    expected += std::string(reinterpret_cast<const char *>(junk + 1), sizeof(junk) - 1);  // Not a record: passed through
+    Text("\n");
+    LOG("after corruption %d", 7);
+}
+
+std::string DecoderOutput(const std::string &decoder, const std::string &capturePath)
+{
+    char self[4096];
+    ssize_t n = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (n <= 0) return "";
+    self[n] = '\0';
+
+    std::string command = decoder + " " + self + " " + capturePath;
+    FILE *pipe = popen(command.c_str(), "r");
+    if (pipe == nullptr) return "";
+    std::string out;
+    char chunk[4096];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), pipe)) > 0) out.append(chunk, got);
+    if (pclose(pipe) != 0) printf("  FAIL: %s exited with an error\n", command.c_str());
+    return out;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    const std::string decoder = argc > 1 ? argv[1] : "./LogDecoder";
+
+    Cases();
+    Corruption();
+    const Tally onePass = cases;
+    tally = &firmware;
+    FirmwareLines();
+    tally = &cases;
+    while (capture.size() < 2048) Cases();  // Records straddle the 512-byte reads of LogDecoder
+
+    // A record cut at the end of the capture: the decoder drops its sync byte and passes the rest through
+    uint8_t record[BINARY_LOG_MAX_RECORD_SIZE];
+    size_t len = 0;
+    ENCODE(len, record, "cut %d", 1);
+    capture.insert(capture.end(), record, record + len - 1);
+    expected.append(reinterpret_cast<const char *>(record + 1), len - 2);
+
+    char capturePath[] = "/tmp/LogRoundTripXXXXXX";
+    int fd = mkstemp(capturePath);
+    if (fd < 0 || write(fd, capture.data(), capture.size()) != ssize_t(capture.size())) {
+        fprintf(stderr, "Could not write the capture file\n");
+        return 2;
+    }
+    close(fd);
+    const std::string out = DecoderOutput(decoder, capturePath);
+    unlink(capturePath);
+
+    if (out != expected) {
+        size_t at = 0;
+        while (at < out.size() && at < expected.size() && out[at] == expected[at]) at++;
+        size_t from = expected.rfind('\n', at);
+        from = (from == std::string::npos) ? 0 : from + 1;
+        printf("  FAIL: decoded text differs at byte %zu\n  expected: %s\n  decoded:  %s\n",
+               at,
+               expected.substr(from, expected.find('\n', at) - from).c_str(),
+               out.substr(from, out.find('\n', at) - from).c_str());
+        failures++;
+    }
+
+    const double firmwareRatio = double(firmware.text) / firmware.record;
+    printf("%zu bytes of capture, %zu expected\n", capture.size(), expected.size());
+    printf("Cases, every conversion: %zu bytes as binary records, %zu as text (%.1fx)\n",
+           onePass.record,
+           onePass.text,
+           double(onePass.text) / onePass.record);
+    printf("Firmware line mix: %zu bytes as binary records, %zu as text (%.1fx)\n", firmware.record, firmware.text, firmwareRatio);
+    if (firmwareRatio < 5.0) {
+        printf("  FAIL: the firmware line mix is less than 5 times smaller as records\n");
+        failures++;
+    }
+    const double encodeNs = TimeFirmwareLines(Mode::kEncodeOnly);
+    const double textNs = TimeFirmwareLines(Mode::kTextOnly);
+    printf("Host time per firmware line: BinaryLogEncode %.0f ns, vsnprintf %.0f ns\n", encodeNs, textNs);
+    printf("%s\n", failures == 0 ? "All checks passed" : "Some checks failed");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,444 @@
+/**
+ * @file        RingBench.cpp
+ * @brief       Unit test and ns/byte benchmark of the console ring buffer (Application/src/SerialConsole/circular_buffer.c)
+ * @details     Two parts, both on the PC:
+ *				--Test: the single-producer/single-consumer rules of circular_buffer.h. Empty and full, rejected puts,
+ *				  order across the wrap of the storage, put_n/get_n/peek_contiguous/skip/advance, head and tail counters
+ *				  wrapping around SIZE_MAX, then a producer thread and a consumer thread moving a counting sequence
+ *				  through a small ring with no lock.
+ *				--Benchmark: ns per byte moved through a 512-byte ring (TX_BUFFER_SIZE), byte by byte and in chunks, for
+ *				  circular_buffer.c and for the modulo/full-flag buffer it replaced (copied below from the baseline).
+ *				  The vTaskSuspendAll/xTaskResumeAll pair the old callers put around every access is not counted, so
+ *				  the gap on the board is larger than the one printed here.
+ *
+ *				The bootloader copy (SD_MMC_EXAMPLE_Bootloader_ESE516_SPRING2019/src/SerialConsole) is the same code
+ *				without circular_buf_advance.
+ *
+ *				Build:	cc -c -O2 -Wall -Wextra ../../Application/src/SerialConsole/circular_buffer.c
+ *						g++ -std=c++17 -O2 -Wall -Wextra -pthread -I../../Application/src/SerialConsole -o RingBench
+ *						  RingBench.cpp circular_buffer.o
+ *				Use:	RingBench [test|bench|all]
+ *
+ * @copyright
+ * @author
+ * @date        October 16, 2026
+ * @version		0.1
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "circular_buffer.h"
+}
+
+namespace {
+
+constexpr size_t kRingSize = 512;                ///< TX_BUFFER_SIZE and RX_BUFFER_SIZE of SerialConsole.c
+constexpr size_t kBenchBytes = 64u * 1024 * 1024;  ///< Bytes moved by each benchmark
+
+int failures = 0;
+
+#define CHECK(condition)                                                     \
+    do {                                                                     \
+        if (!(condition)) {                                                  \
+            printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #condition);  \
+            failures++;                                                      \
+        }                                                                    \
+    } while (0)
+
+/******************************************************************************
+ * Baseline: the embeddedartistry buffer circular_buffer.c replaced, with its handle allocated by init.
+ * Not inlined, as when it was its own translation unit
+ ******************************************************************************/
+
+namespace baseline {
+
+struct circular_buf_t {
+    uint8_t *buffer;
+    size_t head;
+    size_t tail;
+    size_t max;
+    bool full;
+};
+typedef circular_buf_t *cbuf_handle_t;
+
+void circular_buf_reset(cbuf_handle_t cbuf)
+{
+    cbuf->head = 0;
+    cbuf->tail = 0;
+    cbuf->full = false;
+}
+
+cbuf_handle_t circular_buf_init(uint8_t *buffer, size_t size)
+{
+    cbuf_handle_t cbuf = static_cast<cbuf_handle_t>(malloc(sizeof(circular_buf_t)));
+    cbuf->buffer = buffer;
+    cbuf->max = size;
+    circular_buf_reset(cbuf);
+    return cbuf;
+}
+
+void circular_buf_free(cbuf_handle_t cbuf)
+{
+    free(cbuf);
+}
+
+bool circular_buf_empty(cbuf_handle_t cbuf)
+{
+    return (!cbuf->full && (cbuf->head == cbuf->tail));
+}
+
+bool circular_buf_full(cbuf_handle_t cbuf)
+{
+    return cbuf->full;
+}
+
+void advance_pointer(cbuf_handle_t cbuf)
+{
+    if (cbuf->full) {
+        cbuf->tail = (cbuf->tail + 1) % cbuf->max;
+    }
+    cbuf->head = (cbuf->head + 1) % cbuf->max;
+    cbuf->full = (cbuf->head == cbuf->tail);
+}
+
+void retreat_pointer(cbuf_handle_t cbuf)
+{
+    cbuf->full = false;
+    cbuf->tail = (cbuf->tail + 1) % cbuf->max;
+}
+
+__attribute__((noinline)) int circular_buf_put2(cbuf_handle_t cbuf, uint8_t data)
+{
+    int r = -1;
+    if (!circular_buf_full(cbuf)) {
+        cbuf->buffer[cbuf->head] = data;
+        advance_pointer(cbuf);
+        r = 0;
+    }
+    return r;
+}
+
+__attribute__((noinline)) int circular_buf_get(cbuf_handle_t cbuf, uint8_t *data)
+{
+    int r = -1;
+    if (!circular_buf_empty(cbuf)) {
+        *data = cbuf->buffer[cbuf->tail];
+        retreat_pointer(cbuf);
+        r = 0;
+    }
+    return r;
+}
+
+}  // namespace baseline
+
+/******************************************************************************
+ * Unit test
+ ******************************************************************************/
+
+void TestEmptyFull()
+{
+    static uint8_t storage[8];
+    circular_buf_t ring;
+    uint8_t byte = 0;
+
+    circular_buf_init(&ring, storage, sizeof(storage));
+    CHECK(circular_buf_empty(&ring));
+    CHECK(!circular_buf_full(&ring));
+    CHECK(circular_buf_capacity(&ring) == 8);
+    CHECK(circular_buf_size(&ring) == 0);
+    CHECK(circular_buf_get(&ring, &byte) == -1);
+
+    for (uint8_t i = 0; i < 8; i++) CHECK(circular_buf_put(&ring, i) == 0);
+    CHECK(circular_buf_full(&ring));
+    CHECK(circular_buf_size(&ring) == 8);
+    CHECK(circular_buf_put(&ring, 99) == -1);  // Rejected, the oldest byte stays
+    const uint8_t more[3] = {99, 99, 99};
+    CHECK(circular_buf_put_n(&ring, more, sizeof(more)) == 0);
+
+    for (uint8_t i = 0; i < 8; i++) {
+        CHECK(circular_buf_get(&ring, &byte) == 0);
+        CHECK(byte == i);
+    }
+    CHECK(circular_buf_empty(&ring));
+
+    circular_buf_put(&ring, 1);
+    circular_buf_reset(&ring);
+    CHECK(circular_buf_empty(&ring));
+}
+
+void TestWrap()
+{
+    static uint8_t storage[16];
+    circular_buf_t ring;
+    uint8_t in[16];
+    uint8_t out[16];
+    uint8_t next = 0;
+    uint8_t expected = 0;
+
+    circular_buf_init(&ring, storage, sizeof(storage));
+    // Chunk sizes that are prime to the storage size, so every split of a copy across the end is hit
+    for (int round = 0; round < 200; round++) {
+        size_t putLen = size_t(1 + round % 13);
+        for (size_t i = 0; i < putLen; i++) in[i] = uint8_t(next + i);
+        size_t space = circular_buf_capacity(&ring) - circular_buf_size(&ring);
+        size_t put = circular_buf_put_n(&ring, in, putLen);
+        CHECK(put == (putLen < space ? putLen : space));
+        next = uint8_t(next + put);
+
+        size_t getLen = size_t(1 + round % 7);
+        size_t got = circular_buf_get_n(&ring, out, getLen);
+        for (size_t i = 0; i < got; i++) CHECK(out[i] == uint8_t(expected + i));
+        expected = uint8_t(expected + got);
+        CHECK(circular_buf_size(&ring) == size_t(uint8_t(next - expected)));
+    }
+}
+
+void TestPeekSkip()
+{
+    static uint8_t storage[16];
+    circular_buf_t ring;
+    uint8_t *span = nullptr;
+    uint8_t data[16];
+
+    circular_buf_init(&ring, storage, sizeof(storage));
+    CHECK(circular_buf_peek_contiguous(&ring, &span) == 0);
+
+    for (uint8_t i = 0; i < 16; i++) data[i] = i;
+    circular_buf_put_n(&ring, data, 12);
+    circular_buf_skip(&ring, 10);
+    circular_buf_put_n(&ring, data, 9);  // 2 old bytes, then 4 up to the end of the storage, then 5 from its start
+
+    CHECK(circular_buf_peek_contiguous(&ring, &span) == 6);
+    CHECK(span == &storage[10]);
+    CHECK(span[0] == 10 && span[1] == 11 && span[2] == 0 && span[5] == 3);
+    circular_buf_skip(&ring, 6);
+    CHECK(circular_buf_peek_contiguous(&ring, &span) == 5);
+    CHECK(span == &storage[0]);
+    CHECK(span[0] == 4 && span[4] == 8);
+    circular_buf_skip(&ring, 5);
+    CHECK(circular_buf_empty(&ring));
+}
+
+/// The DMAC writes straight into the storage, the producer only publishes the count
+void TestAdvance()
+{
+    static uint8_t storage[8];
+    circular_buf_t ring;
+    uint8_t out[8];
+
+    circular_buf_init(&ring, storage, sizeof(storage));
+    memcpy(storage, "abcdefgh", 8);
+    circular_buf_advance(&ring, 5);
+    CHECK(circular_buf_size(&ring) == 5);
+    CHECK(circular_buf_get_n(&ring, out, sizeof(out)) == 5);
+    CHECK(memcmp(out, "abcde", 5) == 0);
+    circular_buf_advance(&ring, 6);
+    CHECK(circular_buf_get_n(&ring, out, sizeof(out)) == 6);
+    CHECK(memcmp(out, "fghabc", 6) == 0);
+}
+
+/// Head and tail are free-running: the sizes stay right when the counters wrap around
+void TestCounterWrap()
+{
+    static uint8_t storage[8];
+    circular_buf_t ring;
+    uint8_t byte = 0;
+
+    circular_buf_init(&ring, storage, sizeof(storage));
+    ring.head = ring.tail = SIZE_MAX - 2;
+    for (uint8_t i = 0; i < 8; i++) CHECK(circular_buf_put(&ring, i) == 0);
+    CHECK(ring.head < ring.tail);
+    CHECK(circular_buf_full(&ring));
+    CHECK(circular_buf_size(&ring) == 8);
+    CHECK(circular_buf_put(&ring, 8) == -1);
+    for (uint8_t i = 0; i < 8; i++) {
+        CHECK(circular_buf_get(&ring, &byte) == 0);
+        CHECK(byte == i);
+    }
+    CHECK(circular_buf_empty(&ring));
+}
+
+/// One producer thread and one consumer thread, no lock, as the DMAC callback and a task share the TX ring
+void TestConcurrent()
+{
+    constexpr uint32_t kTotal = 1024 * 1024;
+    static uint8_t storage[64];
+    static circular_buf_t ring;
+    circular_buf_init(&ring, storage, sizeof(storage));
+
+    std::thread producer([] {
+        uint8_t chunk[23];
+        uint32_t sent = 0;
+        while (sent < kTotal) {
+            size_t len = 1 + sent % sizeof(chunk);
+            if (len > kTotal - sent) len = kTotal - sent;
+            for (size_t i = 0; i < len; i++) chunk[i] = uint8_t((sent + i) * 7);
+            size_t put = (len == 1) ? (circular_buf_put(&ring, chunk[0]) == 0) : circular_buf_put_n(&ring, chunk, len);
+            sent += uint32_t(put);
+            if (put == 0) std::this_thread::yield();  // Full: let the consumer run, the PC may have a single core
+        }
+    });
+
+    uint32_t received = 0;
+    uint32_t errors = 0;
+    uint8_t *span = nullptr;
+    uint8_t out[17];
+    while (received < kTotal) {
+        // Alternate the two consumer styles: copy out, and peek then skip (the TX DMA path)
+        if (received & 1) {
+            size_t got = circular_buf_get_n(&ring, out, sizeof(out));
+            for (size_t i = 0; i < got; i++) errors += out[i] != uint8_t((received + i) * 7);
+            received += uint32_t(got);
+        } else {
+            size_t len = circular_buf_peek_contiguous(&ring, &span);
+            for (size_t i = 0; i < len; i++) errors += span[i] != uint8_t((received + i) * 7);
+            circular_buf_skip(&ring, len);
+            received += uint32_t(len);
+            if (len == 0) std::this_thread::yield();
+        }
+    }
+    producer.join();
+    CHECK(errors == 0);
+    CHECK(circular_buf_empty(&ring));
+}
+
+void RunTests()
+{
+    printf("test\n");
+    fflush(stdout);
+    TestEmptyFull();
+    TestWrap();
+    TestPeekSkip();
+    TestAdvance();
+    TestCounterWrap();
+    TestConcurrent();
+    printf("  %s\n", failures == 0 ? "ok" : "failed");
+}
+
+/******************************************************************************
+ * Benchmark
+ ******************************************************************************/
+
+volatile uint32_t benchSink;  ///< Keeps the compiler from dropping the reads
+
+template <typename Fn>
+void Bench(const char *name, Fn fn)
+{
+    fn(kBenchBytes / 16);  // Warm up
+    auto start = std::chrono::steady_clock::now();
+    uint32_t sum = fn(kBenchBytes);
+    auto end = std::chrono::steady_clock::now();
+    benchSink = sum;
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    printf("  %-38s %6.2f ns/byte %8.0f MB/s\n", name, ns / kBenchBytes, kBenchBytes / ns * 1e3);
+}
+
+/// Fills the ring to half, then drains it, as a burst of console output between two DMA completions
+constexpr size_t kBurst = kRingSize / 2;
+
+uint32_t BaselineBytes(size_t total)
+{
+    static uint8_t storage[kRingSize];
+    baseline::cbuf_handle_t ring = baseline::circular_buf_init(storage, sizeof(storage));
+    uint32_t sum = 0;
+    uint8_t byte = 0;
+    for (size_t done = 0; done < total; done += kBurst) {
+        for (size_t i = 0; i < kBurst; i++) baseline::circular_buf_put2(ring, uint8_t(i));
+        for (size_t i = 0; i < kBurst; i++) {
+            baseline::circular_buf_get(ring, &byte);
+            sum += byte;
+        }
+    }
+    baseline::circular_buf_free(ring);
+    return sum;
+}
+
+uint32_t RingBytes(size_t total)
+{
+    static uint8_t storage[kRingSize];
+    circular_buf_t ring;
+    circular_buf_init(&ring, storage, sizeof(storage));
+    uint32_t sum = 0;
+    uint8_t byte = 0;
+    for (size_t done = 0; done < total; done += kBurst) {
+        for (size_t i = 0; i < kBurst; i++) circular_buf_put(&ring, uint8_t(i));
+        for (size_t i = 0; i < kBurst; i++) {
+            circular_buf_get(&ring, &byte);
+            sum += byte;
+        }
+    }
+    return sum;
+}
+
+/// put_n and get_n with the chunk size of a short log line
+uint32_t RingChunks(size_t total)
+{
+    constexpr size_t kChunk = 48;
+    static uint8_t storage[kRingSize];
+    circular_buf_t ring;
+    uint8_t in[kChunk];
+    uint8_t out[kChunk];
+    circular_buf_init(&ring, storage, sizeof(storage));
+    for (size_t i = 0; i < kChunk; i++) in[i] = uint8_t(i);
+    uint32_t sum = 0;
+    for (size_t done = 0; done < total; done += kChunk) {
+        circular_buf_put_n(&ring, in, kChunk);
+        circular_buf_get_n(&ring, out, kChunk);
+        sum += out[done % kChunk];
+    }
+    return sum;
+}
+
+/// put_n, then peek_contiguous and skip, as SerialConsole.c feeds the TX DMAC
+uint32_t RingSpans(size_t total)
+{
+    constexpr size_t kChunk = 48;
+    static uint8_t storage[kRingSize];
+    circular_buf_t ring;
+    uint8_t in[kChunk];
+    uint8_t *span = nullptr;
+    circular_buf_init(&ring, storage, sizeof(storage));
+    for (size_t i = 0; i < kChunk; i++) in[i] = uint8_t(i);
+    uint32_t sum = 0;
+    for (size_t done = 0; done < total; done += kChunk) {
+        circular_buf_put_n(&ring, in, kChunk);
+        size_t len;
+        while ((len = circular_buf_peek_contiguous(&ring, &span)) != 0) {
+            sum += span[len - 1];
+            circular_buf_skip(&ring, len);
+        }
+    }
+    return sum;
+}
+
+void RunBench()
+{
+    printf("bench (%zu-byte ring, %zu MB each)\n", kRingSize, kBenchBytes >> 20);
+    Bench("baseline put2/get (modulo, flag)", BaselineBytes);
+    Bench("circular_buffer put/get", RingBytes);
+    Bench("circular_buffer put_n/get_n (48)", RingChunks);
+    Bench("circular_buffer put_n/peek+skip (48)", RingSpans);
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    const std::string what = argc > 1 ? argv[1] : "all";
+
+    if (argc > 2 || (what != "test" && what != "bench" && what != "all")) {
+        fprintf(stderr, "Usage: %s [test|bench|all]\n", argv[0]);
+        return 2;
+    }
+    if (what != "bench") RunTests();
+    if (what != "test" && failures == 0) RunBench();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,386 @@
+/**
+ * @file        StreamReceiver.cpp
+ * @brief       Host receiver for the binary sensor stream of the Application console (see DataStream.h).
+ * @details     Reads the console (serial port, capture file or stdin), finds the COBS frames between the console text,
+ *				checks their CRC and writes the records as CSV or as a binary file. Console text can be echoed to stderr.
+ *				Lost frames are counted from the sequence numbers.
+ *
+ *				Build:	g++ -std=c++17 -O2 -pthread -I../../Application/src/SerialConsole -o StreamReceiver StreamReceiver.cpp
+ *				Use:	StreamReceiver [-b baud] [-o prefix] [-f csv|bin] [-t] <device|file|->
+ *						-b	baud rate, when reading a serial port (must match CONSOLE_BAUDRATE). Default 115200
+ *						-o	write to <prefix>_imu.csv, <prefix>_weight.csv... (or <prefix>.bin) instead of stdout
+ *						-f	csv (default) or bin: <type><length><record> as received
+ *						-t	echo the console text to stderr
+ *				Then send "stream on" on the console.
+ *
+ *				StreamReceiver --bench [frames] measures the decoder throughput through a pseudo-terminal pair:
+ *				a thread writes IMU frames to the master side while the receiver reads the slave side.
+ *
+ * @copyright
+ * @author
+ * @date        October 16, 2026
+ * @version		0.1
+ */
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DataStream.h"
+
+namespace {
+
+constexpr uint16_t kCrcInit = 0xFFFF;
+
+uint16_t Crc16(const uint8_t *data, size_t len, uint16_t crc)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc ^= uint16_t(data[i]) << 8;
+        for (int bit = 0; bit < 8; bit++) crc = (crc & 0x8000) ? uint16_t((crc << 1) ^ 0x1021) : uint16_t(crc << 1);
+    }
+    return crc;
+}
+
+/// COBS decoding of the bytes between two delimiters. Returns false if the block is not valid COBS
+bool CobsDecode(const std::vector<uint8_t> &in, std::vector<uint8_t> &out)
+{
+    out.clear();
+    size_t pos = 0;
+    while (pos < in.size()) {
+        const uint8_t code = in[pos++];
+        if (code == 0 || pos + code - 1 > in.size()) return false;
+        out.insert(out.end(), in.begin() + pos, in.begin() + pos + code - 1);
+        pos += code - 1;
+        if (code != 0xFF && pos < in.size()) out.push_back(0);
+    }
+    return true;
+}
+
+/// Encoder for the benchmark, same layout as DataStreamEncodeFrame in the firmware
+std::vector<uint8_t> EncodeFrame(uint8_t type, uint8_t sequence, const void *record, size_t len)
+{
+    std::vector<uint8_t> payload = {type, sequence};
+    payload.insert(payload.end(), static_cast<const uint8_t *>(record), static_cast<const uint8_t *>(record) + len);
+    const uint16_t crc = Crc16(payload.data(), payload.size(), kCrcInit);
+    payload.push_back(uint8_t(crc));
+    payload.push_back(uint8_t(crc >> 8));
+
+    std::vector<uint8_t> frame = {0, 0};
+    size_t code = 1;
+    for (uint8_t byte : payload) {
+        if (byte == 0) {
+            frame[code] = uint8_t(frame.size() - code);
+            code = frame.size();
+            frame.push_back(0);
+        } else {
+            frame.push_back(byte);
+        }
+    }
+    frame[code] = uint8_t(frame.size() - code);
+    frame.push_back(0);
+    return frame;
+}
+
+/// Where the decoded records go
+class RecordSink
+{
+   public:
+    RecordSink(const std::string &prefix, bool binary) : prefix_(prefix), binary_(binary) {}
+
+    ~RecordSink()
+    {
+        for (auto &entry : files_) {
+            if (entry.second != stdout) fclose(entry.second);
+        }
+    }
+
+    void Write(uint8_t type, const uint8_t *record, size_t len)
+    {
+        if (binary_) {
+            FILE *file = File(0, prefix_.empty() ? "" : prefix_ + ".bin", nullptr);
+            const uint8_t header[2] = {type, uint8_t(len)};
+            fwrite(header, 1, sizeof(header), file);
+            fwrite(record, 1, len, file);
+            return;
+        }
+
+        switch (type) {
+            case DATA_STREAM_RECORD_IMU: {
+                DataStreamImuRecord r;
+                if (len != sizeof(r)) break;
+                memcpy(&r, record, sizeof(r));
+                fprintf(File(type, Name("imu"), "type,timestamp_ms,ax,ay,az,gx,gy,gz"),
+                        "%s%u,%d,%d,%d,%d,%d,%d\n",
+                        Tag("imu"),
+                        r.timestampMs,
+                        r.acceleration[0],
+                        r.acceleration[1],
+                        r.acceleration[2],
+                        r.angularRate[0],
+                        r.angularRate[1],
+                        r.angularRate[2]);
+                return;
+            }
+            case DATA_STREAM_RECORD_WEIGHT: {
+                DataStreamWeightRecord r;
+                if (len != sizeof(r)) break;
+                memcpy(&r, record, sizeof(r));
+                fprintf(File(type, Name("weight"), "type,timestamp_ms,raw"), "%s%u,%d\n", Tag("weight"), r.timestampMs, r.raw);
+                return;
+            }
+            case DATA_STREAM_RECORD_DISTANCE: {
+                DataStreamDistanceRecord r;
+                if (len != sizeof(r)) break;
+                memcpy(&r, record, sizeof(r));
+                fprintf(File(type, Name("distance"), "type,timestamp_ms,distance_mm"), "%s%u,%u\n", Tag("distance"), r.timestampMs, r.distanceMm);
+                return;
+            }
+            default:
+                break;
+        }
+        fprintf(stderr, "Unknown record: type %u, %zu bytes\n", type, len);
+    }
+
+   private:
+    std::string Name(const char *type) const { return prefix_.empty() ? "" : prefix_ + "_" + type + ".csv"; }
+
+    // With a file per type the type column is redundant, so it is only written to stdout
+    const char *Tag(const char *type)
+    {
+        tag_ = prefix_.empty() ? std::string(type) + "," : "";
+        return tag_.c_str();
+    }
+
+    FILE *File(uint8_t type, const std::string &name, const char *header)
+    {
+        auto it = files_.find(type);
+        if (it != files_.end()) return it->second;
+
+        FILE *file = name.empty() ? stdout : fopen(name.c_str(), binary_ ? "wb" : "w");
+        if (file == nullptr) {
+            perror(name.c_str());
+            exit(1);
+        }
+        if (header != nullptr) {
+            // stdout mixes the types: the header of each type is printed before its first record
+            fprintf(file, "%s\n", prefix_.empty() ? header : strchr(header, ',') + 1);
+        }
+        files_[type] = file;
+        return file;
+    }
+
+    std::string prefix_;
+    bool binary_;
+    std::string tag_;
+    std::map<uint8_t, FILE *> files_;
+};
+
+/// Splits the console bytes into text and frames
+class StreamDecoder
+{
+   public:
+    StreamDecoder(RecordSink *sink, bool echoText) : sink_(sink), echoText_(echoText) {}  // A null sink discards the records
+
+    void Feed(const uint8_t *data, size_t len)
+    {
+        for (size_t i = 0; i < len; i++) {
+            if (data[i] != 0) {
+                block_.push_back(data[i]);
+            } else if (!block_.empty()) {
+                Block();
+                block_.clear();
+            }
+        }
+    }
+
+    void PrintStats() const
+    {
+        fprintf(stderr, "%llu frames, %llu lost, %llu CRC errors\n", (unsigned long long)frames_, (unsigned long long)lost_, (unsigned long long)crcErrors_);
+    }
+
+    uint64_t frames() const { return frames_; }
+    uint64_t lost() const { return lost_; }
+    uint64_t crcErrors() const { return crcErrors_; }
+
+   private:
+    void Block()
+    {
+        // Type, sequence and CRC at least. Text never contains 0x00, so a block that fails is text
+        if (CobsDecode(block_, payload_) && payload_.size() >= 4 && Crc16(payload_.data(), payload_.size() - 2, kCrcInit) == (payload_[payload_.size() - 2] | payload_[payload_.size() - 1] << 8)) {
+            const uint8_t sequence = payload_[1];
+            if (frames_ > 0) lost_ += uint8_t(sequence - lastSequence_ - 1);
+            lastSequence_ = sequence;
+            frames_++;
+            if (sink_ != nullptr) sink_->Write(payload_[0], &payload_[2], payload_.size() - 4);
+            return;
+        }
+
+        // Console text is 7-bit ASCII (binary log records aside), so a block with other bytes is most likely a damaged frame
+        for (uint8_t byte : block_) {
+            if (byte >= 0x80) {
+                crcErrors_++;
+                break;
+            }
+        }
+        if (echoText_) fwrite(block_.data(), 1, block_.size(), stderr);
+    }
+
+    RecordSink *sink_;
+    bool echoText_;
+    std::vector<uint8_t> block_;
+    std::vector<uint8_t> payload_;
+    uint8_t lastSequence_ = 0;
+    uint64_t frames_ = 0;
+    uint64_t lost_ = 0;
+    uint64_t crcErrors_ = 0;
+};
+
+speed_t BaudToSpeed(long baud)
+{
+    switch (baud) {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        case 500000: return B500000;
+        case 921600: return B921600;
+        case 1000000: return B1000000;
+        case 2000000: return B2000000;
+        default: return B0;
+    }
+}
+
+bool MakeRaw(int fd, speed_t speed)
+{
+    termios tio;
+    if (tcgetattr(fd, &tio) != 0) return false;
+    cfmakeraw(&tio);
+    if (speed != B0) {
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+    }
+    return tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+int Bench(long frameCount)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        perror("posix_openpt");
+        return 1;
+    }
+    int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (slave < 0 || !MakeRaw(slave, B0) || !MakeRaw(master, B0)) {
+        perror("pty");
+        return 1;
+    }
+
+    // Mix the frames with some console text, the way the firmware does
+    std::vector<uint8_t> stream;
+    const char text[] = "MQTT Connected\r\n";
+    for (long i = 0; i < 256; i++) {
+        DataStreamImuRecord r = {uint32_t(i), {int16_t(i), 0, int16_t(-i)}, {1, int16_t(256 * i), 3}};
+        std::vector<uint8_t> frame = EncodeFrame(DATA_STREAM_RECORD_IMU, uint8_t(i), &r, sizeof(r));
+        stream.insert(stream.end(), frame.begin(), frame.end());
+        if (i % 64 == 0) stream.insert(stream.end(), text, text + sizeof(text) - 1);
+    }
+
+    const long repeats = (frameCount + 255) / 256;
+    std::thread writer([&]() {
+        for (long i = 0; i < repeats; i++) {
+            for (size_t pos = 0; pos < stream.size();) {
+                ssize_t n = write(master, stream.data() + pos, stream.size() - pos);
+                if (n <= 0) return;
+                pos += size_t(n);
+            }
+        }
+    });
+
+    StreamDecoder decoder(nullptr, false);
+    const uint64_t expected = uint64_t(repeats) * 256;
+    uint64_t bytes = 0;
+    uint8_t buffer[4096];
+    const auto start = std::chrono::steady_clock::now();
+    while (decoder.frames() + decoder.lost() < expected) {
+        ssize_t n = read(slave, buffer, sizeof(buffer));
+        if (n <= 0) break;
+        bytes += size_t(n);
+        decoder.Feed(buffer, size_t(n));
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    writer.join();
+
+    printf("%llu frames, %llu bytes in %.3f s: %.0f frames/s, %.2f MB/s\n", (unsigned long long)decoder.frames(), (unsigned long long)bytes, seconds, decoder.frames() / seconds, bytes / seconds / 1e6);
+    decoder.PrintStats();
+    close(slave);
+    close(master);
+    return (decoder.lost() == 0 && decoder.crcErrors() == 0) ? 0 : 1;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    long baud = 115200;
+    std::string prefix;
+    bool binary = false;
+    bool echoText = false;
+    const char *input = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--bench") return Bench(i + 1 < argc ? atol(argv[i + 1]) : 1000000);
+        if (arg == "-b" && i + 1 < argc) {
+            baud = atol(argv[++i]);
+        } else if (arg == "-o" && i + 1 < argc) {
+            prefix = argv[++i];
+        } else if (arg == "-f" && i + 1 < argc) {
+            binary = std::string(argv[++i]) == "bin";
+        } else if (arg == "-t") {
+            echoText = true;
+        } else {
+            input = argv[i];
+        }
+    }
+    if (input == nullptr) {
+        fprintf(stderr, "Usage: %s [-b baud] [-o prefix] [-f csv|bin] [-t] <device|file|->\n       %s --bench [frames]\n", argv[0], argv[0]);
+        return 2;
+    }
+
+    int fd = (strcmp(input, "-") == 0) ? STDIN_FILENO : open(input, O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        perror(input);
+        return 1;
+    }
+    if (isatty(fd)) {
+        if (BaudToSpeed(baud) == B0 || !MakeRaw(fd, BaudToSpeed(baud))) {
+            fprintf(stderr, "Could not set %s to %ld baud\n", input, baud);
+            return 1;
+        }
+    }
+
+    RecordSink sink(prefix, binary);
+    StreamDecoder decoder(&sink, echoText);
+    uint8_t buffer[4096];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        decoder.Feed(buffer, size_t(n));
+        fflush(stdout);
+    }
+
+    decoder.PrintStats();
+    return 0;
+}